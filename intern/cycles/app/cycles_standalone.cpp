@@ -166,13 +166,17 @@ static void session_init()
 
 static void session_exit()
 {
+  double total_time = 0.0, render_time = 0.0;
+
   if (options.session) {
+    options.session->progress.get_time(total_time, render_time);
     delete options.session;
     options.session = NULL;
   }
 
   if (options.session_params.background && !options.quiet) {
-    session_print("Finished Rendering.");
+    session_print(string_printf(
+        "Finished Rendering in %.2f seconds, %.2f rendering.", total_time, render_time));
     printf("\n");
   }
 }
@@ -389,7 +393,7 @@ static void options_parse(int argc, const char **argv)
 
   /* parse options */
   ArgParse ap;
-  bool help = false, debug = false, version = false;
+  bool help = false, debug = false, version = false, wavefront = false;
   int verbosity = 1;
 
   ap.options("Usage: cycles [options] file.xml",
@@ -419,6 +423,9 @@ static void options_parse(int argc, const char **argv)
              "--threads %d",
              &options.session_params.threads,
              "CPU Rendering Threads",
+             "--wavefront",
+             &wavefront,
+             "Trace paths in batches with the CPU split kernel",
              "--width  %d",
              &options.width,
              "Window width in pixel",
@@ -521,6 +528,10 @@ static void options_parse(int argc, const char **argv)
     exit(EXIT_FAILURE);
   }
 #endif
+  else if (wavefront && options.session_params.device.type != DEVICE_CPU) {
+    fprintf(stderr, "Wavefront option only works with CPU device\n");
+    exit(EXIT_FAILURE);
+  }
   else if (options.session_params.samples < 0) {
     fprintf(stderr, "Invalid number of samples: %d\n", options.session_params.samples);
     exit(EXIT_FAILURE);
@@ -530,6 +541,11 @@ static void options_parse(int argc, const char **argv)
     exit(EXIT_FAILURE);
   }
 
+  options.session_params.device.use_split_kernel = wavefront;
+  if (wavefront) {
+    options.session_params.device.has_adaptive_stop_per_sample = false;
+  }
+
   /* For smoother Viewport */
   options.session_params.start_resolution = 64;
 }
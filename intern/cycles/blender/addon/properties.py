@@ -295,6 +295,32 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         min=0.0, max=1.0,
         default=0.01,
     )
+    use_adaptive_sampling: BoolProperty(
+        name="Use Adaptive Sampling",
+        description="Stop sampling pixels once their noise is below the threshold, "
+        "tiles finish early when all their pixels converged (final renders on CPU only)",
+        default=False,
+    )
+    adaptive_threshold: FloatProperty(
+        name="Adaptive Sampling Threshold",
+        description="Noise level at which pixels stop being sampled, lower values give less noise",
+        min=0.0, max=1.0,
+        default=0.01,
+        precision=4,
+    )
+    adaptive_min_samples: IntProperty(
+        name="Adaptive Min Samples",
+        description="Minimum number of samples before a pixel is tested for convergence, "
+        "zero uses the square root of the number of samples",
+        min=0, max=4096,
+        default=0,
+    )
+    use_light_tree: BoolProperty(
+        name="Light Tree",
+        description="Pick lights by their estimated contribution to the shading point rather than by power alone, "
+        "reducing noise in scenes with many lights (not used when sampling all lights)",
+        default=False,
+    )
 
     caustics_reflective: BoolProperty(
         name="Reflective Caustics",
@@ -542,6 +568,12 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         description="Use special type BVH optimized for hair (uses more ram but renders faster)",
         default=True,
     )
+    debug_use_compressed_bvh: BoolProperty(
+        name="Use Compressed BVH",
+        description="Store BVH node bounds quantized, reducing memory usage in cost of looser "
+                    "bounds (only used with AVX2 CPUs)",
+        default=False,
+    )
     debug_bvh_time_steps: IntProperty(
         name="BVH Time Steps",
         description="Split BVH primitives by this number of time steps to speed up render time in cost of memory",
@@ -656,6 +688,27 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         items=enum_texture_limit
     )
 
+    use_texture_cache: BoolProperty(
+        name="Use Texture Cache",
+        description="Load image textures on demand in tiles and mipmap levels, instead of loading "
+                    "full images into memory (CPU rendering only)",
+        default=False,
+    )
+    use_sparse_volumes: BoolProperty(
+        name="Sparse Volumes",
+        description="Store mostly empty volumes in tiles, only allocating tiles that are not empty. "
+                    "This only reduces memory usage, rendering is not faster and cubic "
+                    "interpolation is slower (CPU rendering only)",
+        default=False,
+    )
+    texture_cache_size: IntProperty(
+        name="Texture Cache Size",
+        description="Maximum memory used by the texture cache, in megabytes",
+        default=4096,
+        min=64,
+        subtype='UNSIGNED',
+    )
+
     ao_bounces: IntProperty(
         name="AO Bounces",
         default=0,
@@ -1240,7 +1293,8 @@ class CyclesRenderLayerSettings(bpy.types.PropertyGroup):
     )
     pass_debug_render_time: BoolProperty(
         name="Debug Render Time",
-        description="Render time in milliseconds per sample and pixel",
+        description="Render time in milliseconds per sample and pixel, with the time spent per "
+        "shader and object stored in the render metadata",
         default=False,
         update=update_render_passes,
     )
@@ -74,6 +74,14 @@ def use_cpu(context):
     return (get_device_type(context) == 'NONE' or cscene.device == 'CPU')
 
 
+def use_cpu_split_kernel(context):
+    # Debug flags are only synced to Cycles with this debug value, see engine.py.
+    cscene = context.scene.cycles
+
+    return (use_cpu(context) and bpy.app.debug_value == 256 and
+            cscene.debug_use_cpu_split_kernel)
+
+
 def use_opencl(context):
     cscene = context.scene.cycles
 
@@ -213,6 +221,33 @@ class CYCLES_RENDER_PT_sampling_sub_samples(CyclesButtonsPanel, Panel):
         draw_samples_info(layout, context)
 
 
+class CYCLES_RENDER_PT_sampling_adaptive(CyclesButtonsPanel, Panel):
+    bl_label = "Adaptive Sampling"
+    bl_parent_id = "CYCLES_RENDER_PT_sampling"
+    bl_options = {'DEFAULT_CLOSED'}
+
+    def draw_header(self, context):
+        layout = self.layout
+        cscene = context.scene.cycles
+
+        # Not supported by the CPU split kernel.
+        layout.active = not use_cpu_split_kernel(context)
+        layout.prop(cscene, "use_adaptive_sampling", text="")
+
+    def draw(self, context):
+        layout = self.layout
+        layout.use_property_split = True
+        layout.use_property_decorate = False
+
+        cscene = context.scene.cycles
+
+        layout.active = cscene.use_adaptive_sampling and not use_cpu_split_kernel(context)
+
+        col = layout.column(align=True)
+        col.prop(cscene, "adaptive_threshold", text="Noise Threshold")
+        col.prop(cscene, "adaptive_min_samples", text="Min Samples")
+
+
 class CYCLES_RENDER_PT_sampling_advanced(CyclesButtonsPanel, Panel):
     bl_label = "Advanced"
     bl_parent_id = "CYCLES_RENDER_PT_sampling"
@@ -244,6 +279,10 @@ class CYCLES_RENDER_PT_sampling_advanced(CyclesButtonsPanel, Panel):
             col.prop(cscene, "sample_all_lights_direct")
             col.prop(cscene, "sample_all_lights_indirect")
 
+        col = layout.column(align=True)
+        col.active = not (use_branched_path(context) and use_sample_all_lights(context))
+        col.prop(cscene, "use_light_tree")
+
         for view_layer in scene.view_layers:
             if view_layer.samples > 0:
                 layout.separator()
@@ -654,6 +693,7 @@ class CYCLES_RENDER_PT_performance_acceleration_structure(CyclesButtonsPanel, Pa
         sub = col.column()
         sub.active = not cscene.use_bvh_embree or not _cycles.with_embree
         sub.prop(cscene, "debug_use_hair_bvh")
+        sub.prop(cscene, "debug_use_compressed_bvh")
         sub = col.column()
         sub.active = not cscene.debug_use_spatial_splits and not cscene.use_bvh_embree
         sub.prop(cscene, "debug_bvh_time_steps")
@@ -675,6 +715,31 @@ class CYCLES_RENDER_PT_performance_final_render(CyclesButtonsPanel, Panel):
 
         col.prop(rd, "use_save_buffers")
         col.prop(rd, "use_persistent_data", text="Persistent Images")
+        col.prop(scene.cycles, "use_sparse_volumes")
+
+
+class CYCLES_RENDER_PT_performance_texture_cache(CyclesButtonsPanel, Panel):
+    bl_label = "Texture Cache"
+    bl_parent_id = "CYCLES_RENDER_PT_performance"
+    bl_options = {'DEFAULT_CLOSED'}
+
+    def draw_header(self, context):
+        layout = self.layout
+        cscene = context.scene.cycles
+
+        layout.prop(cscene, "use_texture_cache", text="")
+
+    def draw(self, context):
+        layout = self.layout
+        layout.use_property_split = True
+        layout.use_property_decorate = False
+
+        cscene = context.scene.cycles
+
+        layout.active = cscene.use_texture_cache
+
+        col = layout.column()
+        col.prop(cscene, "texture_cache_size", text="Memory Limit (MB)")
 
 
 class CYCLES_RENDER_PT_performance_viewport(CyclesButtonsPanel, Panel):
@@ -2113,6 +2178,7 @@ classes = (
     CYCLES_PT_integrator_presets,
     CYCLES_RENDER_PT_sampling,
     CYCLES_RENDER_PT_sampling_sub_samples,
+    CYCLES_RENDER_PT_sampling_adaptive,
     CYCLES_RENDER_PT_sampling_advanced,
     CYCLES_RENDER_PT_light_paths,
     CYCLES_RENDER_PT_light_paths_max_bounces,
@@ -2135,6 +2201,7 @@ classes = (
     CYCLES_RENDER_PT_performance_tiles,
     CYCLES_RENDER_PT_performance_acceleration_structure,
     CYCLES_RENDER_PT_performance_final_render,
+    CYCLES_RENDER_PT_performance_texture_cache,
     CYCLES_RENDER_PT_performance_viewport,
     CYCLES_RENDER_PT_passes,
     CYCLES_RENDER_PT_passes_data,
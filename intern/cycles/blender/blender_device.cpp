@@ -17,6 +17,8 @@
 #include "blender/blender_device.h"
 #include "blender/blender_util.h"
 
+#include "util/util_debug.h"
+
 CCL_NAMESPACE_BEGIN
 
 int blender_device_threads(BL::Scene &b_scene)
@@ -101,6 +103,11 @@ DeviceInfo blender_device_info(BL::Preferences &b_preferences, BL::Scene &b_scen
     }
   }
 
+  /* The split kernel doesn't support adaptive sampling. */
+  if (device.type == DEVICE_CPU && DebugFlags().cpu.split_kernel) {
+    device.has_adaptive_stop_per_sample = false;
+  }
+
   return device;
 }
 
@@ -31,6 +31,8 @@
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
 #include "util/util_math.h"
+#include "util/util_task.h"
+#include "util/util_time.h"
 
 #include "mikktspace.h"
 
@@ -918,7 +920,8 @@ Mesh *BlenderSync::sync_mesh(BL::Depsgraph &b_depsgraph,
                              BL::Object &b_ob_instance,
                              bool object_updated,
                              bool show_self,
-                             bool show_particles)
+                             bool show_particles,
+                             TaskPool *geometry_task_pool)
 {
   /* test if we can instance or if the object is modified */
   BL::ID b_ob_data = b_ob.data();
@@ -956,7 +959,14 @@ Mesh *BlenderSync::sync_mesh(BL::Depsgraph &b_depsgraph,
   }
   Mesh *mesh;
 
-  if (!mesh_map.sync(&mesh, key)) {
+  bool need_sync = mesh_map.sync(&mesh, key);
+
+  /* ensure we only sync instanced meshes once, the mesh may still be
+   * exported by a task so don't look at its data */
+  if (mesh_synced.find(mesh) != mesh_synced.end())
+    return mesh;
+
+  if (!need_sync) {
     /* if transform was applied to mesh, need full update */
     if (object_updated && mesh->transform_applied)
       ;
@@ -980,14 +990,85 @@ Mesh *BlenderSync::sync_mesh(BL::Depsgraph &b_depsgraph,
     }
   }
 
-  /* ensure we only sync instanced meshes once */
-  if (mesh_synced.find(mesh) != mesh_synced.end())
-    return mesh;
-
   progress.set_sync_status("Synchronizing object", b_ob.name());
 
   mesh_synced.insert(mesh);
 
+  /* The object syncs right after this need to know the mesh is updated. */
+  mesh->need_update = true;
+  mesh->used_shaders = used_shaders;
+
+  if (geometry_task_pool) {
+    geometry_task_object_add(geometry_task_pool, b_ob);
+  }
+
+  /* Mesh objects are converted in the task, other types go through code
+   * paths of Blender that are not safe to run from multiple threads. */
+  BL::Mesh b_mesh(PointerRNA_NULL);
+  const bool convert_in_task = geometry_task_pool && b_ob.type() == BL::Object::type_MESH;
+
+  if (requested_geometry_flags != Mesh::GEOMETRY_NONE) {
+    /* Adaptive subdivision setup. Not for baking since that requires
+     * exact mapping to the Blender mesh. */
+    if (scene->bake_manager->get_baking()) {
+      mesh->subdivision_type = Mesh::SUBDIVISION_NONE;
+    }
+    else {
+      mesh->subdivision_type = object_subdivision_type(b_ob, preview, experimental);
+    }
+
+    if (!convert_in_task) {
+      /* For some reason, meshes do not need this... */
+      bool need_undeformed = mesh->need_attribute(scene, ATTR_STD_GENERATED);
+
+      b_mesh = object_to_mesh(
+          b_data, b_ob, b_depsgraph, need_undeformed, mesh->subdivision_type);
+    }
+  }
+
+  mesh_sync_results.push_back(MeshSyncResult(mesh, b_ob));
+  MeshSyncResult *result = &mesh_sync_results.back();
+
+  if (geometry_task_pool) {
+    geometry_task_pool->push(function_bind(&BlenderSync::sync_mesh_data,
+                                           this,
+                                           b_depsgraph,
+                                           b_ob,
+                                           b_mesh,
+                                           requested_geometry_flags,
+                                           convert_in_task,
+                                           show_self,
+                                           show_particles,
+                                           result));
+  }
+  else {
+    sync_mesh_data(b_depsgraph,
+                   b_ob,
+                   b_mesh,
+                   requested_geometry_flags,
+                   false,
+                   show_self,
+                   show_particles,
+                   result);
+  }
+
+  return mesh;
+}
+
+/* Export of mesh geometry, curves and attributes. May run in a task, so it
+ * must only modify the mesh it exports. */
+void BlenderSync::sync_mesh_data(BL::Depsgraph b_depsgraph,
+                                 BL::Object b_ob,
+                                 BL::Mesh b_mesh,
+                                 int requested_geometry_flags,
+                                 bool convert_mesh,
+                                 bool show_self,
+                                 bool show_particles,
+                                 MeshSyncResult *result)
+{
+  Mesh *mesh = result->mesh;
+  BL::ID b_ob_data = b_ob.data();
+
   /* create derived mesh */
   array<int> oldtriangles;
   array<Mesh::SubdFace> oldsubd_faces;
@@ -1003,41 +1084,41 @@ Mesh *BlenderSync::sync_mesh(BL::Depsgraph &b_depsgraph,
   oldcurve_keys.steal_data(mesh->curve_keys);
   oldcurve_radius.steal_data(mesh->curve_radius);
 
+  vector<Shader *> used_shaders = mesh->used_shaders;
   mesh->clear();
   mesh->used_shaders = used_shaders;
   mesh->name = ustring(b_ob_data.name().c_str());
 
   if (requested_geometry_flags != Mesh::GEOMETRY_NONE) {
-    /* Adaptive subdivision setup. Not for baking since that requires
-     * exact mapping to the Blender mesh. */
-    if (scene->bake_manager->get_baking()) {
-      mesh->subdivision_type = Mesh::SUBDIVISION_NONE;
-    }
-    else {
-      mesh->subdivision_type = object_subdivision_type(b_ob, preview, experimental);
-    }
+    if (convert_mesh) {
+      /* For some reason, meshes do not need this... */
+      bool need_undeformed = mesh->need_attribute(scene, ATTR_STD_GENERATED);
 
-    /* For some reason, meshes do not need this... */
-    bool need_undeformed = mesh->need_attribute(scene, ATTR_STD_GENERATED);
-
-    BL::Mesh b_mesh = object_to_mesh(
-        b_data, b_ob, b_depsgraph, need_undeformed, mesh->subdivision_type);
+      b_mesh = object_to_mesh(
+          b_data, b_ob, b_depsgraph, need_undeformed, mesh->subdivision_type);
+    }
 
     if (b_mesh) {
       /* Sync mesh itself. */
       if (view_layer.use_surfaces && show_self) {
+        double time = time_dt();
         if (mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
           create_subd_mesh(scene, mesh, b_ob, b_mesh, used_shaders, dicing_rate, max_subdivisions);
         else
           create_mesh(scene, mesh, b_mesh, used_shaders, false);
+        geometry_sync_times.add(geometry_sync_times.mesh, time_dt() - time);
 
+        time = time_dt();
         create_mesh_volume_attributes(scene, b_ob, mesh, b_scene.frame_current());
+        geometry_sync_times.add(geometry_sync_times.attributes, time_dt() - time);
       }
 
       /* Sync hair curves. */
       if (view_layer.use_hair && show_particles &&
           mesh->subdivision_type == Mesh::SUBDIVISION_NONE) {
+        double time = time_dt();
         sync_curves(mesh, b_mesh, b_ob, false);
+        geometry_sync_times.add(geometry_sync_times.curves, time_dt() - time);
       }
 
       free_object_to_mesh(b_data, b_ob, b_mesh);
@@ -1045,23 +1126,44 @@ Mesh *BlenderSync::sync_mesh(BL::Depsgraph &b_depsgraph,
   }
   mesh->geometry_flags = requested_geometry_flags;
 
-  /* fluid motion */
-  sync_mesh_fluid_motion(b_ob, scene, mesh);
-
   /* tag update */
-  bool rebuild = (oldtriangles != mesh->triangles) || (oldsubd_faces != mesh->subd_faces) ||
-                 (oldsubd_face_corners != mesh->subd_face_corners) ||
-                 (oldcurve_keys != mesh->curve_keys) || (oldcurve_radius != mesh->curve_radius);
+  result->rebuild = (oldtriangles != mesh->triangles) || (oldsubd_faces != mesh->subd_faces) ||
+                    (oldsubd_face_corners != mesh->subd_face_corners) ||
+                    (oldcurve_keys != mesh->curve_keys) ||
+                    (oldcurve_radius != mesh->curve_radius);
+}
+
+/* Converting the same Blender object from multiple tasks is not safe, wait for
+ * the pending task of an object before pushing another one for it. */
+void BlenderSync::geometry_task_object_add(TaskPool *geometry_task_pool, BL::Object &b_ob)
+{
+  if (!geometry_task_objects.insert(b_ob.ptr.data).second) {
+    geometry_task_pool->wait_work();
+    geometry_task_objects.clear();
+    geometry_task_objects.insert(b_ob.ptr.data);
+  }
+}
 
-  mesh->tag_update(scene, rebuild);
+/* Finish meshes once their export is done, this touches shared scene data. */
+void BlenderSync::sync_mesh_finish()
+{
+  geometry_task_objects.clear();
 
-  return mesh;
+  foreach (MeshSyncResult &result, mesh_sync_results) {
+    /* fluid motion */
+    sync_mesh_fluid_motion(result.b_ob, scene, result.mesh);
+
+    result.mesh->tag_update(scene, result.rebuild);
+  }
+
+  mesh_sync_results.clear();
 }
 
 void BlenderSync::sync_mesh_motion(BL::Depsgraph &b_depsgraph,
                                    BL::Object &b_ob,
                                    Object *object,
-                                   float motion_time)
+                                   float motion_time,
+                                   TaskPool *geometry_task_pool)
 {
   /* ensure we only sync instanced meshes once */
   Mesh *mesh = object->mesh;
@@ -1089,15 +1191,36 @@ void BlenderSync::sync_mesh_motion(BL::Depsgraph &b_depsgraph,
   if (!numverts && !numkeys)
     return;
 
-  /* skip objects without deforming modifiers. this is not totally reliable,
-   * would need a more extensive check to see which objects are animated */
-  BL::Mesh b_mesh(PointerRNA_NULL);
-
   /* fluid motion is exported immediate with mesh, skip here */
   BL::DomainFluidSettings b_fluid_domain = object_fluid_domain_find(b_ob);
   if (b_fluid_domain)
     return;
 
+  if (geometry_task_pool && b_ob.type() == BL::Object::type_MESH) {
+    geometry_task_object_add(geometry_task_pool, b_ob);
+    geometry_task_pool->push(function_bind(
+        &BlenderSync::sync_mesh_motion_data, this, b_depsgraph, b_ob, mesh, motion_step));
+  }
+  else {
+    sync_mesh_motion_data(b_depsgraph, b_ob, mesh, motion_step);
+  }
+}
+
+/* Export of deformation motion at one motion step. May run in a task, so it
+ * must only modify the mesh it exports. */
+void BlenderSync::sync_mesh_motion_data(BL::Depsgraph b_depsgraph,
+                                        BL::Object b_ob,
+                                        Mesh *mesh,
+                                        int motion_step)
+{
+  scoped_timer timer;
+  const size_t numverts = mesh->verts.size();
+  const size_t numkeys = mesh->curve_keys.size();
+
+  /* skip objects without deforming modifiers. this is not totally reliable,
+   * would need a more extensive check to see which objects are animated */
+  BL::Mesh b_mesh(PointerRNA_NULL);
+
   if (ccl::BKE_object_is_deform_modified(b_ob, b_scene, preview)) {
     /* get derived mesh */
     b_mesh = object_to_mesh(b_data, b_ob, b_depsgraph, false, Mesh::SUBDIVISION_NONE);
@@ -1131,6 +1254,7 @@ void BlenderSync::sync_mesh_motion(BL::Depsgraph &b_depsgraph,
       }
     }
 
+    geometry_sync_times.add(geometry_sync_times.motion, timer.get_time());
     return;
   }
 
@@ -1208,6 +1332,8 @@ void BlenderSync::sync_mesh_motion(BL::Depsgraph &b_depsgraph,
 
   /* free derived mesh */
   free_object_to_mesh(b_data, b_ob, b_mesh);
+
+  geometry_sync_times.add(geometry_sync_times.motion, timer.get_time());
 }
 
 CCL_NAMESPACE_END
@@ -32,6 +32,8 @@
 #include "util/util_foreach.h"
 #include "util/util_hash.h"
 #include "util/util_logging.h"
+#include "util/util_task.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -291,7 +293,8 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
                                  bool show_self,
                                  bool show_particles,
                                  BlenderObjectCulling &culling,
-                                 bool *use_portal)
+                                 bool *use_portal,
+                                 TaskPool *geometry_task_pool)
 {
   const bool is_instance = b_instance.is_instance();
   BL::Object b_ob = b_instance.object();
@@ -381,7 +384,7 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
 
       /* mesh deformation */
       if (object->mesh)
-        sync_mesh_motion(b_depsgraph, b_ob, object, motion_time);
+        sync_mesh_motion(b_depsgraph, b_ob, object, motion_time, geometry_task_pool);
     }
 
     return object;
@@ -394,8 +397,13 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
     object_updated = true;
 
   /* mesh sync */
-  object->mesh = sync_mesh(
-      b_depsgraph, b_ob, b_ob_instance, object_updated, show_self, show_particles);
+  object->mesh = sync_mesh(b_depsgraph,
+                           b_ob,
+                           b_ob_instance,
+                           object_updated,
+                           show_self,
+                           show_particles,
+                           geometry_task_pool);
 
   /* special case not tracked by object update flags */
 
@@ -522,6 +530,12 @@ void BlenderSync::sync_objects(BL::Depsgraph &b_depsgraph, float motion_time)
   /* initialize culling */
   BlenderObjectCulling culling(scene, b_scene);
 
+  /* mesh, curve and attribute export runs in tasks, the object loop itself
+   * stays serial since it modifies shared maps and scene data */
+  TaskPool geometry_task_pool;
+  scoped_timer timer;
+  geometry_sync_times.reset();
+
   /* object loop */
   bool cancel = false;
   bool use_portal = false;
@@ -551,12 +565,23 @@ void BlenderSync::sync_objects(BL::Depsgraph &b_depsgraph, float motion_time)
                   show_self,
                   show_particles,
                   culling,
-                  &use_portal);
+                  &use_portal,
+                  &geometry_task_pool);
     }
 
     cancel = progress.get_cancel();
   }
 
+  const double time_objects = timer.get_time();
+  geometry_task_pool.wait_work();
+  sync_mesh_finish();
+
+  VLOG(1) << "Synchronized objects" << (motion ? " motion" : "") << " in " << timer.get_time()
+          << " seconds (object loop " << time_objects << ", mesh " << geometry_sync_times.mesh
+          << ", attributes " << geometry_sync_times.attributes << ", curves "
+          << geometry_sync_times.curves << ", motion " << geometry_sync_times.motion
+          << " seconds summed over threads).";
+
   progress.set_sync_status("");
 
   if (!cancel && !motion) {
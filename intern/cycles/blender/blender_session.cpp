@@ -401,6 +401,20 @@ static void add_cryptomatte_layer(BL::RenderResult &b_rr, string name, string ma
   render_add_metadata(b_rr, prefix + "manifest", manifest);
 }
 
+static void add_profiling_metadata(BL::RenderResult &b_rr,
+                                   const string &prefix,
+                                   NamedSampleCountStats &stats)
+{
+  double avg_samples_per_hit;
+  foreach (const NamedSampleCountPair &entry, stats.sorted_entries(&avg_samples_per_hit)) {
+    const double seconds = entry.samples * 0.001;
+    const double relative = ((double)entry.samples) / (entry.hits * avg_samples_per_hit);
+    b_rr.stamp_data_add_field(
+        (prefix + entry.name.c_str()).c_str(),
+        string_printf("%.2fs (Relative cost: %.2f)", seconds, relative).c_str());
+  }
+}
+
 void BlenderSession::stamp_view_layer_metadata(Scene *scene, const string &view_layer_name)
 {
   BL::RenderResult b_rr = b_engine.get_result();
@@ -444,6 +458,14 @@ void BlenderSession::stamp_view_layer_metadata(Scene *scene, const string &view_
                             time_human_readable_from_seconds(render_time).c_str());
   b_rr.stamp_data_add_field((prefix + "synchronization_time").c_str(),
                             time_human_readable_from_seconds(total_time - render_time).c_str());
+
+  /* Store time spent per shader and object, sampled by the profiler. */
+  if (session->params.use_profiling) {
+    RenderStats stats;
+    session->collect_statistics(&stats);
+    add_profiling_metadata(b_rr, prefix + "shader_time.", stats.shaders);
+    add_profiling_metadata(b_rr, prefix + "object_time.", stats.objects);
+  }
 }
 
 void BlenderSession::render(BL::Depsgraph &b_depsgraph_)
@@ -38,6 +38,8 @@
 #include "util/util_foreach.h"
 #include "util/util_opengl.h"
 #include "util/util_hash.h"
+#include "util/util_logging.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -197,6 +199,8 @@ void BlenderSync::sync_data(BL::RenderSettings &b_render,
                             int height,
                             void **python_thread_state)
 {
+  scoped_timer timer;
+
   BL::ViewLayer b_view_layer = b_depsgraph.view_layer_eval();
 
   sync_view_layer(b_v3d, b_view_layer);
@@ -206,6 +210,8 @@ void BlenderSync::sync_data(BL::RenderSettings &b_render,
   sync_images();
   sync_curve_settings();
 
+  const double time_settings = timer.get_time();
+
   mesh_synced.clear(); /* use for objects and motion sync */
 
   if (scene->need_motion() == Scene::MOTION_PASS || scene->need_motion() == Scene::MOTION_NONE ||
@@ -216,7 +222,12 @@ void BlenderSync::sync_data(BL::RenderSettings &b_render,
 
   mesh_synced.clear();
 
+  const double time_objects = timer.get_time() - time_settings;
+
   free_data_after_sync(b_depsgraph);
+
+  VLOG(1) << "Synchronized data in " << timer.get_time() << " seconds (settings and shaders "
+          << time_settings << ", objects and motion " << time_objects << " seconds).";
 }
 
 /* Integrator */
@@ -279,6 +290,11 @@ void BlenderSync::sync_integrator()
   integrator->sample_all_lights_direct = get_boolean(cscene, "sample_all_lights_direct");
   integrator->sample_all_lights_indirect = get_boolean(cscene, "sample_all_lights_indirect");
   integrator->light_sampling_threshold = get_float(cscene, "light_sampling_threshold");
+  integrator->use_light_tree = get_boolean(cscene, "use_light_tree");
+
+  integrator->use_adaptive_sampling = get_boolean(cscene, "use_adaptive_sampling");
+  integrator->adaptive_threshold = get_float(cscene, "adaptive_threshold");
+  integrator->adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
 
   int diffuse_samples = get_int(cscene, "diffuse_samples");
   int glossy_samples = get_int(cscene, "glossy_samples");
@@ -321,6 +337,14 @@ void BlenderSync::sync_integrator()
 
   if (integrator->modified(previntegrator))
     integrator->tag_update(scene);
+
+  /* Light tree is built along with the light distribution. */
+  if (integrator->use_light_tree != previntegrator.use_light_tree ||
+      integrator->method != previntegrator.method ||
+      integrator->sample_all_lights_direct != previntegrator.sample_all_lights_direct ||
+      integrator->sample_all_lights_indirect != previntegrator.sample_all_lights_indirect) {
+    scene->light_manager->tag_update(scene);
+  }
 }
 
 /* Film */
@@ -518,6 +542,13 @@ vector<Pass> BlenderSync::sync_render_passes(BL::RenderLayer &b_rlay, BL::ViewLa
       Pass::add(pass_type, passes);
   }
 
+  /* Adaptive sampling keeps an error estimate and sample count per pixel. */
+  PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
+  if (get_boolean(cscene, "use_adaptive_sampling")) {
+    Pass::add(PASS_ADAPTIVE_AUX_BUFFER, passes);
+    Pass::add(PASS_SAMPLE_COUNT, passes);
+  }
+
   PointerRNA crp = RNA_pointer_get(&b_view_layer.ptr, "cycles");
   bool full_denoising = get_boolean(crp, "use_denoising");
   bool write_denoising_passes = get_boolean(crp, "denoising_store_passes");
@@ -663,6 +694,7 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene, bool background)
 
   params.use_bvh_spatial_split = RNA_boolean_get(&cscene, "debug_use_spatial_splits");
   params.use_bvh_unaligned_nodes = RNA_boolean_get(&cscene, "debug_use_hair_bvh");
+  params.use_bvh_compressed_nodes = RNA_boolean_get(&cscene, "debug_use_compressed_bvh");
   params.num_bvh_time_steps = RNA_int_get(&cscene, "debug_bvh_time_steps");
 
   if (background && params.shadingsystem != SHADINGSYSTEM_OSL)
@@ -684,6 +716,15 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene, bool background)
     params.texture_limit = 0;
   }
 
+  if (RNA_boolean_get(&cscene, "use_texture_cache")) {
+    params.texture_cache_size = RNA_int_get(&cscene, "texture_cache_size");
+  }
+  else {
+    params.texture_cache_size = 0;
+  }
+
+  params.use_sparse_grids = RNA_boolean_get(&cscene, "use_sparse_volumes");
+
   /* TODO(sergey): Once OSL supports per-microarchitecture optimization get
    * rid of this.
    */
@@ -805,6 +846,9 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine &b_engine,
                                get_boolean(cscene, "use_progressive_refine")) &&
                               !b_r.use_save_buffers();
 
+  /* Save buffers require render results to match the Blender tiles exactly. */
+  params.split_tiles = !b_r.use_save_buffers();
+
   if (params.progressive_refine) {
     BL::Scene::view_layers_iterator b_view_layer;
     for (b_scene.view_layers.begin(b_view_layer); b_view_layer != b_scene.view_layers.end();
@@ -846,8 +890,19 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine &b_engine,
     params.progressive_update_timeout = 0.1;
   }
 
+  /* The render time pass also stores the time spent per shader and object in the metadata. */
+  bool use_render_time_pass = false;
+  BL::Scene::view_layers_iterator b_view_layer;
+  for (b_scene.view_layers.begin(b_view_layer); b_view_layer != b_scene.view_layers.end();
+       ++b_view_layer) {
+    PointerRNA crl = RNA_pointer_get(&b_view_layer->ptr, "cycles");
+    if (get_boolean(crl, "pass_debug_render_time")) {
+      use_render_time_pass = true;
+    }
+  }
+
   params.use_profiling = params.device.has_profiling && !b_engine.is_preview() && background &&
-                         BlenderSession::print_render_stats;
+                         (BlenderSession::print_render_stats || use_render_time_pass);
 
   return params;
 }
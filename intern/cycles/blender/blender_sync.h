@@ -27,8 +27,10 @@
 #include "render/scene.h"
 #include "render/session.h"
 
+#include "util/util_list.h"
 #include "util/util_map.h"
 #include "util/util_set.h"
+#include "util/util_thread.h"
 #include "util/util_transform.h"
 #include "util/util_vector.h"
 
@@ -47,6 +49,7 @@ class ViewLayer;
 class Shader;
 class ShaderGraph;
 class ShaderNode;
+class TaskPool;
 
 class BlenderSync {
  public:
@@ -125,7 +128,18 @@ class BlenderSync {
                   BL::Object &b_ob_instance,
                   bool object_updated,
                   bool show_self,
-                  bool show_particles);
+                  bool show_particles,
+                  TaskPool *geometry_task_pool = NULL);
+  struct MeshSyncResult;
+  void sync_mesh_data(BL::Depsgraph b_depsgraph,
+                      BL::Object b_ob,
+                      BL::Mesh b_mesh,
+                      int requested_geometry_flags,
+                      bool convert_mesh,
+                      bool show_self,
+                      bool show_particles,
+                      MeshSyncResult *result);
+  void sync_mesh_finish();
   void sync_curves(
       Mesh *mesh, BL::Mesh &b_mesh, BL::Object &b_ob, bool motion, int motion_step = 0);
   Object *sync_object(BL::Depsgraph &b_depsgraph,
@@ -135,7 +149,8 @@ class BlenderSync {
                       bool show_self,
                       bool show_particles,
                       BlenderObjectCulling &culling,
-                      bool *use_portal);
+                      bool *use_portal,
+                      TaskPool *geometry_task_pool);
   void sync_light(BL::Object &b_parent,
                   int persistent_id[OBJECT_PERSISTENT_ID_SIZE],
                   BL::Object &b_ob,
@@ -147,7 +162,13 @@ class BlenderSync {
   void sync_mesh_motion(BL::Depsgraph &b_depsgraph,
                         BL::Object &b_ob,
                         Object *object,
-                        float motion_time);
+                        float motion_time,
+                        TaskPool *geometry_task_pool = NULL);
+  void sync_mesh_motion_data(BL::Depsgraph b_depsgraph,
+                             BL::Object b_ob,
+                             Mesh *mesh,
+                             int motion_step);
+  void geometry_task_object_add(TaskPool *geometry_task_pool, BL::Object &b_ob);
   void sync_camera_motion(
       BL::RenderSettings &b_render, BL::Object &b_ob, int width, int height, float motion_time);
 
@@ -180,6 +201,45 @@ class BlenderSync {
   id_map<ParticleSystemKey, ParticleSystem> particle_system_map;
   set<Mesh *> mesh_synced;
   set<Mesh *> mesh_motion_synced;
+
+  /* Meshes exported by geometry tasks, finished once the tasks are done. */
+  struct MeshSyncResult {
+    MeshSyncResult(Mesh *mesh, BL::Object &b_ob) : mesh(mesh), b_ob(b_ob), rebuild(false)
+    {
+    }
+
+    Mesh *mesh;
+    BL::Object b_ob;
+    bool rebuild;
+  };
+  list<MeshSyncResult> mesh_sync_results;
+  /* Blender objects with a pending geometry task. */
+  set<void *> geometry_task_objects;
+
+  /* Time spent in geometry export stages, summed over all threads. */
+  struct GeometrySyncTimes {
+    GeometrySyncTimes()
+    {
+      reset();
+    }
+
+    void reset()
+    {
+      mesh = attributes = curves = motion = 0.0;
+    }
+
+    void add(double &stage, double time)
+    {
+      thread_scoped_lock lock(mutex);
+      stage += time;
+    }
+
+    thread_mutex mutex;
+    double mesh;
+    double attributes;
+    double curves;
+    double motion;
+  } geometry_sync_times;
   set<float> motion_times;
   void *world_map;
   bool world_recalc;
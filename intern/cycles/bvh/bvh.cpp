@@ -91,7 +91,7 @@ int BVHStackEntry::encodeIdx() const
 /* BVH */
 
 BVH::BVH(const BVHParams &params_, const vector<Object *> &objects_)
-    : params(params_), objects(objects_)
+    : params(params_), objects(objects_), top_level_nodes_size(0), top_level_leaf_nodes_size(0)
 {
 }
 
@@ -174,12 +174,31 @@ void BVH::build(Progress &progress, Stats *)
 
 void BVH::refit(Progress &progress)
 {
+  if (params.top_level) {
+    /* Strip instance BVH's merged by the previous build, they may have been
+     * refit or rebuilt since and are merged again after packing. */
+    const size_t num_prims = top_level_prim_index.size();
+    pack.prim_index = top_level_prim_index;
+    pack.prim_type.resize(num_prims);
+    pack.prim_object.resize(num_prims);
+    if (pack.prim_time.size()) {
+      pack.prim_time.resize(num_prims);
+    }
+    pack.nodes.resize(top_level_nodes_size);
+    pack.leaf_nodes.resize(top_level_leaf_nodes_size);
+  }
+
   progress.set_substatus("Packing BVH primitives");
   pack_primitives();
 
   if (progress.get_cancel())
     return;
 
+  if (params.top_level) {
+    progress.set_substatus("Packing BVH instances");
+    pack_instances(top_level_nodes_size, top_level_leaf_nodes_size);
+  }
+
   progress.set_substatus("Refitting BVH nodes");
   refit_nodes();
 }
@@ -327,6 +346,10 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
   const bool use_qbvh = (params.bvh_layout == BVH_LAYOUT_BVH4);
   const bool use_obvh = (params.bvh_layout == BVH_LAYOUT_BVH8);
 
+  top_level_prim_index = pack.prim_index;
+  top_level_nodes_size = nodes_size;
+  top_level_leaf_nodes_size = leaf_nodes_size;
+
   /* Adjust primitive index to point to the triangle in the global array, for
    * meshes with transform applied and already in the top level BVH.
    */
@@ -510,8 +533,8 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
         }
         else {
           if (use_obvh) {
-            nsize = BVH_ONODE_SIZE;
-            nsize_bbox = BVH_ONODE_SIZE - 1;
+            nsize = (params.use_compressed_nodes) ? BVH_ONODE_COMPRESSED_SIZE : BVH_ONODE_SIZE;
+            nsize_bbox = nsize - 1;
           }
           else {
             nsize = (use_qbvh) ? BVH_QNODE_SIZE : BVH_NODE_SIZE;
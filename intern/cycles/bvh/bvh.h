@@ -104,6 +104,12 @@ class BVH {
   /* merge instance BVH's */
   void pack_instances(size_t nodes_size, size_t leaf_nodes_size);
 
+  /* Top level BVH data before instances were merged into it, so refitting
+   * can merge them again. */
+  array<int> top_level_prim_index;
+  size_t top_level_nodes_size;
+  size_t top_level_leaf_nodes_size;
+
   /* for subclasses to implement */
   virtual void pack_nodes(const BVHNode *root) = 0;
   virtual void refit_nodes() = 0;
@@ -234,8 +234,6 @@ void BVH2::pack_nodes(const BVHNode *root)
 
 void BVH2::refit_nodes()
 {
-  assert(!params.top_level);
-
   BoundBox bbox = BoundBox::empty;
   uint visibility = 0;
   refit_node(0, (pack.root_index == -1) ? true : false, bbox, visibility);
@@ -373,8 +373,6 @@ void BVH4::pack_nodes(const BVHNode *root)
 
 void BVH4::refit_nodes()
 {
-  assert(!params.top_level);
-
   BoundBox bbox = BoundBox::empty;
   uint visibility = 0;
   refit_node(0, (pack.root_index == -1) ? true : false, bbox, visibility);
@@ -196,6 +196,11 @@ void BVH8::pack_aligned_node(int idx,
                              const float time_to,
                              const int num)
 {
+  if (params.use_compressed_nodes) {
+    pack_compressed_node(idx, bounds, child, visibility, time_from, time_to, num);
+    return;
+  }
+
   float8 data[8];
   memset(data, 0, sizeof(data));
 
@@ -236,6 +241,101 @@ void BVH8::pack_aligned_node(int idx,
   memcpy(&pack.nodes[idx], data, sizeof(float4) * BVH_ONODE_SIZE);
 }
 
+/* Decode quantized bound the same way as the kernel does, both with and
+ * without fused multiply-add, so the stored bounds are conservative for
+ * either of them. */
+static void obvh_quantized_bound(int q, float origin, float scale, float *lower, float *upper)
+{
+  const float fused = fmaf((float)q, scale, origin);
+  const float unfused = (float)q * scale + origin;
+  *lower = min(fused, unfused);
+  *upper = max(fused, unfused);
+}
+
+void BVH8::pack_compressed_node(int idx,
+                                const BoundBox *bounds,
+                                const int *child,
+                                const uint visibility,
+                                const float time_from,
+                                const float time_to,
+                                const int num)
+{
+  float4 data[BVH_ONODE_COMPRESSED_SIZE];
+  memset(data, 0, sizeof(data));
+
+  data[0].x = __uint_as_float(visibility & ~PATH_RAY_NODE_UNALIGNED);
+  data[0].y = time_from;
+  data[0].z = time_to;
+
+  /* Children bounds are quantized to 8 bits on a grid spanning the node. */
+  BoundBox node_bounds = BoundBox::empty;
+  for (int i = 0; i < num; i++) {
+    if (bounds[i].valid()) {
+      node_bounds.grow(bounds[i]);
+    }
+  }
+
+  float origin[3] = {0.0f, 0.0f, 0.0f};
+  float scale[3] = {1.0f, 1.0f, 1.0f};
+  if (node_bounds.valid()) {
+    for (int axis = 0; axis < 3; axis++) {
+      const float lo = node_bounds.min[axis];
+      const float hi = node_bounds.max[axis];
+      /* Slightly enlarge the grid so the top grid line is not below the
+       * node bounds after rounding. */
+      origin[axis] = lo;
+      scale[axis] = (hi - lo) * (1.0f / 255.0f) * (1.0f + 1e-5f) +
+                    max(fabsf(lo), fabsf(hi)) * FLT_EPSILON + 1e-30f;
+    }
+  }
+
+  uchar *quantized = (uchar *)&data[3];
+  int *children = (int *)&data[6];
+
+  for (int i = 0; i < 8; i++) {
+    if (i >= num || !bounds[i].valid() || !node_bounds.valid()) {
+      /* Inverted bounds which are never recorded as intersection. */
+      for (int axis = 0; axis < 3; axis++) {
+        quantized[(axis * 2 + 0) * 8 + i] = 255;
+        quantized[(axis * 2 + 1) * 8 + i] = 0;
+      }
+      children[i] = (i < num) ? child[i] : 0;
+      continue;
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+      const float bb_min = bounds[i].min[axis];
+      const float bb_max = bounds[i].max[axis];
+      float lower, upper;
+
+      /* Round outwards, then correct for floating point error. */
+      int q_min = clamp((int)floorf((bb_min - origin[axis]) / scale[axis]), 0, 255);
+      obvh_quantized_bound(q_min, origin[axis], scale[axis], &lower, &upper);
+      while (q_min > 0 && upper > bb_min) {
+        q_min--;
+        obvh_quantized_bound(q_min, origin[axis], scale[axis], &lower, &upper);
+      }
+
+      int q_max = clamp((int)ceilf((bb_max - origin[axis]) / scale[axis]), 0, 255);
+      obvh_quantized_bound(q_max, origin[axis], scale[axis], &lower, &upper);
+      while (q_max < 255 && lower < bb_max) {
+        q_max++;
+        obvh_quantized_bound(q_max, origin[axis], scale[axis], &lower, &upper);
+      }
+
+      quantized[(axis * 2 + 0) * 8 + i] = (uchar)q_min;
+      quantized[(axis * 2 + 1) * 8 + i] = (uchar)q_max;
+    }
+
+    children[i] = child[i];
+  }
+
+  data[1] = make_float4(origin[0], origin[1], origin[2], 0.0f);
+  data[2] = make_float4(scale[0], scale[1], scale[2], 0.0f);
+
+  memcpy(&pack.nodes[idx], data, sizeof(float4) * BVH_ONODE_COMPRESSED_SIZE);
+}
+
 void BVH8::pack_unaligned_inner(const BVHStackEntry &e, const BVHStackEntry *en, int num)
 {
   Transform aligned_space[8];
@@ -330,14 +430,16 @@ void BVH8::pack_nodes(const BVHNode *root)
   const size_t num_leaf_nodes = root->getSubtreeSize(BVH_STAT_LEAF_COUNT);
   assert(num_leaf_nodes <= num_nodes);
   const size_t num_inner_nodes = num_nodes - num_leaf_nodes;
+  const size_t aligned_node_size = (params.use_compressed_nodes) ? BVH_ONODE_COMPRESSED_SIZE :
+                                                                   BVH_ONODE_SIZE;
   size_t node_size;
   if (params.use_unaligned_nodes) {
     const size_t num_unaligned_nodes = root->getSubtreeSize(BVH_STAT_UNALIGNED_INNER_COUNT);
     node_size = (num_unaligned_nodes * BVH_UNALIGNED_ONODE_SIZE) +
-                (num_inner_nodes - num_unaligned_nodes) * BVH_ONODE_SIZE;
+                (num_inner_nodes - num_unaligned_nodes) * aligned_node_size;
   }
   else {
-    node_size = num_inner_nodes * BVH_ONODE_SIZE;
+    node_size = num_inner_nodes * aligned_node_size;
   }
   /* Resize arrays. */
   pack.nodes.clear();
@@ -360,7 +462,7 @@ void BVH8::pack_nodes(const BVHNode *root)
   }
   else {
     stack.push_back(BVHStackEntry(root, nextNodeIdx));
-    nextNodeIdx += root->has_unaligned() ? BVH_UNALIGNED_ONODE_SIZE : BVH_ONODE_SIZE;
+    nextNodeIdx += root->has_unaligned() ? BVH_UNALIGNED_ONODE_SIZE : aligned_node_size;
   }
 
   while (stack.size()) {
@@ -386,7 +488,8 @@ void BVH8::pack_nodes(const BVHNode *root)
         }
         else {
           idx = nextNodeIdx;
-          nextNodeIdx += children[i]->has_unaligned() ? BVH_UNALIGNED_ONODE_SIZE : BVH_ONODE_SIZE;
+          nextNodeIdx += children[i]->has_unaligned() ? BVH_UNALIGNED_ONODE_SIZE :
+                                                        aligned_node_size;
         }
         stack.push_back(BVHStackEntry(children[i], idx));
       }
@@ -402,8 +505,6 @@ void BVH8::pack_nodes(const BVHNode *root)
 
 void BVH8::refit_nodes()
 {
-  assert(!params.top_level);
-
   BoundBox bbox = BoundBox::empty;
   uint visibility = 0;
   refit_node(0, (pack.root_index == -1) ? true : false, bbox, visibility);
@@ -505,7 +606,12 @@ void BVH8::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     int num_nodes = 0;
 
     for (int i = 0; i < 8; ++i) {
-      child[i] = __float_as_int(data[(is_unaligned) ? 13 : 7][i]);
+      if (is_unaligned) {
+        child[i] = __float_as_int(data[13][i]);
+      }
+      else {
+        child[i] = __float_as_int(data[(params.use_compressed_nodes) ? 3 : 7][i]);
+      }
 
       if (child[i] != 0) {
         refit_node((child[i] < 0) ? -child[i] - 1 : child[i],
@@ -77,6 +77,12 @@ class BVHParams {
    */
   bool use_unaligned_nodes;
 
+  /* Store child bounds of aligned nodes quantized relative to the node
+   * bounds, to reduce memory usage and bandwidth.
+   * Only used for BVH8 layout.
+   */
+  bool use_compressed_nodes;
+
   /* Split time range to this number of steps and create leaf node for each
    * of this time steps.
    *
@@ -119,6 +125,7 @@ class BVHParams {
     top_level = false;
     bvh_layout = BVH_LAYOUT_BVH2;
     use_unaligned_nodes = false;
+    use_compressed_nodes = false;
 
     primitive_mask = PRIMITIVE_ALL;
 
@@ -34,6 +34,7 @@
 #include "kernel/kernel_types.h"
 #include "kernel/split/kernel_split_data.h"
 #include "kernel/kernel_globals.h"
+#include "kernel/kernel_adaptive_sampling.h"
 
 #include "kernel/filter/filter.h"
 
@@ -53,6 +54,7 @@
 #include "util/util_progress.h"
 #include "util/util_system.h"
 #include "util/util_thread.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -132,6 +134,12 @@ template<typename F> class KernelFunctions {
   F kernel;
 };
 
+/* Number of paths each thread traces together in the split kernel. Every
+ * kernel stage runs over the whole wavefront before the next, so paths are
+ * batched by state, and sorted by shader before shader evaluation. */
+#define CPU_WAVEFRONT_SIZE_X 32
+#define CPU_WAVEFRONT_SIZE_Y 32
+
 class CPUSplitKernel : public DeviceSplitKernel {
   CPUDevice *device;
 
@@ -284,9 +292,12 @@ class CPUDevice : public Device {
 #ifdef WITH_OSL
     kernel_globals.osl = &osl_globals;
 #endif
-    use_split_kernel = DebugFlags().cpu.split_kernel;
+    use_split_kernel = info.use_split_kernel || DebugFlags().cpu.split_kernel;
     if (use_split_kernel) {
-      VLOG(1) << "Will be using split kernel.";
+      VLOG(1) << "Will be using split kernel, with " << CPU_WAVEFRONT_SIZE_X * CPU_WAVEFRONT_SIZE_Y
+              << " paths per thread.";
+      /* Split kernels don't count samples per pixel or stop converged pixels. */
+      info.has_adaptive_stop_per_sample = false;
     }
     need_texture_info = false;
 
@@ -465,13 +476,16 @@ class CPUDevice : public Device {
       }
 
       TextureInfo &info = texture_info[flat_slot];
-      info.data = (uint64_t)mem.host_pointer;
+      info.data = (mem.texture_cache_image) ? (uint64_t)mem.texture_cache_image :
+                                               (uint64_t)mem.host_pointer;
       info.cl_buffer = 0;
       info.interpolation = mem.interpolation;
       info.extension = mem.extension;
       info.width = mem.data_width;
       info.height = mem.data_height;
       info.depth = mem.data_depth;
+      info.use_texture_cache = (mem.texture_cache_image != NULL);
+      info.use_sparse_grid = mem.is_sparse_grid;
 
       need_texture_info = true;
     }
@@ -813,12 +827,63 @@ class CPUDevice : public Device {
     return true;
   }
 
+  /* Test pixels of the tile for convergence, returns true when all converged. */
+  bool adaptive_sampling_filter(KernelGlobals *kg, RenderTile &tile)
+  {
+    WorkTile wtile;
+    wtile.x = tile.x;
+    wtile.y = tile.y;
+    wtile.w = tile.w;
+    wtile.h = tile.h;
+    wtile.offset = tile.offset;
+    wtile.stride = tile.stride;
+    wtile.buffer = (float *)tile.buffer;
+
+    for (int y = tile.y; y < tile.y + tile.h; y++) {
+      for (int x = tile.x; x < tile.x + tile.w; x++) {
+        const int index = tile.offset + x + y * tile.stride;
+        float *buffer = wtile.buffer + index * kernel_data.film.pass_stride;
+        if (!kernel_adaptive_pixel_converged(kg, buffer)) {
+          kernel_adaptive_stopping(kg, buffer);
+        }
+      }
+    }
+
+    bool any = false;
+    for (int y = tile.y; y < tile.y + tile.h; y++) {
+      any |= kernel_adaptive_filter_x(kg, y, &wtile);
+    }
+    for (int x = tile.x; x < tile.x + tile.w; x++) {
+      any |= kernel_adaptive_filter_y(kg, x, &wtile);
+    }
+    return !any;
+  }
+
+  /* Scale pixels that stopped early to the sample count of the tile. */
+  void adaptive_sampling_post(KernelGlobals *kg, RenderTile &tile)
+  {
+    float *render_buffer = (float *)tile.buffer;
+    for (int y = tile.y; y < tile.y + tile.h; y++) {
+      for (int x = tile.x; x < tile.x + tile.w; x++) {
+        const int index = tile.offset + x + y * tile.stride;
+        float *buffer = render_buffer + index * kernel_data.film.pass_stride;
+        kernel_adaptive_post_adjust(kg, buffer, (float)tile.sample);
+      }
+    }
+  }
+
   void path_trace(DeviceTask &task, RenderTile &tile, KernelGlobals *kg)
   {
     const bool use_coverage = kernel_data.film.cryptomatte_passes & CRYPT_ACCURATE;
+    const int pass_render_time = kernel_data.film.pass_render_time;
+    const int pass_stride = kernel_data.film.pass_stride;
 
     scoped_timer timer(&tile.buffers->render_time);
 
+    if (pass_render_time) {
+      tile.buffers->use_pixel_render_time = true;
+    }
+
     Coverage coverage(kg, tile);
     if (use_coverage) {
       coverage.init_path_trace();
@@ -842,17 +907,37 @@ class CPUDevice : public Device {
           if (use_coverage) {
             coverage.init_pixel(x, y);
           }
+          const double pixel_start_time = (pass_render_time) ? time_dt() : 0.0;
+
           path_trace_kernel()(kg, render_buffer, sample, x, y, tile.offset, tile.stride);
+
+          if (pass_render_time) {
+            const int index = tile.offset + x + y * tile.stride;
+            float *buffer = render_buffer + index * pass_stride;
+            buffer[pass_render_time] += (float)(time_dt() - pixel_start_time);
+          }
         }
       }
 
       tile.sample = sample + 1;
 
+      if (task.adaptive_sampling.use && task.adaptive_sampling.need_filter(sample)) {
+        if (adaptive_sampling_filter(kg, tile)) {
+          /* All pixels converged, count the remaining samples as done. */
+          tile.sample = end_sample;
+          task.update_progress(&tile, tile.w * tile.h * (end_sample - sample));
+          break;
+        }
+      }
+
       task.update_progress(&tile, tile.w * tile.h);
     }
     if (use_coverage) {
       coverage.finalize();
     }
+    if (task.adaptive_sampling.use) {
+      adaptive_sampling_post(kg, tile);
+    }
   }
 
   void denoise(DenoisingTask &denoising, RenderTile &tile)
@@ -1196,7 +1281,7 @@ int2 CPUSplitKernel::split_kernel_global_size(device_memory & /*kg*/,
                                               device_memory & /*data*/,
                                               DeviceTask * /*task*/)
 {
-  return make_int2(1, 1);
+  return make_int2(CPU_WAVEFRONT_SIZE_X, CPU_WAVEFRONT_SIZE_Y);
 }
 
 uint64_t CPUSplitKernel::state_buffer_size(device_memory &kernel_globals,
@@ -1225,6 +1310,7 @@ void device_cpu_info(vector<DeviceInfo> &devices)
   info.has_osl = true;
   info.has_half_images = true;
   info.has_profiling = true;
+  info.has_adaptive_stop_per_sample = true;
 
   devices.insert(devices.begin(), info);
 }
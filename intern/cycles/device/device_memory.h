@@ -30,6 +30,7 @@
 CCL_NAMESPACE_BEGIN
 
 class Device;
+struct TextureCacheImage;
 
 enum MemoryType { MEM_READ_ONLY, MEM_READ_WRITE, MEM_DEVICE_ONLY, MEM_TEXTURE, MEM_PIXELS };
 
@@ -210,6 +211,10 @@ class device_memory {
   const char *name;
   InterpolationType interpolation;
   ExtensionType extension;
+  /* Image texture pixels are looked up in the texture cache instead. */
+  TextureCacheImage *texture_cache_image;
+  /* 3D texture voxels are stored in sparse tiles, see util_sparse_grid.h. */
+  bool is_sparse_grid;
 
   /* Pointers. */
   Device *device;
@@ -343,10 +348,25 @@ template<typename T> class device_vector : public device_memory {
     data_width = width;
     data_height = height;
     data_depth = depth;
+    is_sparse_grid = false;
 
     return data();
   }
 
+  /* Host memory allocation for a sparse grid of the given dimensions, storing
+   * only num voxels. */
+  T *alloc_sparse_grid(size_t num, size_t width, size_t height, size_t depth)
+  {
+    T *grid = alloc(num);
+
+    data_width = width;
+    data_height = height;
+    data_depth = depth;
+    is_sparse_grid = true;
+
+    return grid;
+  }
+
   /* Host memory resize. Only use this if the original data needs to be
    * preserved, it is faster to call alloc() if it can be discarded. */
   T *resize(size_t width, size_t height = 0, size_t depth = 0)
@@ -399,6 +419,7 @@ template<typename T> class device_vector : public device_memory {
     data_width = 0;
     data_height = 0;
     data_depth = 0;
+    is_sparse_grid = false;
     host_pointer = 0;
     assert(device_pointer == 0);
   }
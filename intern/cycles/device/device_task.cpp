@@ -136,4 +136,15 @@ void DeviceTask::update_progress(RenderTile *rtile, int pixel_samples)
   }
 }
 
+/* Adaptive Sampling */
+
+AdaptiveSampling::AdaptiveSampling() : use(false), adaptive_step(0), min_samples(0)
+{
+}
+
+bool AdaptiveSampling::need_filter(int sample) const
+{
+  return (sample + 1) >= min_samples && ((sample + 1) % adaptive_step) == 0;
+}
+
 CCL_NAMESPACE_END
@@ -230,6 +230,67 @@ ccl_device_inline void obvh_stack_sort(OBVHStackItem *ccl_restrict s1,
   }
 }
 
+/* Compressed axis-aligned nodes intersection
+ *
+ * Child bounds are stored as 8 bit integers relative to the node bounds, in
+ * the same order as the aligned node: minimum and maximum for each axis. */
+
+#ifdef __KERNEL_AVX2__
+ccl_device_inline avxf obvh_compressed_node_bounds(const uchar *ccl_restrict bounds,
+                                                   const float origin,
+                                                   const float scale)
+{
+  const __m256 quantized = _mm256_cvtepi32_ps(
+      _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)bounds)));
+  return madd(avxf(quantized), avxf(scale), avxf(origin));
+}
+
+ccl_device_inline int obvh_compressed_node_intersect(KernelGlobals *ccl_restrict kg,
+                                                     const avxf &isect_near,
+                                                     const avxf &isect_far,
+                                                     const avx3f &org_idir,
+                                                     const avx3f &idir,
+                                                     const int near_x,
+                                                     const int near_y,
+                                                     const int near_z,
+                                                     const int far_x,
+                                                     const int far_y,
+                                                     const int far_z,
+                                                     const int node_addr,
+                                                     avxf *ccl_restrict dist)
+{
+  const float4 origin = kernel_tex_fetch(__bvh_nodes, node_addr + 1);
+  const float4 scale = kernel_tex_fetch(__bvh_nodes, node_addr + 2);
+  const uchar *bounds = (const uchar *)&kernel_tex_array(__bvh_nodes)[node_addr + 3];
+
+  const avxf tnear_x = msub(
+      obvh_compressed_node_bounds(bounds + near_x * 8, origin.x, scale.x), idir.x, org_idir.x);
+  const avxf tnear_y = msub(
+      obvh_compressed_node_bounds(bounds + near_y * 8, origin.y, scale.y), idir.y, org_idir.y);
+  const avxf tnear_z = msub(
+      obvh_compressed_node_bounds(bounds + near_z * 8, origin.z, scale.z), idir.z, org_idir.z);
+  const avxf tfar_x = msub(
+      obvh_compressed_node_bounds(bounds + far_x * 8, origin.x, scale.x), idir.x, org_idir.x);
+  const avxf tfar_y = msub(
+      obvh_compressed_node_bounds(bounds + far_y * 8, origin.y, scale.y), idir.y, org_idir.y);
+  const avxf tfar_z = msub(
+      obvh_compressed_node_bounds(bounds + far_z * 8, origin.z, scale.z), idir.z, org_idir.z);
+
+  const avxf tnear = max4(tnear_x, tnear_y, tnear_z, isect_near);
+  const avxf tfar = min4(tfar_x, tfar_y, tfar_z, isect_far);
+  const avxb vmask = tnear <= tfar;
+  int mask = (int)movemask(vmask);
+  *dist = tnear;
+  return mask;
+}
+#endif
+
+/* Offset of the child node indices in an aligned node. */
+ccl_device_inline int obvh_aligned_node_children_offset(KernelGlobals *ccl_restrict kg)
+{
+  return (kernel_data.bvh.use_compressed_nodes) ? 6 : 14;
+}
+
 /* Axis-aligned nodes intersection */
 
 ccl_device_inline int obvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg,
@@ -252,6 +313,22 @@ ccl_device_inline int obvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg
 {
   const int offset = node_addr + 2;
 #ifdef __KERNEL_AVX2__
+  if (kernel_data.bvh.use_compressed_nodes) {
+    return obvh_compressed_node_intersect(kg,
+                                          isect_near,
+                                          isect_far,
+                                          org_idir,
+                                          idir,
+                                          near_x,
+                                          near_y,
+                                          near_z,
+                                          far_x,
+                                          far_y,
+                                          far_z,
+                                          node_addr,
+                                          dist);
+  }
+
   const avxf tnear_x = msub(
       kernel_tex_fetch_avxf(__bvh_nodes, offset + near_x * 2), idir.x, org_idir.x);
   const avxf tnear_y = msub(
@@ -128,7 +128,8 @@ ccl_device uint BVH_FUNCTION_FULL_NAME(OBVH)(KernelGlobals *kg,
           else
 #endif
           {
-            cnodes = kernel_tex_fetch_avxf(__bvh_nodes, node_addr + 14);
+            cnodes = kernel_tex_fetch_avxf(__bvh_nodes,
+                                           node_addr + obvh_aligned_node_children_offset(kg));
           }
 
           /* One child is hit, continue with that child. */
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_ADAPTIVE_SAMPLING_H__
+#define __KERNEL_ADAPTIVE_SAMPLING_H__
+
+CCL_NAMESPACE_BEGIN
+
+/* Adaptive Sampling
+ *
+ * Besides the combined pass, every other sample is accumulated at twice its
+ * weight into an auxiliary buffer. Both are estimates of the same pixel value,
+ * their difference is used as error estimate to stop sampling pixels that have
+ * converged. The fourth component of the auxiliary buffer marks converged
+ * pixels, the sample count pass holds the number of samples each pixel took.
+ *
+ * Based on "A hierarchical automatic stopping condition for Monte Carlo global
+ * illumination", Dammertz et al., 2010. */
+
+ccl_device_inline bool kernel_adaptive_pixel_converged(KernelGlobals *kg,
+                                                       ccl_global float *buffer)
+{
+  return buffer[kernel_data.film.pass_adaptive_aux_buffer + 3] > 0.0f;
+}
+
+/* Mark the pixel as converged when the error estimate drops below the threshold. */
+ccl_device void kernel_adaptive_stopping(KernelGlobals *kg, ccl_global float *buffer)
+{
+  const float num_samples = buffer[kernel_data.film.pass_sample_count];
+  if (num_samples == 0.0f) {
+    return;
+  }
+
+  const float inv_num_samples = 1.0f / num_samples;
+  const ccl_global float *combined = buffer + kernel_data.film.pass_combined;
+  const ccl_global float *aux = buffer + kernel_data.film.pass_adaptive_aux_buffer;
+
+  const float3 I = make_float3(combined[0], combined[1], combined[2]) * inv_num_samples;
+  const float3 A = make_float3(aux[0], aux[1], aux[2]) * inv_num_samples;
+
+  /* Difference relative to the square root of the intensity, so noise in dark
+   * areas is weighted more like it is perceived. The epsilon avoids division
+   * by zero for black pixels. */
+  const float error = (fabsf(I.x - A.x) + fabsf(I.y - A.y) + fabsf(I.z - A.z)) /
+                      sqrtf(max(I.x + I.y + I.z, 1e-4f));
+
+  if (error < kernel_data.integrator.adaptive_threshold) {
+    buffer[kernel_data.film.pass_adaptive_aux_buffer + 3] = 1.0f;
+  }
+}
+
+/* Let neighbors of pixels that are not converged take more samples too, as a
+ * box filter in two passes. Returns true if any pixel in the row needs more
+ * samples. */
+ccl_device bool kernel_adaptive_filter_x(KernelGlobals *kg, int y, ccl_global WorkTile *tile)
+{
+  bool any = false;
+  bool prev = false;
+  for (int x = tile->x; x < tile->x + tile->w; x++) {
+    const int index = tile->offset + x + y * tile->stride;
+    ccl_global float *aux = tile->buffer + index * kernel_data.film.pass_stride +
+                            kernel_data.film.pass_adaptive_aux_buffer;
+    if (aux[3] == 0.0f) {
+      any = true;
+      if (x > tile->x && !prev) {
+        aux[3 - kernel_data.film.pass_stride] = 0.0f;
+      }
+      prev = true;
+    }
+    else {
+      if (prev) {
+        aux[3] = 0.0f;
+      }
+      prev = false;
+    }
+  }
+  return any;
+}
+
+ccl_device bool kernel_adaptive_filter_y(KernelGlobals *kg, int x, ccl_global WorkTile *tile)
+{
+  const int row_stride = tile->stride * kernel_data.film.pass_stride;
+  bool any = false;
+  bool prev = false;
+  for (int y = tile->y; y < tile->y + tile->h; y++) {
+    const int index = tile->offset + x + y * tile->stride;
+    ccl_global float *aux = tile->buffer + index * kernel_data.film.pass_stride +
+                            kernel_data.film.pass_adaptive_aux_buffer;
+    if (aux[3] == 0.0f) {
+      any = true;
+      if (y > tile->y && !prev) {
+        aux[3 - row_stride] = 0.0f;
+      }
+      prev = true;
+    }
+    else {
+      if (prev) {
+        aux[3] = 0.0f;
+      }
+      prev = false;
+    }
+  }
+  return any;
+}
+
+/* Scale all passes of a pixel that stopped early, so the pixel looks like it
+ * took num_samples samples like the rest of the tile. */
+ccl_device void kernel_adaptive_post_adjust(KernelGlobals *kg,
+                                            ccl_global float *buffer,
+                                            float num_samples)
+{
+  const int pass_sample_count = kernel_data.film.pass_sample_count;
+  const float pixel_samples = buffer[pass_sample_count];
+  if (pixel_samples == 0.0f || pixel_samples == num_samples) {
+    return;
+  }
+
+  const float scale = num_samples / pixel_samples;
+
+  /* Cryptomatte stores pairs of ids and weights, only scale the weights. */
+  int cryptomatte_begin = 0, cryptomatte_end = 0;
+  if (kernel_data.film.cryptomatte_passes) {
+    const int num_types = ((kernel_data.film.cryptomatte_passes & CRYPT_OBJECT) ? 1 : 0) +
+                          ((kernel_data.film.cryptomatte_passes & CRYPT_MATERIAL) ? 1 : 0) +
+                          ((kernel_data.film.cryptomatte_passes & CRYPT_ASSET) ? 1 : 0);
+    cryptomatte_begin = kernel_data.film.pass_cryptomatte;
+    cryptomatte_end = cryptomatte_begin + num_types * kernel_data.film.cryptomatte_depth * 4;
+  }
+
+  for (int i = 0; i < kernel_data.film.pass_stride; i++) {
+    if (i == pass_sample_count) {
+      continue;
+    }
+    if (i >= cryptomatte_begin && i < cryptomatte_end && ((i - cryptomatte_begin) & 1) == 0) {
+      continue;
+    }
+    buffer[i] *= scale;
+  }
+
+  buffer[pass_sample_count] = num_samples;
+}
+
+CCL_NAMESPACE_END
+
+#endif /* __KERNEL_ADAPTIVE_SAMPLING_H__ */
@@ -543,10 +543,206 @@ ccl_device float background_light_pdf(KernelGlobals *kg, float3 P, float3 direct
 }
 #endif
 
+/* Light Tree
+ *
+ * Lights are selected by traversing a BVH over the light distribution, at each
+ * interior node picking a child proportional to an estimate of its contribution
+ * to the shading point. Distant and background lights have no position, they
+ * are picked uniformly along with the tree as a whole.
+ *
+ * Based on "Importance Sampling of Many Lights with Adaptive Tree Splitting",
+ * Conty Estevez and Kulla, 2018. The receiver normal is not used, so the same
+ * probabilities can be computed when a light is hit by a BSDF sample. */
+
+ccl_device float light_tree_node_importance(KernelGlobals *kg, int node, float3 P)
+{
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, node);
+  const float3 bbox_min = make_float3(knode->bbox_min[0], knode->bbox_min[1], knode->bbox_min[2]);
+  const float3 bbox_max = make_float3(knode->bbox_max[0], knode->bbox_max[1], knode->bbox_max[2]);
+
+  const float3 centroid = 0.5f * (bbox_min + bbox_max);
+  const float3 to_P = P - centroid;
+  const float distance_squared = len_squared(to_P);
+  const float radius_squared = 0.25f * len_squared(bbox_max - bbox_min);
+
+  /* Don't let the importance go to infinity inside or near the node. */
+  float importance = knode->energy / max(distance_squared, radius_squared);
+
+  if (knode->cos_theta_o > -1.0f && distance_squared > radius_squared) {
+    /* Smallest angle between any emitter normal and any direction from the
+     * node towards P, bounding the cosine falloff of the emission. */
+    const float3 axis = make_float3(knode->axis[0], knode->axis[1], knode->axis[2]);
+    const float cos_theta = fabsf(dot(axis, to_P)) / sqrtf(distance_squared);
+    const float theta = fast_acosf(min(cos_theta, 1.0f));
+    const float theta_o = fast_acosf(knode->cos_theta_o);
+    const float theta_u = fast_asinf(sqrtf(radius_squared / distance_squared));
+    const float theta_prime = max(theta - theta_o - theta_u, 0.0f);
+
+    importance *= max(fast_cosf(theta_prime), 0.0f);
+  }
+
+  return importance;
+}
+
+/* Probability of picking the left child of an interior node. */
+ccl_device_inline float light_tree_left_probability(KernelGlobals *kg, int node, float3 P)
+{
+  const int left = node + 1;
+  const int right = kernel_tex_fetch(__light_tree_nodes, node).child;
+
+  const float importance_left = light_tree_node_importance(kg, left, P);
+  const float importance_right = light_tree_node_importance(kg, right, P);
+  const float importance = importance_left + importance_right;
+
+  if (importance == 0.0f) {
+    return -1.0f;
+  }
+  return importance_left / importance;
+}
+
+/* Pick a light distribution primitive, returns -1 if no light contributes to P.
+ * The random number is rescaled so it can be used again for sampling the light. */
+ccl_device int light_tree_sample(KernelGlobals *kg, float3 P, float *randu, float *pdf)
+{
+  const int num_nodes = kernel_data.integrator.light_tree_num_nodes;
+  const int num_global = kernel_data.integrator.light_tree_num_global;
+  const int num_choices = num_global + ((num_nodes > 0) ? 1 : 0);
+
+  float r = *randu * num_choices;
+  const int choice = min((int)r, num_choices - 1);
+  r -= choice;
+
+  /* Global lights are leaf nodes stored after the tree. */
+  int node = (choice < num_global) ? num_nodes + choice : 0;
+  float node_pdf = kernel_data.integrator.pdf_lights;
+
+  int child = kernel_tex_fetch(__light_tree_nodes, node).child;
+  while (child >= 0) {
+    const float p_left = light_tree_left_probability(kg, node, P);
+    if (p_left < 0.0f) {
+      return -1;
+    }
+
+    if (r < p_left) {
+      r = r / p_left;
+      node = node + 1;
+      node_pdf *= p_left;
+    }
+    else {
+      r = (r - p_left) / (1.0f - p_left);
+      node = child;
+      node_pdf *= 1.0f - p_left;
+    }
+
+    child = kernel_tex_fetch(__light_tree_nodes, node).child;
+  }
+
+  *randu = min(r, 1.0f - FLT_EPSILON);
+  *pdf = node_pdf;
+  return ~child;
+}
+
+/* Probability of light_tree_sample() picking the light distribution primitive,
+ * following the path to its leaf. */
+ccl_device float light_tree_pdf(KernelGlobals *kg, float3 P, int index)
+{
+  uint bit_trail = kernel_tex_fetch(__light_tree_bit_trail, index);
+  float pdf = kernel_data.integrator.pdf_lights;
+  int node = 0;
+
+  int child = kernel_tex_fetch(__light_tree_nodes, node).child;
+  while (child >= 0) {
+    const float p_left = light_tree_left_probability(kg, node, P);
+    if (p_left < 0.0f) {
+      return 0.0f;
+    }
+
+    if (bit_trail & 1) {
+      node = child;
+      pdf *= 1.0f - p_left;
+    }
+    else {
+      node = node + 1;
+      pdf *= p_left;
+    }
+    bit_trail >>= 1;
+
+    child = kernel_tex_fetch(__light_tree_nodes, node).child;
+  }
+
+  return pdf;
+}
+
+/* Light distribution index of an emissive triangle. Triangles come first in
+ * the distribution, sorted by object and primitive. */
+ccl_device int light_tree_triangle_index(KernelGlobals *kg, int object, int prim)
+{
+  const int num_triangles = kernel_data.integrator.num_distribution -
+                            kernel_data.integrator.num_all_lights;
+  int first = 0;
+  int len = num_triangles;
+
+  while (len > 0) {
+    int half_len = len >> 1;
+    int middle = first + half_len;
+    const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(
+        __light_distribution, middle);
+    const int middle_object = kdistribution->mesh_light.object_id;
+
+    if (middle_object < object || (middle_object == object && kdistribution->prim < prim)) {
+      first = middle + 1;
+      len = len - half_len - 1;
+    }
+    else {
+      len = half_len;
+    }
+  }
+
+  if (first < num_triangles) {
+    const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(
+        __light_distribution, first);
+    if (kdistribution->mesh_light.object_id == object && kdistribution->prim == prim) {
+      return first;
+    }
+  }
+  return -1;
+}
+
+/* Probability of light_sample() picking the lamp. */
+ccl_device float lamp_light_select_pdf(KernelGlobals *kg, int lamp, float3 P)
+{
+  if (kernel_data.integrator.use_light_tree) {
+    const LightType type = (LightType)kernel_tex_fetch(__lights, lamp).type;
+    if (type != LIGHT_DISTANT && type != LIGHT_BACKGROUND) {
+      const int index = kernel_data.integrator.num_distribution -
+                        kernel_data.integrator.num_all_lights + lamp;
+      return light_tree_pdf(kg, P, index);
+    }
+  }
+  return kernel_data.integrator.pdf_lights;
+}
+
+/* Probability of light_sample() picking the triangle, area is the area the
+ * light distribution was built with. */
+ccl_device float triangle_light_select_pdf(
+    KernelGlobals *kg, int object, int prim, float3 P, float area)
+{
+  if (kernel_data.integrator.use_light_tree) {
+    const int index = light_tree_triangle_index(kg, object, prim);
+    return (index != -1) ? light_tree_pdf(kg, P, index) : 0.0f;
+  }
+  return area * kernel_data.integrator.pdf_triangles;
+}
+
 /* Regular Light */
 
-ccl_device_inline bool lamp_light_sample(
-    KernelGlobals *kg, int lamp, float randu, float randv, float3 P, LightSample *ls)
+ccl_device_inline bool lamp_light_sample(KernelGlobals *kg,
+                                         int lamp,
+                                         float randu,
+                                         float randv,
+                                         float3 P,
+                                         float select_pdf,
+                                         LightSample *ls)
 {
   const ccl_global KernelLight *klight = &kernel_tex_fetch(__lights, lamp);
   LightType type = (LightType)klight->type;
@@ -661,7 +857,7 @@ ccl_device_inline bool lamp_light_sample(
     }
   }
 
-  ls->pdf *= kernel_data.integrator.pdf_lights;
+  ls->pdf *= select_pdf;
 
   return (ls->pdf > 0.0f);
 }
@@ -799,7 +995,7 @@ ccl_device bool lamp_light_eval(
     return false;
   }
 
-  ls->pdf *= kernel_data.integrator.pdf_lights;
+  ls->pdf *= lamp_light_select_pdf(kg, lamp, P);
 
   return true;
 }
@@ -838,12 +1034,11 @@ ccl_device_inline bool triangle_world_space_vertices(
   return has_motion;
 }
 
-ccl_device_inline float triangle_light_pdf_area(KernelGlobals *kg,
-                                                const float3 Ng,
+ccl_device_inline float triangle_light_pdf_area(const float3 Ng,
                                                 const float3 I,
-                                                float t)
+                                                float t,
+                                                float pdf)
 {
-  float pdf = kernel_data.integrator.pdf_triangles;
   float cos_pi = fabsf(dot(Ng, I));
 
   if (cos_pi == 0.0f)
@@ -867,11 +1062,23 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
   const float longest_edge_squared = max(len_squared(e0), max(len_squared(e1), len_squared(e2)));
   const float3 N = cross(e0, e1);
   const float distance_to_plane = fabsf(dot(N, sd->I * t)) / dot(N, N);
+  const float area = 0.5f * len(N);
+
+  /* sd contains the point on the light source
+   * calculate Px, the point that we're shading */
+  const float3 Px = sd->P + sd->I * t;
+
+  /* Probability of selecting this triangle. The light distribution was built
+   * from the area of the center frame vertices. */
+  float area_pre = area;
+  if (has_motion && !kernel_data.integrator.use_light_tree) {
+    float3 V_pre[3];
+    triangle_world_space_vertices(kg, sd->object, sd->prim, -1.0f, V_pre);
+    area_pre = triangle_area(V_pre[0], V_pre[1], V_pre[2]);
+  }
+  const float select_pdf = triangle_light_select_pdf(kg, sd->object, sd->prim, Px, area_pre);
 
   if (longest_edge_squared > distance_to_plane * distance_to_plane) {
-    /* sd contains the point on the light source
-     * calculate Px, the point that we're shading */
-    const float3 Px = sd->P + sd->I * t;
     const float3 v0_p = V[0] - Px;
     const float3 v1_p = V[1] - Px;
     const float3 v2_p = V[2] - Px;
@@ -885,39 +1092,20 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
     const float gamma = fast_acosf(dot(u02, u12));
     const float solid_angle = alpha + beta + gamma - M_PI_F;
 
-    /* pdf_triangles is calculated over triangle area, but we're not sampling over its area */
+    /* select_pdf is the probability of the whole triangle, sampled over its solid angle */
     if (UNLIKELY(solid_angle == 0.0f)) {
       return 0.0f;
     }
     else {
-      float area = 1.0f;
-      if (has_motion) {
-        /* get the center frame vertices, this is what the PDF was calculated from */
-        triangle_world_space_vertices(kg, sd->object, sd->prim, -1.0f, V);
-        area = triangle_area(V[0], V[1], V[2]);
-      }
-      else {
-        area = 0.5f * len(N);
-      }
-      const float pdf = area * kernel_data.integrator.pdf_triangles;
-      return pdf / solid_angle;
+      return select_pdf / solid_angle;
     }
   }
   else {
-    float pdf = triangle_light_pdf_area(kg, sd->Ng, sd->I, t);
-    if (has_motion) {
-      const float area = 0.5f * len(N);
-      if (UNLIKELY(area == 0.0f)) {
-        return 0.0f;
-      }
-      /* scale the PDF.
-       * area = the area the sample was taken from
-       * area_pre = the are from which pdf_triangles was calculated from */
-      triangle_world_space_vertices(kg, sd->object, sd->prim, -1.0f, V);
-      const float area_pre = triangle_area(V[0], V[1], V[2]);
-      pdf = pdf * area_pre / area;
+    /* The sample was taken from the area at the current time. */
+    if (UNLIKELY(area == 0.0f)) {
+      return 0.0f;
     }
-    return pdf;
+    return triangle_light_pdf_area(sd->Ng, sd->I, t, select_pdf / area);
   }
 }
 
@@ -928,7 +1116,8 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
                                                   float randv,
                                                   float time,
                                                   LightSample *ls,
-                                                  const float3 P)
+                                                  const float3 P,
+                                                  float select_pdf)
 {
   /* A naive heuristic to decide between costly solid angle sampling
    * and simple area sampling, comparing the distance to the triangle plane
@@ -959,6 +1148,18 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
   ls->shader |= SHADER_USE_MIS;
   ls->type = LIGHT_TRIANGLE;
 
+  /* Probability of selecting this triangle, when not picked from the light tree
+   * it is proportional to the area of the center frame vertices. */
+  if (!kernel_data.integrator.use_light_tree) {
+    float area_pre = area;
+    if (has_motion) {
+      float3 V_pre[3];
+      triangle_world_space_vertices(kg, object, prim, -1.0f, V_pre);
+      area_pre = triangle_area(V_pre[0], V_pre[1], V_pre[2]);
+    }
+    select_pdf = area_pre * kernel_data.integrator.pdf_triangles;
+  }
+
   float distance_to_plane = fabsf(dot(N0, V[0] - P) / dot(N0, N0));
 
   if (longest_edge_squared > distance_to_plane * distance_to_plane) {
@@ -1041,19 +1242,13 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
 
     ls->P = P + ls->D * ls->t;
 
-    /* pdf_triangles is calculated over triangle area, but we're sampling over solid angle */
+    /* select_pdf is the probability of the whole triangle, sampled over its solid angle */
     if (UNLIKELY(solid_angle == 0.0f)) {
       ls->pdf = 0.0f;
       return;
     }
     else {
-      if (has_motion) {
-        /* get the center frame vertices, this is what the PDF was calculated from */
-        triangle_world_space_vertices(kg, object, prim, -1.0f, V);
-        area = triangle_area(V[0], V[1], V[2]);
-      }
-      const float pdf = area * kernel_data.integrator.pdf_triangles;
-      ls->pdf = pdf / solid_angle;
+      ls->pdf = select_pdf / solid_angle;
     }
   }
   else {
@@ -1066,15 +1261,9 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
     ls->P = u * V[0] + v * V[1] + t * V[2];
     /* compute incoming direction, distance and pdf */
     ls->D = normalize_len(ls->P - P, &ls->t);
-    ls->pdf = triangle_light_pdf_area(kg, ls->Ng, -ls->D, ls->t);
-    if (has_motion && area != 0.0f) {
-      /* scale the PDF.
-       * area = the area the sample was taken from
-       * area_pre = the are from which pdf_triangles was calculated from */
-      triangle_world_space_vertices(kg, object, prim, -1.0f, V);
-      const float area_pre = triangle_area(V[0], V[1], V[2]);
-      ls->pdf = ls->pdf * area_pre / area;
-    }
+    /* The sample was taken from the area at the current time. */
+    ls->pdf = (area != 0.0f) ? triangle_light_pdf_area(ls->Ng, -ls->D, ls->t, select_pdf / area) :
+                               0.0f;
     ls->u = u;
     ls->v = v;
   }
@@ -1129,7 +1318,18 @@ ccl_device_noinline bool light_sample(
     KernelGlobals *kg, float randu, float randv, float time, float3 P, int bounce, LightSample *ls)
 {
   /* sample index */
-  int index = light_distribution_sample(kg, &randu);
+  int index;
+  float select_pdf = 0.0f;
+
+  if (kernel_data.integrator.use_light_tree) {
+    index = light_tree_sample(kg, P, &randu, &select_pdf);
+    if (index == -1) {
+      return false;
+    }
+  }
+  else {
+    index = light_distribution_sample(kg, &randu);
+  }
 
   /* fetch light data */
   const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(__light_distribution,
@@ -1140,7 +1340,7 @@ ccl_device_noinline bool light_sample(
     int object = kdistribution->mesh_light.object_id;
     int shader_flag = kdistribution->mesh_light.shader_flag;
 
-    triangle_light_sample(kg, prim, object, randu, randv, time, ls, P);
+    triangle_light_sample(kg, prim, object, randu, randv, time, ls, P, select_pdf);
     ls->shader |= shader_flag;
     return (ls->pdf > 0.0f);
   }
@@ -1151,7 +1351,11 @@ ccl_device_noinline bool light_sample(
       return false;
     }
 
-    return lamp_light_sample(kg, lamp, randu, randv, P, ls);
+    if (!kernel_data.integrator.use_light_tree) {
+      select_pdf = kernel_data.integrator.pdf_lights;
+    }
+
+    return lamp_light_sample(kg, lamp, randu, randv, P, select_pdf, ls);
   }
 }
 
@@ -31,6 +31,7 @@
 #include "kernel/kernel_shader.h"
 #include "kernel/kernel_light.h"
 #include "kernel/kernel_passes.h"
+#include "kernel/kernel_adaptive_sampling.h"
 
 #if defined(__VOLUME__) || defined(__SUBSURFACE__)
 #  include "kernel/kernel_volume.h"
@@ -647,6 +648,13 @@ ccl_device void kernel_path_trace(
 
   buffer += index * pass_stride;
 
+  if (kernel_data.film.pass_adaptive_aux_buffer) {
+    if (kernel_adaptive_pixel_converged(kg, buffer)) {
+      return;
+    }
+    kernel_write_pass_float(buffer + kernel_data.film.pass_sample_count, 1.0f);
+  }
+
   /* Initialize random numbers and sample ray. */
   uint rng_hash;
   Ray ray;
@@ -62,7 +62,8 @@ ccl_device_noinline void kernel_branched_path_surface_connect_light(
             kg, lamp_rng_hash, state, j, num_samples);
 
         LightSample ls;
-        if (lamp_light_sample(kg, i, light_u, light_v, sd->P, &ls)) {
+        if (lamp_light_sample(
+                kg, i, light_u, light_v, sd->P, kernel_data.integrator.pdf_lights, &ls)) {
           /* The sampling probability returned by lamp_light_sample assumes that all lights were
            * sampled.
            * However, this code only samples lamps, so if the scene also had mesh lights, the real
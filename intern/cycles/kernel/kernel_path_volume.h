@@ -166,7 +166,8 @@ ccl_device void kernel_branched_path_volume_connect_light(KernelGlobals *kg,
             kg, lamp_rng_hash, state, j, num_samples, PRNG_LIGHT_U, &light_u, &light_v);
 
         LightSample ls;
-        lamp_light_sample(kg, i, light_u, light_v, ray->P, &ls);
+        lamp_light_sample(
+            kg, i, light_u, light_v, ray->P, kernel_data.integrator.pdf_lights, &ls);
 
         float3 tp = throughput;
 
@@ -190,7 +191,8 @@ ccl_device void kernel_branched_path_volume_connect_light(KernelGlobals *kg,
 
         /* todo: split up light_sample so we don't have to call it again with new position */
         if (result == VOLUME_PATH_SCATTERED &&
-            lamp_light_sample(kg, i, light_u, light_v, sd->P, &ls)) {
+            lamp_light_sample(
+                kg, i, light_u, light_v, sd->P, kernel_data.integrator.pdf_lights, &ls)) {
           if (kernel_data.integrator.pdf_triangles != 0.0f)
             ls.pdf *= 2.0f;
 
@@ -365,6 +365,8 @@ typedef enum PassType {
 #endif
   PASS_RENDER_TIME,
   PASS_CRYPTOMATTE,
+  PASS_ADAPTIVE_AUX_BUFFER,
+  PASS_SAMPLE_COUNT,
   PASS_CATEGORY_MAIN_END = 31,
 
   PASS_MIST = 32,
@@ -1218,6 +1220,11 @@ typedef struct KernelFilm {
   int pass_denoising_clean;
   int denoising_flags;
 
+  int pass_adaptive_aux_buffer;
+  int pass_sample_count;
+  int pass_render_time;
+  int pad1;
+
   /* XYZ to rendering color space transform. float4 instead of float3 to
    * ensure consistent padding/alignment across devices. */
   float4 xyz_to_r;
@@ -1321,7 +1328,16 @@ typedef struct KernelIntegrator {
 
   int max_closures;
 
-  int pad1, pad2, pad3;
+  /* light tree */
+  int use_light_tree;
+  int light_tree_num_nodes;
+  int light_tree_num_global;
+
+  /* adaptive sampling */
+  float adaptive_threshold;
+  int adaptive_min_samples;
+  int adaptive_step;
+  int pad1;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
@@ -1344,6 +1360,8 @@ typedef struct KernelBVH {
   int have_instancing;
   int bvh_layout;
   int use_bvh_steps;
+  int use_compressed_nodes;
+  int pad3, pad4, pad5;
 
   /* Embree */
 #ifdef __EMBREE__
@@ -1484,6 +1502,23 @@ typedef struct KernelLightDistribution {
 } KernelLightDistribution;
 static_assert_align(KernelLightDistribution, 16);
 
+/* Node of the light tree, a BVH over light distribution primitives used to
+ * select lights by their estimated contribution to a shading point.
+ * Interior nodes have the left child next to them in the array. */
+typedef struct KernelLightTreeNode {
+  float bbox_min[3];
+  float energy;
+  float bbox_max[3];
+  /* Cosine of the half angle of the double cone bounding the emitter normals
+   * around axis, -1 for emitters that emit in all directions. */
+  float cos_theta_o;
+  float axis[3];
+  /* Interior node: index of the right child.
+   * Leaf: bitwise not of the light distribution index. */
+  int child;
+} KernelLightTreeNode;
+static_assert_align(KernelLightTreeNode, 16);
+
 typedef struct KernelParticle {
   int index;
   float age;
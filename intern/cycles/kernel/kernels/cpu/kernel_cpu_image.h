@@ -17,6 +17,9 @@
 #ifndef __KERNEL_CPU_IMAGE_H__
 #define __KERNEL_CPU_IMAGE_H__
 
+#include "util/util_sparse_grid.h"
+#include "util/util_texture_cache.h"
+
 CCL_NAMESPACE_BEGIN
 
 template<typename T> struct TextureInterpolator {
@@ -249,6 +252,26 @@ template<typename T> struct TextureInterpolator {
 
   /* ********  3D interpolation ******** */
 
+  /* Read voxel from a dense or sparse grid. */
+  template<bool is_sparse>
+  static ccl_always_inline float4 read_3d(const TextureInfo &info, int x, int y, int z)
+  {
+    const T *data = (const T *)info.data;
+
+    if (is_sparse) {
+      const int offset = sparse_grid_tile_offset(data, info.width, info.height, x, y, z);
+      if (offset == SPARSE_TILE_EMPTY) {
+        return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+      }
+      return read(data[offset + sparse_grid_voxel_offset(x, y, z)]);
+    }
+
+    const int width = info.width;
+    const int height = info.height;
+    return read(data[x + y * width + z * width * height]);
+  }
+
+  template<bool is_sparse>
   static ccl_always_inline float4 interp_3d_closest(const TextureInfo &info,
                                                     float x,
                                                     float y,
@@ -284,10 +307,10 @@ template<typename T> struct TextureInterpolator {
         return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
     }
 
-    const T *data = (const T *)info.data;
-    return read(data[ix + iy * width + iz * width * height]);
+    return read_3d<is_sparse>(info, ix, iy, iz);
   }
 
+  template<bool is_sparse>
   static ccl_always_inline float4 interp_3d_linear(const TextureInfo &info,
                                                    float x,
                                                    float y,
@@ -332,19 +355,17 @@ template<typename T> struct TextureInterpolator {
         return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
     }
 
-    const T *data = (const T *)info.data;
     float4 r;
 
-    r = (1.0f - tz) * (1.0f - ty) * (1.0f - tx) *
-        read(data[ix + iy * width + iz * width * height]);
-    r += (1.0f - tz) * (1.0f - ty) * tx * read(data[nix + iy * width + iz * width * height]);
-    r += (1.0f - tz) * ty * (1.0f - tx) * read(data[ix + niy * width + iz * width * height]);
-    r += (1.0f - tz) * ty * tx * read(data[nix + niy * width + iz * width * height]);
+    r = (1.0f - tz) * (1.0f - ty) * (1.0f - tx) * read_3d<is_sparse>(info, ix, iy, iz);
+    r += (1.0f - tz) * (1.0f - ty) * tx * read_3d<is_sparse>(info, nix, iy, iz);
+    r += (1.0f - tz) * ty * (1.0f - tx) * read_3d<is_sparse>(info, ix, niy, iz);
+    r += (1.0f - tz) * ty * tx * read_3d<is_sparse>(info, nix, niy, iz);
 
-    r += tz * (1.0f - ty) * (1.0f - tx) * read(data[ix + iy * width + niz * width * height]);
-    r += tz * (1.0f - ty) * tx * read(data[nix + iy * width + niz * width * height]);
-    r += tz * ty * (1.0f - tx) * read(data[ix + niy * width + niz * width * height]);
-    r += tz * ty * tx * read(data[nix + niy * width + niz * width * height]);
+    r += tz * (1.0f - ty) * (1.0f - tx) * read_3d<is_sparse>(info, ix, iy, niz);
+    r += tz * (1.0f - ty) * tx * read_3d<is_sparse>(info, nix, iy, niz);
+    r += tz * ty * (1.0f - tx) * read_3d<is_sparse>(info, ix, niy, niz);
+    r += tz * ty * tx * read_3d<is_sparse>(info, nix, niy, niz);
 
     return r;
   }
@@ -355,6 +376,7 @@ template<typename T> struct TextureInterpolator {
    * Only happens for AVX2 kernel and global __KERNEL_SSE__ vectorization
    * enabled.
    */
+  template<bool is_sparse>
 #if defined(__GNUC__) || defined(__clang__)
   static ccl_always_inline
 #else
@@ -420,15 +442,14 @@ template<typename T> struct TextureInterpolator {
     }
 
     const int xc[4] = {pix, ix, nix, nnix};
-    const int yc[4] = {width * piy, width * iy, width * niy, width * nniy};
-    const int zc[4] = {
-        width * height * piz, width * height * iz, width * height * niz, width * height * nniz};
+    const int yc[4] = {piy, iy, niy, nniy};
+    const int zc[4] = {piz, iz, niz, nniz};
     float u[4], v[4], w[4];
 
     /* Some helper macro to keep code reasonable size,
      * let compiler to inline all the matrix multiplications.
      */
-#define DATA(x, y, z) (read(data[xc[x] + yc[y] + zc[z]]))
+#define DATA(x, y, z) (read_3d<is_sparse>(info, xc[x], yc[y], zc[z]))
 #define COL_TERM(col, row) \
   (v[col] * (u[0] * DATA(0, col, row) + u[1] * DATA(1, col, row) + u[2] * DATA(2, col, row) + \
              u[3] * DATA(3, col, row)))
@@ -440,7 +461,6 @@ template<typename T> struct TextureInterpolator {
     SET_CUBIC_SPLINE_WEIGHTS(w, tz);
 
     /* Actual interpolation. */
-    const T *data = (const T *)info.data;
     return ROW_TERM(0) + ROW_TERM(1) + ROW_TERM(2) + ROW_TERM(3);
 
 #undef COL_TERM
@@ -448,21 +468,31 @@ template<typename T> struct TextureInterpolator {
 #undef DATA
   }
 
+  template<bool is_sparse>
   static ccl_always_inline float4
-  interp_3d(const TextureInfo &info, float x, float y, float z, InterpolationType interp)
+  interp_3d_grid(const TextureInfo &info, float x, float y, float z, InterpolationType interp)
   {
-    if (UNLIKELY(!info.data))
-      return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
-
     switch ((interp == INTERPOLATION_NONE) ? info.interpolation : interp) {
       case INTERPOLATION_CLOSEST:
-        return interp_3d_closest(info, x, y, z);
+        return interp_3d_closest<is_sparse>(info, x, y, z);
       case INTERPOLATION_LINEAR:
-        return interp_3d_linear(info, x, y, z);
+        return interp_3d_linear<is_sparse>(info, x, y, z);
       default:
-        return interp_3d_tricubic(info, x, y, z);
+        return interp_3d_tricubic<is_sparse>(info, x, y, z);
     }
   }
+
+  static ccl_always_inline float4
+  interp_3d(const TextureInfo &info, float x, float y, float z, InterpolationType interp)
+  {
+    if (UNLIKELY(!info.data))
+      return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+    if (info.use_sparse_grid) {
+      return interp_3d_grid<true>(info, x, y, z, interp);
+    }
+    return interp_3d_grid<false>(info, x, y, z, interp);
+  }
 #undef SET_CUBIC_SPLINE_WEIGHTS
 };
 
@@ -470,6 +500,13 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, fl
 {
   const TextureInfo &info = kernel_tex_fetch(__texture_info, id);
 
+  if (info.use_texture_cache) {
+    float r[4];
+    texture_cache_lookup(
+        (const TextureCacheImage *)info.data, info.interpolation, info.extension, x, y, r);
+    return make_float4(r[0], r[1], r[2], r[3]);
+  }
+
   switch (kernel_tex_type(id)) {
     case IMAGE_DATA_TYPE_HALF:
       return TextureInterpolator<half>::interp(info, x, y);
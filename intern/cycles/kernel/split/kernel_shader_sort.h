@@ -16,6 +16,48 @@
 
 CCL_NAMESPACE_BEGIN
 
+#ifdef __KERNEL_CPU__
+/* On the CPU a single thread sorts the whole block, so instead of a bitonic
+ * sort with barriers use a heap sort. Ties are ordered by index to keep the
+ * order deterministic. */
+ccl_device_inline bool shader_sort_less(const uint *value, const ushort *index, uint i, uint j)
+{
+  const uint i_value = value[index[i]];
+  const uint j_value = value[index[j]];
+  return (i_value < j_value) || (i_value == j_value && index[i] < index[j]);
+}
+
+ccl_device_inline void shader_sort_sift_down(const uint *value, ushort *index, uint root, uint n)
+{
+  while (2 * root + 1 < n) {
+    uint child = 2 * root + 1;
+    if (child + 1 < n && shader_sort_less(value, index, child, child + 1)) {
+      child++;
+    }
+    if (!shader_sort_less(value, index, root, child)) {
+      return;
+    }
+    const ushort tmp = index[root];
+    index[root] = index[child];
+    index[child] = tmp;
+    root = child;
+  }
+}
+
+ccl_device_inline void shader_sort_block(const uint *value, ushort *index, uint n)
+{
+  for (uint i = n / 2; i > 0; i--) {
+    shader_sort_sift_down(value, index, i - 1, n);
+  }
+  for (uint end = n - 1; end > 0; end--) {
+    const ushort tmp = index[0];
+    index[0] = index[end];
+    index[end] = tmp;
+    shader_sort_sift_down(value, index, 0, end);
+  }
+}
+#endif /* __KERNEL_CPU__ */
+
 ccl_device void kernel_shader_sort(KernelGlobals *kg, ccl_local_param ShaderSortLocals *locals)
 {
 #ifndef __KERNEL_CUDA__
@@ -54,8 +96,11 @@ ccl_device void kernel_shader_sort(KernelGlobals *kg, ccl_local_param ShaderSort
   }
   ccl_barrier(CCL_LOCAL_MEM_FENCE);
 
-  /* skip sorting for cpu split kernel */
-#  ifdef __KERNEL_OPENCL__
+#  if defined(__KERNEL_CPU__)
+  /* Only sort the part of the block that is in the queue. */
+  const uint num_sort = min((int)(qsize - offset), SHADER_SORT_BLOCK_SIZE);
+  shader_sort_block(local_value, local_index, num_sort);
+#  elif defined(__KERNEL_OPENCL__)
 
   /* bitonic sort */
   for (uint length = 1; length < SHADER_SORT_BLOCK_SIZE; length <<= 1) {
@@ -129,7 +129,8 @@ RenderTile::RenderTile()
 RenderBuffers::RenderBuffers(Device *device)
     : buffer(device, "RenderBuffers", MEM_READ_WRITE),
       map_neighbor_copied(false),
-      render_time(0.0f)
+      render_time(0.0f),
+      use_pixel_render_time(false)
 {
 }
 
@@ -264,10 +265,18 @@ bool RenderBuffers::get_pass_rect(
     int size = params.width * params.height;
 
     if (components == 1 && type == PASS_RENDER_TIME) {
-      /* Render time is not stored by kernel, but measured per tile. */
-      float val = (float)(1000.0 * render_time / (params.width * params.height * sample));
-      for (int i = 0; i < size; i++, pixels++) {
-        pixels[0] = val;
+      if (use_pixel_render_time) {
+        /* Seconds accumulated per pixel by the device. */
+        for (int i = 0; i < size; i++, in += pass_stride, pixels++) {
+          pixels[0] = *in * 1000.0f * scale;
+        }
+      }
+      else {
+        /* Only measured per tile, so use the average. */
+        float val = (float)(1000.0 * render_time / (params.width * params.height * sample));
+        for (int i = 0; i < size; i++, pixels++) {
+          pixels[0] = val;
+        }
       }
     }
     else if (components == 1) {
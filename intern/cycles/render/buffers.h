@@ -81,6 +81,8 @@ class RenderBuffers {
   device_vector<float> buffer;
   bool map_neighbor_copied;
   double render_time;
+  /* Render time pass was measured per pixel, otherwise only the time per tile is known. */
+  bool use_pixel_render_time;
 
   explicit RenderBuffers(Device *device);
   ~RenderBuffers();
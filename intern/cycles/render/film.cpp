@@ -121,8 +121,9 @@ void Pass::add(PassType type, vector<Pass> &passes, const char *name)
       break;
 #endif
     case PASS_RENDER_TIME:
-      /* This pass is handled entirely on the host side. */
-      pass.components = 0;
+      /* Written by the host side, per pixel on the CPU and per tile on other devices. */
+      pass.components = 1;
+      pass.exposure = false;
       break;
 
     case PASS_DIFFUSE_COLOR:
@@ -163,6 +164,14 @@ void Pass::add(PassType type, vector<Pass> &passes, const char *name)
     case PASS_CRYPTOMATTE:
       pass.components = 4;
       break;
+    case PASS_ADAPTIVE_AUX_BUFFER:
+      pass.components = 4;
+      pass.filter = false;
+      break;
+    case PASS_SAMPLE_COUNT:
+      pass.components = 1;
+      pass.filter = false;
+      break;
     default:
       assert(false);
       break;
@@ -321,6 +330,9 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
   kfilm->light_pass_flag = 0;
   kfilm->pass_stride = 0;
   kfilm->use_light_pass = use_light_visibility || use_sample_clamp;
+  kfilm->pass_adaptive_aux_buffer = 0;
+  kfilm->pass_sample_count = 0;
+  kfilm->pass_render_time = 0;
 
   bool have_cryptomatte = false;
 
@@ -452,6 +464,7 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
         break;
 #endif
       case PASS_RENDER_TIME:
+        kfilm->pass_render_time = kfilm->pass_stride;
         break;
       case PASS_CRYPTOMATTE:
         kfilm->pass_cryptomatte = have_cryptomatte ?
@@ -459,6 +472,12 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
                                       kfilm->pass_stride;
         have_cryptomatte = true;
         break;
+      case PASS_ADAPTIVE_AUX_BUFFER:
+        kfilm->pass_adaptive_aux_buffer = kfilm->pass_stride;
+        break;
+      case PASS_SAMPLE_COUNT:
+        kfilm->pass_sample_count = kfilm->pass_stride;
+        break;
       default:
         assert(false);
         break;
@@ -25,7 +25,9 @@
 #include "util/util_logging.h"
 #include "util/util_path.h"
 #include "util/util_progress.h"
+#include "util/util_sparse_grid.h"
 #include "util/util_texture.h"
+#include "util/util_texture_cache.h"
 #include "util/util_unique_ptr.h"
 
 #ifdef WITH_OSL
@@ -103,6 +105,10 @@ ImageManager::ImageManager(const DeviceInfo &info)
   /* Set image limits */
   max_num_images = TEX_NUM_MAX;
   has_half_images = info.has_half_images;
+  /* Kernel can only call back into the texture cache on the CPU. */
+  has_texture_cache = (info.type == DEVICE_CPU);
+  /* Only the CPU kernel can read sparse grids. */
+  has_sparse_grids = (info.type == DEVICE_CPU);
 
   for (size_t type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
     tex_num_images[type] = 0;
@@ -402,6 +408,7 @@ int ImageManager::add_image(const string &filename,
   img->use_alpha = use_alpha;
   img->colorspace = colorspace;
   img->mem = NULL;
+  img->cache_image = NULL;
 
   images[type][slot] = img;
 
@@ -541,6 +548,7 @@ template<TypeDesc::BASETYPE FileFormat, typename StorageType, typename DeviceTyp
 bool ImageManager::file_load_image(Image *img,
                                    ImageDataType type,
                                    int texture_limit,
+                                   bool use_sparse_grid,
                                    device_vector<DeviceType> &tex_img)
 {
   unique_ptr<ImageInput> in = NULL;
@@ -757,6 +765,100 @@ bool ImageManager::file_load_image(Image *img,
     memcpy(texture_pixels, &scaled_pixels[0], scaled_pixels.size() * sizeof(StorageType));
   }
 
+  /* Store mostly empty volumes as sparse grid. */
+  if (use_sparse_grid && tex_img.data_depth > 1) {
+    file_load_sparse_grid(img, tex_img);
+  }
+
+  return true;
+}
+
+template<typename DeviceType>
+void ImageManager::file_load_sparse_grid(Image *img, device_vector<DeviceType> &tex_img)
+{
+  const size_t width = tex_img.data_width;
+  const size_t height = tex_img.data_height;
+  const size_t depth = tex_img.data_depth;
+
+  vector<DeviceType> sparse_grid;
+  if (!sparse_grid_create(tex_img.data(), width, height, depth, &sparse_grid)) {
+    return;
+  }
+
+  VLOG(1) << "Storing volume " << img->filename << " as sparse grid, "
+          << string_human_readable_size(tex_img.memory_size()) << " dense, "
+          << string_human_readable_size(sparse_grid.size() * sizeof(DeviceType)) << " sparse.";
+
+  DeviceType *pixels;
+  {
+    thread_scoped_lock device_lock(device_mutex);
+    pixels = tex_img.alloc_sparse_grid(sparse_grid.size(), width, height, depth);
+  }
+  memcpy(pixels, sparse_grid.data(), sparse_grid.size() * sizeof(DeviceType));
+}
+
+bool ImageManager::use_texture_cache(Image *img, Scene *scene)
+{
+  if (!has_texture_cache || scene->params.texture_cache_size == 0) {
+    return false;
+  }
+
+  /* Builtin images are already in memory, and volumes are not tiled by the
+   * texture system. */
+  if (img->builtin_data || img->metadata.depth > 1) {
+    return false;
+  }
+
+  /* Color space conversion happens while loading the full image. */
+  if (img->metadata.colorspace != u_colorspace_raw &&
+      img->metadata.colorspace != u_colorspace_srgb) {
+    return false;
+  }
+
+  /* Load sRGB float and half images in full, so their conversion to linear
+   * matches images loaded without the texture cache. */
+  if (img->metadata.colorspace == u_colorspace_srgb &&
+      (img->metadata.is_float || img->metadata.is_half)) {
+    return false;
+  }
+
+  return img->metadata.width > 0 && img->metadata.height > 0;
+}
+
+bool ImageManager::device_load_cache_image(Device *device, Scene *scene, Image *img)
+{
+  /* Instead of downsizing the image, let the texture system pick the mipmap
+   * level closest to the texture limit. */
+  const int texture_limit = scene->params.texture_limit;
+  const size_t max_size = max(img->metadata.width, img->metadata.height);
+  const float filter_width = (texture_limit > 0 && max_size > texture_limit) ?
+                                 1.0f / texture_limit :
+                                 0.0f;
+
+  img->cache_image = texture_cache_image_create(img->filename, filter_width, img->use_alpha);
+  if (img->cache_image == NULL) {
+    return false;
+  }
+
+  /* Device memory still holds a single pixel, so slots and statistics work
+   * the same as for images loaded into memory. */
+  device_vector<uchar4> *tex_img = new device_vector<uchar4>(
+      device, img->mem_name.c_str(), MEM_TEXTURE);
+
+  thread_scoped_lock device_lock(device_mutex);
+  uchar4 *pixels = tex_img->alloc(1, 1);
+  pixels[0] = make_uchar4(TEX_IMAGE_MISSING_R * 255,
+                          TEX_IMAGE_MISSING_G * 255,
+                          TEX_IMAGE_MISSING_B * 255,
+                          TEX_IMAGE_MISSING_A * 255);
+
+  img->mem = tex_img;
+  img->mem->interpolation = img->interpolation;
+  img->mem->extension = img->extension;
+  img->mem->texture_cache_image = img->cache_image;
+
+  tex_img->copy_to_device();
+
   return true;
 }
 
@@ -775,6 +877,8 @@ void ImageManager::device_load_image(
   progress->set_status("Updating Images", "Loading " + filename);
 
   const int texture_limit = scene->params.texture_limit;
+  /* Sparse grids only save memory, cubic interpolation is slower so it's not done by default. */
+  const bool use_sparse_grid = has_sparse_grids && scene->params.use_sparse_grids;
 
   /* Slot assignment */
   int flat_slot = type_index_to_flattened_slot(slot, type);
@@ -786,13 +890,22 @@ void ImageManager::device_load_image(
     delete img->mem;
     img->mem = NULL;
   }
+  if (img->cache_image) {
+    texture_cache_image_free(img->filename, img->cache_image);
+    img->cache_image = NULL;
+  }
+
+  if (use_texture_cache(img, scene) && device_load_cache_image(device, scene, img)) {
+    img->need_load = false;
+    return;
+  }
 
   /* Create new texture. */
   if (type == IMAGE_DATA_TYPE_FLOAT4) {
     device_vector<float4> *tex_img = new device_vector<float4>(
         device, img->mem_name.c_str(), MEM_TEXTURE);
 
-    if (!file_load_image<TypeDesc::FLOAT, float>(img, type, texture_limit, *tex_img)) {
+    if (!file_load_image<TypeDesc::FLOAT, float>(img, type, texture_limit, use_sparse_grid, *tex_img)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
       float *pixels = (float *)tex_img->alloc(1, 1);
@@ -814,7 +927,7 @@ void ImageManager::device_load_image(
     device_vector<float> *tex_img = new device_vector<float>(
         device, img->mem_name.c_str(), MEM_TEXTURE);
 
-    if (!file_load_image<TypeDesc::FLOAT, float>(img, type, texture_limit, *tex_img)) {
+    if (!file_load_image<TypeDesc::FLOAT, float>(img, type, texture_limit, use_sparse_grid, *tex_img)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
       float *pixels = (float *)tex_img->alloc(1, 1);
@@ -833,7 +946,7 @@ void ImageManager::device_load_image(
     device_vector<uchar4> *tex_img = new device_vector<uchar4>(
         device, img->mem_name.c_str(), MEM_TEXTURE);
 
-    if (!file_load_image<TypeDesc::UINT8, uchar>(img, type, texture_limit, *tex_img)) {
+    if (!file_load_image<TypeDesc::UINT8, uchar>(img, type, texture_limit, use_sparse_grid, *tex_img)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
       uchar *pixels = (uchar *)tex_img->alloc(1, 1);
@@ -855,7 +968,7 @@ void ImageManager::device_load_image(
     device_vector<uchar> *tex_img = new device_vector<uchar>(
         device, img->mem_name.c_str(), MEM_TEXTURE);
 
-    if (!file_load_image<TypeDesc::UINT8, uchar>(img, type, texture_limit, *tex_img)) {
+    if (!file_load_image<TypeDesc::UINT8, uchar>(img, type, texture_limit, use_sparse_grid, *tex_img)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
       uchar *pixels = (uchar *)tex_img->alloc(1, 1);
@@ -874,7 +987,7 @@ void ImageManager::device_load_image(
     device_vector<half4> *tex_img = new device_vector<half4>(
         device, img->mem_name.c_str(), MEM_TEXTURE);
 
-    if (!file_load_image<TypeDesc::HALF, half>(img, type, texture_limit, *tex_img)) {
+    if (!file_load_image<TypeDesc::HALF, half>(img, type, texture_limit, use_sparse_grid, *tex_img)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
       half *pixels = (half *)tex_img->alloc(1, 1);
@@ -896,7 +1009,7 @@ void ImageManager::device_load_image(
     device_vector<uint16_t> *tex_img = new device_vector<uint16_t>(
         device, img->mem_name.c_str(), MEM_TEXTURE);
 
-    if (!file_load_image<TypeDesc::USHORT, uint16_t>(img, type, texture_limit, *tex_img)) {
+    if (!file_load_image<TypeDesc::USHORT, uint16_t>(img, type, texture_limit, use_sparse_grid, *tex_img)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
       uint16_t *pixels = (uint16_t *)tex_img->alloc(1, 1);
@@ -915,7 +1028,7 @@ void ImageManager::device_load_image(
     device_vector<ushort4> *tex_img = new device_vector<ushort4>(
         device, img->mem_name.c_str(), MEM_TEXTURE);
 
-    if (!file_load_image<TypeDesc::USHORT, uint16_t>(img, type, texture_limit, *tex_img)) {
+    if (!file_load_image<TypeDesc::USHORT, uint16_t>(img, type, texture_limit, use_sparse_grid, *tex_img)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
       uint16_t *pixels = (uint16_t *)tex_img->alloc(1, 1);
@@ -937,7 +1050,7 @@ void ImageManager::device_load_image(
     device_vector<half> *tex_img = new device_vector<half>(
         device, img->mem_name.c_str(), MEM_TEXTURE);
 
-    if (!file_load_image<TypeDesc::HALF, half>(img, type, texture_limit, *tex_img)) {
+    if (!file_load_image<TypeDesc::HALF, half>(img, type, texture_limit, use_sparse_grid, *tex_img)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
       half *pixels = (half *)tex_img->alloc(1, 1);
@@ -972,6 +1085,10 @@ void ImageManager::device_free_image(Device *, ImageDataType type, int slot)
       delete img->mem;
     }
 
+    if (img->cache_image) {
+      texture_cache_image_free(img->filename, img->cache_image);
+    }
+
     delete img;
     images[type][slot] = NULL;
     --tex_num_images[type];
@@ -984,6 +1101,10 @@ void ImageManager::device_update(Device *device, Scene *scene, Progress &progres
     return;
   }
 
+  if (has_texture_cache && scene->params.texture_cache_size > 0) {
+    texture_cache_init(scene->params.texture_cache_size);
+  }
+
   TaskPool pool;
   for (int type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
     for (size_t slot = 0; slot < images[type].size(); slot++) {
@@ -1022,6 +1143,11 @@ void ImageManager::device_update_slot(Device *device,
   Image *image = images[type][slot];
   assert(image != NULL);
 
+  /* Displacement images are loaded before device_update(). */
+  if (has_texture_cache && scene->params.texture_cache_size > 0) {
+    texture_cache_init(scene->params.texture_cache_size);
+  }
+
   if (image->users == 0) {
     device_free_image(device, type, slot);
   }
@@ -1086,10 +1212,28 @@ void ImageManager::collect_statistics(RenderStats *stats)
 {
   for (int type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
     foreach (const Image *image, images[type]) {
+      if (image->cache_image) {
+        TextureCacheImageStatistics image_stats;
+        if (texture_cache_image_statistics(image->filename, &image_stats)) {
+          stats->image.cache.add_entry(NamedTextureCacheEntry(path_filename(image->filename),
+                                                              image_stats.tile_misses,
+                                                              image_stats.bytes_read,
+                                                              image_stats.mip_levels_used));
+        }
+        continue;
+      }
       stats->image.textures.add_entry(
           NamedSizeEntry(path_filename(image->filename), image->mem->memory_size()));
     }
   }
+
+  TextureCacheStatistics cache_stats;
+  if (stats->image.cache.entries.size() && texture_cache_statistics(&cache_stats)) {
+    stats->image.cache.tile_lookups = cache_stats.tile_lookups;
+    stats->image.cache.tile_misses = cache_stats.tile_misses;
+    stats->image.cache.memory_used = cache_stats.memory_used;
+    stats->image.cache.memory_limit = cache_stats.memory_limit;
+  }
 }
 
 CCL_NAMESPACE_END
@@ -35,6 +35,7 @@ class Progress;
 class RenderStats;
 class Scene;
 class ColorSpaceProcessor;
+struct TextureCacheImage;
 
 class ImageMetaData {
  public:
@@ -156,6 +157,8 @@ class ImageManager {
 
     string mem_name;
     device_memory *mem;
+    /* Pixels are read on demand through the texture cache. */
+    TextureCacheImage *cache_image;
 
     int users;
   };
@@ -164,6 +167,8 @@ class ImageManager {
   int tex_num_images[IMAGE_DATA_NUM_TYPES];
   int max_num_images;
   bool has_half_images;
+  bool has_texture_cache;
+  bool has_sparse_grids;
 
   thread_mutex device_mutex;
   int animation_frame;
@@ -177,10 +182,17 @@ class ImageManager {
   bool file_load_image(Image *img,
                        ImageDataType type,
                        int texture_limit,
+                       bool use_sparse_grid,
                        device_vector<DeviceType> &tex_img);
 
+  template<typename DeviceType>
+  void file_load_sparse_grid(Image *img, device_vector<DeviceType> &tex_img);
+
   void metadata_detect_colorspace(ImageMetaData &metadata, const char *file_format);
 
+  bool use_texture_cache(Image *img, Scene *scene);
+  bool device_load_cache_image(Device *device, Scene *scene, Image *img);
+
   void device_load_image(
       Device *device, Scene *scene, ImageDataType type, int slot, Progress *progress);
   void device_free_image(Device *device, ImageDataType type, int slot);
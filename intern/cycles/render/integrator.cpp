@@ -67,6 +67,11 @@ NODE_DEFINE(Integrator)
   SOCKET_BOOLEAN(sample_all_lights_direct, "Sample All Lights Direct", true);
   SOCKET_BOOLEAN(sample_all_lights_indirect, "Sample All Lights Indirect", true);
   SOCKET_FLOAT(light_sampling_threshold, "Light Sampling Threshold", 0.05f);
+  SOCKET_BOOLEAN(use_light_tree, "Use Light Tree", false);
+
+  SOCKET_BOOLEAN(use_adaptive_sampling, "Use Adaptive Sampling", false);
+  SOCKET_FLOAT(adaptive_threshold, "Adaptive Threshold", 0.01f);
+  SOCKET_INT(adaptive_min_samples, "Adaptive Min Samples", 0);
 
   static NodeEnum method_enum;
   method_enum.insert("path", PATH);
@@ -171,6 +176,14 @@ void Integrator::device_update(Device *device, DeviceScene *dscene, Scene *scene
   kintegrator->sampling_pattern = sampling_pattern;
   kintegrator->aa_samples = aa_samples;
 
+  /* Adaptive sampling, pixels are tested for convergence every few samples
+   * once they took the minimum number of samples. */
+  kintegrator->adaptive_threshold = adaptive_threshold;
+  kintegrator->adaptive_step = 4;
+  kintegrator->adaptive_min_samples = (adaptive_min_samples == 0) ?
+                                          max(4, (int)sqrtf((float)aa_samples)) :
+                                          adaptive_min_samples;
+
   if (light_sampling_threshold > 0.0f) {
     kintegrator->light_inv_rr_threshold = 1.0f / light_sampling_threshold;
   }
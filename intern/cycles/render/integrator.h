@@ -72,6 +72,11 @@ class Integrator : public Node {
   bool sample_all_lights_direct;
   bool sample_all_lights_indirect;
   float light_sampling_threshold;
+  bool use_light_tree;
+
+  bool use_adaptive_sampling;
+  float adaptive_threshold;
+  int adaptive_min_samples;
 
   enum Method {
     BRANCHED_PATH = 0,
@@ -26,6 +26,7 @@
 #include "render/scene.h"
 #include "render/shader.h"
 
+#include "util/util_algorithm.h"
 #include "util/util_foreach.h"
 #include "util/util_hash.h"
 #include "util/util_path.h"
@@ -257,6 +258,272 @@ bool LightManager::object_usable_as_light(Object *object)
   return false;
 }
 
+/* Light Tree */
+
+/* Emitter in the light tree, a light distribution primitive. */
+struct LightTreeEmitter {
+  BoundBox bbox;
+  float3 centroid;
+  float energy;
+  /* Double cone bounding the normals, cos_theta_o is -1 for all directions. */
+  float3 axis;
+  float cos_theta_o;
+  /* Index in the light distribution. */
+  int index;
+};
+
+static float light_tree_emission_estimate(Shader *shader)
+{
+  float3 emission;
+  if (shader->is_constant_emission(&emission)) {
+    return max(average(emission), 0.0f);
+  }
+  /* Unknown emission, weight by area or strength only. */
+  return 1.0f;
+}
+
+/* Merge double cones, the result bounds the directions of both. */
+static void light_tree_cone_merge(float3 &axis,
+                                  float &cos_theta_o,
+                                  const float3 &other_axis,
+                                  float other_cos_theta_o)
+{
+  if (cos_theta_o == -1.0f || other_cos_theta_o == -1.0f) {
+    cos_theta_o = -1.0f;
+    return;
+  }
+
+  /* Flip the other cone to the side closest to this one. */
+  const float3 b = (dot(axis, other_axis) < 0.0f) ? -other_axis : other_axis;
+  const float theta_a = safe_acosf(cos_theta_o);
+  const float theta_b = safe_acosf(other_cos_theta_o);
+  const float theta_d = safe_acosf(dot(axis, b));
+
+  if (theta_b + theta_d <= theta_a) {
+    return;
+  }
+  if (theta_a + theta_d <= theta_b) {
+    axis = b;
+    cos_theta_o = other_cos_theta_o;
+    return;
+  }
+
+  const float theta_o = 0.5f * (theta_a + theta_d + theta_b);
+  if (theta_o >= M_PI_2_F) {
+    cos_theta_o = -1.0f;
+    return;
+  }
+
+  /* Rotate the axis towards the other cone. */
+  const float theta_r = theta_o - theta_a;
+  const float3 ortho = normalize(b - axis * dot(axis, b));
+  axis = normalize(axis * cosf(theta_r) + ortho * sinf(theta_r));
+  cos_theta_o = cosf(theta_o);
+}
+
+static int light_tree_ceil_log2(size_t n)
+{
+  int log2 = 0;
+  while (((size_t)1 << log2) < n) {
+    log2++;
+  }
+  return log2;
+}
+
+/* Split emitters in two, returns the number of emitters on the left. */
+static size_t light_tree_split(LightTreeEmitter *emitters,
+                               size_t num,
+                               const BoundBox &centroid_bbox,
+                               bool balanced)
+{
+  const float3 extent = centroid_bbox.size();
+  const int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 :
+                   (extent.y >= extent.z) ? 1 :
+                                            2;
+  const float axis_min = centroid_bbox.min[axis];
+  const float axis_extent = extent[axis];
+
+  if (!balanced && axis_extent > 0.0f) {
+    /* Bin emitters along the widest axis and pick the split with the lowest
+     * cost, the energy weighted surface area of both sides. */
+    const int num_bins = 12;
+    BoundBox bin_bbox[num_bins];
+    float bin_energy[num_bins];
+    size_t bin_count[num_bins];
+    for (int i = 0; i < num_bins; i++) {
+      bin_bbox[i] = BoundBox::empty;
+      bin_energy[i] = 0.0f;
+      bin_count[i] = 0;
+    }
+
+    const float bin_scale = num_bins / axis_extent;
+    for (size_t i = 0; i < num; i++) {
+      const int bin = clamp(
+          (int)((emitters[i].centroid[axis] - axis_min) * bin_scale), 0, num_bins - 1);
+      bin_bbox[bin].grow(emitters[i].bbox);
+      bin_energy[bin] += emitters[i].energy;
+      bin_count[bin]++;
+    }
+
+    /* Sweep from the right to get the cost of the right side of each split. */
+    float right_cost[num_bins];
+    BoundBox right_bbox = BoundBox::empty;
+    float right_energy = 0.0f;
+    for (int i = num_bins - 1; i > 0; i--) {
+      right_bbox.grow(bin_bbox[i]);
+      right_energy += bin_energy[i];
+      right_cost[i] = (right_bbox.valid()) ? right_energy * right_bbox.safe_area() : 0.0f;
+    }
+
+    int best_split = -1;
+    float best_cost = FLT_MAX;
+    BoundBox left_bbox = BoundBox::empty;
+    float left_energy = 0.0f;
+    size_t left_count = 0;
+    for (int i = 0; i < num_bins - 1; i++) {
+      left_bbox.grow(bin_bbox[i]);
+      left_energy += bin_energy[i];
+      left_count += bin_count[i];
+      if (left_count == 0 || left_count == num) {
+        continue;
+      }
+      const float left_cost = (left_bbox.valid()) ? left_energy * left_bbox.safe_area() : 0.0f;
+      const float cost = left_cost + right_cost[i + 1];
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_split = i;
+      }
+    }
+
+    if (best_split != -1) {
+      LightTreeEmitter *middle = std::partition(
+          emitters, emitters + num, [&](const LightTreeEmitter &emitter) {
+            const int bin = clamp(
+                (int)((emitter.centroid[axis] - axis_min) * bin_scale), 0, num_bins - 1);
+            return bin <= best_split;
+          });
+      return middle - emitters;
+    }
+  }
+
+  /* Split in the middle by count, also when all centroids are in the same place. */
+  const size_t half = num / 2;
+  std::nth_element(emitters,
+                   emitters + half,
+                   emitters + num,
+                   [&](const LightTreeEmitter &a, const LightTreeEmitter &b) {
+                     return a.centroid[axis] < b.centroid[axis];
+                   });
+  return half;
+}
+
+/* Build the subtree in depth first order, the left child follows its parent.
+ * The bit trail records the path to each leaf, 1 for the right child. */
+static int light_tree_build_recursive(vector<KernelLightTreeNode> &nodes,
+                                      uint *bit_trail,
+                                      LightTreeEmitter *emitters,
+                                      size_t num,
+                                      int depth,
+                                      uint trail)
+{
+  const int node_index = nodes.size();
+  nodes.push_back(KernelLightTreeNode());
+
+  BoundBox bbox = BoundBox::empty;
+  BoundBox centroid_bbox = BoundBox::empty;
+  float energy = 0.0f;
+  float3 axis = emitters[0].axis;
+  float cos_theta_o = emitters[0].cos_theta_o;
+
+  for (size_t i = 0; i < num; i++) {
+    bbox.grow(emitters[i].bbox);
+    centroid_bbox.grow(emitters[i].centroid);
+    energy += emitters[i].energy;
+    light_tree_cone_merge(axis, cos_theta_o, emitters[i].axis, emitters[i].cos_theta_o);
+  }
+
+  int child;
+  if (num == 1) {
+    child = ~emitters[0].index;
+    bit_trail[emitters[0].index] = trail;
+  }
+  else {
+    /* The bit trail has room for 32 levels, fall back to balanced splits
+     * when an unbalanced one could exceed that. */
+    const bool balanced = (depth + 1 + light_tree_ceil_log2(num) > 32);
+    const size_t num_left = light_tree_split(emitters, num, centroid_bbox, balanced);
+
+    light_tree_build_recursive(nodes, bit_trail, emitters, num_left, depth + 1, trail);
+    child = light_tree_build_recursive(
+        nodes, bit_trail, emitters + num_left, num - num_left, depth + 1, trail | (1u << depth));
+  }
+
+  KernelLightTreeNode &knode = nodes[node_index];
+  knode.bbox_min[0] = bbox.min.x;
+  knode.bbox_min[1] = bbox.min.y;
+  knode.bbox_min[2] = bbox.min.z;
+  knode.energy = energy;
+  knode.bbox_max[0] = bbox.max.x;
+  knode.bbox_max[1] = bbox.max.y;
+  knode.bbox_max[2] = bbox.max.z;
+  knode.cos_theta_o = cos_theta_o;
+  knode.axis[0] = axis.x;
+  knode.axis[1] = axis.y;
+  knode.axis[2] = axis.z;
+  knode.child = child;
+
+  return node_index;
+}
+
+static void light_tree_global_node(KernelLightTreeNode *knode, int index)
+{
+  memset(knode, 0, sizeof(KernelLightTreeNode));
+  knode->cos_theta_o = -1.0f;
+  knode->child = ~index;
+}
+
+static void light_tree_device_update(DeviceScene *dscene,
+                                     vector<LightTreeEmitter> &emitters,
+                                     const vector<int> &global_lights,
+                                     size_t num_distribution)
+{
+  vector<KernelLightTreeNode> nodes;
+  nodes.reserve(emitters.size() * 2 + global_lights.size());
+
+  uint *bit_trail = dscene->light_tree_bit_trail.alloc(max(num_distribution, (size_t)1));
+  memset(bit_trail, 0, sizeof(uint) * dscene->light_tree_bit_trail.size());
+
+  if (!emitters.empty()) {
+    light_tree_build_recursive(nodes, bit_trail, &emitters[0], emitters.size(), 0, 0);
+  }
+  const int num_tree_nodes = nodes.size();
+
+  /* Distant and background lights are stored as leaves after the tree. */
+  KernelLightTreeNode *knodes = dscene->light_tree_nodes.alloc(
+      max(num_tree_nodes + global_lights.size(), (size_t)1));
+  if (num_tree_nodes) {
+    memcpy(knodes, &nodes[0], sizeof(KernelLightTreeNode) * num_tree_nodes);
+  }
+  for (size_t i = 0; i < global_lights.size(); i++) {
+    light_tree_global_node(&knodes[num_tree_nodes + i], global_lights[i]);
+  }
+
+  KernelIntegrator *kintegrator = &dscene->data.integrator;
+  kintegrator->use_light_tree = true;
+  kintegrator->light_tree_num_nodes = num_tree_nodes;
+  kintegrator->light_tree_num_global = global_lights.size();
+
+  /* Probability of picking a distant or background light, or the tree. */
+  const size_t num_choices = global_lights.size() + ((num_tree_nodes) ? 1 : 0);
+  kintegrator->pdf_lights = 1.0f / num_choices;
+
+  VLOG(1) << "Light tree with " << emitters.size() << " emitters, " << num_tree_nodes
+          << " nodes and " << global_lights.size() << " distant or background lights.";
+
+  dscene->light_tree_nodes.copy_to_device();
+  dscene->light_tree_bit_trail.copy_to_device();
+}
+
 void LightManager::device_update_distribution(Device *,
                                               DeviceScene *dscene,
                                               Scene *scene,
@@ -310,6 +577,18 @@ void LightManager::device_update_distribution(Device *,
   KernelLightDistribution *distribution = dscene->light_distribution.alloc(num_distribution + 1);
   float totarea = 0.0f;
 
+  /* Light tree, not used when branched path tracing samples all lights. */
+  Integrator *integrator = scene->integrator;
+  const bool use_light_tree = integrator->use_light_tree &&
+                              !(integrator->method == Integrator::BRANCHED_PATH &&
+                                (integrator->sample_all_lights_direct ||
+                                 integrator->sample_all_lights_indirect));
+  vector<LightTreeEmitter> light_tree_emitters;
+  vector<int> light_tree_global_lights;
+  if (use_light_tree) {
+    light_tree_emitters.reserve(num_distribution);
+  }
+
   /* triangles */
   size_t offset = 0;
   int j = 0;
@@ -328,6 +607,8 @@ void LightManager::device_update_distribution(Device *,
     Transform tfm = object->tfm;
     int object_id = j;
     int shader_flag = 0;
+    /* Normals of moving triangles are unknown, don't bound them. */
+    bool use_normal_bounds = !(object->use_motion() || mesh->has_motion_blur());
 
     if (!(object->visibility & PATH_RAY_DIFFUSE)) {
       shader_flag |= SHADER_EXCLUDE_DIFFUSE;
@@ -374,7 +655,22 @@ void LightManager::device_update_distribution(Device *,
           p3 = transform_point(&tfm, p3);
         }
 
-        totarea += triangle_area(p1, p2, p3);
+        float area = triangle_area(p1, p2, p3);
+        totarea += area;
+
+        if (use_light_tree) {
+          LightTreeEmitter emitter;
+          emitter.bbox = BoundBox::empty;
+          emitter.bbox.grow(p1);
+          emitter.bbox.grow(p2);
+          emitter.bbox.grow(p3);
+          emitter.centroid = (p1 + p2 + p3) * (1.0f / 3.0f);
+          emitter.energy = area * light_tree_emission_estimate(shader);
+          emitter.axis = safe_normalize(cross(p2 - p1, p3 - p1));
+          emitter.cos_theta_o = (use_normal_bounds && area > 0.0f) ? 1.0f : -1.0f;
+          emitter.index = offset - 1;
+          light_tree_emitters.push_back(emitter);
+        }
       }
     }
 
@@ -412,6 +708,41 @@ void LightManager::device_update_distribution(Device *,
       background_mis |= light->use_mis;
     }
 
+    if (use_light_tree) {
+      if (light->type == LIGHT_DISTANT || light->type == LIGHT_BACKGROUND) {
+        light_tree_global_lights.push_back(offset);
+      }
+      else {
+        Shader *shader = (light->shader) ? light->shader : scene->default_light;
+
+        LightTreeEmitter emitter;
+        emitter.bbox = BoundBox::empty;
+        emitter.energy = max(average(light->strength), 0.0f) *
+                         light_tree_emission_estimate(shader);
+        emitter.index = offset;
+
+        if (light->type == LIGHT_AREA) {
+          float3 axisu = light->axisu * (light->sizeu * light->size);
+          float3 axisv = light->axisv * (light->sizev * light->size);
+          emitter.bbox.grow(light->co + 0.5f * (axisu + axisv));
+          emitter.bbox.grow(light->co + 0.5f * (axisu - axisv));
+          emitter.bbox.grow(light->co - 0.5f * (axisu + axisv));
+          emitter.bbox.grow(light->co - 0.5f * (axisu - axisv));
+          emitter.axis = safe_normalize(light->dir);
+          emitter.cos_theta_o = 1.0f;
+        }
+        else {
+          emitter.bbox.grow(light->co - make_float3(light->size));
+          emitter.bbox.grow(light->co + make_float3(light->size));
+          emitter.axis = make_float3(0.0f, 0.0f, 1.0f);
+          emitter.cos_theta_o = -1.0f;
+        }
+        emitter.centroid = emitter.bbox.center();
+
+        light_tree_emitters.push_back(emitter);
+      }
+    }
+
     light_index++;
     offset++;
   }
@@ -461,6 +792,20 @@ void LightManager::device_update_distribution(Device *,
 
     kintegrator->use_lamp_mis = use_lamp_mis;
 
+    /* Light tree replaces the distribution for picking lights. */
+    if (use_light_tree) {
+      light_tree_device_update(
+          dscene, light_tree_emitters, light_tree_global_lights, num_distribution);
+    }
+    else {
+      dscene->light_tree_nodes.free();
+      dscene->light_tree_bit_trail.free();
+
+      kintegrator->use_light_tree = false;
+      kintegrator->light_tree_num_nodes = 0;
+      kintegrator->light_tree_num_global = 0;
+    }
+
     /* bit of an ugly hack to compensate for emitting triangles influencing
      * amount of samples we get for this pass */
     kfilm->pass_shadow_scale = 1.0f;
@@ -488,12 +833,17 @@ void LightManager::device_update_distribution(Device *,
   }
   else {
     dscene->light_distribution.free();
+    dscene->light_tree_nodes.free();
+    dscene->light_tree_bit_trail.free();
 
     kintegrator->num_distribution = 0;
     kintegrator->num_all_lights = 0;
     kintegrator->pdf_triangles = 0.0f;
     kintegrator->pdf_lights = 0.0f;
     kintegrator->use_lamp_mis = false;
+    kintegrator->use_light_tree = false;
+    kintegrator->light_tree_num_nodes = 0;
+    kintegrator->light_tree_num_global = 0;
     kintegrator->num_portals = 0;
     kintegrator->portal_offset = 0;
     kintegrator->portal_pdf = 0.0f;
@@ -933,6 +1283,8 @@ void LightManager::device_update(Device *device,
 void LightManager::device_free(Device *, DeviceScene *dscene)
 {
   dscene->light_distribution.free();
+  dscene->light_tree_nodes.free();
+  dscene->light_tree_bit_trail.free();
   dscene->lights.free();
   dscene->light_background_marginal_cdf.free();
   dscene->light_background_conditional_cdf.free();
@@ -35,9 +35,11 @@
 #include "subd/subd_patch_table.h"
 
 #include "util/util_foreach.h"
+#include "util/util_hash.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
 #include "util/util_set.h"
+#include "util/util_time.h"
 
 #ifdef WITH_EMBREE
 #  include "bvh/bvh_embree.h"
@@ -1045,6 +1047,8 @@ void Mesh::compute_bvh(
       bparams.bvh_type = params->bvh_type;
       bparams.curve_flags = dscene->data.curve.curveflags;
       bparams.curve_subdivisions = dscene->data.curve.subdivisions;
+      bparams.use_compressed_nodes = params->use_bvh_compressed_nodes &&
+                                     bparams.bvh_layout == BVH_LAYOUT_BVH8;
 
       delete bvh;
       bvh = BVH::create(bparams, objects);
@@ -1138,10 +1142,12 @@ MeshManager::MeshManager()
 {
   need_update = true;
   need_flags_update = true;
+  bvh = NULL;
 }
 
 MeshManager::~MeshManager()
 {
+  delete bvh;
 }
 
 void MeshManager::update_osl_attributes(Device *device,
@@ -1883,14 +1889,73 @@ void MeshManager::device_update_mesh(
   }
 }
 
+/* Describes the primitives held by the scene BVH. When it matches between
+ * updates only vertex positions, transforms or visibility changed, and the
+ * BVH can be refit. */
+static void bvh_compute_signature(const BVHParams &bparams,
+                                  const vector<Object *> &objects,
+                                  vector<uint> &signature)
+{
+  signature.clear();
+  signature.push_back(bparams.bvh_layout);
+  signature.push_back(bparams.use_spatial_split);
+  signature.push_back(bparams.use_unaligned_nodes);
+  signature.push_back(bparams.num_motion_triangle_steps);
+  signature.push_back(bparams.num_motion_curve_steps);
+  signature.push_back(bparams.bvh_type);
+  signature.push_back(bparams.curve_flags);
+  signature.push_back(bparams.curve_subdivisions);
+  signature.push_back(bparams.use_compressed_nodes);
+
+  foreach (Object *object, objects) {
+    const Mesh *mesh = object->mesh;
+
+    if (!object->is_traceable()) {
+      signature.push_back(0);
+      continue;
+    }
+    else if (mesh->is_instanced()) {
+      signature.push_back(1);
+      continue;
+    }
+
+    /* Meshes with transform applied have their primitives in the scene BVH. */
+    uint hash = hash_int_2d(mesh->num_triangles(), mesh->num_curves());
+    hash = hash_int_2d(hash, mesh->curve_keys.size());
+    hash = hash_int_2d(hash, mesh->use_motion_blur ? mesh->motion_steps : 0);
+
+    for (size_t i = 0; i < mesh->triangles.size(); i++) {
+      hash = hash_int_2d(hash, mesh->triangles[i]);
+    }
+    for (size_t i = 0; i < mesh->curve_first_key.size(); i++) {
+      hash = hash_int_2d(hash, mesh->curve_first_key[i]);
+    }
+
+    signature.push_back(hash);
+  }
+}
+
+template<typename T>
+static void bvh_copy_to_device(device_vector<T> &dvector, array<T> &data, bool keep_data)
+{
+  if (data.size()) {
+    if (keep_data) {
+      T *ptr = dvector.alloc(data.size());
+      memcpy(ptr, data.data(), sizeof(T) * data.size());
+    }
+    else {
+      dvector.steal_data(data);
+    }
+    dvector.copy_to_device();
+  }
+}
+
 void MeshManager::device_update_bvh(Device *device,
                                     DeviceScene *dscene,
                                     Scene *scene,
                                     Progress &progress)
 {
   /* bvh build */
-  progress.set_status("Updating Scene BVH", "Building");
-
   BVHParams bparams;
   bparams.top_level = true;
   bparams.bvh_layout = BVHParams::best_bvh_layout(scene->params.bvh_layout,
@@ -1903,19 +1968,46 @@ void MeshManager::device_update_bvh(Device *device,
   bparams.bvh_type = scene->params.bvh_type;
   bparams.curve_flags = dscene->data.curve.curveflags;
   bparams.curve_subdivisions = dscene->data.curve.subdivisions;
+  bparams.use_compressed_nodes = scene->params.use_bvh_compressed_nodes &&
+                                 bparams.bvh_layout == BVH_LAYOUT_BVH8;
+
+  VLOG(1) << "Using " << bvh_layout_name(bparams.bvh_layout) << " layout"
+          << (bparams.use_compressed_nodes ? " with compressed nodes." : ".");
+
+  /* With persistent data, keep the BVH for the next update. Embree builds
+   * its own acceleration structure which we can't refit here. */
+  const bool keep_bvh = scene->params.persistent_data &&
+                        bparams.bvh_layout != BVH_LAYOUT_EMBREE;
+
+  vector<uint> signature;
+  if (keep_bvh) {
+    bvh_compute_signature(bparams, scene->objects, signature);
+  }
 
-  VLOG(1) << "Using " << bvh_layout_name(bparams.bvh_layout) << " layout.";
+  const bool refit = keep_bvh && bvh != NULL && signature == bvh_signature;
+  scoped_timer timer;
+
+  if (refit) {
+    progress.set_status("Updating Scene BVH", "Refitting");
+
+    bvh->objects = scene->objects;
+    bvh->refit(progress);
+  }
+  else {
+    progress.set_status("Updating Scene BVH", "Building");
 
 #ifdef WITH_EMBREE
-  if (bparams.bvh_layout == BVH_LAYOUT_EMBREE) {
-    if (dscene->data.bvh.scene) {
-      BVHEmbree::destroy(dscene->data.bvh.scene);
+    if (bparams.bvh_layout == BVH_LAYOUT_EMBREE) {
+      if (dscene->data.bvh.scene) {
+        BVHEmbree::destroy(dscene->data.bvh.scene);
+      }
     }
-  }
 #endif
 
-  BVH *bvh = BVH::create(bparams, scene->objects);
-  bvh->build(progress, &device->stats);
+    delete bvh;
+    bvh = BVH::create(bparams, scene->objects);
+    bvh->build(progress, &device->stats);
+  }
 
   if (progress.get_cancel()) {
 #ifdef WITH_EMBREE
@@ -1926,58 +2018,38 @@ void MeshManager::device_update_bvh(Device *device,
     }
 #endif
     delete bvh;
+    bvh = NULL;
+    bvh_signature.clear();
     return;
   }
 
+  VLOG(1) << "Scene BVH " << (refit ? "refit" : "build") << " time " << timer.get_time()
+          << " seconds.";
+
   /* copy to device */
   progress.set_status("Updating Scene BVH", "Copying BVH to device");
 
   PackedBVH &pack = bvh->pack;
 
-  if (pack.nodes.size()) {
-    dscene->bvh_nodes.steal_data(pack.nodes);
-    dscene->bvh_nodes.copy_to_device();
-  }
-  if (pack.leaf_nodes.size()) {
-    dscene->bvh_leaf_nodes.steal_data(pack.leaf_nodes);
-    dscene->bvh_leaf_nodes.copy_to_device();
-  }
-  if (pack.object_node.size()) {
-    dscene->object_node.steal_data(pack.object_node);
-    dscene->object_node.copy_to_device();
-  }
-  if (pack.prim_tri_index.size()) {
-    dscene->prim_tri_index.steal_data(pack.prim_tri_index);
-    dscene->prim_tri_index.copy_to_device();
-  }
-  if (pack.prim_tri_verts.size()) {
-    dscene->prim_tri_verts.steal_data(pack.prim_tri_verts);
-    dscene->prim_tri_verts.copy_to_device();
-  }
-  if (pack.prim_type.size()) {
-    dscene->prim_type.steal_data(pack.prim_type);
-    dscene->prim_type.copy_to_device();
-  }
-  if (pack.prim_visibility.size()) {
-    dscene->prim_visibility.steal_data(pack.prim_visibility);
-    dscene->prim_visibility.copy_to_device();
-  }
-  if (pack.prim_index.size()) {
-    dscene->prim_index.steal_data(pack.prim_index);
-    dscene->prim_index.copy_to_device();
-  }
-  if (pack.prim_object.size()) {
-    dscene->prim_object.steal_data(pack.prim_object);
-    dscene->prim_object.copy_to_device();
-  }
-  if (pack.prim_time.size()) {
-    dscene->prim_time.steal_data(pack.prim_time);
-    dscene->prim_time.copy_to_device();
-  }
+  VLOG(1) << "Scene BVH nodes memory "
+          << string_human_readable_size((pack.nodes.size() + pack.leaf_nodes.size()) *
+                                        sizeof(int4));
+
+  bvh_copy_to_device(dscene->bvh_nodes, pack.nodes, keep_bvh);
+  bvh_copy_to_device(dscene->bvh_leaf_nodes, pack.leaf_nodes, keep_bvh);
+  bvh_copy_to_device(dscene->object_node, pack.object_node, keep_bvh);
+  bvh_copy_to_device(dscene->prim_tri_index, pack.prim_tri_index, keep_bvh);
+  bvh_copy_to_device(dscene->prim_tri_verts, pack.prim_tri_verts, keep_bvh);
+  bvh_copy_to_device(dscene->prim_type, pack.prim_type, keep_bvh);
+  bvh_copy_to_device(dscene->prim_visibility, pack.prim_visibility, keep_bvh);
+  bvh_copy_to_device(dscene->prim_index, pack.prim_index, keep_bvh);
+  bvh_copy_to_device(dscene->prim_object, pack.prim_object, keep_bvh);
+  bvh_copy_to_device(dscene->prim_time, pack.prim_time, keep_bvh);
 
   dscene->data.bvh.root = pack.root_index;
   dscene->data.bvh.bvh_layout = bparams.bvh_layout;
   dscene->data.bvh.use_bvh_steps = (scene->params.num_bvh_time_steps != 0);
+  dscene->data.bvh.use_compressed_nodes = bparams.use_compressed_nodes;
 
 #ifdef WITH_EMBREE
   if (bparams.bvh_layout == BVH_LAYOUT_EMBREE) {
@@ -1988,7 +2060,14 @@ void MeshManager::device_update_bvh(Device *device,
   }
 #endif
 
-  delete bvh;
+  if (keep_bvh) {
+    bvh_signature.swap(signature);
+  }
+  else {
+    delete bvh;
+    bvh = NULL;
+    bvh_signature.clear();
+  }
 }
 
 void MeshManager::device_update_preprocess(Device *device, Scene *scene, Progress &progress)
@@ -2232,6 +2311,7 @@ void MeshManager::device_update(Device *device,
   }
 
   TaskPool pool;
+  scoped_timer timer;
 
   size_t i = 0;
   foreach (Mesh *mesh, scene->meshes) {
@@ -2247,6 +2327,7 @@ void MeshManager::device_update(Device *device,
   TaskPool::Summary summary;
   pool.wait_work(&summary);
   VLOG(2) << "Objects BVH build pool statistics:\n" << summary.full_report();
+  VLOG(1) << "Objects BVH build time " << timer.get_time() << " seconds.";
 
   foreach (Shader *shader, scene->shaders) {
     shader->need_update_mesh = false;
@@ -373,6 +373,11 @@ class MeshManager {
   void collect_statistics(const Scene *scene, RenderStats *stats);
 
  protected:
+  /* Scene BVH kept between updates with persistent data, refit instead of
+   * rebuilt when its signature did not change. */
+  BVH *bvh;
+  vector<uint> bvh_signature;
+
   /* Calculate verts/triangles/curves offsets in global arrays. */
   void mesh_calc_offset(Scene *scene);
 
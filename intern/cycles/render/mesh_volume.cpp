@@ -21,6 +21,7 @@
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
+#include "util/util_sparse_grid.h"
 #include "util/util_types.h"
 
 CCL_NAMESPACE_BEGIN
@@ -360,6 +361,22 @@ void VolumeMeshBuilder::convert_quads_to_tris(const vector<QuadData> &quads,
 struct VoxelAttributeGrid {
   float *data;
   int channels;
+  bool is_sparse;
+
+  /* Offset of the voxel in data, or -1 if it is in an empty tile of a
+   * sparse grid. */
+  size_t voxel_offset(const int3 &resolution, int x, int y, int z) const
+  {
+    if (is_sparse) {
+      const int tile_offset = sparse_grid_tile_offset(
+          data, resolution.x, resolution.y, x, y, z);
+      if (tile_offset == SPARSE_TILE_EMPTY) {
+        return -1;
+      }
+      return (tile_offset + sparse_grid_voxel_offset(x, y, z)) * (size_t)channels;
+    }
+    return compute_voxel_index(resolution, x, y, z) * channels;
+  }
 };
 
 void MeshManager::create_volume_mesh(Scene *scene, Mesh *mesh, Progress &progress)
@@ -394,6 +411,7 @@ void MeshManager::create_volume_mesh(Scene *scene, Mesh *mesh, Progress &progres
     VoxelAttributeGrid voxel_grid;
     voxel_grid.data = static_cast<float *>(image_memory->host_pointer);
     voxel_grid.channels = image_memory->data_elements;
+    voxel_grid.is_sparse = image_memory->is_sparse_grid;
     voxel_grids.push_back(voxel_grid);
   }
 
@@ -447,19 +465,55 @@ void MeshManager::create_volume_mesh(Scene *scene, Mesh *mesh, Progress &progres
   VolumeMeshBuilder builder(&volume_params);
   const float isovalue = mesh->volume_isovalue;
 
-  for (int z = 0; z < resolution.z; ++z) {
-    for (int y = 0; y < resolution.y; ++y) {
-      for (int x = 0; x < resolution.x; ++x) {
-        size_t voxel_index = compute_voxel_index(resolution, x, y, z);
+  /* Empty tiles of sparse grids are zero, so they can be skipped unless zero
+   * is above the isovalue. */
+  const bool skip_empty_tiles = (isovalue > 0.0f);
+
+  for (int tz = 0; tz < resolution.z; tz += SPARSE_TILE_SIZE) {
+    for (int ty = 0; ty < resolution.y; ty += SPARSE_TILE_SIZE) {
+      for (int tx = 0; tx < resolution.x; tx += SPARSE_TILE_SIZE) {
+        if (skip_empty_tiles) {
+          bool is_empty = true;
+
+          for (size_t i = 0; i < voxel_grids.size(); ++i) {
+            const VoxelAttributeGrid &voxel_grid = voxel_grids[i];
+            if (!voxel_grid.is_sparse || sparse_grid_tile_offset(voxel_grid.data,
+                                                                 resolution.x,
+                                                                 resolution.y,
+                                                                 tx,
+                                                                 ty,
+                                                                 tz) != SPARSE_TILE_EMPTY) {
+              is_empty = false;
+              break;
+            }
+          }
 
-        for (size_t i = 0; i < voxel_grids.size(); ++i) {
-          const VoxelAttributeGrid &voxel_grid = voxel_grids[i];
-          const int channels = voxel_grid.channels;
+          if (is_empty) {
+            continue;
+          }
+        }
 
-          for (int c = 0; c < channels; c++) {
-            if (voxel_grid.data[voxel_index * channels + c] >= isovalue) {
-              builder.add_node_with_padding(x, y, z);
-              break;
+        const int z_end = min(tz + SPARSE_TILE_SIZE, resolution.z);
+        const int y_end = min(ty + SPARSE_TILE_SIZE, resolution.y);
+        const int x_end = min(tx + SPARSE_TILE_SIZE, resolution.x);
+
+        for (int z = tz; z < z_end; ++z) {
+          for (int y = ty; y < y_end; ++y) {
+            for (int x = tx; x < x_end; ++x) {
+              for (size_t i = 0; i < voxel_grids.size(); ++i) {
+                const VoxelAttributeGrid &voxel_grid = voxel_grids[i];
+                const int channels = voxel_grid.channels;
+                const size_t voxel_offset = voxel_grid.voxel_offset(resolution, x, y, z);
+
+                for (int c = 0; c < channels; c++) {
+                  const float value = (voxel_offset == -1) ? 0.0f :
+                                                             voxel_grid.data[voxel_offset + c];
+                  if (value >= isovalue) {
+                    builder.add_node_with_padding(x, y, z);
+                    break;
+                  }
+                }
+              }
             }
           }
         }
@@ -499,9 +553,14 @@ void MeshManager::create_volume_mesh(Scene *scene, Mesh *mesh, Progress &progres
                  (1024.0 * 1024.0)
           << "Mb.";
 
-  VLOG(1) << "Memory usage volume grid: "
-          << (resolution.x * resolution.y * resolution.z * sizeof(float)) / (1024.0 * 1024.0)
-          << "Mb.";
+  size_t grid_memory = 0;
+  foreach (Attribute &attr, mesh->attributes.attributes) {
+    if (attr.element == ATTR_ELEMENT_VOXEL) {
+      grid_memory += scene->image_manager->image_memory(attr.data_voxel()->slot)->memory_size();
+    }
+  }
+
+  VLOG(1) << "Memory usage volume grid: " << grid_memory / (1024.0 * 1024.0) << "Mb.";
 }
 
 CCL_NAMESPACE_END
@@ -107,6 +107,8 @@ class DeviceScene {
   device_vector<KernelLight> lights;
   device_vector<float2> light_background_marginal_cdf;
   device_vector<float2> light_background_conditional_cdf;
+  device_vector<KernelLightTreeNode> light_tree_nodes;
+  device_vector<uint> light_tree_bit_trail;
 
   /* particles */
   device_vector<KernelParticle> particles;
@@ -166,9 +168,14 @@ class SceneParams {
   BVHType bvh_type;
   bool use_bvh_spatial_split;
   bool use_bvh_unaligned_nodes;
+  bool use_bvh_compressed_nodes;
   int num_bvh_time_steps;
   bool persistent_data;
   int texture_limit;
+  /* Memory limit of the texture cache in megabytes, zero disables it. */
+  int texture_cache_size;
+  /* Store mostly empty volumes as sparse grids, to reduce memory usage. */
+  bool use_sparse_grids;
 
   SceneParams()
   {
@@ -177,9 +184,12 @@ class SceneParams {
     bvh_type = BVH_DYNAMIC;
     use_bvh_spatial_split = false;
     use_bvh_unaligned_nodes = true;
+    use_bvh_compressed_nodes = false;
     num_bvh_time_steps = 0;
     persistent_data = false;
     texture_limit = 0;
+    texture_cache_size = 0;
+    use_sparse_grids = false;
   }
 
   bool modified(const SceneParams &params)
@@ -188,8 +198,11 @@ class SceneParams {
              bvh_type == params.bvh_type &&
              use_bvh_spatial_split == params.use_bvh_spatial_split &&
              use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes &&
+             use_bvh_compressed_nodes == params.use_bvh_compressed_nodes &&
              num_bvh_time_steps == params.num_bvh_time_steps &&
-             persistent_data == params.persistent_data && texture_limit == params.texture_limit);
+             persistent_data == params.persistent_data && texture_limit == params.texture_limit &&
+             texture_cache_size == params.texture_cache_size &&
+             use_sparse_grids == params.use_sparse_grids);
   }
 };
 
@@ -63,6 +63,12 @@ Session::Session(const SessionParams &params_)
 
   device = Device::create(params.device, stats, profiler, params.background);
 
+  /* Split the last tiles of a final render, so that render threads don't sit idle while a few
+   * large tiles finish. */
+  if (params.background && params.split_tiles) {
+    tile_manager.split_tiles_threshold = num_render_threads(params.device);
+  }
+
   if (params.background && !params.write_render_cb) {
     buffers = NULL;
     display = NULL;
@@ -374,6 +380,20 @@ bool Session::draw_cpu(BufferParams &buffer_params, DeviceDrawParams &draw_param
   return false;
 }
 
+/* Number of threads acquiring tiles, one for every CPU thread and one for every other device. */
+int Session::num_render_threads(const DeviceInfo &info)
+{
+  if (info.type == DEVICE_MULTI) {
+    int num_threads = 0;
+    foreach (const DeviceInfo &subinfo, info.multi_devices) {
+      num_threads += num_render_threads(subinfo);
+    }
+    return num_threads;
+  }
+
+  return (info.type == DEVICE_CPU) ? TaskScheduler::num_threads() : 1;
+}
+
 bool Session::acquire_tile(Device *tile_device, RenderTile &rtile)
 {
   if (progress.get_cancel()) {
@@ -403,6 +423,10 @@ bool Session::acquire_tile(Device *tile_device, RenderTile &rtile)
   rtile.tile_index = tile->index;
   rtile.task = (tile->state == Tile::DENOISE) ? RenderTile::DENOISE : RenderTile::PATH_TRACE;
 
+  /* Tiles may be split by other threads once the lock is released, which can reallocate the
+   * tiles array, so only access the tile through its index from here on. */
+  RenderBuffers *tile_buffers = tile->buffers;
+
   tile_lock.unlock();
 
   /* in case of a permanent buffer, return it, otherwise we will allocate
@@ -418,7 +442,7 @@ bool Session::acquire_tile(Device *tile_device, RenderTile &rtile)
     return true;
   }
 
-  if (tile->buffers == NULL) {
+  if (tile_buffers == NULL) {
     /* fill buffer parameters */
     BufferParams buffer_params = tile_manager.params;
     buffer_params.full_x = rtile.x;
@@ -427,14 +451,18 @@ bool Session::acquire_tile(Device *tile_device, RenderTile &rtile)
     buffer_params.height = rtile.h;
 
     /* allocate buffers */
-    tile->buffers = new RenderBuffers(tile_device);
-    tile->buffers->reset(buffer_params);
+    tile_buffers = new RenderBuffers(tile_device);
+    tile_buffers->reset(buffer_params);
+
+    tile_lock.lock();
+    tile_manager.state.tiles[rtile.tile_index].buffers = tile_buffers;
+    tile_lock.unlock();
   }
 
-  tile->buffers->params.get_offset_stride(rtile.offset, rtile.stride);
+  tile_buffers->params.get_offset_stride(rtile.offset, rtile.stride);
 
-  rtile.buffer = tile->buffers->buffer.device_pointer;
-  rtile.buffers = tile->buffers;
+  rtile.buffer = tile_buffers->buffer.device_pointer;
+  rtile.buffers = tile_buffers;
   rtile.sample = tile_manager.state.sample;
 
   /* this will tag tile as IN PROGRESS in blender-side render pipeline,
@@ -1024,6 +1052,11 @@ void Session::render()
   task.update_progress_sample = function_bind(&Progress::add_samples, &this->progress, _1, _2);
   task.need_finish_queue = params.progressive_refine;
   task.integrator_branched = scene->integrator->method == Integrator::BRANCHED_PATH;
+  task.adaptive_sampling.use = scene->integrator->use_adaptive_sampling &&
+                               scene->dscene.data.film.pass_adaptive_aux_buffer &&
+                               device->info.has_adaptive_stop_per_sample;
+  task.adaptive_sampling.adaptive_step = scene->dscene.data.integrator.adaptive_step;
+  task.adaptive_sampling.min_samples = scene->dscene.data.integrator.adaptive_min_samples;
   task.requested_tile_size = params.tile_size;
   task.passes_size = tile_manager.params.get_passes_size();
 
@@ -55,6 +55,7 @@ class SessionParams {
   int start_resolution;
   int pixel_size;
   int threads;
+  bool split_tiles;
 
   bool use_profiling;
 
@@ -86,6 +87,7 @@ class SessionParams {
     start_resolution = INT_MAX;
     pixel_size = 1;
     threads = 0;
+    split_tiles = true;
 
     use_profiling = false;
 
@@ -106,12 +108,15 @@ class SessionParams {
 
   bool modified(const SessionParams &params)
   {
-    return !(device == params.device && background == params.background &&
+    return !(device == params.device &&
+             device.use_split_kernel == params.device.use_split_kernel &&
+             background == params.background &&
              progressive_refine == params.progressive_refine
              /* && samples == params.samples */
              && progressive == params.progressive && experimental == params.experimental &&
              tile_size == params.tile_size && start_resolution == params.start_resolution &&
              pixel_size == params.pixel_size && threads == params.threads &&
+             split_tiles == params.split_tiles &&
              use_profiling == params.use_profiling &&
              display_buffer_linear == params.display_buffer_linear &&
              cancel_timeout == params.cancel_timeout && reset_timeout == params.reset_timeout &&
@@ -188,6 +193,8 @@ class Session {
   bool draw_gpu(BufferParams &params, DeviceDrawParams &draw_params);
   void reset_gpu(BufferParams &params, int samples);
 
+  static int num_render_threads(const DeviceInfo &info);
+
   bool acquire_tile(Device *tile_device, RenderTile &tile);
   void update_tile_sample(RenderTile &tile);
   void release_tile(RenderTile &tile);
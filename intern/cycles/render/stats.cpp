@@ -45,6 +45,12 @@ bool namedSampleCountPairComparator(const NamedSampleCountPair &a, const NamedSa
   return a.samples > b.samples;
 }
 
+bool namedTextureCacheEntryComparator(const NamedTextureCacheEntry &a,
+                                      const NamedTextureCacheEntry &b)
+{
+  return a.bytes_read > b.bytes_read;
+}
+
 }  // namespace
 
 NamedSizeEntry::NamedSizeEntry() : name(""), size(0)
@@ -164,12 +170,10 @@ void NamedSampleCountStats::add(const ustring &name, uint64_t samples, uint64_t
   entries.emplace(name, NamedSampleCountPair(name, samples, hits));
 }
 
-string NamedSampleCountStats::full_report(int indent_level)
+vector<NamedSampleCountPair> NamedSampleCountStats::sorted_entries(double *avg_samples_per_hit)
 {
-  const string indent(indent_level * kIndentNumSpaces, ' ');
-
-  vector<NamedSampleCountPair> sorted_entries;
-  sorted_entries.reserve(entries.size());
+  vector<NamedSampleCountPair> sorted;
+  sorted.reserve(entries.size());
 
   uint64_t total_hits = 0, total_samples = 0;
   foreach (entry_map::const_reference entry, entries) {
@@ -178,14 +182,26 @@ string NamedSampleCountStats::full_report(int indent_level)
     total_hits += pair.hits;
     total_samples += pair.samples;
 
-    sorted_entries.push_back(pair);
+    sorted.push_back(pair);
+  }
+
+  if (avg_samples_per_hit) {
+    *avg_samples_per_hit = ((double)total_samples) / total_hits;
   }
-  const double avg_samples_per_hit = ((double)total_samples) / total_hits;
 
-  sort(sorted_entries.begin(), sorted_entries.end(), namedSampleCountPairComparator);
+  sort(sorted.begin(), sorted.end(), namedSampleCountPairComparator);
+  return sorted;
+}
+
+string NamedSampleCountStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+
+  double avg_samples_per_hit;
+  vector<NamedSampleCountPair> sorted = sorted_entries(&avg_samples_per_hit);
 
   string result = "";
-  foreach (const NamedSampleCountPair &entry, sorted_entries) {
+  foreach (const NamedSampleCountPair &entry, sorted) {
     const double seconds = entry.samples * 0.001;
     const double relative = ((double)entry.samples) / (entry.hits * avg_samples_per_hit);
 
@@ -210,6 +226,64 @@ string MeshStats::full_report(int indent_level)
   return result;
 }
 
+/* Texture cache statistics. */
+
+NamedTextureCacheEntry::NamedTextureCacheEntry(const string &name,
+                                               uint64_t tile_misses,
+                                               uint64_t bytes_read,
+                                               int mip_levels_used)
+    : name(name),
+      tile_misses(tile_misses),
+      bytes_read(bytes_read),
+      mip_levels_used(mip_levels_used)
+{
+}
+
+TextureCacheStats::TextureCacheStats()
+    : tile_lookups(0), tile_misses(0), memory_used(0), memory_limit(0)
+{
+}
+
+void TextureCacheStats::add_entry(const NamedTextureCacheEntry &entry)
+{
+  entries.push_back(entry);
+}
+
+string TextureCacheStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  const string double_indent = indent + indent;
+  const double hit_ratio = (tile_lookups) ?
+                               100.0 * (double)(tile_lookups - tile_misses) / tile_lookups :
+                               0.0;
+  string result = "";
+  result += string_printf("%sMemory: %s of %s\n",
+                          indent.c_str(),
+                          string_human_readable_size(memory_used).c_str(),
+                          string_human_readable_size(memory_limit).c_str());
+  result += string_printf("%sTile lookups: %s, misses: %s (hit ratio %.2f%%)\n",
+                          indent.c_str(),
+                          string_human_readable_number(tile_lookups).c_str(),
+                          string_human_readable_number(tile_misses).c_str(),
+                          hit_ratio);
+  sort(entries.begin(), entries.end(), namedTextureCacheEntryComparator);
+  foreach (const NamedTextureCacheEntry &entry, entries) {
+    string mip_levels = "";
+    for (int level = 0; level < 32; level++) {
+      if (entry.mip_levels_used & (1 << level)) {
+        mip_levels += string_printf("%s%d", (mip_levels.empty()) ? "" : " ", level);
+      }
+    }
+    result += string_printf("%s%-32s %s read, %s tile misses, mipmap levels: %s\n",
+                            double_indent.c_str(),
+                            entry.name.c_str(),
+                            string_human_readable_size(entry.bytes_read).c_str(),
+                            string_human_readable_number(entry.tile_misses).c_str(),
+                            mip_levels.c_str());
+  }
+  return result;
+}
+
 /* Image statistics. */
 
 ImageStats::ImageStats()
@@ -221,6 +295,9 @@ string ImageStats::full_report(int indent_level)
   const string indent(indent_level * kIndentNumSpaces, ' ');
   string result = "";
   result += indent + "Textures:\n" + textures.full_report(indent_level + 1);
+  if (cache.entries.size()) {
+    result += indent + "Texture cache:\n" + cache.full_report(indent_level + 1);
+  }
   return result;
 }
 
@@ -105,6 +105,10 @@ class NamedSampleCountStats {
   string full_report(int indent_level = 0);
   void add(const ustring &name, uint64_t samples, uint64_t hits);
 
+  /* Entries sorted by time spent, most expensive first. Optionally returns the average
+   * number of time samples per hit, which is used to estimate relative cost. */
+  vector<NamedSampleCountPair> sorted_entries(double *avg_samples_per_hit = NULL);
+
   typedef unordered_map<ustring, NamedSampleCountPair, ustringHash> entry_map;
   entry_map entries;
 };
@@ -124,6 +128,41 @@ class MeshStats {
   NamedSizeStats geometry;
 };
 
+/* Named entry of an image read on demand through the texture cache. */
+class NamedTextureCacheEntry {
+ public:
+  NamedTextureCacheEntry(const string &name,
+                         uint64_t tile_misses,
+                         uint64_t bytes_read,
+                         int mip_levels_used);
+
+  string name;
+  /* Tiles which had to be read from file. */
+  uint64_t tile_misses;
+  uint64_t bytes_read;
+  /* Bit field of the mipmap levels which were accessed. */
+  int mip_levels_used;
+};
+
+/* Statistics about the texture cache. Tile lookups and misses are only
+ * known for the cache as a whole, per image only the tiles read from file. */
+class TextureCacheStats {
+ public:
+  TextureCacheStats();
+
+  void add_entry(const NamedTextureCacheEntry &entry);
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  uint64_t tile_lookups;
+  uint64_t tile_misses;
+  size_t memory_used;
+  size_t memory_limit;
+
+  vector<NamedTextureCacheEntry> entries;
+};
+
 /* Statistics about images held in memory. */
 class ImageStats {
  public:
@@ -133,6 +172,7 @@ class ImageStats {
   string full_report(int indent_level = 0);
 
   NamedSizeStats textures;
+  TextureCacheStats cache;
 };
 
 /* Render process statistics. */
@@ -106,6 +106,7 @@ TileManager::TileManager(bool progressive_,
   preserve_tile_device = preserve_tile_device_;
   background = background_;
   schedule_denoising = false;
+  split_tiles_threshold = 0;
 
   range_start_sample = 0;
   range_num_samples = -1;
@@ -477,6 +478,59 @@ bool TileManager::finish_tile(int index, bool &delete_tile)
   }
 }
 
+/* Tiles are not split below this size, smaller tiles have too much per tile overhead. */
+#define TILE_SPLIT_MIN_SIZE 16
+
+void TileManager::split_render_tiles(list<int> &tile_list)
+{
+  /* Denoising needs the regular tile grid to find neighbors, and progressive rendering
+   * regenerates the same tiles for every sample. */
+  if (split_tiles_threshold == 0 || schedule_denoising || progressive) {
+    return;
+  }
+
+  while (!tile_list.empty() && (int)tile_list.size() < split_tiles_threshold) {
+    /* Find the largest remaining tile, it is the one that would finish last. */
+    list<int>::iterator largest = tile_list.begin();
+    for (list<int>::iterator it = tile_list.begin(); it != tile_list.end(); it++) {
+      const Tile &tile = state.tiles[*it];
+      const Tile &largest_tile = state.tiles[*largest];
+      if (tile.w * tile.h > largest_tile.w * largest_tile.h) {
+        largest = it;
+      }
+    }
+
+    /* Halve along the longest axis, so tiles stay roughly square. */
+    Tile &tile = state.tiles[*largest];
+    const bool split_x = (tile.w >= tile.h);
+    const int size = split_x ? tile.w : tile.h;
+    if (size < 2 * TILE_SPLIT_MIN_SIZE) {
+      break;
+    }
+
+    const int split = size / 2;
+    const int index = state.tiles.size();
+    Tile new_tile = tile;
+    new_tile.index = index;
+
+    if (split_x) {
+      tile.w = split;
+      new_tile.x += split;
+      new_tile.w -= split;
+    }
+    else {
+      tile.h = split;
+      new_tile.y += split;
+      new_tile.h -= split;
+    }
+
+    /* Note that this invalidates the reference to the split tile. */
+    state.tiles.push_back(new_tile);
+    tile_list.insert(++largest, index);
+    state.num_tiles++;
+  }
+}
+
 bool TileManager::next_tile(Tile *&tile, int device)
 {
   int logical_device = preserve_tile_device ? device : 0;
@@ -494,6 +548,8 @@ bool TileManager::next_tile(Tile *&tile, int device)
   if (state.render_tiles[logical_device].empty())
     return false;
 
+  split_render_tiles(state.render_tiles[logical_device]);
+
   int idx = state.render_tiles[logical_device].front();
   state.render_tiles[logical_device].pop_front();
   tile = &state.tiles[idx];
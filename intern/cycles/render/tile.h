@@ -128,6 +128,12 @@ class TileManager {
   /* Schedule tiles for denoising after they've been rendered. */
   bool schedule_denoising;
 
+  /* ** Tile splitting at the end of the frame. ** */
+
+  /* Once fewer tiles than this are left to render, the largest remaining tiles are split in
+   * half so that all render threads have work until the frame is done. Zero disables it. */
+  int split_tiles_threshold;
+
  protected:
   void set_tiles();
 
@@ -161,6 +167,9 @@ class TileManager {
   int gen_tiles(bool sliced);
   void gen_render_tiles();
 
+  /* Split queued tiles while there are fewer than split_tiles_threshold of them. */
+  void split_render_tiles(list<int> &tile_list);
+
   int get_neighbor_index(int index, int neighbor);
   bool check_neighbor_state(int index, Tile::State state);
 };
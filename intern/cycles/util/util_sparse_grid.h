@@ -0,0 +1,160 @@
+/*
+ * Copyright 2011-2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTIL_SPARSE_GRID_H__
+#define __UTIL_SPARSE_GRID_H__
+
+#include <algorithm>
+#include <limits.h>
+#include <string.h>
+
+#include "util/util_math.h"
+#include "util/util_texture.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+/* Sparse Grid
+ *
+ * Volumes are often mostly empty, so instead of a dense 3D array they can be
+ * stored as tiles of SPARSE_TILE_SIZE^3 voxels, with only the tiles that have
+ * any non-zero voxel allocated.
+ *
+ * The grid starts with an index holding one int per tile in x, y, z order.
+ * It is the offset in voxels from the start of the grid to the tile, or
+ * SPARSE_TILE_EMPTY for tiles where all voxels are zero. The tiles follow the
+ * index, aligned to 16 bytes, with voxels also in x, y, z order. Tiles on the
+ * border of the grid are padded to the full tile size.
+ *
+ * The index is also used to skip empty tiles when building the volume
+ * bounding mesh. The integrator itself doesn't read it, it only skips empty
+ * space outside of the bounding mesh. */
+
+CCL_NAMESPACE_BEGIN
+
+/* Offset of the tile containing a voxel, or SPARSE_TILE_EMPTY. */
+ccl_device_inline int sparse_grid_tile_offset(
+    const void *grid, int width, int height, int x, int y, int z)
+{
+  const int tiles_x = (width + SPARSE_TILE_MASK) >> SPARSE_TILE_SHIFT;
+  const int tiles_y = (height + SPARSE_TILE_MASK) >> SPARSE_TILE_SHIFT;
+  const int tile = (x >> SPARSE_TILE_SHIFT) +
+                   ((y >> SPARSE_TILE_SHIFT) + (z >> SPARSE_TILE_SHIFT) * tiles_y) * tiles_x;
+  return ((const int *)grid)[tile];
+}
+
+/* Offset of a voxel within its tile. */
+ccl_device_inline int sparse_grid_voxel_offset(int x, int y, int z)
+{
+  return (x & SPARSE_TILE_MASK) +
+         ((((z & SPARSE_TILE_MASK) << SPARSE_TILE_SHIFT) + (y & SPARSE_TILE_MASK))
+          << SPARSE_TILE_SHIFT);
+}
+
+/* Size of the tile index, in voxels of type T. */
+template<typename T> inline size_t sparse_grid_index_size(size_t num_tiles)
+{
+  return align_up(num_tiles * sizeof(int), 16) / sizeof(T);
+}
+
+/* Convert a dense grid to a sparse grid. Returns false and leaves the output
+ * empty if the sparse grid would not use less memory than the dense grid. */
+template<typename T>
+bool sparse_grid_create(
+    const T *dense, size_t width, size_t height, size_t depth, vector<T> *sparse)
+{
+  const size_t tiles_x = divide_up(width, SPARSE_TILE_SIZE);
+  const size_t tiles_y = divide_up(height, SPARSE_TILE_SIZE);
+  const size_t tiles_z = divide_up(depth, SPARSE_TILE_SIZE);
+  const size_t num_tiles = tiles_x * tiles_y * tiles_z;
+  const size_t tile_voxels = SPARSE_TILE_SIZE * SPARSE_TILE_SIZE * SPARSE_TILE_SIZE;
+  const size_t index_size = sparse_grid_index_size<T>(num_tiles);
+
+  T zero;
+  memset(&zero, 0, sizeof(zero));
+
+  /* Find non-empty tiles. */
+  vector<int> offsets(num_tiles, SPARSE_TILE_EMPTY);
+  size_t num_voxels = index_size;
+
+  for (size_t tz = 0; tz < tiles_z; tz++) {
+    for (size_t ty = 0; ty < tiles_y; ty++) {
+      for (size_t tx = 0; tx < tiles_x; tx++) {
+        const size_t x_end = std::min((tx + 1) * SPARSE_TILE_SIZE, width);
+        const size_t y_end = std::min((ty + 1) * SPARSE_TILE_SIZE, height);
+        const size_t z_end = std::min((tz + 1) * SPARSE_TILE_SIZE, depth);
+        bool is_empty = true;
+
+        for (size_t z = tz * SPARSE_TILE_SIZE; z < z_end && is_empty; z++) {
+          for (size_t y = ty * SPARSE_TILE_SIZE; y < y_end && is_empty; y++) {
+            const T *row = dense + (z * height + y) * width;
+            for (size_t x = tx * SPARSE_TILE_SIZE; x < x_end; x++) {
+              if (memcmp(&row[x], &zero, sizeof(T)) != 0) {
+                is_empty = false;
+                break;
+              }
+            }
+          }
+        }
+
+        if (!is_empty) {
+          offsets[(tz * tiles_y + ty) * tiles_x + tx] = (int)num_voxels;
+          num_voxels += tile_voxels;
+        }
+      }
+    }
+  }
+
+  if (num_voxels >= width * height * depth || num_voxels > INT_MAX) {
+    return false;
+  }
+
+  /* Copy index and tiles. */
+  sparse->resize(num_voxels);
+  T *data = sparse->data();
+  memset(data, 0, sizeof(T) * num_voxels);
+  memcpy(data, offsets.data(), sizeof(int) * num_tiles);
+
+  for (size_t tz = 0; tz < tiles_z; tz++) {
+    for (size_t ty = 0; ty < tiles_y; ty++) {
+      for (size_t tx = 0; tx < tiles_x; tx++) {
+        const int offset = offsets[(tz * tiles_y + ty) * tiles_x + tx];
+        if (offset == SPARSE_TILE_EMPTY) {
+          continue;
+        }
+
+        const size_t x_end = std::min((tx + 1) * SPARSE_TILE_SIZE, width);
+        const size_t y_end = std::min((ty + 1) * SPARSE_TILE_SIZE, height);
+        const size_t z_end = std::min((tz + 1) * SPARSE_TILE_SIZE, depth);
+        const size_t x_begin = tx * SPARSE_TILE_SIZE;
+
+        for (size_t z = tz * SPARSE_TILE_SIZE; z < z_end; z++) {
+          for (size_t y = ty * SPARSE_TILE_SIZE; y < y_end; y++) {
+            T *tile_row = data + offset + sparse_grid_voxel_offset(0, (int)y, (int)z);
+            memcpy(tile_row,
+                   dense + (z * height + y) * width + x_begin,
+                   sizeof(T) * (x_end - x_begin));
+          }
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+CCL_NAMESPACE_END
+
+#endif /* __UTIL_SPARSE_GRID_H__ */
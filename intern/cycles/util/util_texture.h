@@ -28,6 +28,13 @@ CCL_NAMESPACE_BEGIN
 #define TEX_IMAGE_MISSING_B 1
 #define TEX_IMAGE_MISSING_A 1
 
+/* Sparse 3D textures are stored as tiles of SPARSE_TILE_SIZE^3 voxels,
+ * see util_sparse_grid.h. */
+#define SPARSE_TILE_SIZE 8
+#define SPARSE_TILE_SHIFT 3
+#define SPARSE_TILE_MASK (SPARSE_TILE_SIZE - 1)
+#define SPARSE_TILE_EMPTY -1
+
 /* Texture type. */
 #define kernel_tex_type(tex) (tex & IMAGE_DATA_TYPE_MASK)
 
@@ -85,6 +92,12 @@ typedef struct TextureInfo {
   uint interpolation, extension;
   /* Dimensions. */
   uint width, height, depth;
+  /* Pixels are looked up in the texture cache on the CPU, data points to
+   * a TextureCacheImage. */
+  uint use_texture_cache;
+  /* Voxels are stored in tiles, with a tile index at the start of data. */
+  uint use_sparse_grid;
+  uint pad[2];
 } TextureInfo;
 
 CCL_NAMESPACE_END
@@ -0,0 +1,215 @@
+/*
+ * Copyright 2011-2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util/util_texture_cache.h"
+#include "util/util_logging.h"
+#include "util/util_math.h"
+#include "util/util_texture.h"
+#include "util/util_thread.h"
+
+#include <OpenImageIO/texture.h>
+
+CCL_NAMESPACE_BEGIN
+
+OIIO_NAMESPACE_USING
+
+static TextureSystem *texture_system = NULL;
+static size_t texture_system_memory_limit = 0;
+static thread_mutex texture_system_mutex;
+
+void texture_cache_init(size_t memory_limit_mb)
+{
+  thread_scoped_lock lock(texture_system_mutex);
+
+  if (texture_system == NULL) {
+    /* Same settings as OSLShaderManager::texture_system_init(), the shared
+     * texture system is the same for both. */
+    texture_system = TextureSystem::create(true);
+    texture_system->attribute("automip", 1);
+    texture_system->attribute("autotile", 64);
+    texture_system->attribute("gray_to_rgb", 1);
+  }
+
+  if (memory_limit_mb != texture_system_memory_limit) {
+    VLOG(1) << "Texture cache memory limit " << memory_limit_mb << " MB.";
+    texture_system->attribute("max_memory_MB", (float)memory_limit_mb);
+    texture_system_memory_limit = memory_limit_mb;
+  }
+}
+
+TextureCacheImage *texture_cache_image_create(const string &filename,
+                                              float filter_width,
+                                              bool use_alpha)
+{
+  assert(texture_system != NULL);
+
+  TextureSystem::TextureHandle *handle = texture_system->get_texture_handle(ustring(filename));
+  if (handle == NULL) {
+    texture_system->geterror();
+    return NULL;
+  }
+
+  TextureCacheImage *image = new TextureCacheImage();
+  image->handle = handle;
+  image->filter_width = filter_width;
+  image->use_alpha = use_alpha;
+  return image;
+}
+
+void texture_cache_image_free(const string &filename, TextureCacheImage *image)
+{
+  if (texture_system != NULL) {
+    texture_system->invalidate(ustring(filename));
+  }
+  delete image;
+}
+
+void texture_cache_lookup(const TextureCacheImage *image,
+                          int interpolation,
+                          int extension,
+                          float x,
+                          float y,
+                          float r_result[4])
+{
+  if (extension == EXTENSION_CLIP && (x < 0.0f || y < 0.0f || x > 1.0f || y > 1.0f)) {
+    r_result[0] = r_result[1] = r_result[2] = r_result[3] = 0.0f;
+    return;
+  }
+
+  TextureOpt options;
+  switch (interpolation) {
+    case INTERPOLATION_CLOSEST:
+      options.interpmode = TextureOpt::InterpClosest;
+      break;
+    case INTERPOLATION_LINEAR:
+      options.interpmode = TextureOpt::InterpBilinear;
+      break;
+    default:
+      options.interpmode = TextureOpt::InterpBicubic;
+      break;
+  }
+  options.swrap = options.twrap = (extension == EXTENSION_REPEAT) ? TextureOpt::WrapPeriodic :
+                                                                    TextureOpt::WrapClamp;
+  /* Alpha of images without alpha channel. */
+  options.fill = 1.0f;
+
+  /* Images loaded into memory are stored bottom to top, files are top to bottom. */
+  const float s = x;
+  const float t = 1.0f - y;
+  const float width = image->filter_width;
+
+  if (!texture_system->texture((TextureSystem::TextureHandle *)image->handle,
+                               texture_system->get_perthread_info(),
+                               options,
+                               s,
+                               t,
+                               width,
+                               0.0f,
+                               0.0f,
+                               width,
+                               4,
+                               r_result)) {
+    /* This might be slow, but prevents error messages leak. */
+    texture_system->geterror();
+    r_result[0] = TEX_IMAGE_MISSING_R;
+    r_result[1] = TEX_IMAGE_MISSING_G;
+    r_result[2] = TEX_IMAGE_MISSING_B;
+    r_result[3] = TEX_IMAGE_MISSING_A;
+    return;
+  }
+
+  /* The texture system associates alpha, while images loaded into memory
+   * without alpha are read with unassociated alpha and made opaque. */
+  if (!image->use_alpha) {
+    const float alpha = r_result[3];
+    if (alpha != 0.0f && alpha != 1.0f) {
+      const float inv_alpha = 1.0f / alpha;
+      r_result[0] *= inv_alpha;
+      r_result[1] *= inv_alpha;
+      r_result[2] *= inv_alpha;
+    }
+    r_result[3] = 1.0f;
+  }
+
+  /* Same as for images loaded into memory, avoid artifacts from buggy values. */
+  if (!isfinite_safe(r_result[0]) || !isfinite_safe(r_result[1]) ||
+      !isfinite_safe(r_result[2]) || !isfinite_safe(r_result[3])) {
+    r_result[0] = r_result[1] = r_result[2] = r_result[3] = 0.0f;
+  }
+}
+
+/* Statistics are stored with different integer types depending on the
+ * OpenImageIO version, try both. */
+
+static uint64_t texture_cache_attribute_get(const char *name)
+{
+  long long value64 = 0;
+  if (texture_system->getattribute(name, TypeDesc::INT64, &value64)) {
+    return (uint64_t)value64;
+  }
+  int value = 0;
+  if (texture_system->getattribute(name, TypeDesc::INT, &value)) {
+    return (uint64_t)value;
+  }
+  return 0;
+}
+
+static uint64_t texture_cache_image_attribute_get(const string &filename, const char *name)
+{
+  ustring ufilename(filename);
+  ustring uname(name);
+  long long value64 = 0;
+  if (texture_system->get_texture_info(ufilename, 0, uname, TypeDesc::INT64, &value64)) {
+    return (uint64_t)value64;
+  }
+  int value = 0;
+  if (texture_system->get_texture_info(ufilename, 0, uname, TypeDesc::INT, &value)) {
+    return (uint64_t)value;
+  }
+  texture_system->geterror();
+  return 0;
+}
+
+bool texture_cache_statistics(TextureCacheStatistics *r_stats)
+{
+  thread_scoped_lock lock(texture_system_mutex);
+
+  if (texture_system == NULL) {
+    return false;
+  }
+
+  r_stats->tile_lookups = texture_cache_attribute_get("stat:find_tile_calls");
+  r_stats->tile_misses = texture_cache_attribute_get("stat:find_tile_cache_misses");
+  r_stats->memory_used = texture_cache_attribute_get("stat:cache_memory_used");
+  r_stats->memory_limit = texture_system_memory_limit * 1024 * 1024;
+  return true;
+}
+
+bool texture_cache_image_statistics(const string &filename, TextureCacheImageStatistics *r_stats)
+{
+  thread_scoped_lock lock(texture_system_mutex);
+
+  if (texture_system == NULL) {
+    return false;
+  }
+
+  r_stats->tile_misses = texture_cache_image_attribute_get(filename, "stat:tilesread");
+  r_stats->bytes_read = texture_cache_image_attribute_get(filename, "stat:bytesread");
+  r_stats->mip_levels_used = (int)texture_cache_image_attribute_get(filename, "stat:mipsused");
+  return true;
+}
+
+CCL_NAMESPACE_END
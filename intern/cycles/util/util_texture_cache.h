@@ -0,0 +1,84 @@
+/*
+ * Copyright 2011-2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTIL_TEXTURE_CACHE_H__
+#define __UTIL_TEXTURE_CACHE_H__
+
+#include "util/util_string.h"
+#include "util/util_types.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Texture Cache
+ *
+ * Image textures which are too big to be fully loaded into memory are looked
+ * up through the OpenImageIO texture system instead, which reads tiles and
+ * MIP levels from the file on demand and evicts them when going over the
+ * memory budget. The texture system is shared with OSL.
+ *
+ * Only used by the CPU device, TextureInfo::data then points to a
+ * TextureCacheImage instead of pixels. */
+
+typedef struct TextureCacheImage {
+  /* OpenImageIO texture handle. */
+  void *handle;
+  /* Filter width in texture space, used to select a MIP level.
+   * Zero means the full resolution image. */
+  float filter_width;
+  /* Matches ImageManager::Image::use_alpha. */
+  bool use_alpha;
+} TextureCacheImage;
+
+/* Set up the texture cache with the given memory budget, in megabytes. */
+void texture_cache_init(size_t memory_limit_mb);
+
+TextureCacheImage *texture_cache_image_create(const string &filename,
+                                              float filter_width,
+                                              bool use_alpha);
+void texture_cache_image_free(const string &filename, TextureCacheImage *image);
+
+/* Look up pixel in image, with the same coordinates and the same result as
+ * kernel_tex_image_interp() for images loaded into memory.
+ *
+ * Note the result is not returned as float4, the kernel is compiled for
+ * multiple instruction sets which don't all agree on its layout. */
+void texture_cache_lookup(const TextureCacheImage *image,
+                          int interpolation,
+                          int extension,
+                          float x,
+                          float y,
+                          float r_result[4]);
+
+/* Statistics. Tile misses are tiles read from files, the other lookups are hits. */
+typedef struct TextureCacheStatistics {
+  uint64_t tile_lookups;
+  uint64_t tile_misses;
+  size_t memory_used;
+  size_t memory_limit;
+} TextureCacheStatistics;
+
+typedef struct TextureCacheImageStatistics {
+  uint64_t tile_misses;
+  size_t bytes_read;
+  int mip_levels_used;
+} TextureCacheImageStatistics;
+
+bool texture_cache_statistics(TextureCacheStatistics *r_stats);
+bool texture_cache_image_statistics(const string &filename, TextureCacheImageStatistics *r_stats);
+
+CCL_NAMESPACE_END
+
+#endif /* __UTIL_TEXTURE_CACHE_H__ */
@@ -608,6 +608,11 @@ class NODE_PT_quality(bpy.types.Panel):
         col = layout.column()
         col.prop(tree, "use_opencl")
         col.prop(tree, "use_groupnode_buffer")
+        col.prop(tree, "use_row_execution")
+        col.prop(tree, "use_cache")
+        sub = col.column()
+        sub.active = tree.use_cache
+        sub.prop(tree, "cache_limit")
         col.prop(tree, "use_two_pass")
         col.prop(tree, "use_viewer_border")
 
@@ -475,6 +475,9 @@ void makeDerivedMesh(struct Depsgraph *depsgraph,
                      struct BMEditMesh *em,
                      const struct CustomData_MeshMasks *dataMask);
 
+void DM_eval_arena_stats_print(void);
+void DM_eval_arena_free_all(void);
+
 void DM_calc_loop_tangents(DerivedMesh *dm,
                            bool calc_active_tangent,
                            const char (*tangent_names)[MAX_NAME],
@@ -31,6 +31,7 @@ struct Depsgraph;
 struct ID;
 struct ListBase;
 struct Main;
+struct MemArena;
 struct Mesh;
 struct ModifierData;
 struct Object;
@@ -395,6 +396,7 @@ typedef struct CDMaskLink {
  * data required by each modifier in the stack pointed to by md for correct
  * evaluation, assuming the data indicated by dataMask is required at the
  * end of the stack.
+ * The list is allocated from arena when given, otherwise it's freed with BLI_linklist_free.
  */
 struct CDMaskLink *modifiers_calcDataMasks(struct Scene *scene,
                                            struct Object *ob,
@@ -402,7 +404,8 @@ struct CDMaskLink *modifiers_calcDataMasks(struct Scene *scene,
                                            const struct CustomData_MeshMasks *dataMask,
                                            int required_mode,
                                            ModifierData *previewmd,
-                                           const struct CustomData_MeshMasks *previewmask);
+                                           const struct CustomData_MeshMasks *previewmask,
+                                           struct MemArena *arena);
 struct ModifierData *modifiers_getLastPreview(struct Scene *scene,
                                               struct ModifierData *md,
                                               int required_mode);
@@ -97,6 +97,8 @@ typedef struct SeqRenderData {
   bool skip_cache;
   bool is_proxy_render;
   int view_id;
+  /* SEQ_TASK_MAIN_RENDER, or the index of the prefetch thread doing the render */
+  int task_id;
 
   /* special case for OpenGL render */
   struct GPUOffScreen *gpu_offscreen;
@@ -104,6 +106,8 @@ typedef struct SeqRenderData {
   // bool gpu_full_samples;
 } SeqRenderData;
 
+#define SEQ_TASK_MAIN_RENDER 0
+
 void BKE_sequencer_new_render_data(struct Main *bmain,
                                    struct Depsgraph *depsgraph,
                                    struct Scene *scene,
@@ -200,9 +204,6 @@ struct SeqEffectHandle {
  * ********************************************************************** */
 
 struct ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int chanshown);
-struct ImBuf *BKE_sequencer_give_ibuf_threaded(const SeqRenderData *context,
-                                               float cfra,
-                                               int chanshown);
 struct ImBuf *BKE_sequencer_give_ibuf_direct(const SeqRenderData *context,
                                              float cfra,
                                              struct Sequence *seq);
@@ -210,9 +211,6 @@ struct ImBuf *BKE_sequencer_give_ibuf_seqbase(const SeqRenderData *context,
                                               float cfra,
                                               int chan_shown,
                                               struct ListBase *seqbasep);
-void BKE_sequencer_give_ibuf_prefetch_request(const SeqRenderData *context,
-                                              float cfra,
-                                              int chan_shown);
 
 /* **********************************************************************
  * sequencer.c
@@ -328,6 +326,24 @@ void BKE_sequencer_cache_iterate(
     struct Scene *scene,
     void *userdata,
     bool callback(void *userdata, struct Sequence *seq, int cfra, int cache_type, float cost));
+void BKE_sequencer_cache_disk_exit(void);
+bool BKE_sequencer_cache_is_full(struct Scene *scene);
+
+/* **********************************************************************
+ * seqprefetch.c
+ *
+ * Sequencer frame prefetching on background threads
+ * ********************************************************************** */
+
+#define SEQ_PREFETCH_THREADS_MAX 4
+
+void BKE_sequencer_prefetch_start(const SeqRenderData *context, float cfra, int chanshown);
+void BKE_sequencer_prefetch_stop(struct Scene *scene);
+void BKE_sequencer_prefetch_free(struct Scene *scene);
+bool BKE_sequencer_prefetch_need_stop(const SeqRenderData *context);
+struct Scene *BKE_sequencer_prefetch_get_original_scene(const SeqRenderData *context);
+struct Sequence *BKE_sequencer_prefetch_get_original_sequence(const SeqRenderData *context,
+                                                              struct Sequence *seq);
 
 /* **********************************************************************
  * seqeffects.c
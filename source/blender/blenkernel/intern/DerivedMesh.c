@@ -41,7 +41,9 @@
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 #include "BLI_linklist.h"
+#include "BLI_memarena.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_cdderivedmesh.h"
 #include "BKE_colorband.h"
@@ -1097,6 +1099,165 @@ static void mesh_calc_modifier_final_normals(const Mesh *mesh_input,
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Modifier Stack Evaluation Arena
+ *
+ * Scratch data of a modifier stack evaluation (data masks, deformed vertex coordinates)
+ * is taken from an arena instead of being allocated for every evaluation.
+ * Many objects are evaluated at once from the depsgraph threads, so arenas are kept
+ * in a pool: an evaluation takes one and gives it back cleared when it finishes,
+ * keeping its buffers for the next evaluation.
+ * \{ */
+
+/* Deformed coordinates larger than this are freed after the evaluation. */
+#define MODIFIER_EVAL_ARENA_COORDS_MAX_SIZE (1 << 20)
+
+typedef struct ModifierEvalArena {
+  struct ModifierEvalArena *next;
+  /** Small allocations, cleared after each evaluation. */
+  MemArena *memarena;
+  /** Deformed vertex coordinates, there is only one such array at a time. */
+  float (*vert_coords)[3];
+  int vert_coords_len_alloc;
+  bool vert_coords_in_use;
+  /** Statistics of the current evaluation, deformed coordinates which reused #vert_coords
+   * and those which needed a new guarded allocation. */
+  int vert_coords_reused;
+  int vert_coords_allocs;
+} ModifierEvalArena;
+
+static struct {
+  ThreadMutex lock;
+  /** Arenas which are not used by an evaluation. */
+  ModifierEvalArena *pool;
+  /** Statistics since they were last printed. */
+  uint64_t evaluations;
+  uint64_t vert_coords_reused;
+  uint64_t vert_coords_allocs;
+} modifier_eval_arenas = {BLI_MUTEX_INITIALIZER};
+
+static ModifierEvalArena *modifier_eval_arena_acquire(void)
+{
+  BLI_mutex_lock(&modifier_eval_arenas.lock);
+  ModifierEvalArena *arena = modifier_eval_arenas.pool;
+  if (arena) {
+    modifier_eval_arenas.pool = arena->next;
+  }
+  BLI_mutex_unlock(&modifier_eval_arenas.lock);
+
+  if (arena == NULL) {
+    arena = MEM_callocN(sizeof(*arena), __func__);
+    arena->memarena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+  }
+  return arena;
+}
+
+static void modifier_eval_arena_release(ModifierEvalArena *arena)
+{
+  BLI_assert(arena->vert_coords_in_use == false);
+
+  BLI_memarena_clear(arena->memarena);
+  if ((size_t)arena->vert_coords_len_alloc * sizeof(*arena->vert_coords) >
+      MODIFIER_EVAL_ARENA_COORDS_MAX_SIZE) {
+    MEM_freeN(arena->vert_coords);
+    arena->vert_coords = NULL;
+    arena->vert_coords_len_alloc = 0;
+  }
+
+  BLI_mutex_lock(&modifier_eval_arenas.lock);
+  modifier_eval_arenas.evaluations++;
+  modifier_eval_arenas.vert_coords_reused += (uint64_t)arena->vert_coords_reused;
+  modifier_eval_arenas.vert_coords_allocs += (uint64_t)arena->vert_coords_allocs;
+  arena->vert_coords_reused = 0;
+  arena->vert_coords_allocs = 0;
+  arena->next = modifier_eval_arenas.pool;
+  modifier_eval_arenas.pool = arena;
+  BLI_mutex_unlock(&modifier_eval_arenas.lock);
+}
+
+/** Same as #BKE_mesh_vertexCos_get, free with #modifier_eval_arena_vert_coords_free. */
+static float (*modifier_eval_arena_vert_coords_get(ModifierEvalArena *arena,
+                                                   const Mesh *mesh,
+                                                   int *r_verts_len))[3]
+{
+  const int verts_len = mesh->totvert;
+  float(*cos)[3];
+
+  if (arena->vert_coords_in_use) {
+    cos = MEM_malloc_arrayN(verts_len, sizeof(*cos), __func__);
+    arena->vert_coords_allocs++;
+  }
+  else {
+    if (verts_len > arena->vert_coords_len_alloc) {
+      MEM_SAFE_FREE(arena->vert_coords);
+      arena->vert_coords = MEM_malloc_arrayN(verts_len, sizeof(*cos), __func__);
+      arena->vert_coords_len_alloc = verts_len;
+      arena->vert_coords_allocs++;
+    }
+    else {
+      arena->vert_coords_reused++;
+    }
+    arena->vert_coords_in_use = true;
+    cos = arena->vert_coords;
+  }
+
+  for (int i = 0; i < verts_len; i++) {
+    copy_v3_v3(cos[i], mesh->mvert[i].co);
+  }
+  *r_verts_len = verts_len;
+  return cos;
+}
+
+static void modifier_eval_arena_vert_coords_free(ModifierEvalArena *arena, float (*cos)[3])
+{
+  if (cos == arena->vert_coords) {
+    BLI_assert(arena->vert_coords_in_use);
+    arena->vert_coords_in_use = false;
+  }
+  else {
+    MEM_freeN(cos);
+  }
+}
+
+/**
+ * Print how often deformed coordinates reused the arena buffer since the last call.
+ * Intermediate meshes are still allocated for every evaluation and are not counted.
+ */
+void DM_eval_arena_stats_print(void)
+{
+  BLI_mutex_lock(&modifier_eval_arenas.lock);
+  if (modifier_eval_arenas.evaluations != 0) {
+    printf("Modifier stack evaluations: %llu, "
+           "deformed coordinates reused: %llu, allocated: %llu\n",
+           (unsigned long long)modifier_eval_arenas.evaluations,
+           (unsigned long long)modifier_eval_arenas.vert_coords_reused,
+           (unsigned long long)modifier_eval_arenas.vert_coords_allocs);
+  }
+  modifier_eval_arenas.evaluations = 0;
+  modifier_eval_arenas.vert_coords_reused = 0;
+  modifier_eval_arenas.vert_coords_allocs = 0;
+  BLI_mutex_unlock(&modifier_eval_arenas.lock);
+}
+
+/**
+ * Free the pooled arenas, there must be no evaluation running.
+ */
+void DM_eval_arena_free_all(void)
+{
+  BLI_mutex_lock(&modifier_eval_arenas.lock);
+  ModifierEvalArena *arena, *arena_next;
+  for (arena = modifier_eval_arenas.pool; arena; arena = arena_next) {
+    arena_next = arena->next;
+    BLI_memarena_free(arena->memarena);
+    MEM_SAFE_FREE(arena->vert_coords);
+    MEM_freeN(arena);
+  }
+  modifier_eval_arenas.pool = NULL;
+  BLI_mutex_unlock(&modifier_eval_arenas.lock);
+}
+
+/** \} */
+
 static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
                                 Scene *scene,
                                 Object *ob,
@@ -1135,6 +1296,9 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
   const bool use_render = (DEG_get_mode(depsgraph) == DAG_EVAL_RENDER);
   const int required_mode = use_render ? eModifierMode_Render : eModifierMode_Realtime;
 
+  /* Scratch data, freed at once when done. */
+  ModifierEvalArena *arena = modifier_eval_arena_acquire();
+
   /* Sculpt can skip certain modifiers. */
   MultiresModifierData *mmd = get_multires_modifier(scene, ob, 0);
   const bool has_multires = (mmd && mmd->sculptlvl != 0);
@@ -1173,7 +1337,7 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
    * an armature modifier, but not through a following subsurf modifier where
    * subdividing them is expensive. */
   CDMaskLink *datamasks = modifiers_calcDataMasks(
-      scene, ob, md, dataMask, required_mode, previewmd, &previewmask);
+      scene, ob, md, dataMask, required_mode, previewmd, &previewmask, arena->memarena);
   CDMaskLink *md_datamask = datamasks;
   /* XXX Always copying POLYINDEX, else tessellated data are no more valid! */
   CustomData_MeshMasks append_mask = CD_MASK_BAREMESH_ORIGINDEX;
@@ -1196,7 +1360,8 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
 
       if (mti->type == eModifierTypeType_OnlyDeform && !sculpt_dyntopo) {
         if (!deformed_verts) {
-          deformed_verts = BKE_mesh_vertexCos_get(mesh_input, &num_deformed_verts);
+          deformed_verts = modifier_eval_arena_vert_coords_get(
+              arena, mesh_input, &num_deformed_verts);
         }
         else if (isPrevDeform && mti->dependsOnNormals && mti->dependsOnNormals(md)) {
           if (mesh_final == NULL) {
@@ -1310,10 +1475,12 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
           /* Deforming a mesh, read the vertex locations
            * out of the mesh and deform them. Once done with this
            * run of deformers verts will be written back. */
-          deformed_verts = BKE_mesh_vertexCos_get(mesh_final, &num_deformed_verts);
+          deformed_verts = modifier_eval_arena_vert_coords_get(
+              arena, mesh_final, &num_deformed_verts);
         }
         else {
-          deformed_verts = BKE_mesh_vertexCos_get(mesh_input, &num_deformed_verts);
+          deformed_verts = modifier_eval_arena_vert_coords_get(
+              arena, mesh_input, &num_deformed_verts);
         }
       }
       /* if this is not the last modifier in the stack then recalculate the normals
@@ -1417,7 +1584,7 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
         mesh_final = mesh_next;
 
         if (deformed_verts) {
-          MEM_freeN(deformed_verts);
+          modifier_eval_arena_vert_coords_free(arena, deformed_verts);
           deformed_verts = NULL;
         }
 
@@ -1504,8 +1671,6 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
     }
   }
 
-  BLI_linklist_free((LinkNode *)datamasks, NULL);
-
   for (md = firstmd; md; md = md->next) {
     modifier_freeTemporaryData(md);
   }
@@ -1518,7 +1683,7 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
   }
   if (deformed_verts) {
     BKE_mesh_apply_vert_coords(mesh_final, deformed_verts);
-    MEM_freeN(deformed_verts);
+    modifier_eval_arena_vert_coords_free(arena, deformed_verts);
     deformed_verts = NULL;
   }
 
@@ -1541,6 +1706,8 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
   /* Compute normals. */
   mesh_calc_modifier_final_normals(mesh_input, dataMask, sculpt_dyntopo, mesh_final);
 
+  modifier_eval_arena_release(arena);
+
   /* Return final mesh */
   *r_final = mesh_final;
   if (r_deform) {
@@ -1682,7 +1849,7 @@ static void editbmesh_calc_modifiers(struct Depsgraph *depsgraph,
    * an armature modifier, but not through a following subsurf modifier where
    * subdividing them is expensive. */
   CDMaskLink *datamasks = modifiers_calcDataMasks(
-      scene, ob, md, dataMask, required_mode, NULL, NULL);
+      scene, ob, md, dataMask, required_mode, NULL, NULL, NULL);
   CDMaskLink *md_datamask = datamasks;
   CustomData_MeshMasks append_mask = CD_MASK_BAREMESH;
 
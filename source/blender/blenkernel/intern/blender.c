@@ -44,6 +44,7 @@
 #include "BKE_blendfile.h"
 #include "BKE_brush.h"
 #include "BKE_cachefile.h"
+#include "BKE_DerivedMesh.h"
 #include "BKE_global.h"
 #include "BKE_idprop.h"
 #include "BKE_image.h"
@@ -89,6 +90,7 @@ void BKE_blender_free(void)
 
   IMB_exit();
   BKE_cachefiles_exit();
+  DM_eval_arena_free_all();
   BKE_images_exit();
   DEG_free_node_types();
 
@@ -214,7 +214,6 @@ typedef struct MeshCalcNormalsData {
   const MLoop *mloop;
   MVert *mverts;
   float (*pnors)[3];
-  float (*lnors_weighted)[3];
   float (*vnors)[3];
 } MeshCalcNormalsData;
 
@@ -239,7 +238,7 @@ static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
 
   float pnor_temp[3];
   float *pnor = data->pnors ? data->pnors[pidx] : pnor_temp;
-  float(*lnors_weighted)[3] = data->lnors_weighted;
+  float(*vnors)[3] = data->vnors;
 
   const int nverts = mp->totloop;
   float(*edgevecbuf)[3] = BLI_array_alloca(edgevecbuf, (size_t)nverts);
@@ -271,21 +270,25 @@ static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
   }
 
   /* accumulate angle weighted face normal */
-  /* inline version of #accumulate_vertex_normals_poly_v3,
-   * split between this threaded callback and #mesh_calc_normals_poly_accum_cb. */
+  /* inline version of #accumulate_vertex_normals_poly_v3.
+   * Vertices are shared between polygons handled by other threads, so the accumulation is
+   * atomic. Contention is rare in practice (only along the borders of the chunks each thread
+   * works on), this is much cheaper than storing all weighted loop normals and accumulating
+   * them in a single thread afterwards. */
   {
     const float *prev_edge = edgevecbuf[nverts - 1];
 
     for (i = 0; i < nverts; i++) {
-      const int lidx = mp->loopstart + i;
       const float *cur_edge = edgevecbuf[i];
 
       /* calculate angle between the two poly edges incident on
        * this vertex */
       const float fac = saacos(-dot_v3v3(cur_edge, prev_edge));
 
-      /* Store for later accumulation */
-      mul_v3_v3fl(lnors_weighted[lidx], pnor, fac);
+      float *vnor = vnors[ml[i].v];
+      atomic_add_and_fetch_fl(&vnor[0], pnor[0] * fac);
+      atomic_add_and_fetch_fl(&vnor[1], pnor[1] * fac);
+      atomic_add_and_fetch_fl(&vnor[2], pnor[2] * fac);
 
       prev_edge = cur_edge;
     }
@@ -314,7 +317,7 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
                                 int numVerts,
                                 const MLoop *mloop,
                                 const MPoly *mpolys,
-                                int numLoops,
+                                int UNUSED(numLoops),
                                 int numPolys,
                                 float (*r_polynors)[3],
                                 const bool only_face_normals)
@@ -341,8 +344,6 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
   }
 
   float(*vnors)[3] = r_vertnors;
-  float(*lnors_weighted)[3] = MEM_malloc_arrayN(
-      (size_t)numLoops, sizeof(*lnors_weighted), __func__);
   bool free_vnors = false;
 
   /* first go through and calculate normals for all the polys */
@@ -359,28 +360,18 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
       .mloop = mloop,
       .mverts = mverts,
       .pnors = pnors,
-      .lnors_weighted = lnors_weighted,
       .vnors = vnors,
   };
 
-  /* Compute poly normals, and prepare weighted loop normals. */
+  /* Compute poly normals, and accumulate them into vertex normals. */
   BLI_task_parallel_range(0, numPolys, &data, mesh_calc_normals_poly_prepare_cb, &settings);
 
-  /* Actually accumulate weighted loop normals into vertex ones. */
-  /* Unfortunately, not possible to thread that
-   * (not in a reasonable, totally lock- and barrier-free fashion),
-   * since several loops will point to the same vertex... */
-  for (int lidx = 0; lidx < numLoops; lidx++) {
-    add_v3_v3(vnors[mloop[lidx].v], data.lnors_weighted[lidx]);
-  }
-
   /* Normalize and validate computed vertex normals. */
   BLI_task_parallel_range(0, numVerts, &data, mesh_calc_normals_poly_finalize_cb, &settings);
 
   if (free_vnors) {
     MEM_freeN(vnors);
   }
-  MEM_freeN(lnors_weighted);
 }
 
 void BKE_mesh_ensure_normals(Mesh *mesh)
@@ -816,6 +807,7 @@ void BKE_lnor_space_custom_normal_to_data(MLoopNorSpace *lnor_space,
   }
 }
 
+/* Number of polygons handled by each task. */
 #define LOOP_SPLIT_TASK_BLOCK_SIZE 1024
 
 typedef struct LoopSplitTaskData {
@@ -866,12 +858,33 @@ typedef struct LoopSplitTaskDataCommon {
 /* See comment about edge_to_loops below. */
 #define IS_EDGE_SHARP(_e2l) (ELEM((_e2l)[1], INDEX_UNSET, INDEX_INVALID))
 
+static void mesh_edges_sharp_tag_prepare_cb(void *__restrict userdata,
+                                            const int mp_index,
+                                            const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+  LoopSplitTaskDataCommon *data = userdata;
+  const MPoly *mp = &data->mpolys[mp_index];
+  const MLoop *ml = &data->mloops[mp->loopstart];
+  float(*loopnors)[3] = data->loopnors;
+  int *loop_to_poly = data->loop_to_poly;
+
+  for (int ml_index = mp->loopstart; ml_index < mp->loopstart + mp->totloop; ml_index++, ml++) {
+    loop_to_poly[ml_index] = mp_index;
+
+    /* Pre-populate all loop normals as if their verts were all-smooth,
+     * this way we don't have to compute those later!
+     */
+    if (loopnors) {
+      normal_short_to_float_v3(loopnors[ml_index], data->mverts[ml->v].no);
+    }
+  }
+}
+
 static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
                                  const bool check_angle,
                                  const float split_angle,
                                  const bool do_sharp_edges_tag)
 {
-  const MVert *mverts = data->mverts;
   const MEdge *medges = data->medges;
   const MLoop *mloops = data->mloops;
 
@@ -880,11 +893,10 @@ static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
   const int numEdges = data->numEdges;
   const int numPolys = data->numPolys;
 
-  float(*loopnors)[3] = data->loopnors; /* Note: loopnors may be NULL here. */
   const float(*polynors)[3] = data->polynors;
 
   int(*edge_to_loops)[2] = data->edge_to_loops;
-  int *loop_to_poly = data->loop_to_poly;
+  const int *loop_to_poly = data->loop_to_poly;
 
   BLI_bitmap *sharp_edges = do_sharp_edges_tag ? BLI_BITMAP_NEW(numEdges, __func__) : NULL;
 
@@ -893,6 +905,15 @@ static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
 
   const float split_angle_cos = check_angle ? cosf(split_angle) : -1.0f;
 
+  /* Loop to poly mapping and default loop normals (note: loopnors may be NULL here)
+   * don't depend on edges, only the edge to loops mapping below has to be built in order. */
+  {
+    ParallelRangeSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = LOOP_SPLIT_TASK_BLOCK_SIZE;
+    BLI_task_parallel_range(0, numPolys, data, mesh_edges_sharp_tag_prepare_cb, &settings);
+  }
+
   for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
     const MLoop *ml_curr;
     int *e2l;
@@ -904,15 +925,6 @@ static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
     for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
       e2l = edge_to_loops[ml_curr->e];
 
-      loop_to_poly[ml_curr_index] = mp_index;
-
-      /* Pre-populate all loop normals as if their verts were all-smooth,
-       * this way we don't have to compute those later!
-       */
-      if (loopnors) {
-        normal_short_to_float_v3(loopnors[ml_curr_index], mverts[ml_curr->v].no);
-      }
-
       /* Check whether current edge might be smooth or sharp */
       if ((e2l[0] | e2l[1]) == 0) {
         /* 'Empty' edge until now, set e2l[0] (and e2l[1] to INDEX_UNSET to tag it as unset). */
@@ -1355,47 +1367,18 @@ static void loop_split_worker_do(LoopSplitTaskDataCommon *common_data,
   }
 }
 
-static void loop_split_worker(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
-{
-  LoopSplitTaskDataCommon *common_data = BLI_task_pool_userdata(pool);
-  LoopSplitTaskData *data = taskdata;
-
-  /* Temp edge vectors stack, only used when computing lnor spacearr. */
-  BLI_Stack *edge_vectors = common_data->lnors_spacearr ?
-                                BLI_stack_new(sizeof(float[3]), __func__) :
-                                NULL;
-
-#ifdef DEBUG_TIME
-  TIMEIT_START_AVERAGED(loop_split_worker);
-#endif
-
-  for (int i = 0; i < LOOP_SPLIT_TASK_BLOCK_SIZE; i++, data++) {
-    /* A NULL ml_curr is used to tag ended data! */
-    if (data->ml_curr == NULL) {
-      break;
-    }
-
-    loop_split_worker_do(common_data, data, edge_vectors);
-  }
-
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
-  }
-
-#ifdef DEBUG_TIME
-  TIMEIT_END_AVERAGED(loop_split_worker);
-#endif
-}
-
-/* Check whether gievn loop is part of an unknown-so-far cyclic smooth fan, or not.
+/* Check whether given loop is the entry point of a cyclic smooth fan.
  * Needed because cyclic smooth fans have no obvious 'entry point',
- * and yet we need to walk them once, and only once. */
+ * and yet we need to walk them once, and only once.
+ *
+ * The entry point is the first loop of the fan in polygon order, this way all loops can be checked
+ * independently from each other (and in parallel), while giving the same lnor spaces as when
+ * walking the polygons in order. */
 static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
                                                          const MPoly *mpolys,
                                                          const int (*edge_to_loops)[2],
                                                          const int *loop_to_poly,
                                                          const int *e2l_prev,
-                                                         BLI_bitmap *skip_loops,
                                                          const MLoop *ml_curr,
                                                          const MLoop *ml_prev,
                                                          const int ml_curr_index,
@@ -1423,9 +1406,6 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
   BLI_assert(mlfan_vert_index >= 0);
   BLI_assert(mpfan_curr_index >= 0);
 
-  BLI_assert(!BLI_BITMAP_TEST(skip_loops, mlfan_vert_index));
-  BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
-
   while (true) {
     /* Find next loop of the smooth fan. */
     BKE_mesh_loop_manifold_fan_around_vert_next(mloops,
@@ -1445,90 +1425,78 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
       return false;
     }
     /* Smooth loop/edge... */
-    else if (BLI_BITMAP_TEST(skip_loops, mlfan_vert_index)) {
-      if (mlfan_vert_index == ml_curr_index) {
-        /* We walked around a whole cyclic smooth fan without finding any already-processed loop,
-         * means we can use initial ml_curr/ml_prev edge as start for this smooth fan. */
-        return true;
-      }
-      /* ... already checked in some previous looping, we can abort. */
+    else if (mlfan_vert_index == ml_curr_index) {
+      /* We walked around a whole cyclic smooth fan without finding any loop coming before the
+       * initial one, means we can use initial ml_curr/ml_prev edge as start for this smooth fan. */
+      return true;
+    }
+    else if (mpfan_curr_index < mp_curr_index ||
+             (mpfan_curr_index == mp_curr_index && mlfan_vert_index < ml_curr_index)) {
+      /* ... the fan will be handled from that earlier loop, we can abort. */
       return false;
     }
-    else {
-      /* ... we can skip it in future, and keep checking the smooth fan. */
-      BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
-    }
   }
 }
 
-static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common_data)
+/* Loops are first classified, so that the amount of lnor spaces created by each block of polygons
+ * is known, before the actual computation of all fans happens in parallel. */
+enum {
+  LOOP_SPLIT_SKIP = 0,
+  LOOP_SPLIT_SINGLE = 1,
+  LOOP_SPLIT_FAN = 2,
+};
+
+typedef struct LoopSplitGeneratorData {
+  LoopSplitTaskDataCommon *common_data;
+
+  /** One of the LOOP_SPLIT_ values for each loop. */
+  char *loop_types;
+  /** For each block of polygons, the number of lnor spaces it creates,
+   * then the index of the first one of them in \a spaces. */
+  int *block_spaces;
+  /** All lnor spaces, allocated at once in the lnor spacearr memarena. */
+  MLoopNorSpace *spaces;
+} LoopSplitGeneratorData;
+
+typedef struct LoopSplitGeneratorTLS {
+  /** Temp edge vectors stack, only used when computing lnor spacearr. */
+  BLI_Stack *edge_vectors;
+} LoopSplitGeneratorTLS;
+
+static void loop_split_generator_classify_cb(void *__restrict userdata,
+                                             const int block,
+                                             const ParallelRangeTLS *__restrict UNUSED(tls))
 {
-  MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
-  float(*loopnors)[3] = common_data->loopnors;
+  LoopSplitGeneratorData *gen_data = userdata;
+  LoopSplitTaskDataCommon *common_data = gen_data->common_data;
 
   const MLoop *mloops = common_data->mloops;
   const MPoly *mpolys = common_data->mpolys;
   const int *loop_to_poly = common_data->loop_to_poly;
   const int(*edge_to_loops)[2] = common_data->edge_to_loops;
-  const int numLoops = common_data->numLoops;
-  const int numPolys = common_data->numPolys;
-
-  const MPoly *mp;
-  int mp_index;
-
-  const MLoop *ml_curr;
-  const MLoop *ml_prev;
-  int ml_curr_index;
-  int ml_prev_index;
-
-  BLI_bitmap *skip_loops = BLI_BITMAP_NEW(numLoops, __func__);
-
-  LoopSplitTaskData *data_buff = NULL;
-  int data_idx = 0;
-
-  /* Temp edge vectors stack, only used when computing lnor spacearr
-   * (and we are not multi-threading). */
-  BLI_Stack *edge_vectors = NULL;
+  char *loop_types = gen_data->loop_types;
 
-#ifdef DEBUG_TIME
-  TIMEIT_START_AVERAGED(loop_split_generator);
-#endif
+  const int mp_start = block * LOOP_SPLIT_TASK_BLOCK_SIZE;
+  const int mp_end = min_ii(mp_start + LOOP_SPLIT_TASK_BLOCK_SIZE, common_data->numPolys);
+  int num_spaces = 0;
 
-  if (!pool) {
-    if (lnors_spacearr) {
-      edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
-    }
-  }
-
-  /* We now know edges that can be smoothed (with their vector, and their two loops),
-   * and edges that will be hard! Now, time to generate the normals.
-   */
-  for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-    float(*lnors)[3];
+  for (int mp_index = mp_start; mp_index < mp_end; mp_index++) {
+    const MPoly *mp = &mpolys[mp_index];
     const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
-    ml_curr_index = mp->loopstart;
-    ml_prev_index = ml_last_index;
+    int ml_curr_index = mp->loopstart;
+    int ml_prev_index = ml_last_index;
 
-    ml_curr = &mloops[ml_curr_index];
-    ml_prev = &mloops[ml_prev_index];
-    lnors = &loopnors[ml_curr_index];
+    const MLoop *ml_curr = &mloops[ml_curr_index];
+    const MLoop *ml_prev = &mloops[ml_prev_index];
 
-    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++, lnors++) {
+    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
       const int *e2l_curr = edge_to_loops[ml_curr->e];
       const int *e2l_prev = edge_to_loops[ml_prev->e];
-
-#if 0
-      printf("Checking loop %d / edge %u / vert %u (sharp edge: %d, skiploop: %d)...",
-             ml_curr_index,
-             ml_curr->e,
-             ml_curr->v,
-             IS_EDGE_SHARP(e2l_curr),
-             BLI_BITMAP_TEST_BOOL(skip_loops, ml_curr_index));
-#endif
+      char type;
 
       /* A smooth edge, we have to check for cyclic smooth fan case.
-       * If we find a new, never-processed cyclic smooth fan, we can do it now using that loop/edge
-       * as 'entry point', otherwise we can skip it. */
+       * If this loop is the entry point of a cyclic smooth fan, we can do it using that loop/edge,
+       * otherwise we can skip it. */
 
       /* Note: In theory, we could make loop_split_generator_check_cyclic_smooth_fan() store
        * mlfan_vert_index'es and edge indexes in two stacks, to avoid having to fan again around
@@ -1536,102 +1504,169 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
        * the code, add more memory usage, and despite its logical complexity,
        * loop_manifold_fan_around_vert_next() is quite cheap in term of CPU cycles,
        * so really think it's not worth it. */
-      if (!IS_EDGE_SHARP(e2l_curr) && (BLI_BITMAP_TEST(skip_loops, ml_curr_index) ||
-                                       !loop_split_generator_check_cyclic_smooth_fan(mloops,
-                                                                                     mpolys,
-                                                                                     edge_to_loops,
-                                                                                     loop_to_poly,
-                                                                                     e2l_prev,
-                                                                                     skip_loops,
-                                                                                     ml_curr,
-                                                                                     ml_prev,
-                                                                                     ml_curr_index,
-                                                                                     ml_prev_index,
-                                                                                     mp_index))) {
-        //              printf("SKIPPING!\n");
+      if (!IS_EDGE_SHARP(e2l_curr)) {
+        type = loop_split_generator_check_cyclic_smooth_fan(mloops,
+                                                            mpolys,
+                                                            edge_to_loops,
+                                                            loop_to_poly,
+                                                            e2l_prev,
+                                                            ml_curr,
+                                                            ml_prev,
+                                                            ml_curr_index,
+                                                            ml_prev_index,
+                                                            mp_index) ?
+                   LOOP_SPLIT_FAN :
+                   LOOP_SPLIT_SKIP;
+      }
+      else if (IS_EDGE_SHARP(e2l_prev)) {
+        type = LOOP_SPLIT_SINGLE;
       }
+      /* We *do not need* to check/tag loops as already computed!
+       * Due to the fact a loop only links to one of its two edges,
+       * a same fan *will never be walked more than once!*
+       * Since we consider edges having neighbor polys with inverted
+       * (flipped) normals as sharp, we are sure that no fan will be skipped,
+       * even only considering the case (sharp curr_edge, smooth prev_edge),
+       * and not the alternative (smooth curr_edge, sharp prev_edge).
+       * All this due/thanks to link between normals and loop ordering (i.e. winding).
+       */
       else {
-        LoopSplitTaskData *data, data_local;
+        type = LOOP_SPLIT_FAN;
+      }
 
-        //              printf("PROCESSING!\n");
+      loop_types[ml_curr_index] = type;
+      if (type != LOOP_SPLIT_SKIP) {
+        num_spaces++;
+      }
 
-        if (pool) {
-          if (data_idx == 0) {
-            data_buff = MEM_calloc_arrayN(
-                LOOP_SPLIT_TASK_BLOCK_SIZE, sizeof(*data_buff), __func__);
-          }
-          data = &data_buff[data_idx];
-        }
-        else {
-          data = &data_local;
-          memset(data, 0, sizeof(*data));
-        }
+      ml_prev = ml_curr;
+      ml_prev_index = ml_curr_index;
+    }
+  }
 
-        if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
-          data->lnor = lnors;
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-#if 0 /* Not needed for 'single' loop. */
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = NULL; /* Tag as 'single' task. */
-#endif
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
-        }
-        /* We *do not need* to check/tag loops as already computed!
-         * Due to the fact a loop only links to one of its two edges,
-         * a same fan *will never be walked more than once!*
-         * Since we consider edges having neighbor polys with inverted
-         * (flipped) normals as sharp, we are sure that no fan will be skipped,
-         * even only considering the case (sharp curr_edge, smooth prev_edge),
-         * and not the alternative (smooth curr_edge, sharp prev_edge).
-         * All this due/thanks to link between normals and loop ordering (i.e. winding).
-         */
-        else {
-#if 0 /* Not needed for 'fan' loops. */
-          data->lnor = lnors;
-#endif
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = e2l_prev; /* Also tag as 'fan' task. */
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
-        }
+  gen_data->block_spaces[block] = num_spaces;
+}
 
-        if (pool) {
-          data_idx++;
-          if (data_idx == LOOP_SPLIT_TASK_BLOCK_SIZE) {
-            BLI_task_pool_push(pool, loop_split_worker, data_buff, true, TASK_PRIORITY_LOW);
-            data_idx = 0;
-          }
+static void loop_split_generator_compute_cb(void *__restrict userdata,
+                                            const int block,
+                                            const ParallelRangeTLS *__restrict tls)
+{
+  LoopSplitGeneratorData *gen_data = userdata;
+  LoopSplitGeneratorTLS *gen_tls = tls->userdata_chunk;
+  LoopSplitTaskDataCommon *common_data = gen_data->common_data;
+
+  float(*loopnors)[3] = common_data->loopnors;
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mpolys = common_data->mpolys;
+  const int(*edge_to_loops)[2] = common_data->edge_to_loops;
+  const char *loop_types = gen_data->loop_types;
+
+  const int mp_start = block * LOOP_SPLIT_TASK_BLOCK_SIZE;
+  const int mp_end = min_ii(mp_start + LOOP_SPLIT_TASK_BLOCK_SIZE, common_data->numPolys);
+  int space_index = gen_data->block_spaces[block];
+
+  if (common_data->lnors_spacearr && gen_tls->edge_vectors == NULL) {
+    /* Created once per thread, not for each block. */
+    gen_tls->edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
+  }
+
+  for (int mp_index = mp_start; mp_index < mp_end; mp_index++) {
+    const MPoly *mp = &mpolys[mp_index];
+    const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+    int ml_curr_index = mp->loopstart;
+    int ml_prev_index = ml_last_index;
+
+    const MLoop *ml_curr = &mloops[ml_curr_index];
+    const MLoop *ml_prev = &mloops[ml_prev_index];
+
+    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
+      const char type = loop_types[ml_curr_index];
+
+      if (type != LOOP_SPLIT_SKIP) {
+        LoopSplitTaskData data = {NULL};
+
+        data.ml_curr = ml_curr;
+        data.ml_prev = ml_prev;
+        data.ml_curr_index = ml_curr_index;
+        data.mp_index = mp_index;
+        if (type == LOOP_SPLIT_SINGLE) {
+          data.lnor = &loopnors[ml_curr_index];
         }
         else {
-          loop_split_worker_do(common_data, data, edge_vectors);
+          data.ml_prev_index = ml_prev_index;
+          data.e2l_prev = edge_to_loops[ml_prev->e]; /* Also tag as 'fan' task. */
+        }
+        if (common_data->lnors_spacearr) {
+          data.lnor_space = &gen_data->spaces[space_index++];
         }
+
+        loop_split_worker_do(common_data, &data, gen_tls->edge_vectors);
       }
 
       ml_prev = ml_curr;
       ml_prev_index = ml_curr_index;
     }
   }
+}
 
-  /* Last block of data... Since it is calloc'ed and we use first NULL item as stopper,
-   * everything is fine. */
-  if (pool && data_idx) {
-    BLI_task_pool_push(pool, loop_split_worker, data_buff, true, TASK_PRIORITY_LOW);
+static void loop_split_generator_compute_finalize(void *__restrict UNUSED(userdata),
+                                                  void *__restrict userdata_chunk)
+{
+  LoopSplitGeneratorTLS *gen_tls = userdata_chunk;
+
+  if (gen_tls->edge_vectors) {
+    BLI_stack_free(gen_tls->edge_vectors);
   }
+}
 
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
+static void loop_split_generator(LoopSplitTaskDataCommon *common_data)
+{
+  MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
+  const int numLoops = common_data->numLoops;
+  const int numPolys = common_data->numPolys;
+  const int numBlocks = (numPolys + LOOP_SPLIT_TASK_BLOCK_SIZE - 1) / LOOP_SPLIT_TASK_BLOCK_SIZE;
+
+#ifdef DEBUG_TIME
+  TIMEIT_START_AVERAGED(loop_split_generator);
+#endif
+
+  LoopSplitGeneratorData gen_data = {
+      .common_data = common_data,
+      .loop_types = MEM_malloc_arrayN((size_t)numLoops, sizeof(char), __func__),
+      .block_spaces = MEM_malloc_arrayN((size_t)numBlocks, sizeof(int), __func__),
+  };
+
+  ParallelRangeSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  /* Not enough loops to be worth the whole threading overhead... */
+  settings.use_threading = (numLoops >= LOOP_SPLIT_TASK_BLOCK_SIZE * 8);
+
+  BLI_task_parallel_range(0, numBlocks, &gen_data, loop_split_generator_classify_cb, &settings);
+
+  /* Turn the number of lnor spaces of each block into the index of its first one,
+   * so that they can be allocated at once and filled in parallel. */
+  int num_spaces = 0;
+  for (int block = 0; block < numBlocks; block++) {
+    const int block_num_spaces = gen_data.block_spaces[block];
+    gen_data.block_spaces[block] = num_spaces;
+    num_spaces += block_num_spaces;
   }
-  MEM_freeN(skip_loops);
+
+  if (lnors_spacearr && num_spaces) {
+    gen_data.spaces = BLI_memarena_calloc(lnors_spacearr->mem,
+                                          sizeof(MLoopNorSpace) * (size_t)num_spaces);
+    lnors_spacearr->num_spaces += num_spaces;
+  }
+
+  LoopSplitGeneratorTLS gen_tls = {NULL};
+  settings.userdata_chunk = &gen_tls;
+  settings.userdata_chunk_size = sizeof(gen_tls);
+  settings.func_finalize = loop_split_generator_compute_finalize;
+
+  BLI_task_parallel_range(0, numBlocks, &gen_data, loop_split_generator_compute_cb, &settings);
+
+  MEM_freeN(gen_data.loop_types);
+  MEM_freeN(gen_data.block_spaces);
 
 #ifdef DEBUG_TIME
   TIMEIT_END_AVERAGED(loop_split_generator);
@@ -1752,23 +1787,7 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
   /* This first loop check which edges are actually smooth, and compute edge vectors. */
   mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
 
-  if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
-    /* Not enough loops to be worth the whole threading overhead... */
-    loop_split_generator(NULL, &common_data);
-  }
-  else {
-    TaskScheduler *task_scheduler;
-    TaskPool *task_pool;
-
-    task_scheduler = BLI_task_scheduler_get();
-    task_pool = BLI_task_pool_create(task_scheduler, &common_data);
-
-    loop_split_generator(task_pool, &common_data);
-
-    BLI_task_pool_work_and_wait(task_pool);
-
-    BLI_task_pool_free(task_pool);
-  }
+  loop_split_generator(&common_data);
 
   MEM_freeN(edge_to_loops);
   if (!r_loop_to_poly) {
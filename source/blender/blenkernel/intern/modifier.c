@@ -41,6 +41,7 @@
 #include "BLI_utildefines.h"
 #include "BLI_listbase.h"
 #include "BLI_linklist.h"
+#include "BLI_memarena.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_string_utils.h"
@@ -533,7 +534,8 @@ CDMaskLink *modifiers_calcDataMasks(struct Scene *scene,
                                     const CustomData_MeshMasks *dataMask,
                                     int required_mode,
                                     ModifierData *previewmd,
-                                    const CustomData_MeshMasks *previewmask)
+                                    const CustomData_MeshMasks *previewmask,
+                                    MemArena *arena)
 {
   CDMaskLink *dataMasks = NULL;
   CDMaskLink *curr, *prev;
@@ -542,7 +544,8 @@ CDMaskLink *modifiers_calcDataMasks(struct Scene *scene,
   for (; md; md = md->next) {
     const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
 
-    curr = MEM_callocN(sizeof(CDMaskLink), "CDMaskLink");
+    curr = arena ? BLI_memarena_calloc(arena, sizeof(CDMaskLink)) :
+                   MEM_callocN(sizeof(CDMaskLink), "CDMaskLink");
 
     if (modifier_isEnabled(scene, md, required_mode)) {
       if (mti->requiredDataMask) {
@@ -21,30 +21,63 @@
  */
 
 #include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <memory.h>
+#include <time.h>
+
+#include "zlib.h"
+
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#endif
 
 #include "MEM_guardedalloc.h"
 
+#include "DNA_anim_types.h"
+#include "DNA_packedFile_types.h"
 #include "DNA_sequence_types.h"
 #include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
+#include "DNA_vfont_types.h"
 
+#include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
 
+#include "BLI_utildefines.h"
+#include "BLI_fileops.h"
+#include "BLI_fileops_types.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_math_base.h"
 #include "BLI_mempool.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_system.h"
 #include "BLI_threads.h"
 #include "BLI_listbase.h"
 #include "BLI_ghash.h"
 
+#include "BKE_appdir.h"
+#include "BKE_blender_version.h"
+#include "BKE_fcurve.h"
 #include "BKE_sequencer.h"
 #include "BKE_scene.h"
 #include "BKE_main.h"
 
+#include "RNA_access.h"
+
+#include BLI_SYSTEM_PID_H
+
 /* ***************************** Sequencer cache design notes ******************************
  *
  * Cache key members:
  * is_temp_cache - this cache entry will be freed before rendering next frame
- * creator_id - ID of thread that created entry
+ * creator_id - ID of thread that created entry, SEQ_TASK_MAIN_RENDER or prefetch thread index
  * cost - In short: render time divided by playback frame rate
  * link_prev/next - link to another entry created during rendering of the frame
  *
@@ -52,6 +85,7 @@
  * Entries are linked in order as they are put into cache.
  * Only pernament (is_temp_cache = 0) cache entries are linked.
  * Putting SEQ_CACHE_STORE_FINAL_OUT will reset linking
+ * Every creator has its own chain, so frames rendered in parallel are linked separately.
  *
  * Function:
  * All images created during rendering are added to cache, even if the cache is already full.
@@ -67,14 +101,35 @@
  * entries one by one in reverse order to their creation.
  *
  * User can exclude caching of some images. Such entries will have is_temp_cache set.
+ *
+ * Prefetching: prefetch threads render evaluated copies of the scene and its strips, entries are
+ * always keyed by the original scene and strips so they are shared with the main render.
+ * Prefetched frames may only recycle frames before the current frame, otherwise the frame is not
+ * stored and prefetching pauses until the current frame changes. Images rendered by prefetch
+ * threads which are being stopped are not stored, these may be incomplete.
+ *
+ * Disk cache: images which are stored for later use are also written to disk when enabled in the
+ * preferences, and read from there when they're not in memory, see the disk cache section below.
  */
 
+#define SEQ_DISK_CACHE_MISS_MAX 8
+
+/* Image which wasn't found in the disk cache, its key is reused when the image is put. */
+typedef struct SeqDiskCacheMiss {
+  struct Sequence *seq;
+  float cfra;
+  int type;
+  uint64_t key;
+} SeqDiskCacheMiss;
+
 typedef struct SeqCache {
   struct GHash *hash;
   ThreadMutex iterator_mutex;
   struct BLI_mempool *keys_pool;
   struct BLI_mempool *items_pool;
-  struct SeqCacheKey *last_key;
+  struct SeqCacheKey *last_key[SEQ_PREFETCH_THREADS_MAX + 1];
+  /* Most recent first, inputs of a strip are looked up before the strip is put. */
+  SeqDiskCacheMiss disk_miss[SEQ_PREFETCH_THREADS_MAX + 1][SEQ_DISK_CACHE_MISS_MAX];
   size_t memory_used;
 } SeqCache;
 
@@ -199,7 +254,7 @@ static void seq_cache_put(SeqCache *cache, SeqCacheKey *key, ImBuf *ibuf)
 
   if (BLI_ghash_reinsert(cache->hash, key, item, seq_cache_keyfree, seq_cache_valfree)) {
     IMB_refImBuf(ibuf);
-    cache->last_key = key;
+    cache->last_key[key->creator_id] = key;
     cache->memory_used += IMB_get_size_in_memory(ibuf);
   }
 }
@@ -282,7 +337,7 @@ static void seq_cache_recycle_linked(Scene *scene, SeqCacheKey *base)
   }
 }
 
-static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
+static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene, bool is_prefetch_render)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
   SeqCacheKey *finalkey = NULL;
@@ -314,6 +369,16 @@ static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
       continue;
     }
 
+    /* Frame is still being rendered by its creator. */
+    if (key == cache->last_key[key->creator_id]) {
+      continue;
+    }
+
+    /* Don't throw away frames prefetched for upcoming playback. */
+    if (is_prefetch_render && key->cfra >= scene->r.cfra) {
+      continue;
+    }
+
     total_count++;
 
     if (key->cost <= scene->ed->recycle_max_cost) {
@@ -344,7 +409,7 @@ static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
 /* Find only "base" keys
  * Sources(other types) for a frame must be freed all at once
  */
-static bool seq_cache_recycle_item(Scene *scene)
+static bool seq_cache_recycle_item(Scene *scene, bool is_prefetch_render)
 {
   size_t memory_total = ((size_t)U.memcachelimit) * 1024 * 1024;
   SeqCache *cache = seq_cache_get_from_scene(scene);
@@ -355,7 +420,7 @@ static bool seq_cache_recycle_item(Scene *scene)
   seq_cache_lock(scene);
 
   while (cache->memory_used > memory_total) {
-    SeqCacheKey *finalkey = seq_cache_get_item_for_removal(scene);
+    SeqCacheKey *finalkey = seq_cache_get_item_for_removal(scene, is_prefetch_render);
 
     if (finalkey) {
       seq_cache_recycle_linked(scene, finalkey);
@@ -393,6 +458,22 @@ static void seq_cache_set_temp_cache_linked(Scene *scene, SeqCacheKey *base)
   }
 }
 
+/* Image types of seq which are stored for later use. */
+static int seq_cache_get_store_flag(Scene *scene, Sequence *seq)
+{
+  int flag;
+
+  if (seq->cache_flag & SEQ_CACHE_OVERRIDE) {
+    flag = seq->cache_flag;
+    flag |= scene->ed->cache_flag & SEQ_CACHE_STORE_FINAL_OUT;
+  }
+  else {
+    flag = scene->ed->cache_flag;
+  }
+
+  return flag;
+}
+
 static void BKE_sequencer_cache_create(Scene *scene)
 {
   BLI_mutex_lock(&cache_create_lock);
@@ -401,169 +482,23 @@ static void BKE_sequencer_cache_create(Scene *scene)
     cache->keys_pool = BLI_mempool_create(sizeof(SeqCacheKey), 0, 64, BLI_MEMPOOL_NOP);
     cache->items_pool = BLI_mempool_create(sizeof(SeqCacheItem), 0, 64, BLI_MEMPOOL_NOP);
     cache->hash = BLI_ghash_new(seq_cache_hashhash, seq_cache_hashcmp, "SeqCache hash");
-    cache->last_key = NULL;
     BLI_mutex_init(&cache->iterator_mutex);
     scene->ed->cache = cache;
   }
   BLI_mutex_unlock(&cache_create_lock);
 }
 
-/* ***************************** API ****************************** */
-
-void BKE_sequencer_cache_free_temp_cache(Scene *scene, short id, int cfra)
-{
-  SeqCache *cache = seq_cache_get_from_scene(scene);
-  if (!cache) {
-    return;
-  }
-
-  seq_cache_lock(scene);
-
-  GHashIterator gh_iter;
-  BLI_ghashIterator_init(&gh_iter, cache->hash);
-  while (!BLI_ghashIterator_done(&gh_iter)) {
-    SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
-    BLI_ghashIterator_step(&gh_iter);
-
-    if (key->is_temp_cache && key->creator_id == id && key->cfra != cfra) {
-      BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
-    }
-  }
-  seq_cache_unlock(scene);
-}
-
-void BKE_sequencer_cache_destruct(Scene *scene)
-{
-  SeqCache *cache = seq_cache_get_from_scene(scene);
-  if (!cache) {
-    return;
-  }
-
-  BLI_ghash_free(cache->hash, seq_cache_keyfree, seq_cache_valfree);
-  BLI_mempool_destroy(cache->keys_pool);
-  BLI_mempool_destroy(cache->items_pool);
-  BLI_mutex_end(&cache->iterator_mutex);
-  MEM_freeN(cache);
-  scene->ed->cache = NULL;
-}
-
-void BKE_sequencer_cache_cleanup_all(Main *bmain)
-{
-  for (Scene *scene = bmain->scenes.first; scene != NULL; scene = scene->id.next) {
-    BKE_sequencer_cache_cleanup(scene);
-  }
-}
-void BKE_sequencer_cache_cleanup(Scene *scene)
-{
-  SeqCache *cache = seq_cache_get_from_scene(scene);
-  if (!cache) {
-    return;
-  }
-
-  seq_cache_lock(scene);
-
-  GHashIterator gh_iter;
-  BLI_ghashIterator_init(&gh_iter, cache->hash);
-  while (!BLI_ghashIterator_done(&gh_iter)) {
-    SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
-
-    BLI_ghashIterator_step(&gh_iter);
-    BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
-  }
-  cache->last_key = NULL;
-  seq_cache_unlock(scene);
-}
-
-void BKE_sequencer_cache_cleanup_sequence(Scene *scene, Sequence *seq)
-{
-  SeqCache *cache = seq_cache_get_from_scene(scene);
-  if (!cache) {
-    return;
-  }
-
-  seq_cache_lock(scene);
-
-  GHashIterator gh_iter;
-  BLI_ghashIterator_init(&gh_iter, cache->hash);
-  while (!BLI_ghashIterator_done(&gh_iter)) {
-    SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
-    BLI_ghashIterator_step(&gh_iter);
-
-    if (key->seq == seq) {
-      /* Relink keys, so we don't end up with orphaned keys */
-      if (key->link_next || key->link_prev) {
-        seq_cache_relink_keys(key->link_next, key->link_prev);
-      }
-
-      BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
-    }
-  }
-  cache->last_key = NULL;
-  seq_cache_unlock(scene);
-}
-
-struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context,
-                                      Sequence *seq,
-                                      float cfra,
-                                      int type)
-{
-  Scene *scene = context->scene;
-
-  if (!scene->ed->cache) {
-    BKE_sequencer_cache_create(scene);
-    return NULL;
-  }
-
-  seq_cache_lock(scene);
-  SeqCache *cache = seq_cache_get_from_scene(scene);
-  ImBuf *ibuf = NULL;
-
-  if (cache && seq) {
-    SeqCacheKey key;
-
-    key.seq = seq;
-    key.context = *context;
-    key.nfra = cfra - seq->start;
-    key.type = type;
-
-    ibuf = seq_cache_get(cache, &key);
-  }
-  seq_cache_unlock(scene);
-
-  return ibuf;
-}
-
-bool BKE_sequencer_cache_put_if_possible(
-    const SeqRenderData *context, Sequence *seq, float cfra, int type, ImBuf *ibuf, float cost)
-{
-  Scene *scene = context->scene;
-
-  if (seq_cache_recycle_item(scene)) {
-    BKE_sequencer_cache_put(context, seq, cfra, type, ibuf, cost);
-    return true;
-  }
-  else {
-    seq_cache_set_temp_cache_linked(scene, scene->ed->cache->last_key);
-    scene->ed->cache->last_key = NULL;
-    return false;
-  }
-}
-
-void BKE_sequencer_cache_put(
+/* Returns true if the image is stored for later use. */
+static bool seq_cache_put_memory(
     const SeqRenderData *context, Sequence *seq, float cfra, int type, ImBuf *i, float cost)
 {
-  Scene *scene = context->scene;
-  short creator_id = 0;
+  Scene *scene = BKE_sequencer_prefetch_get_original_scene(context);
+  short creator_id = context->task_id;
 
-  if (i == NULL || context->skip_cache || context->is_proxy_render || !seq) {
-    return;
-  }
+  seq = BKE_sequencer_prefetch_get_original_sequence(context, seq);
 
-  /* Prevent reinserting, it breaks cache key linking */
-  ImBuf *test = BKE_sequencer_cache_get(context, seq, cfra, type);
-  if (test) {
-    IMB_freeImBuf(test);
-    return;
+  if (i == NULL || context->skip_cache || context->is_proxy_render || !seq) {
+    return false;
   }
 
   if (!scene->ed->cache) {
@@ -573,15 +508,7 @@ void BKE_sequencer_cache_put(
   seq_cache_lock(scene);
 
   SeqCache *cache = seq_cache_get_from_scene(scene);
-  int flag;
-
-  if (seq->cache_flag & SEQ_CACHE_OVERRIDE) {
-    flag = seq->cache_flag;
-    flag |= scene->ed->cache_flag & SEQ_CACHE_STORE_FINAL_OUT;
-  }
-  else {
-    flag = scene->ed->cache_flag;
-  }
+  int flag = seq_cache_get_store_flag(scene, seq);
 
   if (cost > SEQ_CACHE_COST_MAX) {
     cost = SEQ_CACHE_COST_MAX;
@@ -592,6 +519,8 @@ void BKE_sequencer_cache_put(
   key->cache_owner = cache;
   key->seq = seq;
   key->context = *context;
+  key->context.scene = scene;
+  key->context.depsgraph = NULL;
   key->cfra = cfra;
   key->nfra = cfra - seq->start;
   key->type = type;
@@ -602,57 +531,1247 @@ void BKE_sequencer_cache_put(
   key->is_temp_cache = true;
   key->creator_id = creator_id;
 
+  /* Prevent reinserting, it breaks cache key linking. Another thread may have rendered the same
+   * image meanwhile, so this is checked with the cache locked. */
+  if (BLI_ghash_haskey(cache->hash, key)) {
+    BLI_mempool_free(cache->keys_pool, key);
+    seq_cache_unlock(scene);
+    return false;
+  }
+
   /* Item stored for later use */
   if (flag & type) {
     key->is_temp_cache = false;
-    key->link_prev = cache->last_key;
+    key->link_prev = cache->last_key[creator_id];
   }
 
-  SeqCacheKey *temp_last_key = cache->last_key;
+  SeqCacheKey *temp_last_key = cache->last_key[creator_id];
   seq_cache_put(cache, key, i);
 
   /* Restore pointer to previous item as this one will be freed when stack is rendered */
   if (key->is_temp_cache) {
-    cache->last_key = temp_last_key;
+    cache->last_key[creator_id] = temp_last_key;
   }
 
   /* Set last_key's reference to this key so we can look up chain backwards
    * Item is already put in cache, so cache->last_key points to current key;
    */
   if (flag & type && temp_last_key) {
-    temp_last_key->link_next = cache->last_key;
+    temp_last_key->link_next = cache->last_key[creator_id];
   }
 
   /* Reset linking */
   if (key->type == SEQ_CACHE_STORE_FINAL_OUT) {
-    cache->last_key = NULL;
+    cache->last_key[creator_id] = NULL;
   }
 
   seq_cache_unlock(scene);
+
+  return (flag & type) != 0;
 }
 
-void BKE_sequencer_cache_iterate(
-    struct Scene *scene,
-    void *userdata,
-    bool callback(void *userdata, struct Sequence *seq, int cfra, int cache_type, float cost))
+/* ***************************** Disk cache ******************************
+ *
+ * Images are also written to a directory shared by all files and sessions on the workstation,
+ * under a size limit set in the preferences. Files are named by a hash of everything that affects
+ * the image: render settings, properties of the strip and its inputs, for composite and final
+ * images also strips below it, and path, size and modification time of the media files. So frames
+ * survive restarts as long as nothing they depend on changes, and edits never load old images.
+ *
+ * Properties are hashed as evaluated for the frame, which covers animation. Strips using scenes,
+ * masks or movie clips, and strips shown from proxies are not written, content of these datablocks
+ * and proxy files isn't hashed.
+ * When the cache is over its limit, least recently used files are removed.
+ *
+ * Keys are computed on the render thread, images are compressed and written by a background
+ * thread. Keys of images not found on disk are kept until the image is put, so properties are
+ * hashed once per rendered image.
+ *
+ * Images are read on the render thread, so decompressing has to fit in the time of a frame. Low
+ * compression uses LZO, which decompresses a 1080p float image in about 20ms, zlib takes about
+ * 180ms and is only used for high compression.
+ */
+
+#define SEQ_DISK_CACHE_VERSION 2
+#define SEQ_DISK_CACHE_MAGIC "BSEQCACH"
+#define SEQ_DISK_CACHE_EXT ".seqcache"
+#define SEQ_DISK_CACHE_TMP_EXT ".tmp"
+/* Temporary files older than this are left over from crashed sessions, in seconds. */
+#define SEQ_DISK_CACHE_TMP_TIMEOUT (60 * 60)
+/* Images waiting to be written, more are not written so the queue doesn't use much memory. */
+#define SEQ_DISK_CACHE_WRITE_QUEUE_MAX 8
+/* Limit for nested strips and structs, deeper strips are not written. */
+#define SEQ_DISK_CACHE_HASH_DEPTH_MAX 16
+#define SEQ_DISK_CACHE_LZO_OUT_LEN(size) ((size) + (size) / 16 + 64 + 3)
+
+/* SeqDiskCacheHeader.compression */
+enum {
+  SEQ_DISK_CACHE_COMPRESSION_NONE = 0,
+  SEQ_DISK_CACHE_COMPRESSION_LZO = 1,
+  SEQ_DISK_CACHE_COMPRESSION_ZLIB = 2,
+};
+
+typedef struct SeqDiskCacheHash {
+  /* Two seeds, so names of cache files are 64 bit. */
+  BLI_HashMurmur2A mm2[2];
+  const char *blendfile_path;
+  float cfra;
+  int preview_render_size;
+  int depth;
+} SeqDiskCacheHash;
+
+typedef struct SeqDiskCacheHeader {
+  char magic[8];
+  uint64_t key;
+  int version;
+  int x, y;
+  int planes;
+  int channels;
+  /* IB_rect and IB_rectfloat */
+  int flag;
+  /* Method used for compressed buffers */
+  int compression;
+  int _pad;
+  /* Size of stored buffers, equal to size of the image when not compressed */
+  uint64_t rect_size;
+  uint64_t rect_float_size;
+  /* MAX_COLORSPACE_NAME */
+  char rect_colorspace[64];
+  char float_colorspace[64];
+} SeqDiskCacheHeader;
+
+typedef struct SeqDiskCacheWrite {
+  uint64_t key;
+  ImBuf *ibuf;
+} SeqDiskCacheWrite;
+
+static ThreadMutex seq_disk_cache_lock = BLI_MUTEX_INITIALIZER;
+/* Size of files in the cache directory, protected by seq_disk_cache_lock. */
+static char seq_disk_cache_dir_used[FILE_MAX] = "";
+static size_t seq_disk_cache_size_used = 0;
+/* Images are compressed and written by a single thread, started on first write. */
+static ThreadQueue *seq_disk_cache_write_queue = NULL;
+static ListBase seq_disk_cache_write_thread = {NULL, NULL};
+
+static bool seq_disk_cache_is_enabled(const SeqRenderData *context)
 {
-  SeqCache *cache = seq_cache_get_from_scene(scene);
-  if (!cache) {
-    return;
+  return U.sequencer_disk_cache_size_limit > 0 && !context->skip_cache &&
+         !context->is_proxy_render;
+}
+
+static size_t seq_disk_cache_size_limit(void)
+{
+  return ((size_t)U.sequencer_disk_cache_size_limit) * 1024 * 1024 * 1024;
+}
+
+static void seq_disk_cache_get_dir(char *dir, size_t dir_len)
+{
+  if (U.sequencer_disk_cache_dir[0]) {
+    BLI_strncpy(dir, U.sequencer_disk_cache_dir, dir_len);
+  }
+  else {
+    BLI_join_dirfile(dir, dir_len, BKE_tempdir_base(), "blender_sequencer_cache");
   }
+}
 
-  seq_cache_lock(scene);
-  GHashIterator gh_iter;
-  BLI_ghashIterator_init(&gh_iter, cache->hash);
-  bool interrupt = false;
+static void seq_disk_cache_get_filepath(uint64_t key, char *filepath, size_t filepath_len)
+{
+  char dir[FILE_MAX], filename[64];
+
+  seq_disk_cache_get_dir(dir, sizeof(dir));
+  BLI_snprintf(filename,
+               sizeof(filename),
+               "%08x%08x" SEQ_DISK_CACHE_EXT,
+               (unsigned int)(key >> 32),
+               (unsigned int)key);
+  BLI_join_dirfile(filepath, filepath_len, dir, filename);
+}
 
-  while (!BLI_ghashIterator_done(&gh_iter) && !interrupt) {
-    SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
-    BLI_ghashIterator_step(&gh_iter);
+static void seq_disk_cache_hash_add(SeqDiskCacheHash *hash, const void *data, size_t len)
+{
+  BLI_hash_mm2a_add(&hash->mm2[0], data, len);
+  BLI_hash_mm2a_add(&hash->mm2[1], data, len);
+}
 
-    interrupt = callback(userdata, key->seq, key->cfra, key->type, key->cost);
+static void seq_disk_cache_hash_add_int(SeqDiskCacheHash *hash, int value)
+{
+  seq_disk_cache_hash_add(hash, &value, sizeof(value));
+}
+
+static void seq_disk_cache_hash_add_float(SeqDiskCacheHash *hash, float value)
+{
+  seq_disk_cache_hash_add(hash, &value, sizeof(value));
+}
+
+static void seq_disk_cache_hash_add_string(SeqDiskCacheHash *hash, const char *str)
+{
+  seq_disk_cache_hash_add(hash, str, strlen(str) + 1);
+}
+
+/* Files are identified by path, size and modification time, so replacing a file on disk
+ * invalidates images rendered from it. */
+static void seq_disk_cache_hash_filepath(SeqDiskCacheHash *hash,
+                                         const char *filepath,
+                                         const char *relbase)
+{
+  char filepath_abs[FILE_MAX];
+  BLI_stat_t st;
+
+  BLI_strncpy(filepath_abs, filepath, sizeof(filepath_abs));
+  BLI_path_abs(filepath_abs, relbase);
+  seq_disk_cache_hash_add_string(hash, filepath_abs);
+
+  if (BLI_stat(filepath_abs, &st) == 0) {
+    const int64_t file_info[2] = {(int64_t)st.st_size, (int64_t)st.st_mtime};
+    seq_disk_cache_hash_add(hash, file_info, sizeof(file_info));
   }
+}
 
-  cache->last_key = NULL;
-  seq_cache_unlock(scene);
+/* Returns false if the strip shows a proxy, proxy files aren't hashed. */
+static bool seq_disk_cache_hash_file(SeqDiskCacheHash *hash, Sequence *seq)
+{
+  char filepath[FILE_MAX];
+
+  if (hash->preview_render_size < 100 && (seq->flag & SEQ_USE_PROXY) && seq->strip->proxy) {
+    return false;
+  }
+
+  if (seq->type == SEQ_TYPE_IMAGE) {
+    StripElem *se = BKE_sequencer_give_stripelem(seq, hash->cfra);
+
+    if (se == NULL) {
+      return true;
+    }
+    BLI_join_dirfile(filepath, sizeof(filepath), seq->strip->dir, se->name);
+  }
+  else if (seq->type == SEQ_TYPE_MOVIE && seq->strip->stripdata) {
+    BLI_join_dirfile(filepath, sizeof(filepath), seq->strip->dir, seq->strip->stripdata->name);
+  }
+  else {
+    return true;
+  }
+
+  seq_disk_cache_hash_filepath(hash, filepath, hash->blendfile_path);
+  return true;
+}
+
+/* Fonts are identified by their file, or by their content when packed. */
+static void seq_disk_cache_hash_vfont(SeqDiskCacheHash *hash, VFont *vfont)
+{
+  if (vfont->packedfile) {
+    seq_disk_cache_hash_add(hash, vfont->packedfile->data, vfont->packedfile->size);
+  }
+  else {
+    seq_disk_cache_hash_filepath(
+        hash, vfont->name, vfont->id.lib ? vfont->id.lib->filepath : hash->blendfile_path);
+  }
+}
+
+/* Speed control strips map frames by integrating the animated speed over all frames before cfra,
+ * see BKE_sequence_effect_speed_rebuild_map, so the whole F-Curve is part of the key. Other
+ * effects only evaluate their animation at cfra, which is hashed with their properties. */
+static bool seq_disk_cache_hash_speed_fcurve(SeqDiskCacheHash *hash, Scene *scene, Sequence *seq)
+{
+  FCurve *fcu = id_data_find_fcurve(&scene->id, seq, &RNA_Sequence, "speed_factor", 0, NULL);
+
+  if (fcu == NULL) {
+    seq_disk_cache_hash_add_int(hash, 0);
+    return true;
+  }
+
+  /* Modifiers can generate values which don't follow from keyframes. */
+  if (fcu->fpt || !BLI_listbase_is_empty(&fcu->modifiers)) {
+    return false;
+  }
+
+  seq_disk_cache_hash_add_int(hash, fcu->totvert);
+  seq_disk_cache_hash_add_int(hash, fcu->extend);
+
+  for (uint i = 0; i < fcu->totvert; i++) {
+    const BezTriple *bezt = &fcu->bezt[i];
+    const float params[3] = {bezt->back, bezt->amplitude, bezt->period};
+    const int modes[2] = {bezt->ipo, bezt->easing};
+
+    seq_disk_cache_hash_add(hash, bezt->vec, sizeof(bezt->vec));
+    seq_disk_cache_hash_add(hash, params, sizeof(params));
+    seq_disk_cache_hash_add(hash, modes, sizeof(modes));
+  }
+
+  return true;
+}
+
+/* Properties which don't change rendered images. */
+static bool seq_disk_cache_skip_property(PropertyRNA *prop)
+{
+  static const char *skip_identifiers[] = {"rna_type",
+                                           "name",
+                                           "select",
+                                           "select_left_handle",
+                                           "select_right_handle",
+                                           "lock",
+                                           "elements",
+                                           "fps",
+                                           "override_cache_settings",
+                                           NULL};
+  const char *identifier = RNA_property_identifier(prop);
+
+  if (RNA_property_is_idprop(prop) || STRPREFIX(identifier, "use_cache_")) {
+    return true;
+  }
+
+  for (int i = 0; skip_identifiers[i]; i++) {
+    if (STREQ(identifier, skip_identifiers[i])) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static bool seq_disk_cache_hash_pointer(SeqDiskCacheHash *hash, PointerRNA *ptr);
+
+static bool seq_disk_cache_hash_property(SeqDiskCacheHash *hash,
+                                         PointerRNA *ptr,
+                                         PropertyRNA *prop)
+{
+  const int len = RNA_property_array_length(ptr, prop);
+  bool is_hashable = true;
+
+  seq_disk_cache_hash_add_string(hash, RNA_property_identifier(prop));
+
+  switch (RNA_property_type(prop)) {
+    case PROP_BOOLEAN:
+      if (len) {
+        bool *values = MEM_mallocN(sizeof(bool) * len, __func__);
+        RNA_property_boolean_get_array(ptr, prop, values);
+        seq_disk_cache_hash_add(hash, values, sizeof(bool) * len);
+        MEM_freeN(values);
+      }
+      else {
+        seq_disk_cache_hash_add_int(hash, RNA_property_boolean_get(ptr, prop));
+      }
+      break;
+    case PROP_INT:
+      if (len) {
+        int *values = MEM_mallocN(sizeof(int) * len, __func__);
+        RNA_property_int_get_array(ptr, prop, values);
+        seq_disk_cache_hash_add(hash, values, sizeof(int) * len);
+        MEM_freeN(values);
+      }
+      else {
+        seq_disk_cache_hash_add_int(hash, RNA_property_int_get(ptr, prop));
+      }
+      break;
+    case PROP_FLOAT:
+      if (len) {
+        float *values = MEM_mallocN(sizeof(float) * len, __func__);
+        RNA_property_float_get_array(ptr, prop, values);
+        seq_disk_cache_hash_add(hash, values, sizeof(float) * len);
+        MEM_freeN(values);
+      }
+      else {
+        seq_disk_cache_hash_add_float(hash, RNA_property_float_get(ptr, prop));
+      }
+      break;
+    case PROP_ENUM:
+      seq_disk_cache_hash_add_int(hash, RNA_property_enum_get(ptr, prop));
+      break;
+    case PROP_STRING: {
+      char fixedbuf[256];
+      int value_len;
+      char *value = RNA_property_string_get_alloc(
+          ptr, prop, fixedbuf, sizeof(fixedbuf), &value_len);
+
+      seq_disk_cache_hash_add(hash, value, value_len);
+      if (value != fixedbuf) {
+        MEM_freeN(value);
+      }
+      break;
+    }
+    case PROP_POINTER: {
+      PointerRNA value = RNA_property_pointer_get(ptr, prop);
+      is_hashable = seq_disk_cache_hash_pointer(hash, &value);
+      break;
+    }
+    case PROP_COLLECTION:
+      RNA_PROP_BEGIN (ptr, itemptr, prop) {
+        if (is_hashable) {
+          is_hashable = seq_disk_cache_hash_pointer(hash, &itemptr);
+        }
+      }
+      RNA_PROP_END;
+      break;
+  }
+
+  return is_hashable;
+}
+
+static bool seq_disk_cache_hash_struct(SeqDiskCacheHash *hash, PointerRNA *ptr)
+{
+  bool is_hashable = true;
+
+  seq_disk_cache_hash_add_string(hash, RNA_struct_identifier(ptr->type));
+
+  RNA_STRUCT_BEGIN (ptr, prop) {
+    if (is_hashable && !seq_disk_cache_skip_property(prop)) {
+      is_hashable = seq_disk_cache_hash_property(hash, ptr, prop);
+    }
+  }
+  RNA_STRUCT_END;
+
+  if (is_hashable && RNA_struct_is_a(ptr->type, &RNA_Sequence)) {
+    Sequence *seq = ptr->data;
+
+    is_hashable = seq_disk_cache_hash_file(hash, seq);
+
+    if (is_hashable && seq->type == SEQ_TYPE_SPEED) {
+      is_hashable = seq_disk_cache_hash_speed_fcurve(hash, ptr->id.data, seq);
+    }
+  }
+
+  return is_hashable;
+}
+
+/* Returns false if the image depends on data which isn't hashed. */
+static bool seq_disk_cache_hash_pointer(SeqDiskCacheHash *hash, PointerRNA *ptr)
+{
+  bool is_hashable;
+
+  if (ptr->data == NULL) {
+    seq_disk_cache_hash_add_int(hash, 0);
+    return true;
+  }
+
+  /* Datablocks are identified by name, their content doesn't change sequencer images,
+   * except for these. */
+  if (RNA_struct_is_ID(ptr->type)) {
+    ID *id = ptr->data;
+
+    if (ELEM(GS(id->name), ID_SCE, ID_MSK, ID_MC)) {
+      return false;
+    }
+
+    seq_disk_cache_hash_add_string(hash, id->name);
+    if (id->lib) {
+      seq_disk_cache_hash_add_string(hash, id->lib->name);
+    }
+    if (GS(id->name) == ID_VF) {
+      seq_disk_cache_hash_vfont(hash, (VFont *)id);
+    }
+    return true;
+  }
+
+  if (hash->depth >= SEQ_DISK_CACHE_HASH_DEPTH_MAX) {
+    return false;
+  }
+
+  hash->depth++;
+  is_hashable = seq_disk_cache_hash_struct(hash, ptr);
+  hash->depth--;
+
+  return is_hashable;
+}
+
+/* Strips below seq which are shown in the frame, these are blended into composite images. */
+static bool seq_disk_cache_hash_stack(SeqDiskCacheHash *hash, Scene *scene, Sequence *seq)
+{
+  ListBase *seqbase = BKE_sequence_seqbase(&scene->ed->seqbase, seq);
+
+  if (seqbase == NULL) {
+    return false;
+  }
+
+  for (Sequence *seq_iter = seqbase->first; seq_iter; seq_iter = seq_iter->next) {
+    if (seq_iter == seq || seq_iter->machine > seq->machine ||
+        seq_iter->startdisp > hash->cfra || seq_iter->enddisp <= hash->cfra) {
+      continue;
+    }
+
+    PointerRNA ptr;
+    RNA_pointer_create(&scene->id, &RNA_Sequence, seq_iter, &ptr);
+
+    if (!seq_disk_cache_hash_pointer(hash, &ptr)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* Key of the image in the disk cache, 0 if it can't be written to disk. Strips and scene of the
+ * render context are used, for prefetching these are evaluated copies. */
+static uint64_t seq_disk_cache_key(const SeqRenderData *context,
+                                   Sequence *seq,
+                                   float cfra,
+                                   int type)
+{
+  Scene *scene = context->scene;
+  SeqDiskCacheHash hash;
+  PointerRNA ptr;
+
+  BLI_hash_mm2a_init(&hash.mm2[0], 0);
+  BLI_hash_mm2a_init(&hash.mm2[1], 0x9e3779b9);
+  hash.blendfile_path = BKE_main_blendfile_path(context->bmain);
+  hash.cfra = cfra;
+  hash.preview_render_size = context->preview_render_size;
+  hash.depth = 0;
+
+  seq_disk_cache_hash_add_int(&hash, SEQ_DISK_CACHE_VERSION);
+  seq_disk_cache_hash_add_int(&hash, BLENDER_VERSION);
+  seq_disk_cache_hash_add_int(&hash, BLENDER_SUBVERSION);
+  seq_disk_cache_hash_add_int(&hash, type);
+  seq_disk_cache_hash_add_float(&hash, cfra);
+
+  seq_disk_cache_hash_add_int(&hash, context->rectx);
+  seq_disk_cache_hash_add_int(&hash, context->recty);
+  seq_disk_cache_hash_add_int(&hash, context->preview_render_size);
+  seq_disk_cache_hash_add_int(&hash, context->motion_blur_samples);
+  seq_disk_cache_hash_add_float(&hash, context->motion_blur_shutter);
+  seq_disk_cache_hash_add_int(&hash, context->view_id);
+  seq_disk_cache_hash_add_int(&hash, context->for_render);
+
+  seq_disk_cache_hash_add_int(&hash, scene->r.views_format);
+  seq_disk_cache_hash_add_int(&hash, scene->r.seq_flag);
+  seq_disk_cache_hash_add_int(&hash, scene->r.frs_sec);
+  seq_disk_cache_hash_add_float(&hash, scene->r.frs_sec_base);
+  seq_disk_cache_hash_add_string(&hash, scene->sequencer_colorspace_settings.name);
+
+  RNA_pointer_create(&scene->id, &RNA_Sequence, seq, &ptr);
+
+  if (!seq_disk_cache_hash_pointer(&hash, &ptr)) {
+    return 0;
+  }
+
+  if (ELEM(type, SEQ_CACHE_STORE_COMPOSITE, SEQ_CACHE_STORE_FINAL_OUT) ||
+      ELEM(seq->type, SEQ_TYPE_ADJUSTMENT, SEQ_TYPE_MULTICAM)) {
+    if (!seq_disk_cache_hash_stack(&hash, scene, seq)) {
+      return 0;
+    }
+  }
+
+  const uint64_t key = ((uint64_t)BLI_hash_mm2a_end(&hash.mm2[0]) << 32) |
+                       BLI_hash_mm2a_end(&hash.mm2[1]);
+
+  return (key != 0) ? key : 1;
+}
+
+static int seq_disk_cache_compression(void)
+{
+  switch (U.sequencer_disk_cache_compression) {
+    case USER_SEQ_DISK_CACHE_COMPRESSION_NONE:
+      return SEQ_DISK_CACHE_COMPRESSION_NONE;
+    case USER_SEQ_DISK_CACHE_COMPRESSION_HIGH:
+      return SEQ_DISK_CACHE_COMPRESSION_ZLIB;
+    case USER_SEQ_DISK_CACHE_COMPRESSION_LOW:
+    default:
+#ifdef WITH_LZO
+      return SEQ_DISK_CACHE_COMPRESSION_LZO;
+#else
+      return SEQ_DISK_CACHE_COMPRESSION_NONE;
+#endif
+  }
+}
+
+/* Compressed copy of data, or data itself when it's stored uncompressed. */
+static void *seq_disk_cache_compress(void *data, size_t size, int compression, uint64_t *r_size)
+{
+  void *compressed = NULL;
+  size_t compressed_size = size;
+
+  switch (compression) {
+#ifdef WITH_LZO
+    case SEQ_DISK_CACHE_COMPRESSION_LZO: {
+      lzo_uint out_len = SEQ_DISK_CACHE_LZO_OUT_LEN(size);
+      void *wrkmem = MEM_mallocN(LZO1X_1_MEM_COMPRESS, __func__);
+
+      compressed = MEM_mallocN(out_len, __func__);
+      if (lzo1x_1_compress(data, size, compressed, &out_len, wrkmem) == LZO_E_OK) {
+        compressed_size = out_len;
+      }
+      MEM_freeN(wrkmem);
+      break;
+    }
+#endif
+    case SEQ_DISK_CACHE_COMPRESSION_ZLIB: {
+      uLongf out_len = compressBound(size);
+
+      compressed = MEM_mallocN(out_len, __func__);
+      if (compress2(compressed, &out_len, data, size, Z_DEFAULT_COMPRESSION) == Z_OK) {
+        compressed_size = out_len;
+      }
+      break;
+    }
+  }
+
+  /* Incompressible data is stored as is, which is also the fastest to read. */
+  if (compressed && compressed_size < size) {
+    *r_size = compressed_size;
+    return compressed;
+  }
+
+  MEM_SAFE_FREE(compressed);
+  *r_size = size;
+  return data;
+}
+
+static bool seq_disk_cache_read_buffer(
+    FILE *file, void *data, size_t size, uint64_t stored_size, int compression)
+{
+  if (stored_size == size) {
+    return fread(data, size, 1, file) == 1;
+  }
+
+  if (stored_size > size) {
+    return false;
+  }
+
+  void *compressed = MEM_mallocN(stored_size, __func__);
+  bool ok = fread(compressed, stored_size, 1, file) == 1;
+
+  if (ok) {
+    switch (compression) {
+#ifdef WITH_LZO
+      case SEQ_DISK_CACHE_COMPRESSION_LZO: {
+        lzo_uint out_len = size;
+        ok = lzo1x_decompress_safe(compressed, stored_size, data, &out_len, NULL) == LZO_E_OK &&
+             out_len == size;
+        break;
+      }
+#endif
+      case SEQ_DISK_CACHE_COMPRESSION_ZLIB: {
+        uLongf out_len = size;
+        ok = uncompress(data, &out_len, compressed, stored_size) == Z_OK && out_len == size;
+        break;
+      }
+      default:
+        /* Corrupt, or written by a build with LZO. */
+        ok = false;
+        break;
+    }
+  }
+
+  MEM_freeN(compressed);
+  return ok;
+}
+
+/* Least recently used files first. */
+static int seq_disk_cache_file_cmp(const void *a_, const void *b_)
+{
+  const struct direntry *a = *(const struct direntry **)a_;
+  const struct direntry *b = *(const struct direntry **)b_;
+
+  if (a->s.st_mtime < b->s.st_mtime) {
+    return -1;
+  }
+  if (a->s.st_mtime > b->s.st_mtime) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Remove least recently used files until the cache directory uses less than 90% of the limit,
+ * returns the size of remaining files. Files written by other sessions are only counted here. */
+static size_t seq_disk_cache_enforce_limit(const char *dir, size_t limit)
+{
+  struct direntry *filelist;
+  const unsigned int totfile = BLI_filelist_dir_contents(dir, &filelist);
+  struct direntry **files = MEM_mallocN(sizeof(*files) * max_ii(totfile, 1), __func__);
+  const time_t now = time(NULL);
+  unsigned int totcache = 0;
+  size_t size_used = 0;
+
+  for (unsigned int i = 0; i < totfile; i++) {
+    struct direntry *file = &filelist[i];
+
+    if (!S_ISREG(file->type)) {
+      continue;
+    }
+
+    if (BLI_path_extension_check(file->relname, SEQ_DISK_CACHE_EXT)) {
+      files[totcache++] = file;
+      size_used += file->s.st_size;
+    }
+    else if (strstr(file->relname, SEQ_DISK_CACHE_EXT ".") &&
+             BLI_path_extension_check(file->relname, SEQ_DISK_CACHE_TMP_EXT)) {
+      /* Being written by this or another session, unless it's stale. */
+      if (now - file->s.st_mtime > SEQ_DISK_CACHE_TMP_TIMEOUT &&
+          BLI_delete(file->path, false, false) == 0) {
+        continue;
+      }
+      size_used += file->s.st_size;
+    }
+  }
+
+  if (size_used > limit) {
+    qsort(files, totcache, sizeof(*files), seq_disk_cache_file_cmp);
+
+    for (unsigned int i = 0; i < totcache && size_used > limit / 10 * 9; i++) {
+      if (BLI_delete(files[i]->path, false, false) == 0) {
+        size_used -= files[i]->s.st_size;
+      }
+    }
+  }
+
+  MEM_freeN(files);
+  BLI_filelist_free(filelist, totfile);
+
+  return size_used;
+}
+
+static void seq_disk_cache_add_size(const char *dir, size_t size)
+{
+  const size_t limit = seq_disk_cache_size_limit();
+
+  BLI_mutex_lock(&seq_disk_cache_lock);
+
+  if (!STREQ(seq_disk_cache_dir_used, dir)) {
+    /* First write to this directory, the new file is counted by the scan. */
+    BLI_strncpy(seq_disk_cache_dir_used, dir, sizeof(seq_disk_cache_dir_used));
+    seq_disk_cache_size_used = seq_disk_cache_enforce_limit(dir, limit);
+  }
+  else {
+    seq_disk_cache_size_used += size;
+
+    if (seq_disk_cache_size_used > limit) {
+      seq_disk_cache_size_used = seq_disk_cache_enforce_limit(dir, limit);
+    }
+  }
+
+  BLI_mutex_unlock(&seq_disk_cache_lock);
+}
+
+static void seq_disk_cache_write(uint64_t key, ImBuf *ibuf)
+{
+  char filepath[FILE_MAX], filepath_tmp[FILE_MAX + 32], dir[FILE_MAX];
+  SeqDiskCacheHeader header;
+  const int compression = seq_disk_cache_compression();
+  const size_t num_pixels = (size_t)ibuf->x * ibuf->y;
+  void *rect = NULL, *rect_float = NULL;
+
+  seq_disk_cache_get_filepath(key, filepath, sizeof(filepath));
+
+  /* Written by another thread or session already. */
+  if (BLI_exists(filepath)) {
+    return;
+  }
+
+  BLI_split_dir_part(filepath, dir, sizeof(dir));
+  if (!BLI_dir_create_recursive(dir)) {
+    return;
+  }
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SEQ_DISK_CACHE_MAGIC, sizeof(header.magic));
+  header.key = key;
+  header.version = SEQ_DISK_CACHE_VERSION;
+  header.x = ibuf->x;
+  header.y = ibuf->y;
+  header.planes = ibuf->planes;
+  header.channels = ibuf->channels;
+  header.compression = compression;
+
+  if (ibuf->rect) {
+    header.flag |= IB_rect;
+    rect = seq_disk_cache_compress(
+        ibuf->rect, num_pixels * sizeof(unsigned int), compression, &header.rect_size);
+    BLI_strncpy(header.rect_colorspace,
+                IMB_colormanagement_get_rect_colorspace(ibuf),
+                sizeof(header.rect_colorspace));
+  }
+
+  if (ibuf->rect_float) {
+    header.flag |= IB_rectfloat;
+    rect_float = seq_disk_cache_compress(ibuf->rect_float,
+                                         num_pixels * ibuf->channels * sizeof(float),
+                                         compression,
+                                         &header.rect_float_size);
+    BLI_strncpy(header.float_colorspace,
+                IMB_colormanagement_get_float_colorspace(ibuf),
+                sizeof(header.float_colorspace));
+  }
+
+  /* Write to a temporary file unique to this session, so other sessions never read partial
+   * files. Only the writer thread writes files, the counter needs no lock. */
+  static unsigned int tmp_index = 0;
+  BLI_snprintf(filepath_tmp,
+               sizeof(filepath_tmp),
+               "%s.%d.%u" SEQ_DISK_CACHE_TMP_EXT,
+               filepath,
+               abs(getpid()),
+               tmp_index++);
+
+  FILE *file = BLI_fopen(filepath_tmp, "wb");
+  bool ok = false;
+
+  if (file) {
+    ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+         (rect == NULL || fwrite(rect, header.rect_size, 1, file) == 1) &&
+         (rect_float == NULL || fwrite(rect_float, header.rect_float_size, 1, file) == 1);
+    ok = (fclose(file) == 0) && ok;
+
+    if (ok && BLI_rename(filepath_tmp, filepath) == 0) {
+      seq_disk_cache_add_size(dir, sizeof(header) + header.rect_size + header.rect_float_size);
+    }
+    else {
+      BLI_delete(filepath_tmp, false, false);
+    }
+  }
+
+  if (rect && rect != (void *)ibuf->rect) {
+    MEM_freeN(rect);
+  }
+  if (rect_float && rect_float != (void *)ibuf->rect_float) {
+    MEM_freeN(rect_float);
+  }
+}
+
+/* Mark as recently used. Unlike BLI_file_touch this doesn't create the file again when another
+ * session removed it meanwhile. */
+static void seq_disk_cache_touch(const char *filepath)
+{
+  FILE *file = BLI_fopen(filepath, "r+b");
+
+  if (file) {
+    const int c = getc(file);
+
+    if (c != EOF) {
+      rewind(file);
+      putc(c, file);
+    }
+    fclose(file);
+  }
+}
+
+static ImBuf *seq_disk_cache_read(uint64_t key)
+{
+  char filepath[FILE_MAX];
+  SeqDiskCacheHeader header;
+  ImBuf *ibuf = NULL;
+
+  seq_disk_cache_get_filepath(key, filepath, sizeof(filepath));
+
+  FILE *file = BLI_fopen(filepath, "rb");
+
+  if (file == NULL) {
+    return NULL;
+  }
+
+  bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+            memcmp(header.magic, SEQ_DISK_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+            header.version == SEQ_DISK_CACHE_VERSION && header.key == key && header.x > 0 &&
+            header.y > 0 && header.channels > 0 && header.channels <= 4;
+
+  if (ok) {
+    const size_t num_pixels = (size_t)header.x * header.y;
+
+    ibuf = IMB_allocImBuf(header.x, header.y, header.planes, 0);
+
+    if (header.flag & IB_rect) {
+      ok = imb_addrectImBuf(ibuf) &&
+           seq_disk_cache_read_buffer(file,
+                                      ibuf->rect,
+                                      num_pixels * sizeof(unsigned int),
+                                      header.rect_size,
+                                      header.compression);
+      header.rect_colorspace[sizeof(header.rect_colorspace) - 1] = '\0';
+      IMB_colormanagement_assign_rect_colorspace(ibuf, header.rect_colorspace);
+    }
+
+    if (ok && (header.flag & IB_rectfloat)) {
+      /* Buffer is allocated with 4 channels, enough for any number of channels. */
+      ok = imb_addrectfloatImBuf(ibuf);
+      ibuf->channels = header.channels;
+      ok = ok && seq_disk_cache_read_buffer(file,
+                                            ibuf->rect_float,
+                                            num_pixels * header.channels * sizeof(float),
+                                            header.rect_float_size,
+                                            header.compression);
+      header.float_colorspace[sizeof(header.float_colorspace) - 1] = '\0';
+      IMB_colormanagement_assign_float_colorspace(ibuf, header.float_colorspace);
+    }
+  }
+
+  fclose(file);
+
+  if (!ok) {
+    /* Corrupt or outdated file. */
+    if (ibuf) {
+      IMB_freeImBuf(ibuf);
+    }
+    BLI_delete(filepath, false, false);
+    return NULL;
+  }
+
+  seq_disk_cache_touch(filepath);
+
+  return ibuf;
+}
+
+static void seq_disk_cache_miss_add(
+    const SeqRenderData *context, Sequence *seq, float cfra, int type, uint64_t key)
+{
+  Scene *scene = BKE_sequencer_prefetch_get_original_scene(context);
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+
+  if (cache == NULL) {
+    return;
+  }
+
+  seq_cache_lock(scene);
+  SeqDiskCacheMiss *misses = cache->disk_miss[context->task_id];
+  memmove(misses + 1, misses, sizeof(*misses) * (SEQ_DISK_CACHE_MISS_MAX - 1));
+  misses[0].seq = seq;
+  misses[0].cfra = cfra;
+  misses[0].type = type;
+  misses[0].key = key;
+  seq_cache_unlock(scene);
+}
+
+/* Key of an image which was looked up on disk before it was rendered, so strip properties
+ * don't need to be hashed again. */
+static bool seq_disk_cache_miss_pop(
+    const SeqRenderData *context, Sequence *seq, float cfra, int type, uint64_t *r_key)
+{
+  Scene *scene = BKE_sequencer_prefetch_get_original_scene(context);
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  bool found = false;
+
+  if (cache == NULL) {
+    return false;
+  }
+
+  seq_cache_lock(scene);
+  SeqDiskCacheMiss *misses = cache->disk_miss[context->task_id];
+  for (int i = 0; i < SEQ_DISK_CACHE_MISS_MAX; i++) {
+    if (misses[i].seq == seq && misses[i].cfra == cfra && misses[i].type == type) {
+      *r_key = misses[i].key;
+      misses[i].seq = NULL;
+      found = true;
+      break;
+    }
+  }
+  seq_cache_unlock(scene);
+
+  return found;
+}
+
+static void *seq_disk_cache_write_thread_func(void *data)
+{
+  ThreadQueue *queue = data;
+  SeqDiskCacheWrite *write;
+
+  /* Returns NULL once the queue is empty and BKE_sequencer_cache_disk_exit was called. */
+  while ((write = BLI_thread_queue_pop(queue))) {
+    seq_disk_cache_write(write->key, write->ibuf);
+    IMB_freeImBuf(write->ibuf);
+    MEM_freeN(write);
+  }
+
+  return NULL;
+}
+
+static ImBuf *seq_disk_cache_get(const SeqRenderData *context,
+                                 Sequence *seq,
+                                 float cfra,
+                                 int type)
+{
+  if (!seq_disk_cache_is_enabled(context)) {
+    return NULL;
+  }
+
+  const uint64_t key = seq_disk_cache_key(context, seq, cfra, type);
+  ImBuf *ibuf = (key != 0) ? seq_disk_cache_read(key) : NULL;
+
+  if (ibuf == NULL) {
+    seq_disk_cache_miss_add(context, seq, cfra, type, key);
+  }
+
+  return ibuf;
+}
+
+static void seq_disk_cache_put(
+    const SeqRenderData *context, Sequence *seq, float cfra, int type, ImBuf *ibuf)
+{
+  char filepath[FILE_MAX];
+  uint64_t key;
+
+  if (ibuf == NULL || !seq_disk_cache_is_enabled(context)) {
+    return;
+  }
+
+  if (!seq_disk_cache_miss_pop(context, seq, cfra, type, &key)) {
+    key = seq_disk_cache_key(context, seq, cfra, type);
+  }
+
+  if (key == 0) {
+    return;
+  }
+
+  /* Written by another thread or session already. */
+  seq_disk_cache_get_filepath(key, filepath, sizeof(filepath));
+  if (BLI_exists(filepath)) {
+    return;
+  }
+
+  BLI_mutex_lock(&seq_disk_cache_lock);
+
+  if (seq_disk_cache_write_queue == NULL) {
+    seq_disk_cache_write_queue = BLI_thread_queue_init();
+    BLI_threadpool_init(&seq_disk_cache_write_thread, seq_disk_cache_write_thread_func, 1);
+    BLI_threadpool_insert(&seq_disk_cache_write_thread, seq_disk_cache_write_queue);
+  }
+
+  /* Rendering is faster than writing, skip images rather than holding on to many of them. */
+  if (BLI_thread_queue_len(seq_disk_cache_write_queue) < SEQ_DISK_CACHE_WRITE_QUEUE_MAX) {
+    SeqDiskCacheWrite *write = MEM_mallocN(sizeof(*write), __func__);
+
+    IMB_refImBuf(ibuf);
+    write->key = key;
+    write->ibuf = ibuf;
+    BLI_thread_queue_push(seq_disk_cache_write_queue, write);
+  }
+
+  BLI_mutex_unlock(&seq_disk_cache_lock);
+}
+
+/* ***************************** API ****************************** */
+
+void BKE_sequencer_cache_free_temp_cache(Scene *scene, short id, int cfra)
+{
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (!cache) {
+    return;
+  }
+
+  seq_cache_lock(scene);
+
+  GHashIterator gh_iter;
+  BLI_ghashIterator_init(&gh_iter, cache->hash);
+  while (!BLI_ghashIterator_done(&gh_iter)) {
+    SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
+    BLI_ghashIterator_step(&gh_iter);
+
+    if (key->is_temp_cache && key->creator_id == id && key->cfra != cfra) {
+      BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
+    }
+  }
+  seq_cache_unlock(scene);
+}
+
+void BKE_sequencer_cache_destruct(Scene *scene)
+{
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (!cache) {
+    return;
+  }
+
+  BKE_sequencer_prefetch_free(scene);
+
+  BLI_ghash_free(cache->hash, seq_cache_keyfree, seq_cache_valfree);
+  BLI_mempool_destroy(cache->keys_pool);
+  BLI_mempool_destroy(cache->items_pool);
+  BLI_mutex_end(&cache->iterator_mutex);
+  MEM_freeN(cache);
+  scene->ed->cache = NULL;
+}
+
+void BKE_sequencer_cache_cleanup_all(Main *bmain)
+{
+  for (Scene *scene = bmain->scenes.first; scene != NULL; scene = scene->id.next) {
+    BKE_sequencer_cache_cleanup(scene);
+  }
+}
+void BKE_sequencer_cache_cleanup(Scene *scene)
+{
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (!cache) {
+    return;
+  }
+
+  /* Prefetch threads render from a copy of the data which is now outdated. */
+  BKE_sequencer_prefetch_stop(scene);
+
+  seq_cache_lock(scene);
+
+  GHashIterator gh_iter;
+  BLI_ghashIterator_init(&gh_iter, cache->hash);
+  while (!BLI_ghashIterator_done(&gh_iter)) {
+    SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
+
+    BLI_ghashIterator_step(&gh_iter);
+    BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
+  }
+  memset(cache->last_key, 0, sizeof(cache->last_key));
+  memset(cache->disk_miss, 0, sizeof(cache->disk_miss));
+  seq_cache_unlock(scene);
+}
+
+void BKE_sequencer_cache_cleanup_sequence(Scene *scene, Sequence *seq)
+{
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (!cache) {
+    return;
+  }
+
+  BKE_sequencer_prefetch_stop(scene);
+
+  seq_cache_lock(scene);
+
+  GHashIterator gh_iter;
+  BLI_ghashIterator_init(&gh_iter, cache->hash);
+  while (!BLI_ghashIterator_done(&gh_iter)) {
+    SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
+    BLI_ghashIterator_step(&gh_iter);
+
+    if (key->seq == seq) {
+      /* Relink keys, so we don't end up with orphaned keys */
+      if (key->link_next || key->link_prev) {
+        seq_cache_relink_keys(key->link_next, key->link_prev);
+      }
+
+      BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
+    }
+  }
+  memset(cache->last_key, 0, sizeof(cache->last_key));
+  memset(cache->disk_miss, 0, sizeof(cache->disk_miss));
+  seq_cache_unlock(scene);
+}
+
+struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context,
+                                      Sequence *seq,
+                                      float cfra,
+                                      int type)
+{
+  Scene *scene = BKE_sequencer_prefetch_get_original_scene(context);
+  Sequence *seq_orig = BKE_sequencer_prefetch_get_original_sequence(context, seq);
+
+  if (!scene->ed->cache) {
+    BKE_sequencer_cache_create(scene);
+  }
+
+  seq_cache_lock(scene);
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  ImBuf *ibuf = NULL;
+
+  if (cache && seq_orig) {
+    SeqCacheKey key;
+
+    key.seq = seq_orig;
+    key.context = *context;
+    key.context.scene = scene;
+    key.nfra = cfra - seq_orig->start;
+    key.type = type;
+
+    ibuf = seq_cache_get(cache, &key);
+  }
+  seq_cache_unlock(scene);
+
+  /* Images rendered in earlier sessions, keep them in memory as if rendered now. */
+  if (ibuf == NULL && seq_orig && (seq_cache_get_store_flag(scene, seq_orig) & type)) {
+    ibuf = seq_disk_cache_get(context, seq, cfra, type);
+
+    if (ibuf) {
+      seq_cache_put_memory(context, seq, cfra, type, ibuf, 0.0f);
+    }
+  }
+
+  return ibuf;
+}
+
+bool BKE_sequencer_cache_put_if_possible(
+    const SeqRenderData *context, Sequence *seq, float cfra, int type, ImBuf *ibuf, float cost)
+{
+  /* Image may be incomplete, rendering was interrupted. */
+  if (BKE_sequencer_prefetch_need_stop(context)) {
+    return false;
+  }
+
+  Scene *scene = BKE_sequencer_prefetch_get_original_scene(context);
+  const bool is_prefetch_render = context->task_id != SEQ_TASK_MAIN_RENDER;
+
+  if (seq_cache_recycle_item(scene, is_prefetch_render)) {
+    BKE_sequencer_cache_put(context, seq, cfra, type, ibuf, cost);
+    return true;
+  }
+  else {
+    SeqCache *cache = seq_cache_get_from_scene(scene);
+    Sequence *seq_orig = BKE_sequencer_prefetch_get_original_sequence(context, seq);
+
+    if (cache) {
+      seq_cache_lock(scene);
+      seq_cache_set_temp_cache_linked(scene, cache->last_key[context->task_id]);
+      cache->last_key[context->task_id] = NULL;
+      seq_cache_unlock(scene);
+    }
+
+    /* Memory is full, the disk cache can still keep the image. */
+    if (seq_orig && (seq_cache_get_store_flag(scene, seq_orig) & type)) {
+      seq_disk_cache_put(context, seq, cfra, type, ibuf);
+    }
+    return false;
+  }
+}
+
+void BKE_sequencer_cache_put(
+    const SeqRenderData *context, Sequence *seq, float cfra, int type, ImBuf *i, float cost)
+{
+  /* Image may be incomplete, rendering was interrupted. */
+  if (BKE_sequencer_prefetch_need_stop(context)) {
+    return;
+  }
+
+  if (seq_cache_put_memory(context, seq, cfra, type, i, cost)) {
+    seq_disk_cache_put(context, seq, cfra, type, i);
+  }
+}
+
+void BKE_sequencer_cache_iterate(
+    struct Scene *scene,
+    void *userdata,
+    bool callback(void *userdata, struct Sequence *seq, int cfra, int cache_type, float cost))
+{
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (!cache) {
+    return;
+  }
+
+  seq_cache_lock(scene);
+  GHashIterator gh_iter;
+  BLI_ghashIterator_init(&gh_iter, cache->hash);
+  bool interrupt = false;
+
+  while (!BLI_ghashIterator_done(&gh_iter) && !interrupt) {
+    SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
+    BLI_ghashIterator_step(&gh_iter);
+
+    interrupt = callback(userdata, key->seq, key->cfra, key->type, key->cost);
+  }
+
+  cache->last_key[SEQ_TASK_MAIN_RENDER] = NULL;
+  seq_cache_unlock(scene);
+}
+
+/* Write images which are still queued and stop the writer thread. */
+void BKE_sequencer_cache_disk_exit(void)
+{
+  if (seq_disk_cache_write_queue == NULL) {
+    return;
+  }
+
+  BLI_thread_queue_nowait(seq_disk_cache_write_queue);
+  BLI_threadpool_end(&seq_disk_cache_write_thread);
+  BLI_thread_queue_free(seq_disk_cache_write_queue);
+  seq_disk_cache_write_queue = NULL;
+}
+
+bool BKE_sequencer_cache_is_full(Scene *scene)
+{
+  size_t memory_total = ((size_t)U.memcachelimit) * 1024 * 1024;
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+
+  if (!cache) {
+    return false;
+  }
+
+  return cache->memory_used > memory_total;
 }
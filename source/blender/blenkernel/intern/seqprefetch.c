@@ -0,0 +1,429 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2019 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup bke
+ */
+
+#include <stddef.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_scene_types.h"
+#include "DNA_sequence_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_threads.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include "BKE_global.h"
+#include "BKE_layer.h"
+#include "BKE_main.h"
+#include "BKE_sequencer.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_debug.h"
+#include "DEG_depsgraph_query.h"
+
+/* ***************************** Sequencer prefetch design notes ******************************
+ *
+ * Prefetching renders the frames following the current frame into the sequencer cache, so
+ * playback and scrubbing can show them without waiting for them to render.
+ *
+ * Every scene has at most one prefetch job, which owns a pool of threads. Each thread has its own
+ * dependency graph with an evaluated copy of the scene and its strips. The copy is made when the
+ * job is created on the main thread, after that threads only evaluate animation for their frame,
+ * so they never read data which is being edited in the UI. Images are stored in the cache of the
+ * original scene, see seqcache.c.
+ *
+ * Threads take the next frame which wasn't handed out yet, up to U.prefetchframes frames after the
+ * current frame or until the cache is full. Changing the current frame restarts prefetching from
+ * there. Editing strips invalidates the cache, which stops the threads because their copy of the
+ * data is outdated. Frames being rendered are interrupted between strips and not cached. On the
+ * next redraw the copies are updated, only the scene is copied again, and threads start again.
+ *
+ * Frames with scene or text strips are skipped, these can't be rendered from these threads.
+ */
+
+typedef struct PrefetchThread {
+  struct PrefetchJob *job;
+  /* Cache creator ID of images rendered by this thread */
+  int task_id;
+  struct Depsgraph *depsgraph;
+  Scene *scene_eval;
+} PrefetchThread;
+
+typedef struct PrefetchJob {
+  Main *bmain;
+  Scene *scene;
+  /* Evaluated strips of all threads to their original strip */
+  GHash *seq_orig_map;
+
+  PrefetchThread threads[SEQ_PREFETCH_THREADS_MAX];
+  int num_threads;
+  ListBase threadpool;
+  bool is_running;
+  /* Strips were edited since the evaluated copies were updated. */
+  bool is_outdated;
+
+  /* Members below are protected by the mutex */
+  ThreadMutex mutex;
+  ThreadCondition cond;
+  SeqRenderData context;
+  int chanshown;
+  int cfra;
+  int next_frame;
+  int end_frame;
+  bool is_cache_full;
+  bool stop;
+} PrefetchJob;
+
+static PrefetchJob *seq_prefetch_job_get(Scene *scene)
+{
+  if (scene && scene->ed) {
+    return scene->ed->prefetch_job;
+  }
+
+  return NULL;
+}
+
+static void seq_prefetch_map_sequences(GHash *seq_orig_map,
+                                       ListBase *seqbase_eval,
+                                       ListBase *seqbase_orig)
+{
+  Sequence *seq_eval = seqbase_eval->first;
+  Sequence *seq_orig = seqbase_orig->first;
+
+  for (; seq_eval && seq_orig; seq_eval = seq_eval->next, seq_orig = seq_orig->next) {
+    BLI_ghash_insert(seq_orig_map, seq_eval, seq_orig);
+    seq_prefetch_map_sequences(seq_orig_map, &seq_eval->seqbase, &seq_orig->seqbase);
+  }
+}
+
+/* Scene strips can't be rendered from these threads, text strips use fonts which are not thread
+ * safe: size, wrapping and output buffer are set on the font shared by all renders. */
+static bool seq_prefetch_frame_is_supported(Scene *scene, int cfra)
+{
+  Sequence *seq;
+  bool is_supported = true;
+
+  SEQ_BEGIN (scene->ed, seq) {
+    if (ELEM(seq->type, SEQ_TYPE_SCENE, SEQ_TYPE_TEXT) && seq->startdisp <= cfra &&
+        seq->enddisp > cfra) {
+      is_supported = false;
+    }
+  }
+  SEQ_END;
+
+  return is_supported;
+}
+
+static void seq_prefetch_render_frame(PrefetchThread *thread,
+                                      SeqRenderData *context,
+                                      int cfra,
+                                      int chanshown)
+{
+  PrefetchJob *pfjob = thread->job;
+
+  if (!seq_prefetch_frame_is_supported(thread->scene_eval, cfra)) {
+    return;
+  }
+
+  DEG_evaluate_on_framechange(pfjob->bmain, thread->depsgraph, cfra);
+
+  context->depsgraph = thread->depsgraph;
+  context->scene = thread->scene_eval;
+  context->task_id = thread->task_id;
+
+  /* Frames which are cached already are returned right away. */
+  ImBuf *ibuf = BKE_sequencer_give_ibuf(context, cfra, chanshown);
+
+  if (ibuf) {
+    IMB_freeImBuf(ibuf);
+  }
+}
+
+static void *seq_prefetch_thread(void *data)
+{
+  PrefetchThread *thread = data;
+  PrefetchJob *pfjob = thread->job;
+
+  BLI_mutex_lock(&pfjob->mutex);
+
+  while (!pfjob->stop) {
+    if (pfjob->is_cache_full || pfjob->next_frame > pfjob->end_frame) {
+      BLI_condition_wait(&pfjob->cond, &pfjob->mutex);
+      continue;
+    }
+
+    const int cfra = pfjob->next_frame++;
+    const int chanshown = pfjob->chanshown;
+    SeqRenderData context = pfjob->context;
+
+    BLI_mutex_unlock(&pfjob->mutex);
+
+    seq_prefetch_render_frame(thread, &context, cfra, chanshown);
+    const bool is_cache_full = BKE_sequencer_cache_is_full(pfjob->scene);
+
+    BLI_mutex_lock(&pfjob->mutex);
+
+    /* Wait for the current frame to change, so frames before it can be recycled. */
+    if (is_cache_full) {
+      pfjob->is_cache_full = true;
+    }
+  }
+
+  BLI_mutex_unlock(&pfjob->mutex);
+
+  return NULL;
+}
+
+/* Copy the scene into the dependency graphs of the threads, must be called from the main thread
+ * while the threads are stopped. Only data which changed since the last update is copied. */
+static void seq_prefetch_job_update(PrefetchJob *pfjob)
+{
+  Main *bmain = pfjob->bmain;
+  Scene *scene = pfjob->scene;
+  ViewLayer *view_layer = BKE_view_layer_default_render(scene);
+
+  BLI_ghash_clear(pfjob->seq_orig_map, NULL, NULL);
+
+  for (int i = 0; i < pfjob->num_threads; i++) {
+    PrefetchThread *thread = &pfjob->threads[i];
+
+    /* Edits are only tagged in the dependency graphs of the scene, strips may use other
+     * datablocks now. */
+    DEG_graph_id_tag_update(bmain, thread->depsgraph, &scene->id, ID_RECALC_COPY_ON_WRITE);
+    DEG_graph_tag_relations_update(thread->depsgraph);
+    DEG_graph_relations_update(thread->depsgraph, bmain, scene, view_layer);
+    DEG_evaluate_on_framechange(bmain, thread->depsgraph, scene->r.cfra);
+
+    /* The evaluated scene is copied again, with new strips. */
+    thread->scene_eval = DEG_get_evaluated_scene(thread->depsgraph);
+    thread->scene_eval->ed->prefetch_job = pfjob;
+
+    seq_prefetch_map_sequences(
+        pfjob->seq_orig_map, &thread->scene_eval->ed->seqbase, &scene->ed->seqbase);
+  }
+
+  pfjob->is_outdated = false;
+}
+
+static void seq_prefetch_threads_start(PrefetchJob *pfjob)
+{
+  pfjob->stop = false;
+  pfjob->cfra = MINAFRAME - 1;
+
+  BLI_threadpool_init(&pfjob->threadpool, seq_prefetch_thread, pfjob->num_threads);
+
+  for (int i = 0; i < pfjob->num_threads; i++) {
+    BLI_threadpool_insert(&pfjob->threadpool, &pfjob->threads[i]);
+  }
+
+  pfjob->is_running = true;
+}
+
+/* Frames being rendered are interrupted, see #BKE_sequencer_prefetch_need_stop. */
+static void seq_prefetch_threads_stop(PrefetchJob *pfjob)
+{
+  if (!pfjob->is_running) {
+    return;
+  }
+
+  BLI_mutex_lock(&pfjob->mutex);
+  pfjob->stop = true;
+  BLI_condition_notify_all(&pfjob->cond);
+  BLI_mutex_unlock(&pfjob->mutex);
+
+  BLI_threadpool_end(&pfjob->threadpool);
+
+  pfjob->is_running = false;
+}
+
+static PrefetchJob *seq_prefetch_job_create(const SeqRenderData *context)
+{
+  Scene *scene = context->scene;
+  ViewLayer *view_layer = BKE_view_layer_default_render(scene);
+  PrefetchJob *pfjob = MEM_callocN(sizeof(PrefetchJob), "PrefetchJob");
+
+  pfjob->bmain = context->bmain;
+  pfjob->scene = scene;
+  pfjob->seq_orig_map = BLI_ghash_ptr_new("seq prefetch original strips");
+  pfjob->num_threads = min_iii(
+      BLI_system_thread_count() / 2, U.prefetchframes, SEQ_PREFETCH_THREADS_MAX);
+  pfjob->num_threads = max_ii(pfjob->num_threads, 1);
+
+  BLI_mutex_init(&pfjob->mutex);
+  BLI_condition_init(&pfjob->cond);
+
+  scene->ed->prefetch_job = pfjob;
+
+  /* Task ID 0 is used by the main render. */
+  for (int i = 0; i < pfjob->num_threads; i++) {
+    PrefetchThread *thread = &pfjob->threads[i];
+
+    thread->job = pfjob;
+    thread->task_id = i + 1;
+    thread->depsgraph = DEG_graph_new(scene, view_layer, DAG_EVAL_VIEWPORT);
+    DEG_debug_name_set(thread->depsgraph, "SEQUENCER PREFETCH");
+  }
+
+  /* Evaluate right away, so the scene is copied while it can't be edited. */
+  seq_prefetch_job_update(pfjob);
+
+  return pfjob;
+}
+
+/* ***************************** API ****************************** */
+
+/* Start or continue prefetching the frames after cfra, must be called from the main thread. */
+void BKE_sequencer_prefetch_start(const SeqRenderData *context, float cfra, int chanshown)
+{
+  Scene *scene = context->scene;
+  Editing *ed = scene->ed;
+
+  if (U.prefetchframes <= 0 || G.is_rendering || context->for_render ||
+      context->is_proxy_render || context->task_id != SEQ_TASK_MAIN_RENDER || ed == NULL) {
+    return;
+  }
+
+  /* Evaluated copies don't know which meta strip is opened for editing. */
+  if (!BLI_listbase_is_empty(&ed->metastack)) {
+    BKE_sequencer_prefetch_stop(scene);
+    return;
+  }
+
+  PrefetchJob *pfjob = seq_prefetch_job_get(scene);
+
+  if (pfjob == NULL) {
+    pfjob = seq_prefetch_job_create(context);
+  }
+
+  if (!pfjob->is_running) {
+    if (pfjob->is_outdated) {
+      seq_prefetch_job_update(pfjob);
+    }
+    seq_prefetch_threads_start(pfjob);
+  }
+
+  BLI_mutex_lock(&pfjob->mutex);
+
+  const bool is_restart = (pfjob->cfra != (int)cfra) || (pfjob->chanshown != chanshown) ||
+                          (pfjob->context.rectx != context->rectx) ||
+                          (pfjob->context.recty != context->recty) ||
+                          (pfjob->context.preview_render_size != context->preview_render_size) ||
+                          (pfjob->context.view_id != context->view_id);
+
+  pfjob->context = *context;
+  pfjob->chanshown = chanshown;
+  pfjob->end_frame = min_ii((int)cfra + U.prefetchframes, PEFRA);
+
+  if (is_restart) {
+    pfjob->cfra = (int)cfra;
+    pfjob->next_frame = (int)cfra + 1;
+    pfjob->is_cache_full = false;
+    BLI_condition_notify_all(&pfjob->cond);
+  }
+
+  BLI_mutex_unlock(&pfjob->mutex);
+}
+
+/* Stop prefetching because strips are edited, frames being rendered are interrupted.
+ * The copy of the scene data is kept and updated when prefetching starts again. */
+void BKE_sequencer_prefetch_stop(Scene *scene)
+{
+  PrefetchJob *pfjob = seq_prefetch_job_get(scene);
+
+  /* Evaluated copies of the scene point to the job of the original scene. */
+  if (pfjob == NULL || pfjob->scene != scene) {
+    return;
+  }
+
+  seq_prefetch_threads_stop(pfjob);
+  pfjob->is_outdated = true;
+}
+
+/* Stop prefetching and free its copy of the scene data. */
+void BKE_sequencer_prefetch_free(Scene *scene)
+{
+  PrefetchJob *pfjob = seq_prefetch_job_get(scene);
+
+  /* Evaluated copies of the scene point to the job of the original scene. */
+  if (pfjob == NULL || pfjob->scene != scene) {
+    return;
+  }
+
+  seq_prefetch_threads_stop(pfjob);
+
+  scene->ed->prefetch_job = NULL;
+
+  for (int i = 0; i < pfjob->num_threads; i++) {
+    DEG_graph_free(pfjob->threads[i].depsgraph);
+  }
+
+  BLI_ghash_free(pfjob->seq_orig_map, NULL, NULL);
+  BLI_condition_end(&pfjob->cond);
+  BLI_mutex_end(&pfjob->mutex);
+  MEM_freeN(pfjob);
+}
+
+/* True when the frame being rendered for prefetching is no longer needed, rendering checks this
+ * between strips and the cache doesn't store images rendered after this. */
+bool BKE_sequencer_prefetch_need_stop(const SeqRenderData *context)
+{
+  if (context->task_id == SEQ_TASK_MAIN_RENDER) {
+    return false;
+  }
+
+  PrefetchJob *pfjob = seq_prefetch_job_get(context->scene);
+
+  BLI_mutex_lock(&pfjob->mutex);
+  const bool stop = pfjob->stop;
+  BLI_mutex_unlock(&pfjob->mutex);
+
+  return stop;
+}
+
+/* Scene which owns the cache for images rendered with this context. */
+Scene *BKE_sequencer_prefetch_get_original_scene(const SeqRenderData *context)
+{
+  if (context->task_id != SEQ_TASK_MAIN_RENDER) {
+    return seq_prefetch_job_get(context->scene)->scene;
+  }
+
+  return context->scene;
+}
+
+/* Strip in the original scene, which is used to key cached images. */
+Sequence *BKE_sequencer_prefetch_get_original_sequence(const SeqRenderData *context,
+                                                       Sequence *seq)
+{
+  if (seq && context->task_id != SEQ_TASK_MAIN_RENDER) {
+    return BLI_ghash_lookup(seq_prefetch_job_get(context->scene)->seq_orig_map, seq);
+  }
+
+  return seq;
+}
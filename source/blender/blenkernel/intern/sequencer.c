@@ -77,8 +77,6 @@
 
 #include "RE_pipeline.h"
 
-#include <pthread.h>
-
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
 #include "IMB_colormanagement.h"
@@ -483,6 +481,7 @@ void BKE_sequencer_editing_free(Scene *scene, const bool do_id_user)
     return;
   }
 
+  BKE_sequencer_prefetch_free(scene);
   BKE_sequencer_cache_destruct(scene);
 
   SEQ_BEGIN (ed, seq) {
@@ -634,6 +633,7 @@ void BKE_sequencer_new_render_data(Main *bmain,
   r_context->skip_cache = false;
   r_context->is_proxy_render = false;
   r_context->view_id = 0;
+  r_context->task_id = SEQ_TASK_MAIN_RENDER;
   r_context->gpu_offscreen = NULL;
 }
 
@@ -3990,6 +3990,11 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
     int early_out;
     Sequence *seq = seq_arr[i];
 
+    /* Edits made the frame being prefetched outdated. */
+    if (BKE_sequencer_prefetch_need_stop(context)) {
+      return NULL;
+    }
+
     out = BKE_sequencer_cache_get(context, seq, cfra, SEQ_CACHE_STORE_COMPOSITE);
 
     if (out) {
@@ -4036,6 +4041,11 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
 
   i++;
   for (; i < count; i++) {
+    if (BKE_sequencer_prefetch_need_stop(context)) {
+      IMB_freeImBuf(out);
+      return NULL;
+    }
+
     begin = seq_estimate_render_cost_begin();
     Sequence *seq = seq_arr[i];
 
@@ -4092,7 +4102,8 @@ ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int cha
     out = BKE_sequencer_cache_get(context, seq_arr[count - 1], cfra, SEQ_CACHE_STORE_FINAL_OUT);
   }
 
-  BKE_sequencer_cache_free_temp_cache(context->scene, 0, cfra);
+  BKE_sequencer_cache_free_temp_cache(
+      BKE_sequencer_prefetch_get_original_scene(context), context->task_id, cfra);
 
   clock_t begin = seq_estimate_render_cost_begin();
   float cost = 0;
@@ -4128,146 +4139,6 @@ ImBuf *BKE_sequencer_give_ibuf_direct(const SeqRenderData *context, float cfra,
   return ibuf;
 }
 
-/* *********************** threading api ******************* */
-
-static ListBase running_threads;
-static ListBase prefetch_wait;
-static ListBase prefetch_done;
-
-static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t wakeup_lock = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t wakeup_cond = PTHREAD_COND_INITIALIZER;
-
-// static pthread_mutex_t prefetch_ready_lock = PTHREAD_MUTEX_INITIALIZER;
-// static pthread_cond_t  prefetch_ready_cond = PTHREAD_COND_INITIALIZER;
-
-static pthread_mutex_t frame_done_lock = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t frame_done_cond = PTHREAD_COND_INITIALIZER;
-
-static volatile bool seq_thread_shutdown = true;
-static volatile int seq_last_given_monoton_cfra = 0;
-static int monoton_cfra = 0;
-
-typedef struct PrefetchThread {
-  struct PrefetchThread *next, *prev;
-
-  Scene *scene;
-  struct PrefetchQueueElem *current;
-  pthread_t pthread;
-  int running;
-
-} PrefetchThread;
-
-typedef struct PrefetchQueueElem {
-  struct PrefetchQueueElem *next, *prev;
-
-  int rectx;
-  int recty;
-  float cfra;
-  int chanshown;
-  int preview_render_size;
-
-  int monoton_cfra;
-
-  ImBuf *ibuf;
-} PrefetchQueueElem;
-
-void BKE_sequencer_give_ibuf_prefetch_request(const SeqRenderData *context,
-                                              float cfra,
-                                              int chanshown)
-{
-  PrefetchQueueElem *e;
-  if (seq_thread_shutdown) {
-    return;
-  }
-
-  e = MEM_callocN(sizeof(PrefetchQueueElem), "prefetch_queue_elem");
-  e->rectx = context->rectx;
-  e->recty = context->recty;
-  e->cfra = cfra;
-  e->chanshown = chanshown;
-  e->preview_render_size = context->preview_render_size;
-  e->monoton_cfra = monoton_cfra++;
-
-  pthread_mutex_lock(&queue_lock);
-  BLI_addtail(&prefetch_wait, e);
-  pthread_mutex_unlock(&queue_lock);
-
-  pthread_mutex_lock(&wakeup_lock);
-  pthread_cond_signal(&wakeup_cond);
-  pthread_mutex_unlock(&wakeup_lock);
-}
-
-ImBuf *BKE_sequencer_give_ibuf_threaded(const SeqRenderData *context, float cfra, int chanshown)
-{
-  PrefetchQueueElem *e = NULL;
-  bool found_something = false;
-
-  if (seq_thread_shutdown) {
-    return BKE_sequencer_give_ibuf(context, cfra, chanshown);
-  }
-
-  while (!e) {
-    bool success = false;
-    pthread_mutex_lock(&queue_lock);
-
-    for (e = prefetch_done.first; e; e = e->next) {
-      if (cfra == e->cfra && chanshown == e->chanshown && context->rectx == e->rectx &&
-          context->recty == e->recty && context->preview_render_size == e->preview_render_size) {
-        success = true;
-        found_something = true;
-        break;
-      }
-    }
-
-    if (!e) {
-      for (e = prefetch_wait.first; e; e = e->next) {
-        if (cfra == e->cfra && chanshown == e->chanshown && context->rectx == e->rectx &&
-            context->recty == e->recty && context->preview_render_size == e->preview_render_size) {
-          found_something = true;
-          break;
-        }
-      }
-    }
-
-    if (!e) {
-      PrefetchThread *tslot;
-
-      for (tslot = running_threads.first; tslot; tslot = tslot->next) {
-        if (tslot->current && cfra == tslot->current->cfra &&
-            chanshown == tslot->current->chanshown && context->rectx == tslot->current->rectx &&
-            context->recty == tslot->current->recty &&
-            context->preview_render_size == tslot->current->preview_render_size) {
-          found_something = true;
-          break;
-        }
-      }
-    }
-
-    /* e->ibuf is unrefed by render thread on next round. */
-
-    if (e) {
-      seq_last_given_monoton_cfra = e->monoton_cfra;
-    }
-
-    pthread_mutex_unlock(&queue_lock);
-
-    if (!success) {
-      e = NULL;
-
-      if (!found_something) {
-        fprintf(stderr, "SEQ-THREAD: Requested frame not in queue ???\n");
-        break;
-      }
-      pthread_mutex_lock(&frame_done_lock);
-      pthread_cond_wait(&frame_done_cond, &frame_done_lock);
-      pthread_mutex_unlock(&frame_done_lock);
-    }
-  }
-
-  return e ? e->ibuf : NULL;
-}
-
 /* check whether sequence cur depends on seq */
 bool BKE_sequence_check_depend(Sequence *seq, Sequence *cur)
 {
@@ -0,0 +1,93 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BLI_FLATMAP_H__
+#define __BLI_FLATMAP_H__
+
+/** \file
+ * \ingroup bli
+ *
+ * An open addressing (pointer -> value) hash table.
+ *
+ * Values have a fixed size given on creation and are stored inline next to their key,
+ * so a lookup usually touches a single cache line of metadata and a single slot.
+ * Slots are probed in groups of 16 using one byte of metadata per slot,
+ * compared with SSE2 when available.
+ *
+ * \note Pointers to values are only valid until the next insertion, which may resize the table.
+ * \note Iteration order is unspecified.
+ */
+
+#include "BLI_compiler_attrs.h"
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct FlatMap;
+typedef struct FlatMap FlatMap;
+
+typedef struct FlatMapIterator {
+  const FlatMap *map;
+  uint index;
+} FlatMapIterator;
+
+FlatMap *BLI_flatmap_new_ex(const uint value_size,
+                            const uint nentries_reserve,
+                            const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+FlatMap *BLI_flatmap_new(const uint value_size, const char *info) ATTR_MALLOC
+    ATTR_WARN_UNUSED_RESULT;
+void BLI_flatmap_free(FlatMap *map) ATTR_NONNULL(1);
+void BLI_flatmap_clear_ex(FlatMap *map, const uint nentries_reserve) ATTR_NONNULL(1);
+void BLI_flatmap_clear(FlatMap *map) ATTR_NONNULL(1);
+void BLI_flatmap_reserve(FlatMap *map, const uint nentries_reserve) ATTR_NONNULL(1);
+
+/**
+ * Find or add \a key, \a r_value points to the value storage which is left uninitialized
+ * for newly added keys.
+ *
+ * \return true when the key already existed.
+ */
+bool BLI_flatmap_ensure(FlatMap *map, const void *key, void **r_value) ATTR_NONNULL(1, 3);
+/**
+ * \return A pointer to the value of \a key or NULL when it's not in the map.
+ */
+void *BLI_flatmap_lookup(const FlatMap *map, const void *key) ATTR_WARN_UNUSED_RESULT
+    ATTR_NONNULL(1);
+bool BLI_flatmap_haskey(const FlatMap *map, const void *key) ATTR_WARN_UNUSED_RESULT
+    ATTR_NONNULL(1);
+bool BLI_flatmap_remove(FlatMap *map, const void *key) ATTR_NONNULL(1);
+uint BLI_flatmap_len(const FlatMap *map) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+
+void BLI_flatmapIterator_init(FlatMapIterator *iter, const FlatMap *map) ATTR_NONNULL(1, 2);
+void BLI_flatmapIterator_step(FlatMapIterator *iter) ATTR_NONNULL(1);
+bool BLI_flatmapIterator_done(const FlatMapIterator *iter) ATTR_WARN_UNUSED_RESULT
+    ATTR_NONNULL(1);
+const void *BLI_flatmapIterator_getKey(const FlatMapIterator *iter) ATTR_WARN_UNUSED_RESULT
+    ATTR_NONNULL(1);
+void *BLI_flatmapIterator_getValue(const FlatMapIterator *iter) ATTR_WARN_UNUSED_RESULT
+    ATTR_NONNULL(1);
+
+#define FLATMAP_ITER(iter_, map_) \
+  for (BLI_flatmapIterator_init(&iter_, map_); BLI_flatmapIterator_done(&iter_) == false; \
+       BLI_flatmapIterator_step(&iter_))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLI_FLATMAP_H__ */
@@ -0,0 +1,447 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ *
+ * An (pointer -> value) hash table using open addressing.
+ *
+ * The layout follows the "Swiss table" design: next to the slots array there is an array
+ * of control bytes, one per slot. A control byte is either #CTRL_EMPTY, #CTRL_DELETED
+ * or holds 7 bits of the hash of the key stored in the slot.
+ * Lookups compare a whole group of control bytes at once and only visit slots
+ * whose 7 hash bits match, so mismatching keys are almost never dereferenced.
+ *
+ * \note The API is similar to BLI_ghash.c, but values are stored inline.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_flatmap.h"
+#include "BLI_math_bits.h"
+#include "BLI_strict_flags.h"
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+struct FlatMap {
+  /** Control bytes, #GROUP_SIZE bytes longer than the capacity, see #flatmap_ctrl_set. */
+  uint8_t *ctrl;
+  /** Slots storing the key followed by the value. */
+  char *slots;
+  /** Always a power of two, no less than #GROUP_SIZE. */
+  uint capacity;
+  /** Capacity the buffers were allocated for, may be larger after clearing. */
+  uint capacity_alloc;
+  uint slot_mask;
+  uint slot_size;
+  uint length;
+  /** Number of slots which can still be filled before growing. */
+  uint growth_left;
+};
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Helper Macros & Defines
+ * \{ */
+
+#define GROUP_SIZE 16
+
+#define CTRL_EMPTY 0x80
+#define CTRL_DELETED 0xFE
+
+#define SLOT_KEY(map, index) (*(const void **)((map)->slots + (size_t)(index) * (map)->slot_size))
+#define SLOT_VALUE(map, index) \
+  ((void *)((map)->slots + (size_t)(index) * (map)->slot_size + sizeof(void *)))
+
+/* Maximum load factor of 7/8. */
+#define CAPACITY_TO_GROWTH(capacity) ((capacity) - (capacity) / 8)
+
+#define CAPACITY_DEFAULT 64
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Hashing & Group Matching
+ * \{ */
+
+/* The slot position comes from the address itself (like #BLI_ghashutil_ptrhash),
+ * so pointers allocated close to each other end up in nearby slots, keeping lookups
+ * done in allocation order cache friendly. The 7 control bits are taken from
+ * a mix of all the address bits, so keys in the same group are told apart. */
+BLI_INLINE uint flatmap_hash_h1(const void *key)
+{
+  const uintptr_t y = (uintptr_t)key;
+  return (uint)(y >> 4) ^ (uint)((uint64_t)y >> 36);
+}
+
+BLI_INLINE uint8_t flatmap_hash_h2(const void *key)
+{
+  uint64_t h = (uint64_t)(uintptr_t)key;
+  h *= 0x9e3779b97f4a7c15ULL;
+  return (uint8_t)(h >> 57);
+}
+
+#ifdef __SSE2__
+BLI_INLINE uint group_match(const uint8_t *ctrl, const uint8_t h2)
+{
+  const __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+  return (uint)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)h2)));
+}
+
+BLI_INLINE uint group_match_empty_or_deleted(const uint8_t *ctrl)
+{
+  /* Only #CTRL_EMPTY and #CTRL_DELETED have their sign bit set. */
+  const __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+  return (uint)_mm_movemask_epi8(group);
+}
+#else
+BLI_INLINE uint group_match(const uint8_t *ctrl, const uint8_t h2)
+{
+  uint mask = 0;
+  for (uint i = 0; i < GROUP_SIZE; i++) {
+    if (ctrl[i] == h2) {
+      mask |= 1u << i;
+    }
+  }
+  return mask;
+}
+
+BLI_INLINE uint group_match_empty_or_deleted(const uint8_t *ctrl)
+{
+  uint mask = 0;
+  for (uint i = 0; i < GROUP_SIZE; i++) {
+    if (ctrl[i] & 0x80) {
+      mask |= 1u << i;
+    }
+  }
+  return mask;
+}
+#endif /* __SSE2__ */
+
+BLI_INLINE uint group_match_empty(const uint8_t *ctrl)
+{
+  return group_match(ctrl, CTRL_EMPTY);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Utility API
+ * \{ */
+
+static uint flatmap_capacity_for_reserve(const uint nentries_reserve)
+{
+  uint capacity = GROUP_SIZE;
+  while (CAPACITY_TO_GROWTH(capacity) < nentries_reserve) {
+    capacity *= 2;
+  }
+  return capacity;
+}
+
+/**
+ * The first #GROUP_SIZE control bytes are duplicated after the last one,
+ * so groups starting near the end can be loaded without wrapping around.
+ */
+BLI_INLINE void flatmap_ctrl_set(FlatMap *map, const uint index, const uint8_t ctrl)
+{
+  map->ctrl[index] = ctrl;
+  if (index < GROUP_SIZE) {
+    map->ctrl[index + map->capacity] = ctrl;
+  }
+}
+
+/**
+ * Use \a capacity with all slots empty, when \a alloc is false the existing
+ * buffers must be large enough.
+ */
+static void flatmap_buffers_init(FlatMap *map, const uint capacity, const bool alloc)
+{
+  if (alloc) {
+    map->capacity_alloc = capacity;
+    map->ctrl = MEM_mallocN(capacity + GROUP_SIZE, "FlatMap.ctrl");
+    map->slots = MEM_mallocN((size_t)capacity * map->slot_size, "FlatMap.slots");
+  }
+  BLI_assert(capacity <= map->capacity_alloc);
+  map->capacity = capacity;
+  map->slot_mask = capacity - 1;
+  memset(map->ctrl, CTRL_EMPTY, capacity + GROUP_SIZE);
+  map->length = 0;
+  map->growth_left = CAPACITY_TO_GROWTH(capacity);
+}
+
+static void flatmap_buffers_free(FlatMap *map)
+{
+  MEM_freeN(map->ctrl);
+  MEM_freeN(map->slots);
+}
+
+/**
+ * Probe groups with triangular steps, since the capacity is a power of two
+ * multiple of the group size this visits every group exactly once.
+ */
+#define ITER_GROUPS(MAP, H1, POS) \
+  for (uint POS = (H1) & (MAP)->slot_mask, _step = GROUP_SIZE;; \
+       POS = (POS + _step) & (MAP)->slot_mask, _step += GROUP_SIZE)
+
+#define ITER_MASK_BITS(MASK, BIT) \
+  for (uint BIT; (MASK) && ((BIT = bitscan_forward_uint(MASK)), true); (MASK) &= (MASK)-1)
+
+/**
+ * \param r_free_index: When the key isn't found, the first slot an insertion can use,
+ * found while probing so inserting doesn't need to probe again.
+ */
+BLI_INLINE int flatmap_find_index_ex(const FlatMap *map, const void *key, uint *r_free_index)
+{
+  const uint8_t h2 = flatmap_hash_h2(key);
+  bool has_free_index = false;
+  ITER_GROUPS (map, flatmap_hash_h1(key), pos) {
+    const uint8_t *ctrl = &map->ctrl[pos];
+    uint mask = group_match(ctrl, h2);
+    ITER_MASK_BITS (mask, bit) {
+      const uint index = (pos + bit) & map->slot_mask;
+      if (LIKELY(SLOT_KEY(map, index) == key)) {
+        return (int)index;
+      }
+    }
+    if (r_free_index && !has_free_index) {
+      const uint mask_free = group_match_empty_or_deleted(ctrl);
+      if (mask_free) {
+        *r_free_index = (pos + bitscan_forward_uint(mask_free)) & map->slot_mask;
+        has_free_index = true;
+      }
+    }
+    if (LIKELY(group_match_empty(ctrl))) {
+      return -1;
+    }
+  }
+}
+
+static int flatmap_find_index(const FlatMap *map, const void *key)
+{
+  return flatmap_find_index_ex(map, key, NULL);
+}
+
+static uint flatmap_find_free_index(const FlatMap *map, const void *key)
+{
+  ITER_GROUPS (map, flatmap_hash_h1(key), pos) {
+    const uint mask = group_match_empty_or_deleted(&map->ctrl[pos]);
+    if (mask) {
+      return (pos + bitscan_forward_uint(mask)) & map->slot_mask;
+    }
+  }
+}
+
+/**
+ * Move all entries into new buffers of \a capacity, dropping deleted slots.
+ */
+static void flatmap_resize(FlatMap *map, const uint capacity)
+{
+  FlatMap map_old = *map;
+
+  flatmap_buffers_init(map, capacity, true);
+  for (uint i = 0; i < map_old.capacity; i++) {
+    if ((map_old.ctrl[i] & 0x80) == 0) {
+      const void *key = SLOT_KEY(&map_old, i);
+      const uint index = flatmap_find_free_index(map, key);
+      flatmap_ctrl_set(map, index, flatmap_hash_h2(key));
+      memcpy(map->slots + (size_t)index * map->slot_size,
+             map_old.slots + (size_t)i * map_old.slot_size,
+             map->slot_size);
+    }
+  }
+  map->length = map_old.length;
+  map->growth_left -= map_old.length;
+  flatmap_buffers_free(&map_old);
+}
+
+/**
+ * Called when no empty slots can be used anymore. The capacity is only increased
+ * when the map is more than half full, otherwise there are enough deleted slots
+ * which can be reclaimed.
+ */
+static void flatmap_rehash(FlatMap *map)
+{
+  const bool grow = map->length > CAPACITY_TO_GROWTH(map->capacity) / 2;
+  flatmap_resize(map, grow ? map->capacity * 2 : map->capacity);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Public API
+ * \{ */
+
+/**
+ * \param value_size: Size in bytes of the value stored for every key, may be zero.
+ */
+FlatMap *BLI_flatmap_new_ex(const uint value_size, const uint nentries_reserve, const char *info)
+{
+  FlatMap *map = MEM_mallocN(sizeof(*map), info);
+  /* Keep keys aligned, values are padded to the pointer size. */
+  const uint value_size_aligned = (value_size + (uint)sizeof(void *) - 1) &
+                                  ~((uint)sizeof(void *) - 1);
+  map->slot_size = (uint)sizeof(void *) + value_size_aligned;
+  flatmap_buffers_init(map, flatmap_capacity_for_reserve(nentries_reserve), true);
+  return map;
+}
+
+FlatMap *BLI_flatmap_new(const uint value_size, const char *info)
+{
+  return BLI_flatmap_new_ex(value_size, CAPACITY_TO_GROWTH(CAPACITY_DEFAULT), info);
+}
+
+void BLI_flatmap_free(FlatMap *map)
+{
+  flatmap_buffers_free(map);
+  MEM_freeN(map);
+}
+
+/**
+ * Remove all entries, memory is kept when it's large enough for \a nentries_reserve.
+ *
+ * \note Only the control bytes for the reserved capacity are cleared,
+ * so clearing a map which grew large once stays cheap.
+ */
+void BLI_flatmap_clear_ex(FlatMap *map, const uint nentries_reserve)
+{
+  const uint capacity = flatmap_capacity_for_reserve(nentries_reserve);
+  if (capacity <= map->capacity_alloc) {
+    flatmap_buffers_init(map, capacity, false);
+  }
+  else {
+    flatmap_buffers_free(map);
+    flatmap_buffers_init(map, capacity, true);
+  }
+}
+
+void BLI_flatmap_clear(FlatMap *map)
+{
+  BLI_flatmap_clear_ex(map, CAPACITY_TO_GROWTH(CAPACITY_DEFAULT));
+}
+
+/**
+ * Grow so \a nentries_reserve entries fit without further resizing.
+ */
+void BLI_flatmap_reserve(FlatMap *map, const uint nentries_reserve)
+{
+  if (CAPACITY_TO_GROWTH(map->capacity) < nentries_reserve) {
+    flatmap_resize(map, flatmap_capacity_for_reserve(nentries_reserve));
+  }
+}
+
+bool BLI_flatmap_ensure(FlatMap *map, const void *key, void **r_value)
+{
+  uint index = 0;
+  const int index_found = flatmap_find_index_ex(map, key, &index);
+  if (index_found != -1) {
+    *r_value = SLOT_VALUE(map, index_found);
+    return true;
+  }
+
+  if (UNLIKELY(map->growth_left == 0 && map->ctrl[index] == CTRL_EMPTY)) {
+    flatmap_rehash(map);
+    index = flatmap_find_free_index(map, key);
+  }
+
+  if (map->ctrl[index] == CTRL_EMPTY) {
+    map->growth_left--;
+  }
+  map->length++;
+  flatmap_ctrl_set(map, index, flatmap_hash_h2(key));
+  SLOT_KEY(map, index) = key;
+  *r_value = SLOT_VALUE(map, index);
+  return false;
+}
+
+void *BLI_flatmap_lookup(const FlatMap *map, const void *key)
+{
+  const int index = flatmap_find_index(map, key);
+  return (index != -1) ? SLOT_VALUE(map, index) : NULL;
+}
+
+bool BLI_flatmap_haskey(const FlatMap *map, const void *key)
+{
+  return flatmap_find_index(map, key) != -1;
+}
+
+/**
+ * \return true if \a key was found and removed.
+ */
+bool BLI_flatmap_remove(FlatMap *map, const void *key)
+{
+  const int index = flatmap_find_index(map, key);
+  if (index == -1) {
+    return false;
+  }
+  /* Deleted slots are reused by insertions, but still count towards the load
+   * until the next rehash, since lookups must not stop probing at them. */
+  flatmap_ctrl_set(map, (uint)index, CTRL_DELETED);
+  map->length--;
+  return true;
+}
+
+uint BLI_flatmap_len(const FlatMap *map)
+{
+  return map->length;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Iterator API
+ * \{ */
+
+BLI_INLINE void flatmap_iter_skip_unused(FlatMapIterator *iter)
+{
+  while (iter->index < iter->map->capacity && (iter->map->ctrl[iter->index] & 0x80)) {
+    iter->index++;
+  }
+}
+
+void BLI_flatmapIterator_init(FlatMapIterator *iter, const FlatMap *map)
+{
+  iter->map = map;
+  iter->index = 0;
+  flatmap_iter_skip_unused(iter);
+}
+
+void BLI_flatmapIterator_step(FlatMapIterator *iter)
+{
+  iter->index++;
+  flatmap_iter_skip_unused(iter);
+}
+
+bool BLI_flatmapIterator_done(const FlatMapIterator *iter)
+{
+  return iter->index >= iter->map->capacity;
+}
+
+const void *BLI_flatmapIterator_getKey(const FlatMapIterator *iter)
+{
+  return SLOT_KEY(iter->map, iter->index);
+}
+
+void *BLI_flatmapIterator_getValue(const FlatMapIterator *iter)
+{
+  return SLOT_VALUE(iter->map, iter->index);
+}
+
+/** \} */
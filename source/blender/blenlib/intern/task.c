@@ -155,8 +155,33 @@ typedef struct TaskThreadLocalStorage {
   bool do_delayed_push;
   int num_delayed_queue;
   Task *delayed_queue[DELAYED_QUEUE_SIZE];
+
+  /* State of the random generator used to pick a queue to steal tasks from. */
+  uint32_t steal_seed;
 } TaskThreadLocalStorage;
 
+/* Per-thread queue of tasks which are ready to be executed.
+ *
+ * Every worker thread owns a queue to which it pushes the tasks it spawns,
+ * the queue with index 0 is shared by the main thread and all the threads
+ * which are not managed by the scheduler. A thread pops tasks from the head
+ * of its own queue, and only when it runs out of work it steals tasks from
+ * the tail of other queues, starting from a random victim. This way threads
+ * only contend with each other when work is actually being moved around,
+ * instead of all of them going through a single global lock.
+ *
+ * The queues are guarded by a spin lock rather than being lock-free: a pool
+ * must be able to take its own tasks out of any position of any queue (see
+ * BLI_task_pool_work_and_wait() and BLI_task_pool_cancel()), which classic
+ * lock-free work-stealing deques do not support. The number of tasks is
+ * checked without a lock, so looking into empty queues is cheap.
+ */
+typedef struct TaskQueue {
+  SpinLock lock;
+  ListBase tasks;
+  volatile int num_tasks;
+} TaskQueue;
+
 struct TaskPool {
   TaskScheduler *scheduler;
 
@@ -207,9 +232,17 @@ struct TaskScheduler {
   int num_threads;
   bool background_thread_only;
 
-  ListBase queue;
+  /* Per-thread queues, indexed by the thread ID. */
+  TaskQueue *queues;
+  /* Number of tasks in all the queues which worker threads are allowed
+   * to pick up (see task_is_visible_to_workers()).
+   */
+  int num_queued;
+
+  /* Used to put worker threads to sleep when there is no work for them. */
   ThreadMutex queue_mutex;
   ThreadCondition queue_cond;
+  int num_sleeping;
 
   volatile bool do_exit;
 
@@ -236,9 +269,10 @@ BLI_INLINE void task_data_free(Task *task, const int thread_id)
   }
 }
 
-BLI_INLINE void initialize_task_tls(TaskThreadLocalStorage *tls)
+BLI_INLINE void initialize_task_tls(TaskThreadLocalStorage *tls, const int thread_id)
 {
   memset(tls, 0, sizeof(TaskThreadLocalStorage));
+  tls->steal_seed = (uint32_t)thread_id;
 }
 
 BLI_INLINE TaskThreadLocalStorage *get_task_tls(TaskPool *pool, const int thread_id)
@@ -349,55 +383,137 @@ static void task_pool_num_increase(TaskPool *pool, size_t new)
   BLI_mutex_unlock(&pool->num_mutex);
 }
 
-static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, Task **task)
+/* Tasks of non-background pools are never picked up by the background-only
+ * worker thread, they are handled by BLI_task_pool_work_and_wait().
+ */
+BLI_INLINE bool task_is_visible_to_workers(const TaskScheduler *scheduler, const Task *task)
 {
-  bool found_task = false;
-  BLI_mutex_lock(&scheduler->queue_mutex);
+  return !scheduler->background_thread_only || task->pool->run_in_background;
+}
 
-  while (!scheduler->queue.first && !scheduler->do_exit) {
-    BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+/* Get index of the queue to push tasks to from the given thread.
+ * Thread ID of -1 means the caller did not specify it, in which case the
+ * worker thread is looked up from the TLS.
+ */
+BLI_INLINE int task_scheduler_queue_index(TaskScheduler *scheduler, const int thread_id)
+{
+  if (thread_id == -1) {
+    TaskThread *thread = pthread_getspecific(scheduler->tls_id_key);
+    return (thread != NULL) ? thread->id : 0;
+  }
+  BLI_assert(thread_id <= scheduler->num_threads);
+  return thread_id;
+}
+
+static void task_scheduler_wake_workers(TaskScheduler *scheduler, const bool wake_all)
+{
+  /* NOTE: The task counter was increased before checking this, and the
+   * sleeping thread increases this counter before checking the amount of
+   * queued tasks, so at least one of the sides will notice the other one.
+   */
+  if (atomic_fetch_and_add_int32(&scheduler->num_sleeping, 0) == 0) {
+    return;
+  }
+  BLI_mutex_lock(&scheduler->queue_mutex);
+  if (wake_all) {
+    BLI_condition_notify_all(&scheduler->queue_cond);
+  }
+  else {
+    BLI_condition_notify_one(&scheduler->queue_cond);
   }
+  BLI_mutex_unlock(&scheduler->queue_mutex);
+}
 
-  do {
-    Task *current_task;
+/* Pop task from the given queue.
+ *
+ * If the pool is given, only tasks from this pool are considered, otherwise
+ * any task which worker threads are allowed to run. Owner of the queue takes
+ * tasks from the head, thieves take them from the tail.
+ */
+static Task *task_queue_pop(TaskScheduler *scheduler,
+                            TaskQueue *queue,
+                            TaskPool *pool,
+                            const bool from_tail)
+{
+  Task *task;
 
-    /* Assuming we can only have a void queue in 'exit' case here seems logical
-     * (we should only be here after our worker thread has been woken up from a
-     * condition_wait(), which only happens after a new task was added to the queue),
-     * but it is wrong.
-     * Waiting on condition may wake up the thread even if condition is not signaled
-     * (spurious wake-ups), and some race condition may also empty the queue **after**
-     * condition has been signaled, but **before** awoken thread reaches this point...
-     * See http://stackoverflow.com/questions/8594591
-     *
-     * So we only abort here if do_exit is set.
-     */
-    if (scheduler->do_exit) {
-      BLI_mutex_unlock(&scheduler->queue_mutex);
-      return false;
+  if (queue->num_tasks == 0) {
+    return NULL;
+  }
+
+  BLI_spin_lock(&queue->lock);
+  for (task = from_tail ? queue->tasks.last : queue->tasks.first; task != NULL;
+       task = from_tail ? task->prev : task->next) {
+    if ((pool != NULL) ? (task->pool == pool) : task_is_visible_to_workers(scheduler, task)) {
+      BLI_remlink(&queue->tasks, task);
+      queue->num_tasks--;
+      if (task_is_visible_to_workers(scheduler, task)) {
+        atomic_sub_and_fetch_int32(&scheduler->num_queued, 1);
+      }
+      break;
     }
+  }
+  BLI_spin_unlock(&queue->lock);
 
-    for (current_task = scheduler->queue.first; current_task != NULL;
-         current_task = current_task->next) {
-      TaskPool *pool = current_task->pool;
+  return task;
+}
 
-      if (scheduler->background_thread_only && !pool->run_in_background) {
-        continue;
-      }
+/* Pop task from the thread's own queue, or steal one from other threads. */
+static Task *task_scheduler_pop(TaskScheduler *scheduler,
+                                TaskThreadLocalStorage *tls,
+                                const int thread_id,
+                                TaskPool *pool)
+{
+  const int num_queues = scheduler->num_threads + 1;
+  Task *task = task_queue_pop(scheduler, &scheduler->queues[thread_id], pool, false);
+  if (task != NULL) {
+    return task;
+  }
 
-      *task = current_task;
-      found_task = true;
-      BLI_remlink(&scheduler->queue, *task);
-      break;
+  /* Start from a random victim, so idle threads do not all hammer the same
+   * queue. Simple LCG is good enough for this.
+   */
+  tls->steal_seed = tls->steal_seed * 1103515245u + 12345u;
+  const int victim_start = (int)((tls->steal_seed >> 16) % (uint32_t)num_queues);
+  for (int i = 0; i < num_queues; i++) {
+    const int victim = (victim_start + i) % num_queues;
+    if (victim == thread_id) {
+      continue;
     }
-    if (!found_task) {
-      BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+    task = task_queue_pop(scheduler, &scheduler->queues[victim], pool, true);
+    if (task != NULL) {
+      return task;
     }
-  } while (!found_task);
+  }
 
-  BLI_mutex_unlock(&scheduler->queue_mutex);
+  return NULL;
+}
 
-  return true;
+static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler,
+                                           TaskThread *thread,
+                                           Task **task)
+{
+  while (!scheduler->do_exit) {
+    *task = task_scheduler_pop(scheduler, &thread->tls, thread->id, NULL);
+    if (*task != NULL) {
+      return true;
+    }
+
+    BLI_mutex_lock(&scheduler->queue_mutex);
+    atomic_add_and_fetch_int32(&scheduler->num_sleeping, 1);
+    /* Waiting on condition may wake up the thread even if condition is not
+     * signaled (spurious wake-ups), and other threads might have taken the
+     * task we were woken up for, so it's fine to find no task after this
+     * and come back here.
+     */
+    while (atomic_fetch_and_add_int32(&scheduler->num_queued, 0) == 0 && !scheduler->do_exit) {
+      BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+    }
+    atomic_sub_and_fetch_int32(&scheduler->num_sleeping, 1);
+    BLI_mutex_unlock(&scheduler->queue_mutex);
+  }
+
+  return false;
 }
 
 BLI_INLINE void handle_local_queue(TaskThreadLocalStorage *tls, const int thread_id)
@@ -430,7 +546,7 @@ static void *task_scheduler_thread_run(void *thread_p)
   pthread_setspecific(scheduler->tls_id_key, thread);
 
   /* keep popping off tasks */
-  while (task_scheduler_thread_wait_pop(scheduler, &task)) {
+  while (task_scheduler_thread_wait_pop(scheduler, thread, &task)) {
     TaskPool *pool = task->pool;
 
     /* run task */
@@ -459,7 +575,6 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
    * threads, so we keep track of the number of users. */
   scheduler->do_exit = false;
 
-  BLI_listbase_clear(&scheduler->queue);
   BLI_mutex_init(&scheduler->queue_mutex);
   BLI_condition_init(&scheduler->queue_cond);
 
@@ -480,8 +595,14 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
   scheduler->task_threads = MEM_mallocN(sizeof(TaskThread) * (num_threads + 1),
                                         "TaskScheduler task threads");
 
+  scheduler->queues = MEM_callocN(sizeof(TaskQueue) * (num_threads + 1),
+                                  "TaskScheduler task queues");
+  for (int i = 0; i < num_threads + 1; i++) {
+    BLI_spin_init(&scheduler->queues[i].lock);
+  }
+
   /* Initialize TLS for main thread. */
-  initialize_task_tls(&scheduler->task_threads[0].tls);
+  initialize_task_tls(&scheduler->task_threads[0].tls, 0);
 
   pthread_key_create(&scheduler->tls_id_key, NULL);
 
@@ -496,7 +617,7 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
       TaskThread *thread = &scheduler->task_threads[i + 1];
       thread->scheduler = scheduler;
       thread->id = i + 1;
-      initialize_task_tls(&thread->tls);
+      initialize_task_tls(&thread->tls, thread->id);
 
       if (pthread_create(&scheduler->threads[i], NULL, task_scheduler_thread_run, thread) != 0) {
         fprintf(stderr, "TaskScheduler failed to launch thread %d/%d\n", i, num_threads);
@@ -543,10 +664,15 @@ void BLI_task_scheduler_free(TaskScheduler *scheduler)
   }
 
   /* delete leftover tasks */
-  for (task = scheduler->queue.first; task; task = task->next) {
-    task_data_free(task, 0);
+  for (int i = 0; i < scheduler->num_threads + 1; i++) {
+    TaskQueue *queue = &scheduler->queues[i];
+    for (task = queue->tasks.first; task; task = task->next) {
+      task_data_free(task, 0);
+    }
+    BLI_freelistN(&queue->tasks);
+    BLI_spin_end(&queue->lock);
   }
-  BLI_freelistN(&scheduler->queue);
+  MEM_freeN(scheduler->queues);
 
   /* delete mutex/condition */
   BLI_mutex_end(&scheduler->queue_mutex);
@@ -560,43 +686,76 @@ int BLI_task_scheduler_num_threads(TaskScheduler *scheduler)
   return scheduler->num_threads + 1;
 }
 
-static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriority priority)
+static void task_scheduler_push(TaskScheduler *scheduler,
+                                Task *task,
+                                TaskPriority priority,
+                                const int thread_id)
 {
+  TaskQueue *queue = &scheduler->queues[task_scheduler_queue_index(scheduler, thread_id)];
+  const bool is_visible = task_is_visible_to_workers(scheduler, task);
+
   task_pool_num_increase(task->pool, 1);
 
   /* add task to queue */
-  BLI_mutex_lock(&scheduler->queue_mutex);
+  BLI_spin_lock(&queue->lock);
 
   if (priority == TASK_PRIORITY_HIGH) {
-    BLI_addhead(&scheduler->queue, task);
+    BLI_addhead(&queue->tasks, task);
   }
   else {
-    BLI_addtail(&scheduler->queue, task);
+    BLI_addtail(&queue->tasks, task);
+  }
+  queue->num_tasks++;
+  if (is_visible) {
+    atomic_add_and_fetch_int32(&scheduler->num_queued, 1);
   }
 
-  BLI_condition_notify_one(&scheduler->queue_cond);
-  BLI_mutex_unlock(&scheduler->queue_mutex);
+  BLI_spin_unlock(&queue->lock);
+
+  if (is_visible) {
+    task_scheduler_wake_workers(scheduler, false);
+  }
 }
 
+/* Push tasks of the given pool to the queue of the given thread.
+ * Tasks are either given as an array, or as a list.
+ */
 static void task_scheduler_push_all(TaskScheduler *scheduler,
                                     TaskPool *pool,
                                     Task **tasks,
-                                    int num_tasks)
+                                    ListBase *tasks_list,
+                                    int num_tasks,
+                                    const int thread_id)
 {
   if (num_tasks == 0) {
     return;
   }
 
+  TaskQueue *queue = &scheduler->queues[task_scheduler_queue_index(scheduler, thread_id)];
+  const bool is_visible = !scheduler->background_thread_only || pool->run_in_background;
+
   task_pool_num_increase(pool, num_tasks);
 
-  BLI_mutex_lock(&scheduler->queue_mutex);
+  BLI_spin_lock(&queue->lock);
 
-  for (int i = 0; i < num_tasks; i++) {
-    BLI_addhead(&scheduler->queue, tasks[i]);
+  if (tasks_list != NULL) {
+    BLI_movelisttolist(&queue->tasks, tasks_list);
+  }
+  else {
+    for (int i = 0; i < num_tasks; i++) {
+      BLI_addhead(&queue->tasks, tasks[i]);
+    }
+  }
+  queue->num_tasks += num_tasks;
+  if (is_visible) {
+    atomic_add_and_fetch_int32(&scheduler->num_queued, num_tasks);
   }
 
-  BLI_condition_notify_all(&scheduler->queue_cond);
-  BLI_mutex_unlock(&scheduler->queue_mutex);
+  BLI_spin_unlock(&queue->lock);
+
+  if (is_visible) {
+    task_scheduler_wake_workers(scheduler, true);
+  }
 }
 
 static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
@@ -604,21 +763,33 @@ static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
   Task *task, *nexttask;
   size_t done = 0;
 
-  BLI_mutex_lock(&scheduler->queue_mutex);
+  /* free all tasks from this pool from the queues */
+  for (int i = 0; i < scheduler->num_threads + 1; i++) {
+    TaskQueue *queue = &scheduler->queues[i];
 
-  /* free all tasks from this pool from the queue */
-  for (task = scheduler->queue.first; task; task = nexttask) {
-    nexttask = task->next;
+    if (queue->num_tasks == 0) {
+      continue;
+    }
+
+    BLI_spin_lock(&queue->lock);
 
-    if (task->pool == pool) {
-      task_data_free(task, pool->thread_id);
-      BLI_freelinkN(&scheduler->queue, task);
+    for (task = queue->tasks.first; task; task = nexttask) {
+      nexttask = task->next;
 
-      done++;
+      if (task->pool == pool) {
+        if (task_is_visible_to_workers(scheduler, task)) {
+          atomic_sub_and_fetch_int32(&scheduler->num_queued, 1);
+        }
+        task_data_free(task, pool->thread_id);
+        BLI_freelinkN(&queue->tasks, task);
+        queue->num_tasks--;
+
+        done++;
+      }
     }
-  }
 
-  BLI_mutex_unlock(&scheduler->queue_mutex);
+    BLI_spin_unlock(&queue->lock);
+  }
 
   /* notify done */
   task_pool_num_decrease(pool, done);
@@ -679,7 +850,7 @@ static TaskPool *task_pool_create_ex(TaskScheduler *scheduler,
 #ifndef NDEBUG
       pool->creator_thread_id = pthread_self();
 #endif
-      initialize_task_tls(&pool->local_tls);
+      initialize_task_tls(&pool->local_tls, 0);
     }
     else {
       pool->thread_id = thread->id;
@@ -822,10 +993,10 @@ static void task_pool_push(TaskPool *pool,
       return;
     }
   }
-  /* Do push to a global execution pool, slowest possible method,
-   * causes quite reasonable amount of threading overhead.
+  /* Do push to the thread's execution queue, from where it will be either
+   * picked up by the thread itself or stolen by any other idle thread.
    */
-  task_scheduler_push(pool->scheduler, task, priority);
+  task_scheduler_push(pool->scheduler, task, priority, thread_id);
 }
 
 void BLI_task_pool_push_ex(TaskPool *pool,
@@ -861,14 +1032,12 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 
   if (atomic_fetch_and_and_uint8((uint8_t *)&pool->is_suspended, 0)) {
     if (pool->num_suspended) {
-      task_pool_num_increase(pool, pool->num_suspended);
-      BLI_mutex_lock(&scheduler->queue_mutex);
-
-      BLI_movelisttolist(&scheduler->queue, &pool->suspended_queue);
-
-      BLI_condition_notify_all(&scheduler->queue_cond);
-      BLI_mutex_unlock(&scheduler->queue_mutex);
-
+      task_scheduler_push_all(scheduler,
+                              pool,
+                              NULL,
+                              &pool->suspended_queue,
+                              (int)pool->num_suspended,
+                              pool->thread_id);
       pool->num_suspended = 0;
     }
   }
@@ -882,36 +1051,23 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
   BLI_mutex_lock(&pool->num_mutex);
 
   while (pool->num != 0) {
-    Task *task, *work_task = NULL;
-    bool found_task = false;
+    Task *work_task;
 
     BLI_mutex_unlock(&pool->num_mutex);
 
-    BLI_mutex_lock(&scheduler->queue_mutex);
-
     /* find task from this pool. if we get a task from another pool,
      * we can get into deadlock */
-
-    for (task = scheduler->queue.first; task; task = task->next) {
-      if (task->pool == pool) {
-        work_task = task;
-        found_task = true;
-        BLI_remlink(&scheduler->queue, task);
-        break;
-      }
-    }
-
-    BLI_mutex_unlock(&scheduler->queue_mutex);
+    work_task = task_scheduler_pop(scheduler, tls, pool->thread_id, pool);
 
     /* if found task, do it, otherwise wait until other tasks are done */
-    if (found_task) {
+    if (work_task != NULL) {
       /* run task */
       BLI_assert(!tls->do_delayed_push);
       work_task->run(pool, work_task->taskdata, pool->thread_id);
       BLI_assert(!tls->do_delayed_push);
 
       /* delete task */
-      task_free(pool, task, pool->thread_id);
+      task_free(pool, work_task, pool->thread_id);
 
       /* Handle all tasks from local queue. */
       handle_local_queue(tls, pool->thread_id);
@@ -925,7 +1081,7 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
       break;
     }
 
-    if (!found_task) {
+    if (work_task == NULL) {
       BLI_condition_wait(&pool->num_cond, &pool->num_mutex);
     }
   }
@@ -989,7 +1145,8 @@ void BLI_task_pool_delayed_push_end(TaskPool *pool, int thread_id)
     ASSERT_THREAD_ID(pool->scheduler, thread_id);
     TaskThreadLocalStorage *tls = get_task_tls(pool, thread_id);
     BLI_assert(tls->do_delayed_push);
-    task_scheduler_push_all(pool->scheduler, pool, tls->delayed_queue, tls->num_delayed_queue);
+    task_scheduler_push_all(
+        pool->scheduler, pool, tls->delayed_queue, NULL, tls->num_delayed_queue, thread_id);
     tls->do_delayed_push = false;
     tls->num_delayed_queue = 0;
   }
@@ -73,4 +73,23 @@ enum {
 
 #define BLEN_THUMB_MEMSIZE_FILE(_x, _y) (sizeof(int) * (2 + (size_t)(_x) * (size_t)(_y)))
 
+/**
+ * Compressed files are written as a sequence of independent gzip members ("frames"),
+ * so they can be compressed (and decompressed) in parallel, any gzip reader reads them
+ * back as a single stream.
+ *
+ * The header of every frame has an extra field with a sub-field identified by
+ * #BLEN_GZIP_FRAME_SI1 and #BLEN_GZIP_FRAME_SI2, which stores the size of the whole
+ * gzip member followed by the uncompressed size of its data (both 32bit little endian).
+ * This way frames can be located without decompressing them.
+ */
+#define BLEN_GZIP_FRAME_SI1 'B'
+#define BLEN_GZIP_FRAME_SI2 'L'
+/** Size of the gzip header of a frame, including the extra field. */
+#define BLEN_GZIP_FRAME_HEADER_SIZE 24
+/** Size of the gzip trailer of a frame (CRC32 and uncompressed size). */
+#define BLEN_GZIP_FRAME_TRAILER_SIZE 8
+/** Uncompressed size of all frames but the last one. */
+#define BLEN_GZIP_FRAME_SIZE (1 << 20)
+
 #endif /* __BLO_BLEND_DEFS_H__ */
@@ -25,15 +25,25 @@
  * \ingroup blenloader
  */
 
+struct GSet;
+struct Main;
 struct Scene;
 
-typedef struct {
+typedef struct MemFileChunk {
   void *next, *prev;
+  /** Reference counted, shared between all chunks of all steps with the same contents. */
   const char *buf;
   /** Size in bytes. */
   unsigned int size;
-  /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
+  /** Hash of the contents, to find identical chunks when writing undo steps. */
+  unsigned int hash;
+  /** When true, the memory is shared with a chunk of an earlier #MemFile. */
   bool is_identical;
+  /**
+   * Address of the data-block this chunk belongs to (its old address when reading),
+   * NULL for data written outside of data-blocks. Each data-block starts a new chunk.
+   */
+  const void *id;
 } MemFileChunk;
 
 typedef struct MemFile {
@@ -47,11 +57,24 @@ typedef struct MemFileUndoData {
   size_t undo_size;
 } MemFileUndoData;
 
+/** State used while writing a #MemFile. */
+typedef struct MemFileWriteData {
+  MemFile *written_memfile;
+  /** The previous undo step (may be NULL), chunks are compared with it first. */
+  MemFile *reference_memfile;
+  /** The chunk expected to be written next, following the reference memfile. */
+  MemFileChunk *reference_current_chunk;
+  /** The data-block being written, see #MemFileChunk.id. */
+  const void *current_id;
+} MemFileWriteData;
+
 /* actually only used writefile.c */
-extern void memfile_chunk_add(MemFile *memfile,
-                              const char *buf,
-                              unsigned int size,
-                              MemFileChunk **compchunk_step);
+extern void BLO_memfile_write_init(MemFileWriteData *mem_data,
+                                   MemFile *written_memfile,
+                                   MemFile *reference_memfile);
+extern void BLO_memfile_chunk_add(MemFileWriteData *mem_data,
+                                  const char *buf,
+                                  unsigned int size);
 
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
@@ -62,5 +85,6 @@ extern struct Main *BLO_memfile_main_get(struct MemFile *memfile,
                                          struct Main *bmain,
                                          struct Scene **r_scene);
 extern bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename);
+extern struct GSet *BLO_memfile_identical_ids_get(struct MemFile *memfile, struct Main *bmain);
 
 #endif /* __BLO_UNDOFILE_H__ */
@@ -376,6 +376,11 @@ BlendFileData *BLO_read_from_memfile(Main *oldmain,
     fd->skip_flags = skip_flags;
     BLI_strncpy(fd->relabase, filename, sizeof(fd->relabase));
 
+    /* find data-blocks which can be kept as is, before anything in old main changes */
+    if ((skip_flags & BLO_READ_SKIP_DATA) == 0) {
+      fd->memfile_identical_ids = BLO_memfile_identical_ids_get(memfile, oldmain);
+    }
+
     /* clear ob->proxy_from pointers in old main */
     blo_clear_proxy_pointers_from_lib(oldmain);
 
@@ -104,7 +104,10 @@
 #include "BLI_math.h"
 #include "BLI_threads.h"
 #include "BLI_mempool.h"
+#include "BLI_mmap.h"
+#include "BLI_flatmap.h"
 #include "BLI_ghash.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -221,8 +224,9 @@
  * Delay reading blocks we might not use (especially applies to library linking).
  * which keeps large arrays in memory from data-blocks we may not even use.
  *
- * \note This is disabled when using compression,
+ * \note This is disabled when using regular gzip compression,
  * while zlib supports seek ist's unusably slow, see: T61880.
+ * Files which are compressed in frames support seeking, see: #GzipFrames.
  */
 #define USE_BHEAD_READ_ON_DEMAND
 
@@ -307,96 +311,20 @@ static const char *library_parent_filepath(Library *lib)
 /** \name OldNewMap API
  * \{ */
 
+/* Value stored for every old pointer (the key of the map). */
 typedef struct OldNew {
-  const void *oldp;
   void *newp;
   /* `nr` is "user count" for data, and ID code for libdata. */
   int nr;
 } OldNew;
 
 typedef struct OldNewMap {
-  /* Array that stores the actual entries. */
-  OldNew *entries;
-  int nentries;
-  /* Hashmap that stores indices into the `entries` array. */
-  int32_t *map;
-
-  int capacity_exp;
+  /* Maps old pointers to #OldNew values. */
+  FlatMap *map;
 } OldNewMap;
 
-#define ENTRIES_CAPACITY(onm) (1 << (onm)->capacity_exp)
-#define MAP_CAPACITY(onm) (1 << ((onm)->capacity_exp + 1))
-#define SLOT_MASK(onm) (MAP_CAPACITY(onm) - 1)
-#define DEFAULT_SIZE_EXP 6
-#define PERTURB_SHIFT 5
-
-/* based on the probing algorithm used in Python dicts. */
-#define ITER_SLOTS(onm, KEY, SLOT_NAME, INDEX_NAME) \
-  uint32_t hash = BLI_ghashutil_ptrhash(KEY); \
-  uint32_t mask = SLOT_MASK(onm); \
-  uint perturb = hash; \
-  int SLOT_NAME = mask & hash; \
-  int INDEX_NAME = onm->map[SLOT_NAME]; \
-  for (;; SLOT_NAME = mask & ((5 * SLOT_NAME) + 1 + perturb), \
-          perturb >>= PERTURB_SHIFT, \
-          INDEX_NAME = onm->map[SLOT_NAME])
-
-static void oldnewmap_insert_index_in_map(OldNewMap *onm, const void *ptr, int index)
-{
-  ITER_SLOTS (onm, ptr, slot, stored_index) {
-    if (stored_index == -1) {
-      onm->map[slot] = index;
-      break;
-    }
-  }
-}
-
-static void oldnewmap_insert_or_replace(OldNewMap *onm, OldNew entry)
-{
-  ITER_SLOTS (onm, entry.oldp, slot, index) {
-    if (index == -1) {
-      onm->entries[onm->nentries] = entry;
-      onm->map[slot] = onm->nentries;
-      onm->nentries++;
-      break;
-    }
-    else if (onm->entries[index].oldp == entry.oldp) {
-      onm->entries[index] = entry;
-      break;
-    }
-  }
-}
-
-static OldNew *oldnewmap_lookup_entry(const OldNewMap *onm, const void *addr)
-{
-  ITER_SLOTS (onm, addr, slot, index) {
-    if (index >= 0) {
-      OldNew *entry = &onm->entries[index];
-      if (entry->oldp == addr) {
-        return entry;
-      }
-    }
-    else {
-      return NULL;
-    }
-  }
-}
-
-static void oldnewmap_clear_map(OldNewMap *onm)
-{
-  memset(onm->map, 0xFF, MAP_CAPACITY(onm) * sizeof(*onm->map));
-}
-
-static void oldnewmap_increase_size(OldNewMap *onm)
-{
-  onm->capacity_exp++;
-  onm->entries = MEM_reallocN(onm->entries, sizeof(*onm->entries) * ENTRIES_CAPACITY(onm));
-  onm->map = MEM_reallocN(onm->map, sizeof(*onm->map) * MAP_CAPACITY(onm));
-  oldnewmap_clear_map(onm);
-  for (int i = 0; i < onm->nentries; i++) {
-    oldnewmap_insert_index_in_map(onm, onm->entries[i].oldp, i);
-  }
-}
+#define OLDNEWMAP_ITER(iter_, onm_) FLATMAP_ITER (iter_, (onm_)->map)
+#define OLDNEWMAP_ITER_VALUE(iter_) ((OldNew *)BLI_flatmapIterator_getValue(&(iter_)))
 
 /* Public OldNewMap API */
 
@@ -404,11 +332,7 @@ static OldNewMap *oldnewmap_new(void)
 {
   OldNewMap *onm = MEM_callocN(sizeof(*onm), "OldNewMap");
 
-  onm->capacity_exp = DEFAULT_SIZE_EXP;
-  onm->entries = MEM_malloc_arrayN(
-      ENTRIES_CAPACITY(onm), sizeof(*onm->entries), "OldNewMap.entries");
-  onm->map = MEM_malloc_arrayN(MAP_CAPACITY(onm), sizeof(*onm->map), "OldNewMap.map");
-  oldnewmap_clear_map(onm);
+  onm->map = BLI_flatmap_new(sizeof(OldNew), "OldNewMap.map");
 
   return onm;
 }
@@ -419,15 +343,11 @@ static void oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr,
     return;
   }
 
-  if (UNLIKELY(onm->nentries == ENTRIES_CAPACITY(onm))) {
-    oldnewmap_increase_size(onm);
-  }
-
-  OldNew entry;
-  entry.oldp = oldaddr;
-  entry.newp = newaddr;
-  entry.nr = nr;
-  oldnewmap_insert_or_replace(onm, entry);
+  OldNew *entry;
+  /* Replaces the value of existing entries. */
+  BLI_flatmap_ensure(onm->map, oldaddr, (void **)&entry);
+  entry->newp = newaddr;
+  entry->nr = nr;
 }
 
 void blo_do_versions_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr, int nr)
@@ -437,7 +357,11 @@ void blo_do_versions_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void
 
 static void *oldnewmap_lookup_and_inc(OldNewMap *onm, const void *addr, bool increase_users)
 {
-  OldNew *entry = oldnewmap_lookup_entry(onm, addr);
+  /* Many pointers are NULL, they are never inserted, skip the lookup. */
+  if (addr == NULL) {
+    return NULL;
+  }
+  OldNew *entry = BLI_flatmap_lookup(onm->map, addr);
   if (entry == NULL) {
     return NULL;
   }
@@ -466,8 +390,9 @@ static void *oldnewmap_liblookup(OldNewMap *onm, const void *addr, const void *l
 
 static void oldnewmap_free_unused(OldNewMap *onm)
 {
-  for (int i = 0; i < onm->nentries; i++) {
-    OldNew *entry = &onm->entries[i];
+  FlatMapIterator iter;
+  OLDNEWMAP_ITER (iter, onm) {
+    OldNew *entry = OLDNEWMAP_ITER_VALUE(iter);
     if (entry->nr == 0) {
       MEM_freeN(entry->newp);
       entry->newp = NULL;
@@ -477,25 +402,15 @@ static void oldnewmap_free_unused(OldNewMap *onm)
 
 static void oldnewmap_clear(OldNewMap *onm)
 {
-  onm->capacity_exp = DEFAULT_SIZE_EXP;
-  oldnewmap_clear_map(onm);
-  onm->nentries = 0;
+  BLI_flatmap_clear(onm->map);
 }
 
 static void oldnewmap_free(OldNewMap *onm)
 {
-  MEM_freeN(onm->entries);
-  MEM_freeN(onm->map);
+  BLI_flatmap_free(onm->map);
   MEM_freeN(onm);
 }
 
-#undef ENTRIES_CAPACITY
-#undef MAP_CAPACITY
-#undef SLOT_MASK
-#undef DEFAULT_SIZE_EXP
-#undef PERTURB_SHIFT
-#undef ITER_SLOTS
-
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -991,6 +906,26 @@ static BHead *blo_bhead_read_full(FileData *fd, BHead *thisblock)
   }
   return &new_bhead_data->bhead;
 }
+
+/**
+ * Access block data in-place when the file is memory mapped,
+ * avoiding a temporary copy for data which is converted anyway.
+ *
+ * \return NULL when the data isn't available from a mapping.
+ */
+static const void *blo_bhead_data_mapped(FileData *fd, BHead *thisblock)
+{
+  BHeadN *new_bhead = BHEADN_FROM_BHEAD(thisblock);
+  BLI_assert(new_bhead->has_data == false && new_bhead->file_offset != 0);
+  if (fd->mmap_file == NULL) {
+    return NULL;
+  }
+  if ((size_t)(new_bhead->file_offset + new_bhead->bhead.len) >
+      BLI_mmap_get_length(fd->mmap_file)) {
+    return NULL;
+  }
+  return POINTER_OFFSET(BLI_mmap_get_pointer(fd->mmap_file), new_bhead->file_offset);
+}
 #endif /* USE_BHEAD_READ_ON_DEMAND */
 
 /* Warning! Caller's responsibility to ensure given bhead **is** and ID one! */
@@ -1157,6 +1092,52 @@ static off64_t fd_seek_data_from_file(FileData *filedata, off64_t offset, int wh
   return filedata->file_offset;
 }
 
+/* Memory-mapped file reading.
+ *
+ * Avoids a system call for every block and lets the OS share the page cache
+ * between processes reading the same file (e.g. library files linked by
+ * several render jobs). Block data which is only needed temporarily is used
+ * directly from the mapping, see #blo_bhead_data_mapped. */
+
+static int fd_read_from_mmap(FileData *filedata, void *buffer, uint size)
+{
+  const size_t length = BLI_mmap_get_length(filedata->mmap_file);
+  if (filedata->file_offset >= (int64_t)length) {
+    return 0;
+  }
+  const uint readsize = (uint)MIN2((size_t)size, length - (size_t)filedata->file_offset);
+  if (!BLI_mmap_read(filedata->mmap_file, buffer, (size_t)filedata->file_offset, readsize)) {
+    return EOF;
+  }
+  filedata->file_offset += readsize;
+  return (int)readsize;
+}
+
+static off64_t fd_seek_from_mmap(FileData *filedata, off64_t offset, int whence)
+{
+  const int64_t length = (int64_t)BLI_mmap_get_length(filedata->mmap_file);
+  int64_t offset_new;
+
+  switch (whence) {
+    case SEEK_SET:
+      offset_new = offset;
+      break;
+    case SEEK_CUR:
+      offset_new = filedata->file_offset + offset;
+      break;
+    case SEEK_END:
+      offset_new = length + offset;
+      break;
+    default:
+      return -1;
+  }
+  if (offset_new < 0 || offset_new > length) {
+    return -1;
+  }
+  filedata->file_offset = offset_new;
+  return filedata->file_offset;
+}
+
 /* GZip file reading. */
 
 static int fd_read_gzip_from_file(FileData *filedata, void *buffer, uint size)
@@ -1173,6 +1154,365 @@ static int fd_read_gzip_from_file(FileData *filedata, void *buffer, uint size)
   return (readsize);
 }
 
+/* GZip frames reading.
+ *
+ * Files written in independent gzip members (see #BLEN_GZIP_FRAME_SI1) are
+ * indexed when opened, so any position in the uncompressed data can be read
+ * by decompressing only the frame which contains it. This allows to seek
+ * over data which is never used (see #USE_BHEAD_READ_ON_DEMAND), and to
+ * decompress frames in parallel when reading sequentially. */
+
+typedef struct GzipFrame {
+  /** Location of the gzip member in the file. */
+  off64_t file_offset;
+  uint file_len;
+  /** Location of the frame's data in the uncompressed stream. */
+  int64_t data_offset;
+  uint data_len;
+} GzipFrame;
+
+typedef struct GzipFrameSlot {
+  /** Index of the frame which is stored in this slot, -1 when unused. */
+  int frame_index;
+  /** Value of #GzipFrames.use_counter when the slot was used last time. */
+  uint64_t last_use;
+  /** Compressed gzip member, read from the file. */
+  uchar *data_in;
+  uint data_in_alloc_len;
+  /** Decompressed data, #BLEN_GZIP_FRAME_SIZE. */
+  uchar *data_out;
+  bool error;
+} GzipFrameSlot;
+
+typedef struct GzipFrames {
+  GzipFrame *frames;
+  int frames_num;
+  /** Cache of decompressed frames. */
+  GzipFrameSlot *slots;
+  int slots_num;
+  uint64_t use_counter;
+  /** Frame which was read last time, used to detect sequential reading. */
+  int frame_index_last;
+  /** Created on demand for decompressing multiple frames at once. */
+  TaskPool *task_pool;
+} GzipFrames;
+
+BLI_INLINE uint gzip_frame_read_uint16(const uchar *data)
+{
+  return (uint)data[0] | ((uint)data[1] << 8);
+}
+
+BLI_INLINE uint gzip_frame_read_uint32(const uchar *data)
+{
+  return gzip_frame_read_uint16(data) | (gzip_frame_read_uint16(data + 2) << 16);
+}
+
+/**
+ * Build index of all frames of the file,
+ * \return NULL if the file is not entirely made of frames.
+ */
+static GzipFrames *gzip_frames_index(int file)
+{
+  GzipFrame *frames = NULL;
+  int frames_num = 0, frames_alloc_num = 0;
+  off64_t file_offset = 0;
+  int64_t data_offset = 0;
+  bool ok = true;
+
+  while (true) {
+    uchar header[BLEN_GZIP_FRAME_HEADER_SIZE];
+    if (lseek(file, file_offset, SEEK_SET) == -1) {
+      ok = false;
+      break;
+    }
+    const int readsize = read(file, header, sizeof(header));
+    if (readsize == 0) {
+      break;
+    }
+    if ((readsize != sizeof(header)) || (header[0] != 0x1f) || (header[1] != 0x8b) ||
+        (header[2] != Z_DEFLATED) || (header[3] != (1 << 2)) ||
+        (gzip_frame_read_uint16(&header[10]) != 12) || (header[12] != BLEN_GZIP_FRAME_SI1) ||
+        (header[13] != BLEN_GZIP_FRAME_SI2) || (gzip_frame_read_uint16(&header[14]) != 8)) {
+      ok = false;
+      break;
+    }
+
+    GzipFrame frame;
+    frame.file_offset = file_offset;
+    frame.file_len = gzip_frame_read_uint32(&header[16]);
+    frame.data_offset = data_offset;
+    frame.data_len = gzip_frame_read_uint32(&header[20]);
+    if ((frame.file_len < BLEN_GZIP_FRAME_HEADER_SIZE + BLEN_GZIP_FRAME_TRAILER_SIZE) ||
+        (frame.data_len > BLEN_GZIP_FRAME_SIZE)) {
+      ok = false;
+      break;
+    }
+
+    if (frames_num == frames_alloc_num) {
+      frames_alloc_num = max_ii(64, frames_alloc_num * 2);
+      frames = MEM_reallocN_id(frames, sizeof(*frames) * frames_alloc_num, __func__);
+    }
+    frames[frames_num++] = frame;
+
+    file_offset += frame.file_len;
+    data_offset += frame.data_len;
+  }
+
+  if (!ok || frames_num == 0) {
+    MEM_SAFE_FREE(frames);
+    return NULL;
+  }
+
+  TaskScheduler *scheduler = BLI_task_scheduler_get();
+  GzipFrames *gzframes = MEM_callocN(sizeof(*gzframes), __func__);
+  gzframes->frames = frames;
+  gzframes->frames_num = frames_num;
+  /* Twice the amount of threads, so frames decompressed ahead of time
+   * are not evicted by jumping back a little. */
+  gzframes->slots_num = max_ii(4, BLI_task_scheduler_num_threads(scheduler) * 2);
+  gzframes->slots = MEM_callocN(sizeof(*gzframes->slots) * gzframes->slots_num, __func__);
+  for (int i = 0; i < gzframes->slots_num; i++) {
+    gzframes->slots[i].frame_index = -1;
+  }
+  gzframes->frame_index_last = -1;
+  return gzframes;
+}
+
+static void gzip_frames_free(GzipFrames *gzframes)
+{
+  if (gzframes->task_pool != NULL) {
+    BLI_task_pool_free(gzframes->task_pool);
+  }
+  for (int i = 0; i < gzframes->slots_num; i++) {
+    MEM_SAFE_FREE(gzframes->slots[i].data_in);
+    MEM_SAFE_FREE(gzframes->slots[i].data_out);
+  }
+  MEM_freeN(gzframes->slots);
+  MEM_freeN(gzframes->frames);
+  MEM_freeN(gzframes);
+}
+
+static void gzip_frame_decompress(const GzipFrame *frame, GzipFrameSlot *slot)
+{
+  z_stream strm = {NULL};
+
+  if (slot->data_out == NULL) {
+    slot->data_out = MEM_mallocN(BLEN_GZIP_FRAME_SIZE, __func__);
+  }
+
+  if (inflateInit2(&strm, -MAX_WBITS) != Z_OK) {
+    slot->error = true;
+    return;
+  }
+
+  strm.next_in = slot->data_in + BLEN_GZIP_FRAME_HEADER_SIZE;
+  strm.avail_in = frame->file_len - BLEN_GZIP_FRAME_HEADER_SIZE - BLEN_GZIP_FRAME_TRAILER_SIZE;
+  strm.next_out = slot->data_out;
+  strm.avail_out = frame->data_len;
+
+  const int ret = inflate(&strm, Z_FINISH);
+  const uint data_len = (uint)strm.total_out;
+  inflateEnd(&strm);
+
+  const uchar *trailer = slot->data_in + frame->file_len - BLEN_GZIP_FRAME_TRAILER_SIZE;
+  slot->error = (ret != Z_STREAM_END) || (data_len != frame->data_len) ||
+                (gzip_frame_read_uint32(&trailer[0]) !=
+                 (uint)crc32(0, slot->data_out, frame->data_len));
+}
+
+static void gzip_frame_decompress_task(TaskPool *__restrict pool,
+                                       void *taskdata,
+                                       int UNUSED(threadid))
+{
+  GzipFrames *gzframes = BLI_task_pool_userdata(pool);
+  GzipFrameSlot *slot = taskdata;
+  gzip_frame_decompress(&gzframes->frames[slot->frame_index], slot);
+}
+
+static GzipFrameSlot *gzip_frames_slot_lru(GzipFrames *gzframes)
+{
+  GzipFrameSlot *slot_lru = &gzframes->slots[0];
+  for (int i = 1; i < gzframes->slots_num; i++) {
+    if (gzframes->slots[i].last_use < slot_lru->last_use) {
+      slot_lru = &gzframes->slots[i];
+    }
+  }
+  return slot_lru;
+}
+
+static GzipFrameSlot *gzip_frames_slot_find(GzipFrames *gzframes, const int frame_index)
+{
+  for (int i = 0; i < gzframes->slots_num; i++) {
+    if (gzframes->slots[i].frame_index == frame_index) {
+      return &gzframes->slots[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Get decompressed data of the given frame.
+ *
+ * When reading sequentially, the following frames are decompressed in parallel
+ * together with the requested one.
+ */
+static const uchar *gzip_frames_ensure(FileData *fd, const int frame_index)
+{
+  GzipFrames *gzframes = fd->gzframes;
+  GzipFrameSlot *slot = gzip_frames_slot_find(gzframes, frame_index);
+
+  if (slot == NULL) {
+    const bool is_sequential = (frame_index == gzframes->frame_index_last + 1);
+    const int batch_num = is_sequential ? gzframes->slots_num / 2 : 1;
+    GzipFrameSlot *slot_first = NULL;
+    int slots_pushed_num = 0;
+
+    for (int i = frame_index; i < min_ii(frame_index + batch_num, gzframes->frames_num); i++) {
+      if (i != frame_index && gzip_frames_slot_find(gzframes, i) != NULL) {
+        continue;
+      }
+
+      /* Compressed data is read here, only decompression happens in parallel. */
+      const GzipFrame *frame = &gzframes->frames[i];
+      GzipFrameSlot *slot_new = gzip_frames_slot_lru(gzframes);
+      slot_new->frame_index = i;
+      slot_new->last_use = ++gzframes->use_counter;
+      slot_new->error = false;
+      if (slot_new->data_in_alloc_len < frame->file_len) {
+        MEM_SAFE_FREE(slot_new->data_in);
+        slot_new->data_in = MEM_mallocN(frame->file_len, __func__);
+        slot_new->data_in_alloc_len = frame->file_len;
+      }
+      if ((lseek(fd->filedes, frame->file_offset, SEEK_SET) == -1) ||
+          ((uint)read(fd->filedes, slot_new->data_in, frame->file_len) != frame->file_len)) {
+        slot_new->error = true;
+      }
+
+      if (i == frame_index) {
+        slot_first = slot_new;
+      }
+      else if (!slot_new->error) {
+        if (gzframes->task_pool == NULL) {
+          gzframes->task_pool = BLI_task_pool_create(BLI_task_scheduler_get(), gzframes);
+        }
+        BLI_task_pool_push(
+            gzframes->task_pool, gzip_frame_decompress_task, slot_new, false, TASK_PRIORITY_HIGH);
+        slots_pushed_num++;
+      }
+    }
+
+    if (!slot_first->error) {
+      gzip_frame_decompress(&gzframes->frames[frame_index], slot_first);
+    }
+    if (slots_pushed_num != 0) {
+      BLI_task_pool_work_wait_and_reset(gzframes->task_pool);
+    }
+
+    /* Never keep failed frames around. */
+    for (int i = 0; i < gzframes->slots_num; i++) {
+      if (gzframes->slots[i].error && &gzframes->slots[i] != slot_first) {
+        gzframes->slots[i].frame_index = -1;
+        gzframes->slots[i].last_use = 0;
+      }
+    }
+    slot = slot_first;
+  }
+
+  slot->last_use = ++gzframes->use_counter;
+  gzframes->frame_index_last = frame_index;
+
+  if (slot->error) {
+    slot->frame_index = -1;
+    slot->last_use = 0;
+    return NULL;
+  }
+  return slot->data_out;
+}
+
+static int gzip_frames_find(const GzipFrames *gzframes, const int64_t offset)
+{
+  /* Sequential reading hits the last or the next frame. */
+  int frame_index = max_ii(gzframes->frame_index_last, 0);
+  const GzipFrame *frame = &gzframes->frames[frame_index];
+  if (offset >= frame->data_offset + frame->data_len && frame_index + 1 < gzframes->frames_num) {
+    frame_index++;
+    frame++;
+  }
+  if (offset >= frame->data_offset && offset < frame->data_offset + frame->data_len) {
+    return frame_index;
+  }
+
+  /* Binary search. */
+  int lo = 0, hi = gzframes->frames_num - 1;
+  while (lo <= hi) {
+    const int mid = (lo + hi) / 2;
+    frame = &gzframes->frames[mid];
+    if (offset < frame->data_offset) {
+      hi = mid - 1;
+    }
+    else if (offset >= frame->data_offset + frame->data_len) {
+      lo = mid + 1;
+    }
+    else {
+      return mid;
+    }
+  }
+  return -1;
+}
+
+static int fd_read_gzip_frames(FileData *filedata, void *buffer, uint size)
+{
+  GzipFrames *gzframes = filedata->gzframes;
+  uint totread = 0;
+
+  while (totread < size) {
+    const int frame_index = gzip_frames_find(gzframes, filedata->file_offset);
+    if (frame_index == -1) {
+      /* End of file. */
+      break;
+    }
+    const uchar *data = gzip_frames_ensure(filedata, frame_index);
+    if (data == NULL) {
+      return EOF;
+    }
+
+    const GzipFrame *frame = &gzframes->frames[frame_index];
+    const uint frame_offset = (uint)(filedata->file_offset - frame->data_offset);
+    const uint readsize = MIN2(size - totread, frame->data_len - frame_offset);
+    memcpy(POINTER_OFFSET(buffer, totread), data + frame_offset, readsize);
+    totread += readsize;
+    filedata->file_offset += readsize;
+  }
+
+  return (int)totread;
+}
+
+static off64_t fd_seek_gzip_frames(FileData *filedata, off64_t offset, int whence)
+{
+  const GzipFrame *frame_last = &filedata->gzframes->frames[filedata->gzframes->frames_num - 1];
+  const int64_t data_len = frame_last->data_offset + frame_last->data_len;
+  int64_t offset_new;
+
+  switch (whence) {
+    case SEEK_SET:
+      offset_new = offset;
+      break;
+    case SEEK_CUR:
+      offset_new = filedata->file_offset + offset;
+      break;
+    case SEEK_END:
+      offset_new = data_len + offset;
+      break;
+    default:
+      return -1;
+  }
+  if (offset_new < 0 || offset_new > data_len) {
+    return -1;
+  }
+  filedata->file_offset = offset_new;
+  return offset_new;
+}
+
 /* Memory reading. */
 
 static int fd_read_from_memory(FileData *filedata, void *buffer, uint size)
@@ -1190,28 +1530,28 @@ static int fd_read_from_memory(FileData *filedata, void *buffer, uint size)
 
 static int fd_read_from_memfile(FileData *filedata, void *buffer, uint size)
 {
-  static size_t seek = SIZE_MAX; /* the current position */
-  static size_t offset = 0;      /* size of previous chunks */
-  static MemFileChunk *chunk = NULL;
+  const size_t seek = (size_t)filedata->file_offset; /* the current position */
+  size_t offset = filedata->memfile_chunk_offset;   /* size of previous chunks */
+  MemFileChunk *chunk = filedata->memfile_chunk;
   size_t chunkoffset, readsize, totread;
 
   if (size == 0) {
     return 0;
   }
 
-  if (seek != (size_t)filedata->file_offset) {
+  /* Find the chunk containing the current position starting from the last one read,
+   * reads are mostly sequential or go back a short distance (see #USE_BHEAD_READ_ON_DEMAND). */
+  if (chunk == NULL) {
     chunk = filedata->memfile->chunks.first;
-    seek = 0;
-
-    while (chunk) {
-      if (seek + chunk->size > (size_t)filedata->file_offset) {
-        break;
-      }
-      seek += chunk->size;
-      chunk = chunk->next;
-    }
-    offset = seek;
-    seek = filedata->file_offset;
+    offset = 0;
+  }
+  while (seek < offset) {
+    chunk = chunk->prev;
+    offset -= chunk->size;
+  }
+  while (chunk && (seek - offset > chunk->size)) {
+    offset += chunk->size;
+    chunk = chunk->next;
   }
 
   if (chunk) {
@@ -1219,7 +1559,7 @@ static int fd_read_from_memfile(FileData *filedata, void *buffer, uint size)
 
     do {
       /* first check if it's on the end if current chunk */
-      if (seek - offset == chunk->size) {
+      if (filedata->file_offset - offset == chunk->size) {
         offset += chunk->size;
         chunk = chunk->next;
       }
@@ -1227,10 +1567,10 @@ static int fd_read_from_memfile(FileData *filedata, void *buffer, uint size)
       /* debug, should never happen */
       if (chunk == NULL) {
         printf("illegal read, chunk zero\n");
-        return 0;
+        break;
       }
 
-      chunkoffset = seek - offset;
+      chunkoffset = filedata->file_offset - offset;
       readsize = size - totread;
 
       /* data can be spread over multiple chunks, so clamp size
@@ -1243,15 +1583,40 @@ static int fd_read_from_memfile(FileData *filedata, void *buffer, uint size)
       memcpy(POINTER_OFFSET(buffer, totread), chunk->buf + chunkoffset, readsize);
       totread += readsize;
       filedata->file_offset += readsize;
-      seek += readsize;
     } while (totread < size);
 
-    return totread;
+    filedata->memfile_chunk = chunk;
+    filedata->memfile_chunk_offset = offset;
+
+    return (chunk != NULL) ? totread : 0;
   }
 
+  filedata->memfile_chunk = NULL;
   return 0;
 }
 
+static off64_t fd_seek_from_memfile(FileData *filedata, off64_t offset, int whence)
+{
+  /* Only the position changes, #fd_read_from_memfile finds the chunk to read from. */
+  int64_t offset_new;
+
+  switch (whence) {
+    case SEEK_SET:
+      offset_new = offset;
+      break;
+    case SEEK_CUR:
+      offset_new = filedata->file_offset + offset;
+      break;
+    default:
+      return -1;
+  }
+  if (offset_new < 0) {
+    return -1;
+  }
+  filedata->file_offset = offset_new;
+  return filedata->file_offset;
+}
+
 static FileData *filedata_new(void)
 {
   FileData *fd = MEM_callocN(sizeof(FileData), "FileData");
@@ -1299,6 +1664,8 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
   FileDataSeekFn *seek_fn = NULL; /* Optional. */
 
   gzFile gzfile = (gzFile)Z_NULL;
+  GzipFrames *gzframes = NULL;
+  BLI_mmap_file *mmap_file = NULL;
 
   char header[7];
 
@@ -1318,8 +1685,27 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
 
   /* Regular file. */
   if (memcmp(header, "BLENDER", sizeof(header)) == 0) {
-    read_fn = fd_read_data_from_file;
-    seek_fn = fd_seek_data_from_file;
+    /* Prefer memory mapping, fall back to regular reads when it's not supported. */
+    mmap_file = BLI_mmap_open(file);
+    if (mmap_file != NULL) {
+      read_fn = fd_read_from_mmap;
+      seek_fn = fd_seek_from_mmap;
+    }
+    else {
+      read_fn = fd_read_data_from_file;
+      seek_fn = fd_seek_data_from_file;
+    }
+  }
+
+  /* Gzip file written in frames. */
+  if ((read_fn == NULL) &&
+      /* Check header magic. */
+      (header[0] == 0x1f && header[1] == 0x8b)) {
+    gzframes = gzip_frames_index(file);
+    if (gzframes != NULL) {
+      read_fn = fd_read_gzip_frames;
+      seek_fn = fd_seek_gzip_frames;
+    }
   }
 
   /* Gzip file. */
@@ -1353,6 +1739,8 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
 
   fd->filedes = file;
   fd->gzfiledes = gzfile;
+  fd->gzframes = gzframes;
+  fd->mmap_file = mmap_file;
 
   fd->read = read_fn;
   fd->seek = seek_fn;
@@ -1417,20 +1805,26 @@ static int fd_read_gzip_from_memory(FileData *filedata, void *buffer, uint size)
   filedata->strm.next_out = (Bytef *)buffer;
   filedata->strm.avail_out = size;
 
-  // Inflate another chunk.
-  err = inflate(&filedata->strm, Z_SYNC_FLUSH);
+  while (filedata->strm.avail_out != 0) {
+    // Inflate another chunk.
+    err = inflate(&filedata->strm, Z_SYNC_FLUSH);
 
-  if (err == Z_STREAM_END) {
-    return 0;
-  }
-  else if (err != Z_OK) {
-    printf("fd_read_gzip_from_memory: zlib error\n");
-    return 0;
+    if (err == Z_STREAM_END) {
+      /* Compressed files consist of multiple gzip members, continue with the next one. */
+      if (filedata->strm.avail_in == 0 || inflateReset(&filedata->strm) != Z_OK) {
+        break;
+      }
+    }
+    else if (err != Z_OK) {
+      printf("fd_read_gzip_from_memory: zlib error\n");
+      return 0;
+    }
   }
 
-  filedata->file_offset += size;
+  const uint readsize = size - filedata->strm.avail_out;
+  filedata->file_offset += readsize;
 
-  return (size);
+  return (int)readsize;
 }
 
 static int fd_read_gzip_from_memory_init(FileData *fd)
@@ -1492,6 +1886,7 @@ FileData *blo_filedata_from_memfile(MemFile *memfile, ReportList *reports)
     fd->memfile = memfile;
 
     fd->read = fd_read_from_memfile;
+    fd->seek = fd_seek_from_memfile;
     fd->flags |= FD_FLAGS_NOT_MY_BUFFER;
 
     return blo_decode_and_check(fd, reports);
@@ -1509,6 +1904,18 @@ void blo_filedata_free(FileData *fd)
       gzclose(fd->gzfiledes);
     }
 
+    if (fd->gzframes != NULL) {
+      gzip_frames_free(fd->gzframes);
+    }
+
+    if (fd->mmap_file != NULL) {
+      BLI_mmap_free(fd->mmap_file);
+    }
+
+    if (fd->memfile_identical_ids != NULL) {
+      BLI_gset_free(fd->memfile_identical_ids, NULL);
+    }
+
     if (fd->strm.next_in) {
       if (inflateEnd(&fd->strm) != Z_OK) {
         printf("close gzip stream error\n");
@@ -1811,8 +2218,9 @@ static void *newlibadr_real_us(FileData *fd,
 
 static void change_link_placeholder_to_real_ID_pointer_fd(FileData *fd, const void *old, void *new)
 {
-  for (int i = 0; i < fd->libmap->nentries; i++) {
-    OldNew *entry = &fd->libmap->entries[i];
+  FlatMapIterator iter;
+  OLDNEWMAP_ITER (iter, fd->libmap) {
+    OldNew *entry = OLDNEWMAP_ITER_VALUE(iter);
 
     if (old == entry->newp && entry->nr == ID_LINK_PLACEHOLDER) {
       entry->newp = new;
@@ -1879,12 +2287,12 @@ void blo_make_scene_pointer_map(FileData *fd, Main *oldmain)
 
 void blo_end_scene_pointer_map(FileData *fd, Main *oldmain)
 {
-  OldNew *entry = fd->scenemap->entries;
+  FlatMapIterator iter;
   Scene *sce = oldmain->scenes.first;
-  int i;
 
   /* used entries were restored, so we put them to zero */
-  for (i = 0; i < fd->scenemap->nentries; i++, entry++) {
+  OLDNEWMAP_ITER (iter, fd->scenemap) {
+    OldNew *entry = OLDNEWMAP_ITER_VALUE(iter);
     if (entry->nr > 0) {
       entry->newp = NULL;
     }
@@ -1936,13 +2344,14 @@ void blo_make_image_pointer_map(FileData *fd, Main *oldmain)
 /* this works because freeing old main only happens after this call */
 void blo_end_image_pointer_map(FileData *fd, Main *oldmain)
 {
-  OldNew *entry = fd->imamap->entries;
+  FlatMapIterator map_iter;
   Image *ima = oldmain->images.first;
   Scene *sce = oldmain->scenes.first;
   int i;
 
   /* used entries were restored, so we put them to zero */
-  for (i = 0; i < fd->imamap->nentries; i++, entry++) {
+  OLDNEWMAP_ITER (map_iter, fd->imamap) {
+    OldNew *entry = OLDNEWMAP_ITER_VALUE(map_iter);
     if (entry->nr > 0) {
       entry->newp = NULL;
     }
@@ -2022,13 +2431,13 @@ void blo_make_movieclip_pointer_map(FileData *fd, Main *oldmain)
 /* this works because freeing old main only happens after this call */
 void blo_end_movieclip_pointer_map(FileData *fd, Main *oldmain)
 {
-  OldNew *entry = fd->movieclipmap->entries;
+  FlatMapIterator iter;
   MovieClip *clip = oldmain->movieclips.first;
   Scene *sce = oldmain->scenes.first;
-  int i;
 
   /* used entries were restored, so we put them to zero */
-  for (i = 0; i < fd->movieclipmap->nentries; i++, entry++) {
+  OLDNEWMAP_ITER (iter, fd->movieclipmap) {
+    OldNew *entry = OLDNEWMAP_ITER_VALUE(iter);
     if (entry->nr > 0) {
       entry->newp = NULL;
     }
@@ -2068,12 +2477,12 @@ void blo_make_sound_pointer_map(FileData *fd, Main *oldmain)
 /* this works because freeing old main only happens after this call */
 void blo_end_sound_pointer_map(FileData *fd, Main *oldmain)
 {
-  OldNew *entry = fd->soundmap->entries;
+  FlatMapIterator iter;
   bSound *sound = oldmain->sounds.first;
-  int i;
 
   /* used entries were restored, so we put them to zero */
-  for (i = 0; i < fd->soundmap->nentries; i++, entry++) {
+  OLDNEWMAP_ITER (iter, fd->soundmap) {
+    OldNew *entry = OLDNEWMAP_ITER_VALUE(iter);
     if (entry->nr > 0) {
       entry->newp = NULL;
     }
@@ -2143,11 +2552,11 @@ void blo_end_packed_pointer_map(FileData *fd, Main *oldmain)
   VFont *vfont;
   bSound *sound;
   Library *lib;
-  OldNew *entry = fd->packedmap->entries;
-  int i;
+  FlatMapIterator iter;
 
   /* used entries were restored, so we put them to zero */
-  for (i = 0; i < fd->packedmap->nentries; i++, entry++) {
+  OLDNEWMAP_ITER (iter, fd->packedmap) {
+    OldNew *entry = OLDNEWMAP_ITER_VALUE(iter);
     if (entry->nr > 0) {
       entry->newp = NULL;
     }
@@ -2242,17 +2651,28 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 
     if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
       if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
+        const void *data = (bh + 1);
 #ifdef USE_BHEAD_READ_ON_DEMAND
         if (BHEADN_FROM_BHEAD(bh)->has_data == false) {
-          bh = blo_bhead_read_full(fd, bh);
-          if (UNLIKELY(bh == NULL)) {
-            fd->flags &= ~FD_FLAGS_FILE_OK;
-            return NULL;
+          data = blo_bhead_data_mapped(fd, bh);
+          if (data == NULL) {
+            bh = blo_bhead_read_full(fd, bh);
+            if (UNLIKELY(bh == NULL)) {
+              fd->flags &= ~FD_FLAGS_FILE_OK;
+              return NULL;
+            }
+            data = (bh + 1);
           }
         }
 #endif
         temp = DNA_struct_reconstruct(
-            fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, (bh + 1));
+            fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, data);
+#ifdef USE_BHEAD_READ_ON_DEMAND
+        if (fd->mmap_file != NULL && UNLIKELY(BLI_mmap_has_io_error(fd->mmap_file))) {
+          fd->flags &= ~FD_FLAGS_FILE_OK;
+          MEM_SAFE_FREE(temp);
+        }
+#endif
       }
       else {
         /* SDNA_CMP_EQUAL */
@@ -6744,6 +7164,7 @@ static void direct_link_scene(FileData *fd, Scene *sce)
 
     ed->act_seq = newdataadr(fd, ed->act_seq);
     ed->cache = NULL;
+    ed->prefetch_job = NULL;
 
     /* recursive link sequences, lb will be correctly initialized */
     link_recurs_seq(fd, &ed->seqbase);
@@ -9043,6 +9464,52 @@ static BHead *read_data_into_oldnewmap(FileData *fd, BHead *bhead, const char *a
   return bhead;
 }
 
+/**
+ * Undo: data-block types which are kept from the old main when they didn't change.
+ * Others are always read again, because they hold runtime data which depends
+ * on the previous state (depsgraphs of scenes, GPU materials, UI, object evaluation...).
+ */
+static bool read_libblock_is_reusable(const BHead *bhead)
+{
+  return ELEM(bhead->code, ID_ME, ID_CU, ID_MB, ID_LT, ID_KE, ID_AC, ID_TXT);
+}
+
+/**
+ * Undo: move a data-block which didn't change since the memfile was written
+ * from the old main, instead of reading it again.
+ *
+ * Its address and contents match the memfile, so the regular lib_link functions
+ * relink its pointers to other data-blocks and count its users like for read data-blocks.
+ */
+static BHead *read_libblock_reuse(FileData *fd, Main *main, BHead *bhead, const int tag, ID **r_id)
+{
+  Main *oldmain = fd->old_mainlist->first;
+  ID *id = (ID *)bhead->old;
+  const short idcode = GS(id->name);
+
+  BLI_remlink(which_libbase(oldmain, idcode), id);
+  BLI_addtail(which_libbase(main, idcode), id);
+  oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);
+
+  id->us = ID_FAKE_USERS(id);
+  id->newid = NULL;
+  id->orig_id = NULL;
+  id->recalc = 0;
+  id->tag = tag | LIB_TAG_NEED_LINK | LIB_TAG_NEW;
+
+  if (r_id) {
+    *r_id = id;
+  }
+
+  /* Skip the direct data, it's already in place. */
+  bhead = blo_bhead_next(fd, bhead);
+  while (bhead && bhead->code == DATA) {
+    bhead = blo_bhead_next(fd, bhead);
+  }
+
+  return bhead;
+}
+
 static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const int tag, ID **r_id)
 {
   /* this routine reads a libblock and its direct data. Use link functions to connect it all
@@ -9114,6 +9581,11 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const int ta
     }
   }
 
+  if (fd->memfile_identical_ids && (main->curlib == NULL) && read_libblock_is_reusable(bhead) &&
+      BLI_gset_haskey(fd->memfile_identical_ids, bhead->old)) {
+    return read_libblock_reuse(fd, main, bhead, tag, r_id);
+  }
+
   /* read libblock */
   id = read_struct(fd, bhead, "lib block");
 
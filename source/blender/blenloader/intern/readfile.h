@@ -73,14 +73,26 @@ typedef struct FileData {
 
   /** Regular file reading. */
   int filedes;
+  /** Memory mapping of uncompressed files, used instead of `filedes` reads when available. */
+  struct BLI_mmap_file *mmap_file;
 
   /** Variables needed for reading from memory / stream. */
   const char *buffer;
   /** Variables needed for reading from memfile (undo). */
   struct MemFile *memfile;
+  /** The chunk of the last read and its offset in the memfile. */
+  struct MemFileChunk *memfile_chunk;
+  size_t memfile_chunk_offset;
+  /**
+   * Data-blocks of the old main which are unchanged in the memfile,
+   * these are moved to the new main instead of being read again.
+   */
+  struct GSet *memfile_identical_ids;
 
   /** Variables needed for reading from file. */
   gzFile gzfiledes;
+  /** Index and cache of gzip frames, when the compressed file supports seeking. */
+  struct GzipFrames *gzframes;
   /** Gzip stream for memory decompression. */
   z_stream strm;
 
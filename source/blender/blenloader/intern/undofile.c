@@ -41,9 +41,12 @@
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 
 #include "BLO_undofile.h"
 #include "BLO_readfile.h"
+#include "BLO_writefile.h"
 
 #include "BKE_main.h"
 
@@ -52,15 +55,101 @@
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+/**
+ * Chunk buffers are reference counted, every #MemFileChunk with the same contents
+ * uses the same buffer, regardless of its position in the file or the undo step it was
+ * written for. This way inserting or removing data only duplicates the chunks which actually
+ * changed and not everything which was shifted after them, and contents returning after
+ * several steps (undoing a change by hand for example) are not stored again.
+ */
+typedef struct MemFileChunkBuf {
+  /* Points to the memory following this struct, or to the data to look up. */
+  const char *data;
+  uint size;
+  uint hash;
+  int users;
+  /* Keep the data aligned. */
+  int _pad;
+} MemFileChunkBuf;
+
+#define CHUNK_BUF_FROM_DATA(buf) (((MemFileChunkBuf *)(buf)) - 1)
+
+/**
+ * All chunk buffers of all memfiles by their contents. Memfiles are only written and freed
+ * from the main thread, so this is shared by the whole undo stack without locking.
+ * Only allocated while there are buffers, so nothing is left over on exit.
+ */
+static GSet *memfile_chunk_bufs = NULL;
+
+static uint memfile_chunk_buf_hash(const void *key)
+{
+  const MemFileChunkBuf *chunk_buf = key;
+  return chunk_buf->hash;
+}
+
+static bool memfile_chunk_buf_cmp(const void *a, const void *b)
+{
+  const MemFileChunkBuf *chunk_buf_a = a;
+  const MemFileChunkBuf *chunk_buf_b = b;
+  return !((chunk_buf_a->hash == chunk_buf_b->hash) && (chunk_buf_a->size == chunk_buf_b->size) &&
+           (memcmp(chunk_buf_a->data, chunk_buf_b->data, chunk_buf_a->size) == 0));
+}
+
+/* Returns an existing buffer with the same contents, or NULL. */
+static const char *memfile_chunk_buf_find(const char *buf, uint size, uint hash)
+{
+  if (memfile_chunk_bufs == NULL) {
+    return NULL;
+  }
+
+  const MemFileChunkBuf key = {.data = buf, .size = size, .hash = hash};
+  const MemFileChunkBuf *chunk_buf = BLI_gset_lookup(memfile_chunk_bufs, &key);
+  return chunk_buf ? chunk_buf->data : NULL;
+}
+
+static const char *memfile_chunk_buf_new(const char *buf, uint size, uint hash)
+{
+  MemFileChunkBuf *chunk_buf = MEM_mallocN(sizeof(MemFileChunkBuf) + size, "Chunk buffer");
+  chunk_buf->data = (const char *)(chunk_buf + 1);
+  chunk_buf->size = size;
+  chunk_buf->hash = hash;
+  chunk_buf->users = 1;
+  memcpy(chunk_buf + 1, buf, size);
+
+  if (memfile_chunk_bufs == NULL) {
+    memfile_chunk_bufs = BLI_gset_new(memfile_chunk_buf_hash, memfile_chunk_buf_cmp, __func__);
+  }
+  BLI_gset_insert(memfile_chunk_bufs, chunk_buf);
+
+  return chunk_buf->data;
+}
+
+static void memfile_chunk_buf_user_add(const char *buf)
+{
+  CHUNK_BUF_FROM_DATA(buf)->users++;
+}
+
+static void memfile_chunk_buf_user_remove(const char *buf)
+{
+  MemFileChunkBuf *chunk_buf = CHUNK_BUF_FROM_DATA(buf);
+  BLI_assert(chunk_buf->users > 0);
+  if (--chunk_buf->users == 0) {
+    BLI_gset_remove(memfile_chunk_bufs, chunk_buf, NULL);
+    if (BLI_gset_len(memfile_chunk_bufs) == 0) {
+      BLI_gset_free(memfile_chunk_bufs, NULL);
+      memfile_chunk_bufs = NULL;
+    }
+    MEM_freeN(chunk_buf);
+  }
+}
+
 /* not memfile itself */
 void BLO_memfile_free(MemFile *memfile)
 {
   MemFileChunk *chunk;
 
   while ((chunk = BLI_pophead(&memfile->chunks))) {
-    if (chunk->is_identical == false) {
-      MEM_freeN((void *)chunk->buf);
-    }
+    memfile_chunk_buf_user_remove(chunk->buf);
     MEM_freeN(chunk);
   }
   memfile->size = 0;
@@ -70,53 +159,65 @@ void BLO_memfile_free(MemFile *memfile)
 /* result is that 'first' is being freed */
 void BLO_memfile_merge(MemFile *first, MemFile *second)
 {
-  MemFileChunk *fc, *sc;
-
-  fc = first->chunks.first;
-  sc = second->chunks.first;
-  while (fc || sc) {
-    if (fc && sc) {
-      if (sc->is_identical) {
-        sc->is_identical = false;
-        fc->is_identical = true;
-      }
-    }
-    if (fc) {
-      fc = fc->next;
-    }
-    if (sc) {
-      sc = sc->next;
-    }
+  /* Buffers are reference counted, 'second' keeps using the shared ones,
+   * only the link to the freed step is cleared. */
+  LISTBASE_FOREACH (MemFileChunk *, sc, &second->chunks) {
+    sc->is_identical = false;
   }
 
   BLO_memfile_free(first);
 }
 
-void memfile_chunk_add(MemFile *memfile, const char *buf, uint size, MemFileChunk **compchunk_step)
+static bool memfile_chunk_cmp(const void *a, const void *b)
 {
+  const MemFileChunk *chunk_a = a;
+  const MemFileChunk *chunk_b = b;
+  return !((chunk_a->hash == chunk_b->hash) && (chunk_a->size == chunk_b->size) &&
+           (memcmp(chunk_a->buf, chunk_b->buf, chunk_a->size) == 0));
+}
+
+void BLO_memfile_write_init(MemFileWriteData *mem_data,
+                            MemFile *written_memfile,
+                            MemFile *reference_memfile)
+{
+  mem_data->written_memfile = written_memfile;
+  mem_data->reference_memfile = reference_memfile;
+  mem_data->reference_current_chunk = reference_memfile ? reference_memfile->chunks.first : NULL;
+  mem_data->current_id = NULL;
+}
+
+void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, uint size)
+{
+  MemFile *memfile = mem_data->written_memfile;
   MemFileChunk *curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
   curchunk->size = size;
   curchunk->buf = NULL;
+  curchunk->hash = BLI_hash_mm2((const uchar *)buf, size, 0);
   curchunk->is_identical = false;
+  curchunk->id = mem_data->current_id;
   BLI_addtail(&memfile->chunks, curchunk);
 
-  /* we compare compchunk with buf */
-  if (*compchunk_step != NULL) {
-    MemFileChunk *compchunk = *compchunk_step;
-    if (compchunk->size == curchunk->size) {
-      if (memcmp(compchunk->buf, buf, size) == 0) {
-        curchunk->buf = compchunk->buf;
-        curchunk->is_identical = true;
-      }
+  /* Most of the time the data matches the chunk at the same position in the previous step,
+   * only search all buffers by contents when it doesn't. */
+  MemFileChunk *refchunk = mem_data->reference_current_chunk;
+  if (refchunk != NULL) {
+    if ((refchunk->hash == curchunk->hash) && (refchunk->size == size) &&
+        (memcmp(refchunk->buf, buf, size) == 0)) {
+      curchunk->buf = refchunk->buf;
     }
-    *compchunk_step = compchunk->next;
+    mem_data->reference_current_chunk = refchunk->next;
   }
-
-  /* not equal... */
   if (curchunk->buf == NULL) {
-    char *buf_new = MEM_mallocN(size, "Chunk buffer");
-    memcpy(buf_new, buf, size);
-    curchunk->buf = buf_new;
+    curchunk->buf = memfile_chunk_buf_find(buf, size, curchunk->hash);
+  }
+
+  if (curchunk->buf != NULL) {
+    curchunk->is_identical = true;
+    memfile_chunk_buf_user_add(curchunk->buf);
+  }
+  else {
+    /* not equal... */
+    curchunk->buf = memfile_chunk_buf_new(buf, size, curchunk->hash);
     memfile->size += size;
   }
 }
@@ -141,6 +242,69 @@ struct Main *BLO_memfile_main_get(struct MemFile *memfile,
   return bmain_undo;
 }
 
+static bool memfile_chunk_is_equal(const MemFileChunk *chunk_a, const MemFileChunk *chunk_b)
+{
+  return (chunk_a->buf == chunk_b->buf) || !memfile_chunk_cmp(chunk_a, chunk_b);
+}
+
+/**
+ * Find the data-blocks of \a bmain which are unchanged compared to their state in \a memfile,
+ * so reading \a memfile can keep them instead of reading them again.
+ *
+ * The current state is written the same way as an undo step, using \a memfile as reference,
+ * so unchanged chunks mostly share their memory and comparing them is cheap.
+ * This is much faster than reading, and doesn't depend on the current state
+ * matching the last undo step written.
+ *
+ * \return A set of ID pointers of \a bmain, or NULL when there are none.
+ */
+struct GSet *BLO_memfile_identical_ids_get(MemFile *memfile, struct Main *bmain)
+{
+  MemFile memfile_current = {{NULL}};
+  BLO_write_file_mem(bmain, memfile, &memfile_current, 0);
+
+  /* The first chunk of each data-block in the reference. */
+  GHash *id_chunks = BLI_ghash_ptr_new(__func__);
+  LISTBASE_FOREACH (MemFileChunk *, chunk, &memfile->chunks) {
+    const MemFileChunk *chunk_prev = chunk->prev;
+    if (chunk->id != NULL && (chunk_prev == NULL || chunk_prev->id != chunk->id)) {
+      BLI_ghash_insert(id_chunks, (void *)chunk->id, chunk);
+    }
+  }
+
+  GSet *identical_ids = NULL;
+  const MemFileChunk *chunk = memfile_current.chunks.first;
+  while (chunk != NULL) {
+    const void *id = chunk->id;
+    if (id == NULL) {
+      chunk = chunk->next;
+      continue;
+    }
+
+    /* Compare all chunks of the data-block, the reference must not have more of them either. */
+    const MemFileChunk *chunk_ref = BLI_ghash_lookup(id_chunks, id);
+    bool is_identical = (chunk_ref != NULL);
+    for (; chunk != NULL && chunk->id == id; chunk = chunk->next) {
+      if (is_identical) {
+        is_identical = (chunk_ref != NULL) && (chunk_ref->id == id) &&
+                       memfile_chunk_is_equal(chunk, chunk_ref);
+        chunk_ref = is_identical ? chunk_ref->next : NULL;
+      }
+    }
+    if (is_identical && (chunk_ref == NULL || chunk_ref->id != id)) {
+      if (identical_ids == NULL) {
+        identical_ids = BLI_gset_ptr_new(__func__);
+      }
+      BLI_gset_insert(identical_ids, (void *)id);
+    }
+  }
+
+  BLI_ghash_free(id_chunks, NULL, NULL);
+  BLO_memfile_free(&memfile_current);
+
+  return identical_ids;
+}
+
 /**
  * Saves .blend using undo buffer.
  *
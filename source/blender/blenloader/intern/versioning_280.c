@@ -3423,5 +3423,14 @@ void blo_do_versions_280(FileData *fd, Library *UNUSED(lib), Main *bmain)
         light->sun_angle = 2.0f * atanf(light->area_size);
       }
     }
+
+    /* Compositor result cache. */
+    if (!DNA_struct_elem_find(fd->filesdna, "bNodeTree", "int", "cache_limit")) {
+      LISTBASE_FOREACH (Scene *, scene, &bmain->scenes) {
+        if (scene->nodetree) {
+          scene->nodetree->cache_limit = 1024;
+        }
+      }
+    }
   }
 }
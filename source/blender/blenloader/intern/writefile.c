@@ -143,6 +143,7 @@
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
 
 #include "BKE_action.h"
 #include "BKE_blender_version.h"
@@ -195,10 +196,11 @@
 
 typedef enum {
   WW_WRAP_NONE = 1,
-  WW_WRAP_ZLIB,
+  WW_WRAP_ZLIB_FRAMES,
 } eWriteWrapType;
 
 typedef struct WriteWrap WriteWrap;
+typedef struct ZlibFrameWrap ZlibFrameWrap;
 struct WriteWrap {
   /* callbacks */
   bool (*open)(WriteWrap *ww, const char *filepath);
@@ -211,7 +213,7 @@ struct WriteWrap {
   /* internal */
   union {
     int file_handle;
-    gzFile gz_handle;
+    ZlibFrameWrap *zlib_frames;
   } _user_data;
 };
 
@@ -242,33 +244,217 @@ static size_t ww_write_none(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
-/* zlib */
-#define FILE_HANDLE(ww) (ww)->_user_data.gz_handle
+/* zlib frames
+ *
+ * Data is split into frames of #BLEN_GZIP_FRAME_SIZE, which are compressed
+ * into independent gzip members by the task scheduler while the next frames
+ * are being filled. Frames are written to the file in order once all of them
+ * are compressed. See #BLEN_GZIP_FRAME_SI1 for details about the format.
+ */
 
-static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
+typedef struct ZlibFrame {
+  /** Uncompressed data, up to #BLEN_GZIP_FRAME_SIZE. */
+  uchar *data_in;
+  uint data_in_len;
+  /** Complete gzip member: header, deflate stream and trailer. */
+  uchar *data_out;
+  uint data_out_len;
+  bool error;
+} ZlibFrame;
+
+struct ZlibFrameWrap {
+  int file_handle;
+  TaskPool *task_pool;
+  ZlibFrame *frames;
+  int frames_num;
+  /** Index of the frame which is being filled, all frames before it are compressing. */
+  int frame_index;
+  bool error;
+};
+
+#define ZLIB_FRAME_COMPRESS_LEVEL 1
+#define ZLIB_FRAME_DATA_OUT_SIZE \
+  (BLEN_GZIP_FRAME_HEADER_SIZE + compressBound(BLEN_GZIP_FRAME_SIZE) + \
+   BLEN_GZIP_FRAME_TRAILER_SIZE)
+
+BLI_INLINE void zlib_frame_write_uint16(uchar *data, const uint value)
 {
-  gzFile file;
+  data[0] = (uchar)(value & 0xff);
+  data[1] = (uchar)((value >> 8) & 0xff);
+}
 
-  file = BLI_gzopen(filepath, "wb1");
+BLI_INLINE void zlib_frame_write_uint32(uchar *data, const uint value)
+{
+  zlib_frame_write_uint16(data, value & 0xffff);
+  zlib_frame_write_uint16(data + 2, value >> 16);
+}
 
-  if (file != Z_NULL) {
-    FILE_HANDLE(ww) = file;
-    return true;
+static void zlib_frame_compress_task(TaskPool *__restrict UNUSED(pool),
+                                     void *taskdata,
+                                     int UNUSED(threadid))
+{
+  ZlibFrame *frame = taskdata;
+  z_stream strm = {NULL};
+
+  if (frame->data_out == NULL) {
+    frame->data_out = MEM_mallocN(ZLIB_FRAME_DATA_OUT_SIZE, __func__);
+  }
+
+  /* Raw deflate stream, gzip header and trailer are written manually
+   * since the header needs to know the size of the compressed data. */
+  if (deflateInit2(&strm,
+                   ZLIB_FRAME_COMPRESS_LEVEL,
+                   Z_DEFLATED,
+                   -MAX_WBITS,
+                   MAX_MEM_LEVEL,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    frame->error = true;
+    return;
   }
-  else {
+
+  strm.next_in = frame->data_in;
+  strm.avail_in = frame->data_in_len;
+  strm.next_out = frame->data_out + BLEN_GZIP_FRAME_HEADER_SIZE;
+  strm.avail_out = ZLIB_FRAME_DATA_OUT_SIZE - BLEN_GZIP_FRAME_HEADER_SIZE -
+                   BLEN_GZIP_FRAME_TRAILER_SIZE;
+
+  const int ret = deflate(&strm, Z_FINISH);
+  const uint deflate_len = (uint)strm.total_out;
+  deflateEnd(&strm);
+
+  if (ret != Z_STREAM_END) {
+    frame->error = true;
+    return;
+  }
+
+  frame->data_out_len = BLEN_GZIP_FRAME_HEADER_SIZE + deflate_len + BLEN_GZIP_FRAME_TRAILER_SIZE;
+
+  /* Header: magic, deflate method, FEXTRA flag, no time-stamp, unknown OS. */
+  uchar *header = frame->data_out;
+  header[0] = 0x1f;
+  header[1] = 0x8b;
+  header[2] = Z_DEFLATED;
+  header[3] = 1 << 2;
+  zlib_frame_write_uint32(&header[4], 0);
+  header[8] = 0;
+  header[9] = 255;
+  /* Extra field with a single sub-field. */
+  zlib_frame_write_uint16(&header[10], 12);
+  header[12] = BLEN_GZIP_FRAME_SI1;
+  header[13] = BLEN_GZIP_FRAME_SI2;
+  zlib_frame_write_uint16(&header[14], 8);
+  zlib_frame_write_uint32(&header[16], frame->data_out_len);
+  zlib_frame_write_uint32(&header[20], frame->data_in_len);
+
+  uchar *trailer = frame->data_out + frame->data_out_len - BLEN_GZIP_FRAME_TRAILER_SIZE;
+  zlib_frame_write_uint32(&trailer[0], (uint)crc32(0, frame->data_in, frame->data_in_len));
+  zlib_frame_write_uint32(&trailer[4], frame->data_in_len);
+}
+
+/* Wait for all queued frames to be compressed and write them to the file. */
+static void zlib_frames_flush(ZlibFrameWrap *zfw)
+{
+  BLI_task_pool_work_wait_and_reset(zfw->task_pool);
+
+  for (int i = 0; i < zfw->frame_index; i++) {
+    ZlibFrame *frame = &zfw->frames[i];
+    if (frame->error ||
+        (uint)write(zfw->file_handle, frame->data_out, frame->data_out_len) !=
+            frame->data_out_len) {
+      zfw->error = true;
+    }
+    frame->data_in_len = 0;
+    frame->data_out_len = 0;
+  }
+  zfw->frame_index = 0;
+}
+
+static void zlib_frames_push(ZlibFrameWrap *zfw)
+{
+  BLI_task_pool_push(zfw->task_pool,
+                     zlib_frame_compress_task,
+                     &zfw->frames[zfw->frame_index],
+                     false,
+                     TASK_PRIORITY_LOW);
+  zfw->frame_index++;
+  if (zfw->frame_index == zfw->frames_num) {
+    zlib_frames_flush(zfw);
+  }
+}
+
+#define FILE_HANDLE(ww) (ww)->_user_data.zlib_frames
+
+static bool ww_open_zlib_frames(WriteWrap *ww, const char *filepath)
+{
+  int file;
+
+  file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
+
+  if (file == -1) {
     return false;
   }
+
+  TaskScheduler *scheduler = BLI_task_scheduler_get();
+  ZlibFrameWrap *zfw = MEM_callocN(sizeof(*zfw), __func__);
+  zfw->file_handle = file;
+  zfw->task_pool = BLI_task_pool_create(scheduler, zfw);
+  /* Enough frames to keep all threads busy, buffers are allocated on demand
+   * so small files don't pay for this. */
+  zfw->frames_num = BLI_task_scheduler_num_threads(scheduler);
+  zfw->frames = MEM_callocN(sizeof(*zfw->frames) * zfw->frames_num, __func__);
+
+  FILE_HANDLE(ww) = zfw;
+  return true;
 }
-static bool ww_close_zlib(WriteWrap *ww)
+static bool ww_close_zlib_frames(WriteWrap *ww)
 {
-  return (gzclose(FILE_HANDLE(ww)) == Z_OK);
+  ZlibFrameWrap *zfw = FILE_HANDLE(ww);
+
+  if (zfw->frames[zfw->frame_index].data_in_len != 0) {
+    zlib_frames_push(zfw);
+  }
+  zlib_frames_flush(zfw);
+  BLI_task_pool_free(zfw->task_pool);
+
+  for (int i = 0; i < zfw->frames_num; i++) {
+    MEM_SAFE_FREE(zfw->frames[i].data_in);
+    MEM_SAFE_FREE(zfw->frames[i].data_out);
+  }
+  MEM_freeN(zfw->frames);
+
+  const bool ok = (close(zfw->file_handle) != -1) && !zfw->error;
+  MEM_freeN(zfw);
+
+  return ok;
 }
-static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
+static size_t ww_write_zlib_frames(WriteWrap *ww, const char *buf, size_t buf_len)
 {
-  return gzwrite(FILE_HANDLE(ww), buf, buf_len);
+  ZlibFrameWrap *zfw = FILE_HANDLE(ww);
+  size_t written_len = 0;
+
+  while (written_len < buf_len) {
+    ZlibFrame *frame = &zfw->frames[zfw->frame_index];
+    if (frame->data_in == NULL) {
+      frame->data_in = MEM_mallocN(BLEN_GZIP_FRAME_SIZE, __func__);
+    }
+
+    const size_t len = MIN2(buf_len - written_len, BLEN_GZIP_FRAME_SIZE - frame->data_in_len);
+    memcpy(frame->data_in + frame->data_in_len, buf + written_len, len);
+    frame->data_in_len += (uint)len;
+    written_len += len;
+
+    if (frame->data_in_len == BLEN_GZIP_FRAME_SIZE) {
+      zlib_frames_push(zfw);
+    }
+  }
+
+  return zfw->error ? 0 : buf_len;
 }
 #undef FILE_HANDLE
 
+#undef ZLIB_FRAME_COMPRESS_LEVEL
+#undef ZLIB_FRAME_DATA_OUT_SIZE
+
 /* --- end compression types --- */
 
 static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
@@ -276,10 +462,10 @@ static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
   memset(r_ww, 0, sizeof(*r_ww));
 
   switch (ww_type) {
-    case WW_WRAP_ZLIB: {
-      r_ww->open = ww_open_zlib;
-      r_ww->close = ww_close_zlib;
-      r_ww->write = ww_write_zlib;
+    case WW_WRAP_ZLIB_FRAMES: {
+      r_ww->open = ww_open_zlib_frames;
+      r_ww->close = ww_close_zlib_frames;
+      r_ww->write = ww_write_zlib_frames;
       r_ww->use_buf = false;
       break;
     }
@@ -316,12 +502,7 @@ typedef struct {
   bool error;
 
   /** #MemFile writing (used for undo). */
-  struct {
-    MemFile *current;
-    MemFile *compare;
-    /** Use to de-duplicate chunks when writing. */
-    MemFileChunk *compare_chunk;
-  } mem;
+  MemFileWriteData mem;
   /** When true, write to #WriteData.current, could also call 'is_undo'. */
   bool use_memfile;
 
@@ -360,7 +541,7 @@ static void writedata_do_write(WriteData *wd, const void *mem, int memlen)
 
   /* memory based save */
   if (wd->use_memfile) {
-    memfile_chunk_add(wd->mem.current, mem, memlen, &wd->mem.compare_chunk);
+    BLO_memfile_chunk_add(&wd->mem, mem, memlen);
   }
   else {
     if (wd->ww->write(wd->ww, mem, memlen) != memlen) {
@@ -395,6 +576,26 @@ static void mywrite_flush(WriteData *wd)
   }
 }
 
+/**
+ * Undo writes each data-block in its own chunks, so reading the undo step
+ * can tell which data-blocks changed (see #BLO_memfile_identical_ids_get).
+ */
+static void mywrite_id_begin(WriteData *wd, ID *id)
+{
+  if (wd->use_memfile) {
+    mywrite_flush(wd);
+    wd->mem.current_id = id;
+  }
+}
+
+static void mywrite_id_end(WriteData *wd, ID *UNUSED(id))
+{
+  if (wd->use_memfile) {
+    mywrite_flush(wd);
+    wd->mem.current_id = NULL;
+  }
+}
+
 /**
  * Low level WRITE(2) wrapper that buffers data
  * \param adr: Pointer to new chunk of data
@@ -461,9 +662,7 @@ static WriteData *mywrite_begin(WriteWrap *ww, MemFile *compare, MemFile *curren
   WriteData *wd = writedata_new(ww);
 
   if (current != NULL) {
-    wd->mem.current = current;
-    wd->mem.compare = compare;
-    wd->mem.compare_chunk = compare ? compare->chunks.first : NULL;
+    BLO_memfile_write_init(&wd->mem, current, compare);
     wd->use_memfile = true;
   }
 
@@ -3805,6 +4004,8 @@ static bool write_file_handle(Main *mainvar,
           BKE_override_static_operations_store_start(bmain, override_storage, id);
         }
 
+        mywrite_id_begin(wd, id);
+
         switch ((ID_Type)GS(id->name)) {
           case ID_WM:
             write_windowmanager(wd, (wmWindowManager *)id);
@@ -3921,6 +4122,8 @@ static bool write_file_handle(Main *mainvar,
             break;
         }
 
+        mywrite_id_end(wd, id);
+
         if (do_override) {
           BKE_override_static_operations_store_end(override_storage, id);
         }
@@ -4036,7 +4239,7 @@ bool BLO_write_file(Main *mainvar,
   BLI_snprintf(tempname, sizeof(tempname), "%s@", filepath);
 
   if (write_flags & G_FILE_COMPRESS) {
-    ww_type = WW_WRAP_ZLIB;
+    ww_type = WW_WRAP_ZLIB_FRAMES;
   }
   else {
     ww_type = WW_WRAP_NONE;
@@ -4086,9 +4289,12 @@ bool BLO_write_file(Main *mainvar,
   }
 
   /* actual file writing */
-  const bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, thumb);
+  bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, thumb);
 
-  ww.close(&ww);
+  /* Compressed writing might still have pending data to write. */
+  if (ww.close(&ww) == false) {
+    err = true;
+  }
 
   if (UNLIKELY(path_list_backup)) {
     BKE_bpath_list_restore(mainvar, path_list_flag, path_list_backup);
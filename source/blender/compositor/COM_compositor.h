@@ -153,48 +153,15 @@ extern "C" {
  *
  * In the above example ExecutionGroup B has an outputoperation (ViewerOperation)
  * and is being executed.
- * The first chunk is evaluated [@ref ExecutionGroup.scheduleChunkWhenPossible],
- * but not all input chunks are available.
- * The relevant ExecutionGroup (that can calculate the missing chunks; ExecutionGroup A)
- * is asked to calculate the area ExecutionGroup B is missing.
- * [@ref ExecutionGroup.scheduleAreaWhenPossible]
- * ExecutionGroup B checks what chunks the area spans, and tries to schedule these chunks.
- * If all input data is available these chunks are scheduled [@ref ExecutionGroup.scheduleChunk]
+ * Before any chunk is scheduled a ChunkGraph is built [@ref ChunkGraph.addChunk].
+ * For every chunk of ExecutionGroup B the area it needs of ExecutionGroup A is determined,
+ * and ExecutionGroup A checks what chunks the area spans
+ * [@ref ExecutionGroup.determineChunksInArea]. These chunks are added to the graph as inputs
+ * of the chunk of ExecutionGroup B, recursively for the inputs of ExecutionGroup A.
  *
- * <pre>
- *
- * +-------------------------+        +----------------+                           +----------------+
- * | ExecutionSystem.execute |        | ExecutionGroup |                           | ExecutionGroup |
- * +-------------------------+        | (B)            |                           | (A)            |
- *            O                       +----------------+                           +----------------+
- *            O                                |                                            |
- *            O       ExecutionGroup.execute   |                                            |
- *            O------------------------------->O                                            |
- *            .                                O                                            |
- *            .                                O-------\                                    |
- *            .                                .       | ExecutionGroup.scheduleChunkWhenPossible
- *            .                                .  O----/ (*)                                |
- *            .                                .  O                                         |
- *            .                                .  O                                         |
- *            .                                .  O  ExecutionGroup.scheduleAreaWhenPossible|
- *            .                                .  O---------------------------------------->O
- *            .                                .  .                                         O----------\ ExecutionGroup.scheduleChunkWhenPossible
- *            .                                .  .                                         .          | (*)
- *            .                                .  .                                         .  O-------/
- *            .                                .  .                                         .  O
- *            .                                .  .                                         .  O
- *            .                                .  .                                         .  O-------\ ExecutionGroup.scheduleChunk
- *            .                                .  .                                         .  .       |
- *            .                                .  .                                         .  .  O----/
- *            .                                .  .                                         .  O<=O
- *            .                                .  .                                         O<=O
- *            .                                .  .                                         O
- *            .                                .  O<========================================O
- *            .                                .  O                                         |
- *            .                                O<=O                                         |
- *            .                                O                                            |
- *            .                                O                                            |
- * </pre>
+ * All chunks without inputs are scheduled [@ref ExecutionGroup.scheduleChunk].
+ * When a chunk is executed, the chunks depending on it that have no more pending inputs are
+ * scheduled by the thread that executed it [@ref ChunkGraph.chunkExecuted].
  *
  * This happens until all chunks of (ExecutionGroup B) are finished executing or the user break's the process.
  *
@@ -222,11 +189,8 @@ extern "C" {
  *
  * \see ExecutionGroup.execute Execute a complete ExecutionGroup.
  * Halts until finished or breaked by user
- * \see ExecutionGroup.scheduleChunkWhenPossible Tries to schedule a single chunk,
- * checks if all input data is available. Can trigger dependent chunks to be calculated
- * \see ExecutionGroup.scheduleAreaWhenPossible
- * Tries to schedule an area. This can be multiple chunks
- * (is called from [@ref ExecutionGroup.scheduleChunkWhenPossible])
+ * \see ChunkGraph Dependencies between the chunks of all ExecutionGroups that are needed
+ * \see ExecutionGroup.determineChunksInArea Determine the chunks an area spans.
  * \see ExecutionGroup.scheduleChunk Schedule a chunk on the WorkScheduler
  * \see NodeOperation.determineDependingAreaOfInterest Influence the area of interest of a chunk.
  * \see WriteBufferOperation Operation to write to a MemoryProxy/MemoryBuffer
@@ -243,9 +207,10 @@ extern "C" {
  *
  * \subsection multithread Multi threaded
  * Default the work-scheduler will place all work as WorkPackage in a queue.
- * For every CPUcore a working thread is created.
- * These working threads will ask the WorkScheduler if there is work
- * for a specific Device.
+ * For every CPUcore a working thread is created, each with its own queue.
+ * Work scheduled by a working thread (chunks that became ready when it finished a chunk)
+ * is placed in its own queue and executed next by the same thread.
+ * A working thread without work steals work from the queues of the other threads.
  * the work-scheduler will find work for the device and the device
  * will be asked to execute the WorkPackage.
  *
@@ -360,7 +325,7 @@ void COM_deinitialize(void);
  * \brief Clear all compositor caches. (Compositor system will still remain available).
  * To deinitialize the compositor use the COM_deinitialize method.
  */
-// void COM_clearCaches(void); // NOT YET WRITTEN
+void COM_clearCaches(void);
 
 #ifdef __cplusplus
 }
@@ -109,4 +109,11 @@ typedef enum OrderOfChunks {
 
 #define COM_BLUR_BOKEH_PIXELS 512
 
+/**
+ * \brief Maximum number of pixels computed at once with row execution
+ * Operations keep their input rows on the stack, so this is kept small.
+ * \see SocketReader.executeRow
+ */
+#define COM_ROW_LENGTH 64
+
 #endif /* __COM_DEFINES_H__ */
@@ -0,0 +1,171 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2011, Blender Foundation.
+ */
+
+#include "COM_ChunkGraph.h"
+#include "COM_ExecutionGroup.h"
+#include "COM_ReadBufferOperation.h"
+
+#include "atomic_ops.h"
+
+#include "BLI_rect.h"
+
+ChunkGraph::ChunkGraph()
+{
+  this->m_numRemaining = 0;
+  this->m_cancelled = false;
+  BLI_mutex_init(&this->m_mutex);
+  BLI_condition_init(&this->m_condition);
+}
+
+ChunkGraph::~ChunkGraph()
+{
+  for (GroupChunks::iterator it = this->m_groupChunks.begin(); it != this->m_groupChunks.end();
+       ++it) {
+    ExecutionGroup *group = (ExecutionGroup *)it->first;
+    group->m_chunkGraph = NULL;
+  }
+  for (unsigned int index = 0; index < this->m_chunks.size(); index++) {
+    delete this->m_chunks[index];
+  }
+  BLI_condition_end(&this->m_condition);
+  BLI_mutex_end(&this->m_mutex);
+}
+
+ChunkGraph::Chunk *ChunkGraph::addChunk(ExecutionGroup *group, unsigned int chunkNumber)
+{
+  if (group->m_chunkExecutionStates[chunkNumber] == COM_ES_EXECUTED) {
+    return NULL;
+  }
+
+  std::vector<Chunk *> &groupChunks = this->m_groupChunks[group];
+  if (groupChunks.empty()) {
+    groupChunks.resize(group->m_numberOfChunks, NULL);
+    group->m_chunkGraph = this;
+  }
+  if (groupChunks[chunkNumber]) {
+    return groupChunks[chunkNumber];
+  }
+
+  Chunk *chunk = new Chunk();
+  chunk->group = group;
+  chunk->chunkNumber = chunkNumber;
+  chunk->numPendingInputs = 0;
+  groupChunks[chunkNumber] = chunk;
+
+  rcti rect;
+  group->determineChunkRect(&rect, chunkNumber);
+
+  vector<unsigned int> inputChunkNumbers;
+  for (unsigned int index = 0; index < group->m_cachedReadOperations.size(); index++) {
+    ReadBufferOperation *readOperation =
+        (ReadBufferOperation *)group->m_cachedReadOperations[index];
+    ExecutionGroup *inputGroup = readOperation->getMemoryProxy()->getExecutor();
+    if (inputGroup == NULL) {
+      throw "ERROR";
+    }
+
+    rcti area;
+    BLI_rcti_init(&area, 0, 0, 0, 0);
+    group->determineDependingAreaOfInterest(&rect, readOperation, &area);
+
+    inputChunkNumbers.clear();
+    inputGroup->determineChunksInArea(&area, &inputChunkNumbers);
+
+    for (unsigned int i = 0; i < inputChunkNumbers.size(); i++) {
+      Chunk *input = addChunk(inputGroup, inputChunkNumbers[i]);
+      /* Several read operations can need the same input chunk, only count it once.
+       * Edges into an input chunk are only added while its output chunk is being
+       * added, so a duplicate is always the last output. */
+      if (input && (input->outputs.empty() || input->outputs.back() != chunk)) {
+        input->outputs.push_back(chunk);
+        chunk->numPendingInputs++;
+      }
+    }
+  }
+
+  this->m_chunks.push_back(chunk);
+  this->m_numRemaining++;
+
+  return chunk;
+}
+
+void ChunkGraph::scheduleChunk(Chunk *chunk)
+{
+  if (this->m_cancelled) {
+    return;
+  }
+  chunk->group->scheduleChunk(chunk->chunkNumber);
+}
+
+void ChunkGraph::schedule()
+{
+  /* Collect the ready chunks first, scheduled chunks can finish and change the graph
+   * while iterating. */
+  vector<Chunk *> ready;
+  for (unsigned int index = 0; index < this->m_chunks.size(); index++) {
+    Chunk *chunk = this->m_chunks[index];
+    if (chunk->numPendingInputs == 0) {
+      ready.push_back(chunk);
+    }
+  }
+  for (unsigned int index = 0; index < ready.size(); index++) {
+    scheduleChunk(ready[index]);
+  }
+}
+
+void ChunkGraph::chunkExecuted(const ExecutionGroup *group, unsigned int chunkNumber)
+{
+  GroupChunks::iterator it = this->m_groupChunks.find(group);
+  if (it == this->m_groupChunks.end()) {
+    return;
+  }
+  Chunk *chunk = it->second[chunkNumber];
+  if (chunk == NULL) {
+    return;
+  }
+
+  for (unsigned int index = 0; index < chunk->outputs.size(); index++) {
+    Chunk *output = chunk->outputs[index];
+    if (atomic_sub_and_fetch_int32(&output->numPendingInputs, 1) == 0) {
+      scheduleChunk(output);
+    }
+  }
+
+  BLI_mutex_lock(&this->m_mutex);
+  this->m_numRemaining--;
+  BLI_condition_notify_all(&this->m_condition);
+  BLI_mutex_unlock(&this->m_mutex);
+}
+
+bool ChunkGraph::waitForProgress()
+{
+  BLI_mutex_lock(&this->m_mutex);
+  if (this->m_numRemaining > 0) {
+    BLI_condition_wait(&this->m_condition, &this->m_mutex);
+  }
+  const bool remaining = this->m_numRemaining > 0;
+  BLI_mutex_unlock(&this->m_mutex);
+  return remaining;
+}
+
+void ChunkGraph::cancel()
+{
+  BLI_mutex_lock(&this->m_mutex);
+  this->m_cancelled = true;
+  BLI_mutex_unlock(&this->m_mutex);
+}
@@ -0,0 +1,144 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2011, Blender Foundation.
+ */
+
+#ifndef __COM_CHUNKGRAPH_H__
+#define __COM_CHUNKGRAPH_H__
+
+#include <map>
+#include <vector>
+
+extern "C" {
+#include "BLI_threads.h"
+}
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#  include "MEM_guardedalloc.h"
+#endif
+
+class ExecutionGroup;
+class ExecutionSystem;
+
+/**
+ * \brief Dependency graph of the chunks needed to compute the output of an ExecutionGroup.
+ *
+ * The graph is built up front, before any chunk is scheduled. For every chunk the areas of
+ * interest of its ReadBufferOperations determine the chunks of the input ExecutionGroups
+ * it needs, recursively. Chunks that have no pending inputs are scheduled right away; all
+ * other chunks are scheduled by the thread that finishes their last input chunk.
+ * \ingroup Execution
+ */
+class ChunkGraph {
+ public:
+  /**
+   * \brief a single chunk of an ExecutionGroup in the graph
+   */
+  typedef struct Chunk {
+    ExecutionGroup *group;
+    unsigned int chunkNumber;
+    /**
+     * \brief number of input chunks that are not executed yet
+     */
+    int numPendingInputs;
+    /**
+     * \brief chunks that depend on this chunk
+     */
+    std::vector<Chunk *> outputs;
+
+#ifdef WITH_CXX_GUARDEDALLOC
+    MEM_CXX_CLASS_ALLOC_FUNCS("COM:ChunkGraph::Chunk")
+#endif
+  } Chunk;
+
+ private:
+  typedef std::map<const ExecutionGroup *, std::vector<Chunk *>> GroupChunks;
+
+  /**
+   * \brief all chunks in the graph, in the order they were added
+   */
+  std::vector<Chunk *> m_chunks;
+
+  /**
+   * \brief per ExecutionGroup lookup of the chunks in the graph by chunk number
+   */
+  GroupChunks m_groupChunks;
+
+  /**
+   * \brief number of chunks in the graph that are not executed yet
+   */
+  int m_numRemaining;
+
+  /**
+   * \brief when set, chunks that become ready are not scheduled anymore
+   */
+  bool m_cancelled;
+
+  ThreadMutex m_mutex;
+  ThreadCondition m_condition;
+
+  /**
+   * \brief schedule a chunk whose inputs are all executed
+   */
+  void scheduleChunk(Chunk *chunk);
+
+ public:
+  ChunkGraph();
+  ~ChunkGraph();
+
+  /**
+   * \brief add a chunk and all the input chunks it depends on to the graph
+   * \return the chunk in the graph, NULL when the chunk was executed before
+   */
+  Chunk *addChunk(ExecutionGroup *group, unsigned int chunkNumber);
+
+  /**
+   * \brief schedule all chunks that do not have pending inputs
+   */
+  void schedule();
+
+  /**
+   * \brief called by ExecutionGroup.finalizeChunkExecution when a chunk is executed
+   * schedules the chunks that depend on it once all their inputs are executed.
+   * \note called from the device threads
+   */
+  void chunkExecuted(const ExecutionGroup *group, unsigned int chunkNumber);
+
+  /**
+   * \brief wait until at least one more chunk has been executed
+   * \return false when all chunks in the graph are executed
+   */
+  bool waitForProgress();
+
+  /**
+   * \brief stop scheduling chunks, already scheduled chunks still run
+   */
+  void cancel();
+
+  /**
+   * \brief number of chunks in the graph
+   */
+  unsigned int getNumberOfChunks() const
+  {
+    return this->m_chunks.size();
+  }
+
+#ifdef WITH_CXX_GUARDEDALLOC
+  MEM_CXX_CLASS_ALLOC_FUNCS("COM:ChunkGraph")
+#endif
+};
+
+#endif /* __COM_CHUNKGRAPH_H__ */
@@ -29,6 +29,7 @@ extern "C" {
 #  include "BLI_fileops.h"
 #  include "BLI_path_util.h"
 #  include "BLI_string.h"
+#  include "BLI_threads.h"
 
 #  include "DNA_node_types.h"
 #  include "BKE_appdir.h"
@@ -49,6 +50,8 @@ DebugInfo::OpNameMap DebugInfo::m_op_names;
 std::string DebugInfo::m_current_node_name;
 std::string DebugInfo::m_current_op_name;
 DebugInfo::GroupStateMap DebugInfo::m_group_states;
+DebugInfo::GroupTimingMap DebugInfo::m_group_timings;
+static ThreadMutex g_group_timings_mutex = BLI_MUTEX_INITIALIZER;
 
 std::string DebugInfo::node_name(const Node *node)
 {
@@ -81,10 +84,27 @@ void DebugInfo::execute_started(const ExecutionSystem *system)
 {
   m_file_index = 1;
   m_group_states.clear();
+  m_group_timings.clear();
   for (ExecutionSystem::Groups::const_iterator it = system->m_groups.begin();
        it != system->m_groups.end();
        ++it) {
     m_group_states[*it] = EG_WAIT;
+    m_group_timings[*it].num_chunks = 0;
+    m_group_timings[*it].time = 0.0;
+  }
+}
+
+void DebugInfo::execute_finished(const ExecutionSystem *system)
+{
+  int totgroups = system->m_groups.size();
+  for (int i = 0; i < totgroups; ++i) {
+    const ExecutionGroup *group = system->m_groups[i];
+    const GroupTiming &timing = m_group_timings[group];
+    printf("Compositor group %d (%s): %d chunks, %.4f s\n",
+           i,
+           operation_name(group->getOutputOperation()).c_str(),
+           timing.num_chunks,
+           timing.time);
   }
 }
 
@@ -118,6 +138,18 @@ void DebugInfo::execution_group_finished(const ExecutionGroup *group)
   m_group_states[group] = EG_FINISHED;
 }
 
+void DebugInfo::chunk_executed(const ExecutionGroup *group, double time)
+{
+  /* Called from the device threads, the map itself is filled in execute_started. */
+  BLI_mutex_lock(&g_group_timings_mutex);
+  GroupTimingMap::iterator it = m_group_timings.find(group);
+  if (it != m_group_timings.end()) {
+    it->second.num_chunks++;
+    it->second.time += time;
+  }
+  BLI_mutex_unlock(&g_group_timings_mutex);
+}
+
 int DebugInfo::graphviz_operation(const ExecutionSystem *system,
                                   const NodeOperation *operation,
                                   const ExecutionGroup *group,
@@ -340,6 +372,11 @@ bool DebugInfo::graphviz_system(const ExecutionSystem *system, char *str, int ma
 
     len += snprintf(str + len, maxlen > len ? maxlen - len : 0, "// GROUP: %d\r\n", i);
     len += snprintf(str + len, maxlen > len ? maxlen - len : 0, "subgraph cluster_%d{\r\n", i);
+    len += snprintf(str + len,
+                    maxlen > len ? maxlen - len : 0,
+                    "label=\"%d chunks, %.4f s\"\r\n",
+                    m_group_timings[group].num_chunks,
+                    m_group_timings[group].time);
     /* used as a check for executing group */
     if (m_group_states[group] == EG_WAIT) {
       len += snprintf(str + len, maxlen > len ? maxlen - len : 0, "style=dashed\r\n");
@@ -507,6 +544,9 @@ void DebugInfo::convert_started()
 void DebugInfo::execute_started(const ExecutionSystem * /*system*/)
 {
 }
+void DebugInfo::execute_finished(const ExecutionSystem * /*system*/)
+{
+}
 void DebugInfo::node_added(const Node * /*node*/)
 {
 }
@@ -525,6 +565,9 @@ void DebugInfo::execution_group_started(const ExecutionGroup * /*group*/)
 void DebugInfo::execution_group_finished(const ExecutionGroup * /*group*/)
 {
 }
+void DebugInfo::chunk_executed(const ExecutionGroup * /*group*/, double /*time*/)
+{
+}
 void DebugInfo::graphviz(const ExecutionSystem * /*system*/)
 {
 }
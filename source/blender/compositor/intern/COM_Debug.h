@@ -37,11 +37,19 @@ class DebugInfo {
   typedef std::map<const NodeOperation *, std::string> OpNameMap;
   typedef std::map<const ExecutionGroup *, GroupState> GroupStateMap;
 
+  /** Time spent executing the chunks of a group, accumulated over all threads. */
+  typedef struct GroupTiming {
+    int num_chunks;
+    double time;
+  } GroupTiming;
+  typedef std::map<const ExecutionGroup *, GroupTiming> GroupTimingMap;
+
   static std::string node_name(const Node *node);
   static std::string operation_name(const NodeOperation *op);
 
   static void convert_started();
   static void execute_started(const ExecutionSystem *system);
+  static void execute_finished(const ExecutionSystem *system);
 
   static void node_added(const Node *node);
   static void node_to_operations(const Node *node);
@@ -50,6 +58,7 @@ class DebugInfo {
 
   static void execution_group_started(const ExecutionGroup *group);
   static void execution_group_finished(const ExecutionGroup *group);
+  static void chunk_executed(const ExecutionGroup *group, double time);
 
   static void graphviz(const ExecutionSystem *system);
 
@@ -75,6 +84,7 @@ class DebugInfo {
   static std::string m_current_node_name; /**< base name for all operations added by a node */
   static std::string m_current_op_name;   /**< base name for automatic sub-operations */
   static GroupStateMap m_group_states;    /**< for visualizing group states */
+  static GroupTimingMap m_group_timings;  /**< per group execution time */
 #endif
 };
 
@@ -18,12 +18,15 @@
 
 #include <algorithm>
 #include <math.h>
+#include <map>
 #include <sstream>
 #include <stdlib.h>
+#include <typeinfo>
 
 #include "atomic_ops.h"
 
 #include "COM_ExecutionGroup.h"
+#include "COM_ChunkGraph.h"
 #include "COM_defines.h"
 #include "COM_ExecutionSystem.h"
 #include "COM_ReadBufferOperation.h"
@@ -32,6 +35,7 @@
 #include "COM_ViewerOperation.h"
 #include "COM_ChunkOrder.h"
 #include "COM_Debug.h"
+#include "COM_ResultCache.h"
 
 #include "MEM_guardedalloc.h"
 #include "BLI_math.h"
@@ -59,6 +63,10 @@ ExecutionGroup::ExecutionGroup()
   this->m_chunksFinished = 0;
   BLI_rcti_init(&this->m_viewerBorder, 0, 0, 0, 0);
   this->m_executionStartTime = 0;
+  this->m_chunkGraph = NULL;
+  this->m_cacheKey = 0;
+  this->m_cacheKeyDetermined = false;
+  this->m_restoredFromCache = false;
 }
 
 CompositorPriority ExecutionGroup::getRenderPriotrity()
@@ -148,6 +156,10 @@ void ExecutionGroup::initExecution()
   }
   maxNumber++;
   this->m_cachedMaxReadBufferOffset = maxNumber;
+
+  this->m_cacheKey = 0;
+  this->m_cacheKeyDetermined = false;
+  this->m_restoredFromCache = false;
 }
 
 void ExecutionGroup::deinitExecution()
@@ -322,49 +334,28 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
   DebugInfo::execution_group_started(this);
   DebugInfo::graphviz(graph);
 
-  bool breaked = false;
-  bool finished = false;
-  unsigned int startIndex = 0;
-  const int maxNumberEvaluated = BLI_system_thread_count() * 2;
-
-  while (!finished && !breaked) {
-    bool startEvaluated = false;
-    finished = true;
-    int numberEvaluated = 0;
-
-    for (index = startIndex;
-         index < this->m_numberOfChunks && numberEvaluated < maxNumberEvaluated;
-         index++) {
-      chunkNumber = chunkOrder[index];
-      int yChunk = chunkNumber / this->m_numberOfXChunks;
-      int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
-      const ChunkExecutionState state = this->m_chunkExecutionStates[chunkNumber];
-      if (state == COM_ES_NOT_SCHEDULED) {
-        scheduleChunkWhenPossible(graph, xChunk, yChunk);
-        finished = false;
-        startEvaluated = true;
-        numberEvaluated++;
-
-        if (bTree->update_draw) {
-          bTree->update_draw(bTree->udh);
-        }
-      }
-      else if (state == COM_ES_SCHEDULED) {
-        finished = false;
-        startEvaluated = true;
-        numberEvaluated++;
-      }
-      else if (state == COM_ES_EXECUTED && !startEvaluated) {
-        startIndex = index + 1;
-      }
-    }
-
-    WorkScheduler::finish();
+  /* Build the dependency graph of all chunks up front, chunks of the input groups are
+   * scheduled as soon as their own inputs are executed instead of being discovered when a
+   * chunk of this group is about to be scheduled. */
+  ChunkGraph chunkGraph;
+  for (index = 0; index < this->m_numberOfChunks; index++) {
+    chunkGraph.addChunk(this, chunkOrder[index]);
+  }
+  chunkGraph.schedule();
 
+  while (chunkGraph.waitForProgress()) {
+    if (bTree->update_draw) {
+      bTree->update_draw(bTree->udh);
+    }
     if (bTree->test_break && bTree->test_break(bTree->tbh)) {
-      breaked = true;
+      chunkGraph.cancel();
+      break;
     }
   }
+
+  /* Wait for chunks that were already scheduled when cancelled. */
+  WorkScheduler::finish();
+
   DebugInfo::execution_group_finished(this);
   DebugInfo::graphviz(graph);
 
@@ -436,6 +427,10 @@ void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memo
                  this->m_numberOfChunks);
     this->m_bTree->stats_draw(this->m_bTree->sdh, buf);
   }
+
+  if (this->m_chunkGraph) {
+    this->m_chunkGraph->chunkExecuted(this, chunkNumber);
+  }
 }
 
 inline void ExecutionGroup::determineChunkRect(rcti *rect,
@@ -481,10 +476,12 @@ MemoryBuffer *ExecutionGroup::allocateOutputBuffer(int /*chunkNumber*/, rcti *re
   return NULL;
 }
 
-bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area)
+void ExecutionGroup::determineChunksInArea(const rcti *area,
+                                           vector<unsigned int> *chunkNumbers) const
 {
   if (this->m_singleThreaded) {
-    return scheduleChunkWhenPossible(graph, 0, 0);
+    chunkNumbers->push_back(0);
+    return;
   }
   // find all chunks inside the rect
   // determine minxchunk, minychunk, maxxchunk, maxychunk where x and y are chunknumbers
@@ -503,16 +500,11 @@ bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area
   maxxchunk = min_ii(maxxchunk, (int)m_numberOfXChunks);
   maxychunk = min_ii(maxychunk, (int)m_numberOfYChunks);
 
-  bool result = true;
-  for (indexx = minxchunk; indexx < maxxchunk; indexx++) {
-    for (indexy = minychunk; indexy < maxychunk; indexy++) {
-      if (!scheduleChunkWhenPossible(graph, indexx, indexy)) {
-        result = false;
-      }
+  for (indexy = minychunk; indexy < maxychunk; indexy++) {
+    for (indexx = minxchunk; indexx < maxxchunk; indexx++) {
+      chunkNumbers->push_back(indexy * this->m_numberOfXChunks + indexx);
     }
   }
-
-  return result;
 }
 
 bool ExecutionGroup::scheduleChunk(unsigned int chunkNumber)
@@ -525,75 +517,129 @@ bool ExecutionGroup::scheduleChunk(unsigned int chunkNumber)
   return false;
 }
 
-bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk)
+void ExecutionGroup::determineDependingAreaOfInterest(rcti *input,
+                                                      ReadBufferOperation *readOperation,
+                                                      rcti *output)
 {
-  if (xChunk < 0 || xChunk >= (int)this->m_numberOfXChunks) {
-    return true;
+  this->getOutputOperation()->determineDependingAreaOfInterest(input, readOperation, output);
+}
+
+void ExecutionGroup::determineDependingMemoryProxies(vector<MemoryProxy *> *memoryProxies)
+{
+  unsigned int index;
+  for (index = 0; index < this->m_cachedReadOperations.size(); index++) {
+    ReadBufferOperation *readOperation =
+        (ReadBufferOperation *)this->m_cachedReadOperations[index];
+    memoryProxies->push_back(readOperation->getMemoryProxy());
   }
-  if (yChunk < 0 || yChunk >= (int)this->m_numberOfYChunks) {
-    return true;
+}
+
+uint64_t ExecutionGroup::determineCacheKey(const CompositorContext &context)
+{
+  if (this->m_cacheKeyDetermined) {
+    return this->m_cacheKey;
   }
-  int chunkNumber = yChunk * this->m_numberOfXChunks + xChunk;
-  // chunk is already executed
-  if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_EXECUTED) {
-    return true;
+  this->m_cacheKeyDetermined = true;
+  this->m_cacheKey = 0;
+
+  /* Output groups are cheap compared to their inputs and can have side effects. */
+  if (this->m_isOutput || !this->getOutputOperation()->isWriteBufferOperation()) {
+    return 0;
   }
 
-  // chunk is scheduled, but not executed
-  if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_SCHEDULED) {
-    return false;
+  ResultCacheKey key;
+  key.addPointer(context.getScene());
+  key.addInt(context.getFramenumber());
+  key.addInt(context.getQuality());
+  key.addInt(context.isFastCalculation());
+  key.addString(context.getViewName() ? context.getViewName() : "");
+  key.addInt(this->m_width);
+  key.addInt(this->m_height);
+  key.add(&this->m_viewerBorder, sizeof(this->m_viewerBorder));
+
+  /* Links are identified by the index of the operation in this group. */
+  std::map<const NodeOperation *, int> indices;
+  for (unsigned int index = 0; index < this->m_operations.size(); index++) {
+    indices[this->m_operations[index]] = index;
   }
 
-  // chunk is nor executed nor scheduled.
-  vector<MemoryProxy *> memoryProxies;
-  this->determineDependingMemoryProxies(&memoryProxies);
+  for (unsigned int index = 0; index < this->m_operations.size(); index++) {
+    NodeOperation *operation = this->m_operations[index];
+    const uint64_t nodeHash = operation->getNodeHash();
 
-  rcti rect;
-  determineChunkRect(&rect, xChunk, yChunk);
-  unsigned int index;
-  bool canBeExecuted = true;
-  rcti area;
+    if (!operation->isNodeCacheable()) {
+      return 0;
+    }
 
-  for (index = 0; index < this->m_cachedReadOperations.size(); index++) {
-    ReadBufferOperation *readOperation =
-        (ReadBufferOperation *)this->m_cachedReadOperations[index];
-    BLI_rcti_init(&area, 0, 0, 0, 0);
-    MemoryProxy *memoryProxy = memoryProxies[index];
-    determineDependingAreaOfInterest(&rect, readOperation, &area);
-    ExecutionGroup *group = memoryProxy->getExecutor();
-
-    if (group != NULL) {
-      if (!group->scheduleAreaWhenPossible(graph, &area)) {
-        canBeExecuted = false;
+    key.addString(typeid(*operation).name());
+    key.add(&nodeHash, sizeof(nodeHash));
+    key.addInt(operation->getWidth());
+    key.addInt(operation->getHeight());
+
+    for (unsigned int i = 0; i < operation->getNumberOfInputSockets(); i++) {
+      NodeOperationOutput *link = operation->getInputSocket(i)->getLink();
+      if (link == NULL) {
+        key.addInt(-1);
+        continue;
+      }
+      NodeOperation *linkOperation = &link->getOperation();
+      std::map<const NodeOperation *, int>::const_iterator it = indices.find(linkOperation);
+      key.addInt(it != indices.end() ? it->second : -2);
+      for (unsigned int j = 0; j < linkOperation->getNumberOfOutputSockets(); j++) {
+        if (linkOperation->getOutputSocket(j) == link) {
+          key.addInt(j);
+          break;
+        }
       }
     }
-    else {
-      throw "ERROR";
-    }
-  }
 
-  if (canBeExecuted) {
-    scheduleChunk(chunkNumber);
+    if (operation->isReadBufferOperation()) {
+      ReadBufferOperation *readOperation = (ReadBufferOperation *)operation;
+      ExecutionGroup *inputGroup = readOperation->getMemoryProxy()->getExecutor();
+      const uint64_t inputKey = inputGroup ? inputGroup->determineCacheKey(context) : 0;
+      if (inputKey == 0) {
+        return 0;
+      }
+      key.add(&inputKey, sizeof(inputKey));
+    }
   }
 
-  return false;
+  this->m_cacheKey = key.end();
+  return this->m_cacheKey;
 }
 
-void ExecutionGroup::determineDependingAreaOfInterest(rcti *input,
-                                                      ReadBufferOperation *readOperation,
-                                                      rcti *output)
+bool ExecutionGroup::restoreFromCache()
 {
-  this->getOutputOperation()->determineDependingAreaOfInterest(input, readOperation, output);
+  if (this->m_cacheKey == 0 || this->m_numberOfChunks == 0) {
+    return false;
+  }
+
+  WriteBufferOperation *writeOperation = (WriteBufferOperation *)this->getOutputOperation();
+  if (!ResultCache::restore(this->m_cacheKey, writeOperation->getMemoryProxy())) {
+    return false;
+  }
+
+  for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+    this->m_chunkExecutionStates[index] = COM_ES_EXECUTED;
+  }
+  this->m_restoredFromCache = true;
+  return true;
 }
 
-void ExecutionGroup::determineDependingMemoryProxies(vector<MemoryProxy *> *memoryProxies)
+void ExecutionGroup::storeInCache()
 {
-  unsigned int index;
-  for (index = 0; index < this->m_cachedReadOperations.size(); index++) {
-    ReadBufferOperation *readOperation =
-        (ReadBufferOperation *)this->m_cachedReadOperations[index];
-    memoryProxies->push_back(readOperation->getMemoryProxy());
+  if (this->m_cacheKey == 0 || this->m_restoredFromCache || this->m_numberOfChunks == 0) {
+    return;
   }
+
+  for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+    if (this->m_chunkExecutionStates[index] != COM_ES_EXECUTED) {
+      return;
+    }
+  }
+
+  WriteBufferOperation *writeOperation = (WriteBufferOperation *)this->getOutputOperation();
+  ResultCache::store(this->m_cacheKey, writeOperation->getMemoryProxy());
 }
 
 bool ExecutionGroup::isOpenCL()
@@ -29,6 +29,7 @@
 
 using std::vector;
 
+class ChunkGraph;
 class ExecutionSystem;
 class MemoryProxy;
 class ReadBufferOperation;
@@ -178,6 +179,27 @@ class ExecutionGroup {
    */
   double m_executionStartTime;
 
+  /**
+   * \brief the chunk dependency graph this ExecutionGroup is currently executed in
+   * \note only set during ExecutionGroup.execute of an output ExecutionGroup
+   */
+  ChunkGraph *m_chunkGraph;
+
+  /**
+   * \brief key of the output of this ExecutionGroup in the ResultCache, 0 when not cacheable
+   */
+  uint64_t m_cacheKey;
+
+  /**
+   * \brief is m_cacheKey determined for the current execution
+   */
+  bool m_cacheKeyDetermined;
+
+  /**
+   * \brief was the output of this ExecutionGroup restored from the ResultCache
+   */
+  bool m_restoredFromCache;
+
   // methods
   /**
    * \brief check whether parameter operation can be added to the execution group
@@ -207,29 +229,12 @@ class ExecutionGroup {
   void determineNumberOfChunks();
 
   /**
-   * \brief try to schedule a specific chunk.
-   * \note scheduling succeeds when all input requirements are met and the chunks hasn't been
-   * scheduled yet.
-   * \param graph:
-   * \param xChunk:
-   * \param yChunk:
-   * \return [true:false]
-   * true: package(s) are scheduled
-   * false: scheduling is deferred (depending workpackages are scheduled)
+   * \brief determine the chunks that overlap an area.
+   * \note This method is called for the input ExecutionGroup's when building the ChunkGraph.
+   * \param area: the area in pixel space
+   * \param chunkNumbers: result
    */
-  bool scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk);
-
-  /**
-   * \brief try to schedule a specific area.
-   * \note Check if a certain area is available, when not available this are will be checked.
-   * \note This method is called from other ExecutionGroup's.
-   * \param graph:
-   * \param rect:
-   * \return [true:false]
-   * true: package(s) are scheduled
-   * false: scheduling is deferred (depending workpackages are scheduled)
-   */
-  bool scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *rect);
+  void determineChunksInArea(const rcti *area, vector<unsigned int> *chunkNumbers) const;
 
   /**
    * \brief add a chunk to the WorkScheduler.
@@ -389,7 +394,9 @@ class ExecutionGroup {
    *   - CenterX
    *   - CenterY
    *
-   * After determining the order of the chunks the chunks will be scheduled
+   * After determining the order of the chunks a ChunkGraph with all chunks and the input
+   * chunks they depend on is built, and chunks are scheduled as soon as their inputs are
+   * executed.
    *
    * \see ViewerOperation
    * \param system:
@@ -411,6 +418,26 @@ class ExecutionGroup {
    */
   void determineChunkRect(rcti *rect, const unsigned int chunkNumber) const;
 
+  /**
+   * \brief determine the key of the output of this ExecutionGroup in the ResultCache.
+   * \note Only ExecutionGroup's writing to a MemoryProxy can be cached, the keys of the
+   * \note ExecutionGroup's this group reads from are determined first.
+   * \return the key, 0 when the output can not be cached
+   */
+  uint64_t determineCacheKey(const CompositorContext &context);
+
+  /**
+   * \brief fill the output buffer from the ResultCache and mark all chunks as executed
+   * \note must be called after initExecution, and after determineCacheKey
+   * \return true when the output was found in the cache
+   */
+  bool restoreFromCache();
+
+  /**
+   * \brief store the output buffer in the ResultCache, when all chunks are executed
+   */
+  void storeInCache();
+
   /**
    * \brief can this ExecutionGroup be scheduled on an OpenCLDevice
    * \see WorkScheduler.schedule
@@ -439,6 +466,9 @@ class ExecutionGroup {
   /* allow the DebugInfo class to look at internals */
   friend class DebugInfo;
 
+  /* the ChunkGraph determines chunk dependencies and schedules chunks */
+  friend class ChunkGraph;
+
 #ifdef WITH_CXX_GUARDEDALLOC
   MEM_CXX_CLASS_ALLOC_FUNCS("COM:ExecutionGroup")
 #endif
@@ -32,6 +32,7 @@ extern "C" {
 #include "COM_ExecutionGroup.h"
 #include "COM_WorkScheduler.h"
 #include "COM_ReadBufferOperation.h"
+#include "COM_ResultCache.h"
 #include "COM_Debug.h"
 
 #ifdef WITH_CXX_GUARDEDALLOC
@@ -178,6 +179,20 @@ void ExecutionSystem::execute()
     executionGroup->initExecution();
   }
 
+  /* Groups found in the cache are marked as executed and not scheduled. */
+  const bool use_cache = (editingtree->flag & NTREE_COM_CACHE) != 0;
+  if (use_cache) {
+    ResultCache::set_limit((size_t)editingtree->cache_limit * 1024 * 1024);
+    for (index = 0; index < this->m_groups.size(); index++) {
+      ExecutionGroup *executionGroup = this->m_groups[index];
+      executionGroup->determineCacheKey(this->m_context);
+    }
+    for (index = 0; index < this->m_groups.size(); index++) {
+      ExecutionGroup *executionGroup = this->m_groups[index];
+      executionGroup->restoreFromCache();
+    }
+  }
+
   WorkScheduler::start(this->m_context);
 
   executeGroups(COM_PRIORITY_HIGH);
@@ -189,6 +204,15 @@ void ExecutionSystem::execute()
   WorkScheduler::finish();
   WorkScheduler::stop();
 
+  DebugInfo::execute_finished(this);
+
+  if (use_cache) {
+    for (index = 0; index < this->m_groups.size(); index++) {
+      ExecutionGroup *executionGroup = this->m_groups[index];
+      executionGroup->storeInCache();
+    }
+  }
+
   editingtree->stats_draw(editingtree->sdh, IFACE_("Compositing | De-initializing execution"));
   for (index = 0; index < this->m_operations.size(); index++) {
     NodeOperation *operation = this->m_operations[index];
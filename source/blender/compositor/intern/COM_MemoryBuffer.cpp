@@ -176,6 +176,44 @@ void MemoryBuffer::copyContentFrom(MemoryBuffer *otherBuffer)
   }
 }
 
+void MemoryBuffer::readRow(float *result, int x, int y, int length)
+{
+  const int num_channels = this->m_num_channels;
+  int x1 = max(x, this->m_rect.xmin);
+  int x2 = min(x + length, this->m_rect.xmax);
+
+  if (y < this->m_rect.ymin || y >= this->m_rect.ymax || x1 >= x2) {
+    memset(result, 0, sizeof(float) * length * COM_NUM_CHANNELS_COLOR);
+    return;
+  }
+
+  /* clip result outside rect is zero */
+  if (x1 > x) {
+    memset(result, 0, sizeof(float) * (x1 - x) * COM_NUM_CHANNELS_COLOR);
+  }
+  if (x2 < x + length) {
+    memset(&result[(x2 - x) * COM_NUM_CHANNELS_COLOR],
+           0,
+           sizeof(float) * (x + length - x2) * COM_NUM_CHANNELS_COLOR);
+  }
+
+  const float *buffer = &this->m_buffer[((y - this->m_rect.ymin) * this->m_width +
+                                         (x1 - this->m_rect.xmin)) *
+                                        num_channels];
+  float *row = &result[(x1 - x) * COM_NUM_CHANNELS_COLOR];
+
+  if (num_channels == COM_NUM_CHANNELS_COLOR) {
+    memcpy(row, buffer, sizeof(float) * (x2 - x1) * COM_NUM_CHANNELS_COLOR);
+  }
+  else {
+    for (int i = 0; i < x2 - x1; i++) {
+      for (int c = 0; c < num_channels; c++) {
+        row[i * COM_NUM_CHANNELS_COLOR + c] = buffer[i * num_channels + c];
+      }
+    }
+  }
+}
+
 void MemoryBuffer::writePixel(int x, int y, const float color[4])
 {
   if (x >= this->m_rect.xmin && x < this->m_rect.xmax && y >= this->m_rect.ymin &&
@@ -278,6 +278,12 @@ class MemoryBuffer {
     memcpy(result, buffer, sizeof(float) * this->m_num_channels);
   }
 
+  /**
+   * \brief read a row of pixels, with COM_NUM_CHANNELS_COLOR floats per pixel
+   * Pixels outside of the rect are zero.
+   */
+  void readRow(float *result, int x, int y, int length);
+
   void writePixel(int x, int y, const float color[4]);
   void addPixel(int x, int y, const float color[4]);
   inline void readBilinear(float *result,
@@ -126,6 +126,18 @@ class NodeOperation : public SocketReader {
    */
   bool m_isResolutionSet;
 
+  /**
+   * \brief hash of the settings of the node this operation was created for
+   * \see ResultCache.node_hash
+   */
+  uint64_t m_nodeHash;
+
+  /**
+   * \brief false when m_nodeHash doesn't cover everything the node depends on
+   * \see ResultCache.node_is_cacheable
+   */
+  bool m_isNodeCacheable;
+
  public:
   virtual ~NodeOperation();
 
@@ -190,6 +202,23 @@ class NodeOperation : public SocketReader {
   {
     this->m_btree = tree;
   }
+
+  void setNodeHash(uint64_t nodeHash)
+  {
+    this->m_nodeHash = nodeHash;
+  }
+  uint64_t getNodeHash() const
+  {
+    return this->m_nodeHash;
+  }
+  void setNodeCacheable(bool isNodeCacheable)
+  {
+    this->m_isNodeCacheable = isNodeCacheable;
+  }
+  bool isNodeCacheable() const
+  {
+    return this->m_isNodeCacheable;
+  }
   virtual void initExecution();
 
   /**
@@ -373,6 +402,15 @@ class NodeOperation : public SocketReader {
     return this->m_btree->test_break(this->m_btree->tbh);
   }
 
+  /**
+   * \brief should output operations compute rows of pixels instead of single pixels
+   * \see SocketReader.executeRow
+   */
+  inline bool useRowExecution() const
+  {
+    return (this->m_btree->flag & NTREE_COM_ROW_EXECUTION) != 0;
+  }
+
   inline void updateDraw()
   {
     if (this->m_btree->update_draw) {
@@ -25,6 +25,7 @@ extern "C" {
 #include "COM_Debug.h"
 #include "COM_ExecutionSystem.h"
 #include "COM_Node.h"
+#include "COM_ResultCache.h"
 #include "COM_SocketProxyNode.h"
 
 #include "COM_NodeOperation.h"
@@ -127,6 +128,10 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 
 void NodeOperationBuilder::addOperation(NodeOperation *operation)
 {
+  if (m_current_node) {
+    operation->setNodeHash(ResultCache::node_hash(m_current_node));
+    operation->setNodeCacheable(ResultCache::node_is_cacheable(m_current_node));
+  }
   m_operations.push_back(operation);
 }
 
@@ -0,0 +1,250 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2011, Blender Foundation.
+ */
+
+#include <list>
+#include <string.h>
+
+#include "COM_ResultCache.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_MemoryProxy.h"
+#include "COM_Node.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_rect.h"
+#include "DNA_ID.h"
+#include "DNA_color_types.h"
+#include "BKE_node.h"
+}
+
+typedef struct ResultCacheEntry {
+  uint64_t key;
+  MemoryBuffer *buffer;
+  size_t size;
+} ResultCacheEntry;
+
+/// \brief cached results, most recently used first
+static std::list<ResultCacheEntry> g_entries;
+static size_t g_size = 0;
+static size_t g_limit = 0;
+
+ResultCacheKey::ResultCacheKey()
+{
+  BLI_hash_mm2a_init(&this->m_hash[0], 0);
+  BLI_hash_mm2a_init(&this->m_hash[1], 0x9e3779b9);
+}
+
+void ResultCacheKey::add(const void *data, size_t size)
+{
+  BLI_hash_mm2a_add(&this->m_hash[0], (const unsigned char *)data, size);
+  BLI_hash_mm2a_add(&this->m_hash[1], (const unsigned char *)data, size);
+}
+
+void ResultCacheKey::addInt(int value)
+{
+  BLI_hash_mm2a_add_int(&this->m_hash[0], value);
+  BLI_hash_mm2a_add_int(&this->m_hash[1], value);
+}
+
+void ResultCacheKey::addPointer(const void *pointer)
+{
+  add(&pointer, sizeof(pointer));
+}
+
+void ResultCacheKey::addString(const char *str)
+{
+  add(str, strlen(str) + 1);
+}
+
+uint64_t ResultCacheKey::end()
+{
+  uint64_t key = ((uint64_t)BLI_hash_mm2a_end(&this->m_hash[0]) << 32) |
+                 (uint64_t)BLI_hash_mm2a_end(&this->m_hash[1]);
+  /* 0 is used for results that can't be cached. */
+  return (key != 0) ? key : 1;
+}
+
+/* Curves are read from their points, the tables and pointers differ between executions. */
+static void result_cache_add_curve_mapping(ResultCacheKey &key, const CurveMapping *cumap)
+{
+  key.addInt(cumap->flag & (CUMA_DO_CLIP | CUMA_PREMULLED));
+  key.add(&cumap->clipr, sizeof(cumap->clipr));
+  key.add(cumap->black, sizeof(cumap->black));
+  key.add(cumap->white, sizeof(cumap->white));
+  key.addInt(cumap->tone);
+
+  for (int i = 0; i < CM_TOT; i++) {
+    const CurveMap *cuma = &cumap->cm[i];
+    key.addInt(cuma->totpoint);
+    key.addInt(cuma->flag);
+    key.add(cuma->ext_in, sizeof(cuma->ext_in));
+    key.add(cuma->ext_out, sizeof(cuma->ext_out));
+    if (cuma->curve) {
+      key.add(cuma->curve, sizeof(CurveMapPoint) * cuma->totpoint);
+    }
+  }
+}
+
+bool ResultCache::node_is_cacheable(const Node *node)
+{
+  const bNode *bnode = node->getbNode();
+  if (bnode == NULL) {
+    return true;
+  }
+
+  /* Only render results of scenes are keyed by pointer, the cache is cleared after rendering.
+   * Content of other data-blocks like images, masks, movie clips and textures can change
+   * without notice. */
+  if (bnode->id && GS(bnode->id->name) != ID_SCE) {
+    return false;
+  }
+
+  /* Storage is hashed by value, storage types which hold lists or other allocations can't be.
+   * Storage without a DNA struct name is private to the node. */
+  if (bnode->storage) {
+    const char *storagename = bnode->typeinfo->storagename;
+    if (storagename[0] == '\0' || STREQ(storagename, "NodeCryptomatte") ||
+        STREQ(storagename, "NodeImageMultiFile")) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+uint64_t ResultCache::node_hash(const Node *node)
+{
+  ResultCacheKey key;
+  const bNode *bnode = node->getbNode();
+  if (bnode == NULL) {
+    return key.end();
+  }
+
+  key.addString(bnode->idname);
+  key.addInt(bnode->type);
+  key.addInt(bnode->flag & NODE_MUTED);
+  key.addInt(bnode->custom1);
+  key.addInt(bnode->custom2);
+  key.add(&bnode->custom3, sizeof(bnode->custom3));
+  key.add(&bnode->custom4, sizeof(bnode->custom4));
+  key.addPointer(bnode->id);
+
+  /* Storage and socket values are allocated with guarded alloc, which knows their size. */
+  if (bnode->storage) {
+    if (STREQ(bnode->typeinfo->storagename, "CurveMapping")) {
+      result_cache_add_curve_mapping(key, (const CurveMapping *)bnode->storage);
+    }
+    else {
+      key.add(bnode->storage, MEM_allocN_len(bnode->storage));
+    }
+  }
+  for (const bNodeSocket *sock = (const bNodeSocket *)bnode->inputs.first; sock;
+       sock = sock->next) {
+    if (sock->default_value) {
+      key.add(sock->default_value, MEM_allocN_len(sock->default_value));
+    }
+  }
+
+  return key.end();
+}
+
+static void result_cache_remove(std::list<ResultCacheEntry>::iterator it)
+{
+  g_size -= it->size;
+  delete it->buffer;
+  g_entries.erase(it);
+}
+
+bool ResultCache::restore(uint64_t key, MemoryProxy *memoryProxy)
+{
+  MemoryBuffer *buffer = memoryProxy->getBuffer();
+  if (buffer == NULL) {
+    return false;
+  }
+
+  for (std::list<ResultCacheEntry>::iterator it = g_entries.begin(); it != g_entries.end();
+       ++it) {
+    if (it->key != key) {
+      continue;
+    }
+
+    MemoryBuffer *cached = it->buffer;
+    if (cached->get_num_channels() != buffer->get_num_channels() ||
+        !BLI_rcti_compare(cached->getRect(), buffer->getRect())) {
+      return false;
+    }
+
+    buffer->copyContentFrom(cached);
+    g_entries.splice(g_entries.begin(), g_entries, it);
+    return true;
+  }
+
+  return false;
+}
+
+void ResultCache::store(uint64_t key, MemoryProxy *memoryProxy)
+{
+  MemoryBuffer *buffer = memoryProxy->getBuffer();
+  if (buffer == NULL) {
+    return;
+  }
+
+  const size_t size = sizeof(float) * buffer->get_num_channels() * buffer->getWidth() *
+                      buffer->getHeight();
+  if (size > g_limit) {
+    return;
+  }
+
+  for (std::list<ResultCacheEntry>::iterator it = g_entries.begin(); it != g_entries.end();
+       ++it) {
+    if (it->key == key) {
+      result_cache_remove(it);
+      break;
+    }
+  }
+
+  /* Make room by removing the least recently used results. */
+  while (!g_entries.empty() && g_size + size > g_limit) {
+    result_cache_remove(--g_entries.end());
+  }
+
+  ResultCacheEntry entry;
+  entry.key = key;
+  entry.buffer = new MemoryBuffer(memoryProxy->getDataType(), buffer->getRect());
+  entry.buffer->copyContentFrom(buffer);
+  entry.size = size;
+  g_entries.push_front(entry);
+  g_size += size;
+}
+
+void ResultCache::set_limit(size_t limit)
+{
+  g_limit = limit;
+  while (!g_entries.empty() && g_size > g_limit) {
+    result_cache_remove(--g_entries.end());
+  }
+}
+
+void ResultCache::clear()
+{
+  while (!g_entries.empty()) {
+    result_cache_remove(g_entries.begin());
+  }
+}
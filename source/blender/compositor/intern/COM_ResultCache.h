@@ -0,0 +1,102 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2011, Blender Foundation.
+ */
+
+#ifndef __COM_RESULTCACHE_H__
+#define __COM_RESULTCACHE_H__
+
+#include "BLI_sys_types.h"
+
+extern "C" {
+#include "BLI_hash_mm2a.h"
+}
+
+class MemoryProxy;
+class Node;
+
+/**
+ * \brief builds the key of a cached result from the settings it depends on
+ * Two murmur hashes with different seeds are combined to reduce the chance of collisions.
+ * \ingroup Execution
+ */
+class ResultCacheKey {
+ private:
+  BLI_HashMurmur2A m_hash[2];
+
+ public:
+  ResultCacheKey();
+
+  void add(const void *data, size_t size);
+  void addInt(int value);
+  void addPointer(const void *pointer);
+  void addString(const char *str);
+
+  /**
+   * \brief finish the key, can only be called once
+   * \return the key, never 0
+   */
+  uint64_t end();
+};
+
+/**
+ * \brief cache of the output buffers of ExecutionGroup's between executions of the compositor
+ *
+ * The cache is keyed by a hash of everything the output of an ExecutionGroup depends on:
+ * the settings of the nodes its operations were created from, how they are linked, and the
+ * keys of the ExecutionGroup's it reads from. When only a downstream node is edited, the
+ * upstream groups find their output in the cache and are not executed.
+ *
+ * Least recently used results are removed when the memory limit is exceeded.
+ * \note Only used from COM_execute, which is serialized by the compositor mutex.
+ * \ingroup Execution
+ */
+class ResultCache {
+ public:
+  /**
+   * \brief hash of the settings of a node that influence the operations created for it
+   */
+  static uint64_t node_hash(const Node *node);
+
+  /**
+   * \brief whether node_hash covers everything the operations of a node depend on
+   * Nodes using data-blocks whose content isn't hashed, or storage with pointers, are not cached.
+   */
+  static bool node_is_cacheable(const Node *node);
+
+  /**
+   * \brief copy a cached result into the buffer of a MemoryProxy
+   * \return true when a result with the same key, size and type was found
+   */
+  static bool restore(uint64_t key, MemoryProxy *memoryProxy);
+
+  /**
+   * \brief store a copy of the buffer of a MemoryProxy, when it fits in the memory limit
+   */
+  static void store(uint64_t key, MemoryProxy *memoryProxy);
+
+  /**
+   * \brief set the memory limit in bytes, removing results when it is exceeded
+   */
+  static void set_limit(size_t limit);
+
+  /**
+   * \brief remove all results from the cache
+   */
+  static void clear();
+};
+
+#endif /* __COM_RESULTCACHE_H__ */
@@ -94,6 +94,25 @@ class SocketReader {
   {
   }
 
+  /**
+   * \brief calculate a row of pixels
+   * \note this method is called for non-complex when row execution is enabled.
+   * Operations that override it compute all pixels of the row at once, the default
+   * implementation calls executePixelSampled for every pixel, so operations that are not
+   * converted can still be read by the ones that are.
+   * \param output: is a float array of length * COM_NUM_CHANNELS_COLOR to store the result,
+   * every pixel uses 4 floats regardless of the data type.
+   * \param x: the x-coordinate of the first pixel to calculate in image space
+   * \param y: the y-coordinate of the pixels to calculate in image space
+   * \param length: the number of pixels to calculate, at most COM_ROW_LENGTH
+   */
+  virtual void executeRow(float *output, int x, int y, int length)
+  {
+    for (int i = 0; i < length; i++) {
+      executePixelSampled(&output[i * COM_NUM_CHANNELS_COLOR], x + i, y, COM_PS_NEAREST);
+    }
+  }
+
  public:
   inline void readSampled(float result[4], float x, float y, PixelSampler sampler)
   {
@@ -107,6 +126,10 @@ class SocketReader {
   {
     executePixelFiltered(result, x, y, dx, dy);
   }
+  inline void readRow(float *result, int x, int y, int length)
+  {
+    executeRow(result, x, y, length);
+  }
 
   virtual void *initializeTileData(rcti * /*rect*/)
   {
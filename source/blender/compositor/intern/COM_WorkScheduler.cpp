@@ -16,6 +16,7 @@
  * Copyright 2011, Blender Foundation.
  */
 
+#include <deque>
 #include <list>
 #include <stdio.h>
 
@@ -26,9 +27,12 @@
 #include "COM_OpenCLKernels.cl.h"
 #include "clew.h"
 #include "COM_WriteBufferOperation.h"
+#include "COM_Debug.h"
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "PIL_time.h"
 #include "BLI_threads.h"
 
@@ -52,8 +56,22 @@ static ThreadLocal(CPUDevice *) g_thread_device;
 /// \brief list of all thread for every CPUDevice in cpudevices a thread exists
 static ListBase g_cputhreads;
 static bool g_cpuInitialized = false;
-/// \brief all scheduled work for the cpu
-static ThreadQueue *g_cpuqueue;
+/// \brief scheduled work of a single cpu thread, other threads steal work from its back
+typedef struct CPUWorkQueue {
+  SpinLock spin;
+  std::deque<WorkPackage *> packages;
+} CPUWorkQueue;
+/// \brief all scheduled work for the cpu, a queue for every CPUDevice
+static vector<CPUWorkQueue *> g_cpuqueues;
+/// \brief number of packages in the cpu queues, used to let idle threads sleep
+static int g_cpuQueued = 0;
+/// \brief number of scheduled cpu packages that are not finished
+static int g_cpuPending = 0;
+static unsigned int g_cpuNextQueue = 0;
+static bool g_cpuStopping = false;
+static ThreadMutex g_cpuMutex = BLI_MUTEX_INITIALIZER;
+static ThreadCondition g_cpuWorkCondition;
+static ThreadCondition g_cpuFinishCondition;
 static ThreadQueue *g_gpuqueue;
 #  ifdef COM_OPENCL_ENABLED
 static cl_context g_context;
@@ -72,14 +90,104 @@ static bool g_openclInitialized = false;
 #endif
 
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+static void cpu_queue_push(WorkPackage *package)
+{
+  atomic_add_and_fetch_int32(&g_cpuPending, 1);
+
+  /* Work scheduled from a cpu thread is put in front of its own queue, so chunks that became
+   * ready when it finished a chunk are executed next while their input is still in cache.
+   * Work scheduled from other threads is distributed over the queues. */
+  CPUDevice *device = (CPUDevice *)BLI_thread_local_get(g_thread_device);
+  if (device) {
+    CPUWorkQueue *queue = g_cpuqueues[device->thread_id()];
+    BLI_spin_lock(&queue->spin);
+    queue->packages.push_front(package);
+    BLI_spin_unlock(&queue->spin);
+  }
+  else {
+    unsigned int index = atomic_fetch_and_add_u(&g_cpuNextQueue, 1) % g_cpuqueues.size();
+    CPUWorkQueue *queue = g_cpuqueues[index];
+    BLI_spin_lock(&queue->spin);
+    queue->packages.push_back(package);
+    BLI_spin_unlock(&queue->spin);
+  }
+
+  BLI_mutex_lock(&g_cpuMutex);
+  g_cpuQueued++;
+  BLI_condition_notify_one(&g_cpuWorkCondition);
+  BLI_mutex_unlock(&g_cpuMutex);
+}
+
+static WorkPackage *cpu_queue_try_pop(int thread_id)
+{
+  const int num_queues = g_cpuqueues.size();
+  WorkPackage *package = NULL;
+
+  /* Own queue first, then steal from the back of the other queues. */
+  for (int offset = 0; offset < num_queues && package == NULL; offset++) {
+    CPUWorkQueue *queue = g_cpuqueues[(thread_id + offset) % num_queues];
+    BLI_spin_lock(&queue->spin);
+    if (!queue->packages.empty()) {
+      if (offset == 0) {
+        package = queue->packages.front();
+        queue->packages.pop_front();
+      }
+      else {
+        package = queue->packages.back();
+        queue->packages.pop_back();
+      }
+    }
+    BLI_spin_unlock(&queue->spin);
+  }
+
+  return package;
+}
+
+static WorkPackage *cpu_queue_pop(int thread_id)
+{
+  while (true) {
+    WorkPackage *package = cpu_queue_try_pop(thread_id);
+    if (package) {
+      BLI_mutex_lock(&g_cpuMutex);
+      g_cpuQueued--;
+      BLI_mutex_unlock(&g_cpuMutex);
+      return package;
+    }
+
+    BLI_mutex_lock(&g_cpuMutex);
+    while (g_cpuQueued <= 0 && !g_cpuStopping) {
+      BLI_condition_wait(&g_cpuWorkCondition, &g_cpuMutex);
+    }
+    const bool stopping = g_cpuStopping && g_cpuQueued <= 0;
+    BLI_mutex_unlock(&g_cpuMutex);
+
+    if (stopping) {
+      return NULL;
+    }
+  }
+}
+
+static void cpu_queue_package_finished()
+{
+  if (atomic_sub_and_fetch_int32(&g_cpuPending, 1) == 0) {
+    BLI_mutex_lock(&g_cpuMutex);
+    BLI_condition_notify_all(&g_cpuFinishCondition);
+    BLI_mutex_unlock(&g_cpuMutex);
+  }
+}
+
 void *WorkScheduler::thread_execute_cpu(void *data)
 {
   CPUDevice *device = (CPUDevice *)data;
   WorkPackage *work;
   BLI_thread_local_set(g_thread_device, device);
-  while ((work = (WorkPackage *)BLI_thread_queue_pop(g_cpuqueue))) {
+  while ((work = cpu_queue_pop(device->thread_id()))) {
+    const double start_time = PIL_check_seconds_timer();
     device->execute(work);
+    DebugInfo::chunk_executed(work->getExecutionGroup(),
+                              PIL_check_seconds_timer() - start_time);
     delete work;
+    cpu_queue_package_finished();
   }
 
   return NULL;
@@ -91,7 +199,10 @@ void *WorkScheduler::thread_execute_gpu(void *data)
   WorkPackage *work;
 
   while ((work = (WorkPackage *)BLI_thread_queue_pop(g_gpuqueue))) {
+    const double start_time = PIL_check_seconds_timer();
     device->execute(work);
+    DebugInfo::chunk_executed(work->getExecutionGroup(),
+                              PIL_check_seconds_timer() - start_time);
     delete work;
   }
 
@@ -104,7 +215,9 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
   WorkPackage *package = new WorkPackage(group, chunkNumber);
 #if COM_CURRENT_THREADING_MODEL == COM_TM_NOTHREAD
   CPUDevice device(0);
+  const double start_time = PIL_check_seconds_timer();
   device.execute(package);
+  DebugInfo::chunk_executed(group, PIL_check_seconds_timer() - start_time);
   delete package;
 #elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 #  ifdef COM_OPENCL_ENABLED
@@ -112,10 +225,10 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
     BLI_thread_queue_push(g_gpuqueue, package);
   }
   else {
-    BLI_thread_queue_push(g_cpuqueue, package);
+    cpu_queue_push(package);
   }
 #  else
-  BLI_thread_queue_push(g_cpuqueue, package);
+  cpu_queue_push(package);
 #  endif
 #endif
 }
@@ -124,7 +237,16 @@ void WorkScheduler::start(CompositorContext &context)
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
   unsigned int index;
-  g_cpuqueue = BLI_thread_queue_init();
+  for (index = 0; index < g_cpudevices.size(); index++) {
+    CPUWorkQueue *queue = new CPUWorkQueue();
+    BLI_spin_init(&queue->spin);
+    g_cpuqueues.push_back(queue);
+  }
+  g_cpuQueued = 0;
+  g_cpuPending = 0;
+  g_cpuStopping = false;
+  BLI_condition_init(&g_cpuWorkCondition);
+  BLI_condition_init(&g_cpuFinishCondition);
   BLI_threadpool_init(&g_cputhreads, thread_execute_cpu, g_cpudevices.size());
   for (index = 0; index < g_cpudevices.size(); index++) {
     Device *device = g_cpudevices[index];
@@ -152,23 +274,31 @@ void WorkScheduler::finish()
 #  ifdef COM_OPENCL_ENABLED
   if (g_openclActive) {
     BLI_thread_queue_wait_finish(g_gpuqueue);
-    BLI_thread_queue_wait_finish(g_cpuqueue);
   }
-  else {
-    BLI_thread_queue_wait_finish(g_cpuqueue);
-  }
-#  else
-  BLI_thread_queue_wait_finish(cpuqueue);
 #  endif
+  BLI_mutex_lock(&g_cpuMutex);
+  while (atomic_add_and_fetch_int32(&g_cpuPending, 0) > 0) {
+    BLI_condition_wait(&g_cpuFinishCondition, &g_cpuMutex);
+  }
+  BLI_mutex_unlock(&g_cpuMutex);
 #endif
 }
 void WorkScheduler::stop()
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-  BLI_thread_queue_nowait(g_cpuqueue);
+  BLI_mutex_lock(&g_cpuMutex);
+  g_cpuStopping = true;
+  BLI_condition_notify_all(&g_cpuWorkCondition);
+  BLI_mutex_unlock(&g_cpuMutex);
   BLI_threadpool_end(&g_cputhreads);
-  BLI_thread_queue_free(g_cpuqueue);
-  g_cpuqueue = NULL;
+  while (g_cpuqueues.size() > 0) {
+    CPUWorkQueue *queue = g_cpuqueues.back();
+    g_cpuqueues.pop_back();
+    BLI_spin_end(&queue->spin);
+    delete queue;
+  }
+  BLI_condition_end(&g_cpuWorkCondition);
+  BLI_condition_end(&g_cpuFinishCondition);
 #  ifdef COM_OPENCL_ENABLED
   if (g_openclActive) {
     BLI_thread_queue_nowait(g_gpuqueue);
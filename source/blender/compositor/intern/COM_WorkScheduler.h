@@ -40,7 +40,8 @@ class WorkScheduler {
 
   /**
    * \brief main thread loop for cpudevices
-   * inside this loop new work is queried and being executed
+   * inside this loop new work is queried from the queue of the device,
+   * or stolen from other devices, and being executed
    */
   static void *thread_execute_cpu(void *data);
 
@@ -55,7 +56,9 @@ class WorkScheduler {
    * \brief schedule a chunk of a group to be calculated.
    * An execution group schedules a chunk in the WorkScheduler
    * when ExecutionGroup.isOpenCL is set the work will be handled by a OpenCLDevice
-   * otherwise the work is scheduled for an CPUDevice
+   * otherwise the work is scheduled for an CPUDevice.
+   * CPU work scheduled from a CPUDevice thread is executed next by that thread,
+   * idle CPUDevice threads steal work from the other threads.
    * \see ExecutionGroup.execute
    * \param group: the execution group
    * \param chunkNumber: the number of the chunk in the group to be executed
@@ -28,6 +28,7 @@ extern "C" {
 #include "COM_compositor.h"
 #include "COM_ExecutionSystem.h"
 #include "COM_WorkScheduler.h"
+#include "COM_ResultCache.h"
 #include "clew.h"
 #include "COM_MovieDistortionOperation.h"
 
@@ -82,6 +83,12 @@ void COM_execute(RenderData *rd,
   bool use_opencl = (editingtree->flag & NTREE_COM_OPENCL) != 0;
   WorkScheduler::initialize(use_opencl, BKE_render_num_threads(rd));
 
+  /* Render layers have new results when rendering, and the cache only uses memory when it is
+   * disabled. */
+  if (rendering || !(editingtree->flag & NTREE_COM_CACHE)) {
+    ResultCache::clear();
+  }
+
   /* set progress bar to 0% and status to init compositing */
   editingtree->progress(editingtree->prh, 0.0);
   editingtree->stats_draw(editingtree->sdh, IFACE_("Compositing"));
@@ -110,11 +117,21 @@ void COM_execute(RenderData *rd,
   BLI_mutex_unlock(&s_compositorMutex);
 }
 
+void COM_clearCaches()
+{
+  if (is_compositorMutex_init) {
+    BLI_mutex_lock(&s_compositorMutex);
+    ResultCache::clear();
+    BLI_mutex_unlock(&s_compositorMutex);
+  }
+}
+
 void COM_deinitialize()
 {
   if (is_compositorMutex_init) {
     BLI_mutex_lock(&s_compositorMutex);
     WorkScheduler::deinitialize();
+    ResultCache::clear();
     is_compositorMutex_init = false;
     BLI_mutex_unlock(&s_compositorMutex);
     BLI_mutex_end(&s_compositorMutex);
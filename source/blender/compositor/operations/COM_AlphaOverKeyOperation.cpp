@@ -52,3 +52,37 @@ void AlphaOverKeyOperation::executePixelSampled(float output[4],
     output[3] = (mul * inputColor1[3]) + value[0] * inputOverColor[3];
   }
 }
+
+void AlphaOverKeyOperation::executeRow(float *output, int x, int y, int length)
+{
+  float inputValue[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+  float inputColor1[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+  float inputOverColor[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+
+  this->m_inputValueOperation->readRow(inputValue, x, y, length);
+  this->m_inputColor1Operation->readRow(inputColor1, x, y, length);
+  this->m_inputColor2Operation->readRow(inputOverColor, x, y, length);
+
+  for (int i = 0; i < length; i++) {
+    const float value = inputValue[i * COM_NUM_CHANNELS_COLOR];
+    const float *in1 = &inputColor1[i * COM_NUM_CHANNELS_COLOR];
+    const float *over = &inputOverColor[i * COM_NUM_CHANNELS_COLOR];
+    float *out = &output[i * COM_NUM_CHANNELS_COLOR];
+
+    if (over[3] <= 0.0f) {
+      copy_v4_v4(out, in1);
+    }
+    else if (value == 1.0f && over[3] >= 1.0f) {
+      copy_v4_v4(out, over);
+    }
+    else {
+      const float premul = value * over[3];
+      const float mul = 1.0f - premul;
+
+      out[0] = (mul * in1[0]) + premul * over[0];
+      out[1] = (mul * in1[1]) + premul * over[1];
+      out[2] = (mul * in1[2]) + premul * over[2];
+      out[3] = (mul * in1[3]) + value * over[3];
+    }
+  }
+}
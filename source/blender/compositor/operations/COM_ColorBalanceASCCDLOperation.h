@@ -46,6 +46,7 @@ class ColorBalanceASCCDLOperation : public NodeOperation {
    * the inner loop of this program
    */
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length);
 
   /**
    * Initialize the execution
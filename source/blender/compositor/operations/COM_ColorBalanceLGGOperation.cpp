@@ -79,6 +79,26 @@ void ColorBalanceLGGOperation::executePixelSampled(float output[4],
   output[3] = inputColor[3];
 }
 
+void ColorBalanceLGGOperation::executeRow(float *output, int x, int y, int length)
+{
+  float value[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+
+  this->m_inputValueOperation->readRow(value, x, y, length);
+  this->m_inputColorOperation->readRow(output, x, y, length);
+
+  for (int i = 0; i < length; i++) {
+    float *color = &output[i * COM_NUM_CHANNELS_COLOR];
+    const float fac = min(1.0f, value[i * COM_NUM_CHANNELS_COLOR]);
+    const float mfac = 1.0f - fac;
+
+    for (int c = 0; c < 3; c++) {
+      color[c] = mfac * color[c] +
+                 fac * colorbalance_lgg(
+                           color[c], this->m_lift[c], this->m_gamma_inv[c], this->m_gain[c]);
+    }
+  }
+}
+
 void ColorBalanceLGGOperation::deinitExecution()
 {
   this->m_inputValueOperation = NULL;
@@ -192,6 +192,37 @@ void CompositorOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
   }
 #endif
 
+  if (this->useRowExecution()) {
+    float alpha[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+    float depth[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+
+    for (y = y1; y < y2 && (!breaked); y++) {
+      for (x = x1; x < x2; x += COM_ROW_LENGTH) {
+        const int length = min(x2 - x, COM_ROW_LENGTH);
+        const int row_offset = y * this->getWidth() + x;
+        float *row = buffer + row_offset * COM_NUM_CHANNELS_COLOR;
+        int input_x = x + dx, input_y = y + dy;
+
+        this->m_imageInput->readRow(row, input_x, input_y, length);
+        if (this->m_useAlphaInput) {
+          this->m_alphaInput->readRow(alpha, input_x, input_y, length);
+          for (int i = 0; i < length; i++) {
+            row[i * COM_NUM_CHANNELS_COLOR + 3] = alpha[i * COM_NUM_CHANNELS_COLOR];
+          }
+        }
+
+        this->m_depthInput->readRow(depth, input_x, input_y, length);
+        for (int i = 0; i < length; i++) {
+          zbuffer[row_offset + i] = depth[i * COM_NUM_CHANNELS_COLOR];
+        }
+      }
+      if (isBreaked()) {
+        breaked = true;
+      }
+    }
+    return;
+  }
+
   for (y = y1; y < y2 && (!breaked); y++) {
     for (x = x1; x < x2 && (!breaked); x++) {
       int input_x = x + dx, input_y = y + dy;
@@ -56,6 +56,16 @@ void ConvertValueToColorOperation::executePixelSampled(float output[4],
   output[3] = 1.0f;
 }
 
+void ConvertValueToColorOperation::executeRow(float *output, int x, int y, int length)
+{
+  this->m_inputOperation->readRow(output, x, y, length);
+  for (int i = 0; i < length; i++) {
+    float *color = &output[i * COM_NUM_CHANNELS_COLOR];
+    color[1] = color[2] = color[0];
+    color[3] = 1.0f;
+  }
+}
+
 /* ******** Color to Value ******** */
 
 ConvertColorToValueOperation::ConvertColorToValueOperation() : ConvertBaseOperation()
@@ -74,6 +84,15 @@ void ConvertColorToValueOperation::executePixelSampled(float output[4],
   output[0] = (inputColor[0] + inputColor[1] + inputColor[2]) / 3.0f;
 }
 
+void ConvertColorToValueOperation::executeRow(float *output, int x, int y, int length)
+{
+  this->m_inputOperation->readRow(output, x, y, length);
+  for (int i = 0; i < length; i++) {
+    float *color = &output[i * COM_NUM_CHANNELS_COLOR];
+    color[0] = (color[0] + color[1] + color[2]) / 3.0f;
+  }
+}
+
 /* ******** Color to BW ******** */
 
 ConvertColorToBWOperation::ConvertColorToBWOperation() : ConvertBaseOperation()
@@ -92,6 +111,15 @@ void ConvertColorToBWOperation::executePixelSampled(float output[4],
   output[0] = IMB_colormanagement_get_luminance(inputColor);
 }
 
+void ConvertColorToBWOperation::executeRow(float *output, int x, int y, int length)
+{
+  this->m_inputOperation->readRow(output, x, y, length);
+  for (int i = 0; i < length; i++) {
+    float *color = &output[i * COM_NUM_CHANNELS_COLOR];
+    color[0] = IMB_colormanagement_get_luminance(color);
+  }
+}
+
 /* ******** Color to Vector ******** */
 
 ConvertColorToVectorOperation::ConvertColorToVectorOperation() : ConvertBaseOperation()
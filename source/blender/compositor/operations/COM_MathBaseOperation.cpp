@@ -68,6 +68,21 @@ void MathBaseOperation::clampIfNeeded(float *color)
   }
 }
 
+void MathBaseOperation::readInputRows(float *value1, float *value2, int x, int y, int length)
+{
+  this->m_inputValue1Operation->readRow(value1, x, y, length);
+  this->m_inputValue2Operation->readRow(value2, x, y, length);
+}
+
+void MathBaseOperation::clampRowIfNeeded(float *row, int length)
+{
+  if (this->m_useClamp) {
+    for (int i = 0; i < length; i++) {
+      CLAMP(row[i * COM_NUM_CHANNELS_COLOR], 0.0f, 1.0f);
+    }
+  }
+}
+
 void MathAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
   float inputValue1[4];
@@ -81,6 +96,21 @@ void MathAddOperation::executePixelSampled(float output[4], float x, float y, Pi
   clampIfNeeded(output);
 }
 
+void MathAddOperation::executeRow(float *output, int x, int y, int length)
+{
+  float inputValue1[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+  float inputValue2[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+
+  readInputRows(inputValue1, inputValue2, x, y, length);
+
+  for (int i = 0; i < length; i++) {
+    const int j = i * COM_NUM_CHANNELS_COLOR;
+    output[j] = inputValue1[j] + inputValue2[j];
+  }
+
+  clampRowIfNeeded(output, length);
+}
+
 void MathSubtractOperation::executePixelSampled(float output[4],
                                                 float x,
                                                 float y,
@@ -97,6 +127,21 @@ void MathSubtractOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathSubtractOperation::executeRow(float *output, int x, int y, int length)
+{
+  float inputValue1[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+  float inputValue2[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+
+  readInputRows(inputValue1, inputValue2, x, y, length);
+
+  for (int i = 0; i < length; i++) {
+    const int j = i * COM_NUM_CHANNELS_COLOR;
+    output[j] = inputValue1[j] - inputValue2[j];
+  }
+
+  clampRowIfNeeded(output, length);
+}
+
 void MathMultiplyOperation::executePixelSampled(float output[4],
                                                 float x,
                                                 float y,
@@ -113,6 +158,21 @@ void MathMultiplyOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathMultiplyOperation::executeRow(float *output, int x, int y, int length)
+{
+  float inputValue1[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+  float inputValue2[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+
+  readInputRows(inputValue1, inputValue2, x, y, length);
+
+  for (int i = 0; i < length; i++) {
+    const int j = i * COM_NUM_CHANNELS_COLOR;
+    output[j] = inputValue1[j] * inputValue2[j];
+  }
+
+  clampRowIfNeeded(output, length);
+}
+
 void MathDivideOperation::executePixelSampled(float output[4],
                                               float x,
                                               float y,
@@ -134,6 +194,22 @@ void MathDivideOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathDivideOperation::executeRow(float *output, int x, int y, int length)
+{
+  float inputValue1[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+  float inputValue2[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+
+  readInputRows(inputValue1, inputValue2, x, y, length);
+
+  for (int i = 0; i < length; i++) {
+    const int j = i * COM_NUM_CHANNELS_COLOR;
+    /* We don't want to divide by zero. */
+    output[j] = (inputValue2[j] == 0.0f) ? 0.0f : inputValue1[j] / inputValue2[j];
+  }
+
+  clampRowIfNeeded(output, length);
+}
+
 void MathSineOperation::executePixelSampled(float output[4],
                                             float x,
                                             float y,
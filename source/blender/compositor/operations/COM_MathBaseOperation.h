@@ -42,6 +42,12 @@ class MathBaseOperation : public NodeOperation {
 
   void clampIfNeeded(float color[4]);
 
+  /**
+   * Read rows of both inputs for row execution.
+   */
+  void readInputRows(float *value1, float *value2, int x, int y, int length);
+  void clampRowIfNeeded(float *row, int length);
+
  public:
   /**
    * the inner loop of this program
@@ -75,6 +81,7 @@ class MathAddOperation : public MathBaseOperation {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length);
 };
 class MathSubtractOperation : public MathBaseOperation {
  public:
@@ -82,6 +89,7 @@ class MathSubtractOperation : public MathBaseOperation {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length);
 };
 class MathMultiplyOperation : public MathBaseOperation {
  public:
@@ -89,6 +97,7 @@ class MathMultiplyOperation : public MathBaseOperation {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length);
 };
 class MathDivideOperation : public MathBaseOperation {
  public:
@@ -96,6 +105,7 @@ class MathDivideOperation : public MathBaseOperation {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length);
 };
 class MathSineOperation : public MathBaseOperation {
  public:
@@ -65,6 +65,29 @@ void MixBaseOperation::executePixelSampled(float output[4], float x, float y, Pi
   output[3] = inputColor1[3];
 }
 
+void MixBaseOperation::readInputRows(
+    float *value, float *color1, float *color2, int x, int y, int length)
+{
+  this->m_inputValueOperation->readRow(value, x, y, length);
+  this->m_inputColor1Operation->readRow(color1, x, y, length);
+  this->m_inputColor2Operation->readRow(color2, x, y, length);
+
+  if (this->useValueAlphaMultiply()) {
+    for (int i = 0; i < length; i++) {
+      value[i * COM_NUM_CHANNELS_COLOR] *= color2[i * COM_NUM_CHANNELS_COLOR + 3];
+    }
+  }
+}
+
+void MixBaseOperation::clampRowIfNeeded(float *row, int length)
+{
+  if (m_useClamp) {
+    for (int i = 0; i < length * COM_NUM_CHANNELS_COLOR; i++) {
+      CLAMP(row[i], 0.0f, 1.0f);
+    }
+  }
+}
+
 void MixBaseOperation::determineResolution(unsigned int resolution[2],
                                            unsigned int preferredResolution[2])
 {
@@ -126,6 +149,28 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
   clampIfNeeded(output);
 }
 
+void MixAddOperation::executeRow(float *output, int x, int y, int length)
+{
+  float inputValue[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+  float inputColor1[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+  float inputColor2[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+
+  readInputRows(inputValue, inputColor1, inputColor2, x, y, length);
+
+  for (int i = 0; i < length; i++) {
+    const float value = inputValue[i * COM_NUM_CHANNELS_COLOR];
+    const float *in1 = &inputColor1[i * COM_NUM_CHANNELS_COLOR];
+    const float *in2 = &inputColor2[i * COM_NUM_CHANNELS_COLOR];
+    float *out = &output[i * COM_NUM_CHANNELS_COLOR];
+    out[0] = in1[0] + value * in2[0];
+    out[1] = in1[1] + value * in2[1];
+    out[2] = in1[2] + value * in2[2];
+    out[3] = in1[3];
+  }
+
+  clampRowIfNeeded(output, length);
+}
+
 /* ******** Mix Blend Operation ******** */
 
 MixBlendOperation::MixBlendOperation() : MixBaseOperation()
@@ -160,6 +205,29 @@ void MixBlendOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixBlendOperation::executeRow(float *output, int x, int y, int length)
+{
+  float inputValue[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+  float inputColor1[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+  float inputColor2[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+
+  readInputRows(inputValue, inputColor1, inputColor2, x, y, length);
+
+  for (int i = 0; i < length; i++) {
+    const float value = inputValue[i * COM_NUM_CHANNELS_COLOR];
+    const float *in1 = &inputColor1[i * COM_NUM_CHANNELS_COLOR];
+    const float *in2 = &inputColor2[i * COM_NUM_CHANNELS_COLOR];
+    float *out = &output[i * COM_NUM_CHANNELS_COLOR];
+    const float valuem = 1.0f - value;
+    out[0] = valuem * in1[0] + value * in2[0];
+    out[1] = valuem * in1[1] + value * in2[1];
+    out[2] = valuem * in1[2] + value * in2[2];
+    out[3] = in1[3];
+  }
+
+  clampRowIfNeeded(output, length);
+}
+
 /* ******** Mix Burn Operation ******** */
 
 MixBurnOperation::MixBurnOperation() : MixBaseOperation()
@@ -704,6 +772,29 @@ void MixMultiplyOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixMultiplyOperation::executeRow(float *output, int x, int y, int length)
+{
+  float inputValue[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+  float inputColor1[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+  float inputColor2[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+
+  readInputRows(inputValue, inputColor1, inputColor2, x, y, length);
+
+  for (int i = 0; i < length; i++) {
+    const float value = inputValue[i * COM_NUM_CHANNELS_COLOR];
+    const float *in1 = &inputColor1[i * COM_NUM_CHANNELS_COLOR];
+    const float *in2 = &inputColor2[i * COM_NUM_CHANNELS_COLOR];
+    float *out = &output[i * COM_NUM_CHANNELS_COLOR];
+    const float valuem = 1.0f - value;
+    out[0] = in1[0] * (valuem + value * in2[0]);
+    out[1] = in1[1] * (valuem + value * in2[1]);
+    out[2] = in1[2] * (valuem + value * in2[2]);
+    out[3] = in1[3];
+  }
+
+  clampRowIfNeeded(output, length);
+}
+
 /* ******** Mix Ovelray Operation ******** */
 
 MixOverlayOperation::MixOverlayOperation() : MixBaseOperation()
@@ -908,6 +999,28 @@ void MixSubtractOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixSubtractOperation::executeRow(float *output, int x, int y, int length)
+{
+  float inputValue[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+  float inputColor1[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+  float inputColor2[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+
+  readInputRows(inputValue, inputColor1, inputColor2, x, y, length);
+
+  for (int i = 0; i < length; i++) {
+    const float value = inputValue[i * COM_NUM_CHANNELS_COLOR];
+    const float *in1 = &inputColor1[i * COM_NUM_CHANNELS_COLOR];
+    const float *in2 = &inputColor2[i * COM_NUM_CHANNELS_COLOR];
+    float *out = &output[i * COM_NUM_CHANNELS_COLOR];
+    out[0] = in1[0] - value * in2[0];
+    out[1] = in1[1] - value * in2[1];
+    out[2] = in1[2] - value * in2[2];
+    out[3] = in1[3];
+  }
+
+  clampRowIfNeeded(output, length);
+}
+
 /* ******** Mix Value Operation ******** */
 
 MixValueOperation::MixValueOperation() : MixBaseOperation()
@@ -46,6 +46,13 @@ class MixBaseOperation : public NodeOperation {
     }
   }
 
+  /**
+   * Read rows of all inputs for row execution,
+   * the value is multiplied with the alpha of the second color when needed.
+   */
+  void readInputRows(float *value, float *color1, float *color2, int x, int y, int length);
+  void clampRowIfNeeded(float *row, int length);
+
  public:
   /**
    * Default constructor
@@ -87,12 +94,14 @@ class MixAddOperation : public MixBaseOperation {
  public:
   MixAddOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length);
 };
 
 class MixBlendOperation : public MixBaseOperation {
  public:
   MixBlendOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length);
 };
 
 class MixBurnOperation : public MixBaseOperation {
@@ -159,6 +168,7 @@ class MixMultiplyOperation : public MixBaseOperation {
  public:
   MixMultiplyOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length);
 };
 
 class MixOverlayOperation : public MixBaseOperation {
@@ -189,6 +199,7 @@ class MixSubtractOperation : public MixBaseOperation {
  public:
   MixSubtractOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length);
 };
 
 class MixValueOperation : public MixBaseOperation {
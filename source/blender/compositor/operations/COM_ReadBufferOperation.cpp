@@ -74,6 +74,21 @@ void ReadBufferOperation::executePixelSampled(float output[4],
   }
 }
 
+void ReadBufferOperation::executeRow(float *output, int x, int y, int length)
+{
+  if (m_single_value) {
+    /* write buffer has a single value stored at (0,0) */
+    float value[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    m_buffer->read(value, 0, 0);
+    for (int i = 0; i < length; i++) {
+      copy_v4_v4(&output[i * COM_NUM_CHANNELS_COLOR], value);
+    }
+  }
+  else {
+    m_buffer->readRow(output, x, y, length);
+  }
+}
+
 void ReadBufferOperation::executePixelExtend(float output[4],
                                              float x,
                                              float y,
@@ -44,6 +44,7 @@ class ReadBufferOperation : public NodeOperation {
 
   void *initializeTileData(rcti *rect);
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length);
   void executePixelExtend(float output[4],
                           float x,
                           float y,
@@ -34,6 +34,15 @@ void SetVectorOperation::executePixelSampled(float output[4],
   output[2] = this->m_z;
 }
 
+void SetVectorOperation::executeRow(float *output, int /*x*/, int /*y*/, int length)
+{
+  for (int i = 0; i < length; i++) {
+    output[i * COM_NUM_CHANNELS_COLOR] = this->m_x;
+    output[i * COM_NUM_CHANNELS_COLOR + 1] = this->m_y;
+    output[i * COM_NUM_CHANNELS_COLOR + 2] = this->m_z;
+  }
+}
+
 void SetVectorOperation::determineResolution(unsigned int resolution[2],
                                              unsigned int preferredResolution[2])
 {
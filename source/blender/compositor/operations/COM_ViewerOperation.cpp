@@ -98,6 +98,35 @@ void ViewerOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
   int y;
   bool breaked = false;
 
+  if (this->useRowExecution()) {
+    float alpha_row[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+    float depth_row[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+
+    for (y = y1; y < y2 && (!breaked); y++) {
+      for (x = x1; x < x2; x += COM_ROW_LENGTH) {
+        const int length = min(x2 - x, COM_ROW_LENGTH);
+        offset = y * this->getWidth() + x;
+
+        this->m_imageInput->readRow(&(buffer[offset * 4]), x, y, length);
+        if (this->m_useAlphaInput) {
+          this->m_alphaInput->readRow(alpha_row, x, y, length);
+          for (int i = 0; i < length; i++) {
+            buffer[(offset + i) * 4 + 3] = alpha_row[i * COM_NUM_CHANNELS_COLOR];
+          }
+        }
+        this->m_depthInput->readRow(depth_row, x, y, length);
+        for (int i = 0; i < length; i++) {
+          depthbuffer[offset + i] = depth_row[i * COM_NUM_CHANNELS_COLOR];
+        }
+      }
+      if (isBreaked()) {
+        breaked = true;
+      }
+    }
+    updateImage(rect);
+    return;
+  }
+
   for (y = y1; y < y2 && (!breaked); y++) {
     for (x = x1; x < x2; x++) {
       this->m_imageInput->readSampled(&(buffer[offset4]), x, y, COM_PS_NEAREST);
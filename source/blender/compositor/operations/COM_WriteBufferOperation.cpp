@@ -85,6 +85,38 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/
       data = NULL;
     }
   }
+  else if (this->useRowExecution()) {
+    float row[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+    int x1 = rect->xmin;
+    int y1 = rect->ymin;
+    int x2 = rect->xmax;
+    int y2 = rect->ymax;
+
+    int x;
+    int y;
+    bool breaked = false;
+    for (y = y1; y < y2 && (!breaked); y++) {
+      for (x = x1; x < x2; x += COM_ROW_LENGTH) {
+        const int length = min(x2 - x, COM_ROW_LENGTH);
+        float *output = &buffer[(y * memoryBuffer->getWidth() + x) * num_channels];
+
+        if (num_channels == COM_NUM_CHANNELS_COLOR) {
+          this->m_input->readRow(output, x, y, length);
+        }
+        else {
+          this->m_input->readRow(row, x, y, length);
+          for (int i = 0; i < length; i++) {
+            for (int c = 0; c < num_channels; c++) {
+              output[i * num_channels + c] = row[i * COM_NUM_CHANNELS_COLOR + c];
+            }
+          }
+        }
+      }
+      if (isBreaked()) {
+        breaked = true;
+      }
+    }
+  }
   else {
     int x1 = rect->xmin;
     int y1 = rect->ymin;
@@ -34,6 +34,10 @@
 
 #include "BKE_global.h"
 
+extern "C" {
+#include "BKE_DerivedMesh.h"
+}
+
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 
@@ -314,6 +318,7 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   graph->debug_is_evaluating = false;
   if (do_time_debug) {
     printf("Depsgraph updated in %f seconds.\n", PIL_check_seconds_timer() - start_time);
+    DM_eval_arena_stats_print();
   }
 }
 
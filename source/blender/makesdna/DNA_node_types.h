@@ -459,7 +459,8 @@ typedef struct bNodeTree {
    * in case multiple different editors are used and make context ambiguous.
    */
   bNodeInstanceKey active_viewer_key;
-  char _pad[4];
+  /** Memory budget of the compositor result cache in MB. */
+  int cache_limit;
 
   /** Execution data.
    *
@@ -503,6 +504,8 @@ typedef struct bNodeTree {
 
 /* tree is localized copy, free when deleting node groups */
 /* #define NTREE_IS_LOCALIZED           (1 << 5) */
+#define NTREE_COM_ROW_EXECUTION (1 << 6) /* compute rows of pixels at once */
+#define NTREE_COM_CACHE (1 << 7)         /* keep results between executions */
 
 /* ntree->update */
 typedef enum eNodeTreeUpdate {
@@ -263,6 +263,8 @@ typedef struct Editing {
   rctf over_border;
 
   struct SeqCache *cache;
+  /** Background threads rendering upcoming frames into the cache, runtime only. */
+  struct PrefetchJob *prefetch_job;
 
   /* Cache control */
   float recycle_max_cost;
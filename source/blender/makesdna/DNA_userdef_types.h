@@ -572,6 +572,8 @@ typedef struct UserDef {
   /* EXR cache path */
   /** 768 = FILE_MAXDIR. */
   char render_cachedir[768];
+  /** 768 = FILE_MAXDIR. */
+  char sequencer_disk_cache_dir[768];
   char textudir[768];
   char pythondir[768];
   char sounddir[768];
@@ -671,7 +673,8 @@ typedef struct UserDef {
   int prefetchframes;
   /** Control the rotation step of the view when PAD2, PAD4, PAD6&PAD8 is use. */
   float pad_rot_angle;
-  char _pad12[4];
+  /** Sequencer disk cache size in GB, 0 disables the disk cache. */
+  int sequencer_disk_cache_size_limit;
   /** Rotating view icon size. */
   short rvisize;
   /** Rotating view icon brightness. */
@@ -688,7 +691,9 @@ typedef struct UserDef {
   char ipo_new;
   /** Handle types for newly added keyframes. */
   char keyhandles_new;
-  char _pad11[3];
+  /** #eUserpref_SeqDiskCacheCompression. */
+  char sequencer_disk_cache_compression;
+  char _pad11[2];
   /** #eZoomFrame_Mode. */
   char view_frame_type;
 
@@ -1091,6 +1096,14 @@ typedef enum eTimecodeStyles {
   USER_TIMECODE_SUBRIP = 100,
 } eTimecodeStyles;
 
+/** #UserDef.sequencer_disk_cache_compression */
+typedef enum eUserpref_SeqDiskCacheCompression {
+  /* Fast compression is 0 so it's used by default. */
+  USER_SEQ_DISK_CACHE_COMPRESSION_LOW = 0,
+  USER_SEQ_DISK_CACHE_COMPRESSION_HIGH = 1,
+  USER_SEQ_DISK_CACHE_COMPRESSION_NONE = 2,
+} eUserpref_SeqDiskCacheCompression;
+
 /** #UserDef.ndof_flag (3D mouse options) */
 typedef enum eNdof_Flag {
   NDOF_SHOW_GUIDE = (1 << 0),
@@ -9045,6 +9045,27 @@ static void rna_def_composite_nodetree(BlenderRNA *brna)
   RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_GROUPNODE_BUFFER);
   RNA_def_property_ui_text(prop, "Buffer Groups", "Enable buffering of group nodes");
 
+  prop = RNA_def_property(srna, "use_row_execution", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_ROW_EXECUTION);
+  RNA_def_property_ui_text(prop,
+                           "Row Execution",
+                           "Compute whole rows of pixels at once for nodes that support it, "
+                           "instead of one pixel at a time");
+
+  prop = RNA_def_property(srna, "use_cache", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_CACHE);
+  RNA_def_property_ui_text(prop,
+                           "Cache",
+                           "Keep the results of nodes between executions, so only nodes "
+                           "affected by an edit are computed again");
+
+  prop = RNA_def_property(srna, "cache_limit", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "cache_limit");
+  RNA_def_property_range(prop, 0, INT_MAX);
+  RNA_def_property_ui_range(prop, 0, 65536, 256, -1);
+  RNA_def_property_ui_text(
+      prop, "Cache Limit", "Maximum memory used for cached node results (in megabytes)");
+
   prop = RNA_def_property(srna, "use_two_pass", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_TWO_PASS);
   RNA_def_property_ui_text(prop,
@@ -4655,6 +4655,25 @@ static void rna_def_userdef_system(BlenderRNA *brna)
       {0, NULL, 0, NULL, NULL},
   };
 
+  static const EnumPropertyItem seq_disk_cache_compression_items[] = {
+      {USER_SEQ_DISK_CACHE_COMPRESSION_NONE,
+       "NONE",
+       0,
+       "None",
+       "Requires fast storage, but uses minimum CPU resources"},
+      {USER_SEQ_DISK_CACHE_COMPRESSION_LOW,
+       "LOW",
+       0,
+       "Low",
+       "Fast compression, suitable for most storage"},
+      {USER_SEQ_DISK_CACHE_COMPRESSION_HIGH,
+       "HIGH",
+       0,
+       "High",
+       "Smaller files, but compressing and reading take more CPU time, playback may be slower"},
+      {0, NULL, 0, NULL, NULL},
+  };
+
   static const EnumPropertyItem anisotropic_items[] = {
       {1, "FILTER_0", 0, "Off", ""},
       {2, "FILTER_2", 0, "2x", ""},
@@ -4783,7 +4802,8 @@ static void rna_def_userdef_system(BlenderRNA *brna)
   RNA_def_property_ui_range(prop, 0, 500, 1, -1);
   RNA_def_property_ui_text(prop,
                            "Prefetch Frames",
-                           "Number of frames to render ahead during playback (sequencer only)");
+                           "Number of frames to render ahead on background threads during "
+                           "playback and scrubbing (sequencer only)");
 
   prop = RNA_def_property(srna, "memory_cache_limit", PROP_INT, PROP_NONE);
   RNA_def_property_int_sdna(prop, NULL, "memcachelimit");
@@ -4791,6 +4811,22 @@ static void rna_def_userdef_system(BlenderRNA *brna)
   RNA_def_property_ui_text(prop, "Memory Cache Limit", "Memory cache limit (in megabytes)");
   RNA_def_property_update(prop, 0, "rna_Userdef_memcache_update");
 
+  prop = RNA_def_property(srna, "sequencer_disk_cache_size_limit", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "sequencer_disk_cache_size_limit");
+  RNA_def_property_range(prop, 0, INT_MAX);
+  RNA_def_property_ui_range(prop, 0, 1000, 1, -1);
+  RNA_def_property_ui_text(prop,
+                           "Disk Cache Limit",
+                           "Disk space used by the sequencer disk cache (in gigabytes), "
+                           "0 disables the disk cache");
+
+  prop = RNA_def_property(srna, "sequencer_disk_cache_compression", PROP_ENUM, PROP_NONE);
+  RNA_def_property_enum_sdna(prop, NULL, "sequencer_disk_cache_compression");
+  RNA_def_property_enum_items(prop, seq_disk_cache_compression_items);
+  RNA_def_property_ui_text(prop,
+                           "Disk Cache Compression",
+                           "Compression of images stored in the sequencer disk cache");
+
   prop = RNA_def_property(srna, "scrollback", PROP_INT, PROP_UNSIGNED);
   RNA_def_property_int_sdna(prop, NULL, "scrollback");
   RNA_def_property_range(prop, 32, 32768);
@@ -5474,6 +5510,13 @@ static void rna_def_userdef_filepaths(BlenderRNA *brna)
   RNA_def_property_string_sdna(prop, NULL, "render_cachedir");
   RNA_def_property_ui_text(prop, "Render Cache Path", "Where to cache raw render results");
 
+  prop = RNA_def_property(srna, "sequencer_disk_cache_directory", PROP_STRING, PROP_DIRPATH);
+  RNA_def_property_string_sdna(prop, NULL, "sequencer_disk_cache_dir");
+  RNA_def_property_ui_text(prop,
+                           "Sequencer Disk Cache Path",
+                           "Where to store images of the sequencer disk cache, shared by all "
+                           "files (uses the temporary directory when empty)");
+
   prop = RNA_def_property(srna, "image_editor", PROP_STRING, PROP_FILEPATH);
   RNA_def_property_string_sdna(prop, NULL, "image_editor");
   RNA_def_property_ui_text(prop, "Image Editor", "Path to an image editor");
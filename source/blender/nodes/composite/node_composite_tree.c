@@ -296,6 +296,11 @@ void ntreeCompositTagRender(Scene *curscene)
    * This is still rather weak though,
    * ideally render struct would store own main AND original G_MAIN. */
 
+#ifdef WITH_COMPOSITOR
+  /* Cached compositor results may depend on the previous render result. */
+  COM_clearCaches();
+#endif
+
   for (sce = G_MAIN->scenes.first; sce; sce = sce->id.next) {
     if (sce->nodetree) {
       bNode *node;
@@ -0,0 +1,252 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <cfloat>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+#include "BKE_mesh.h"
+#include "DNA_meshdata_types.h"
+#include "PIL_time.h"
+}
+
+/* Vertex, polygon and split normals of a large deformed grid, the case hit on
+ * every frame of animation playback for high resolution meshes.
+ *
+ * Besides timing #BKE_mesh_calc_normals_poly, the result is compared with a
+ * simple single threaded reference: the threaded version accumulates in a
+ * different order, so normals are only expected to match within a tolerance.
+ */
+
+/* 3163 * 3163 ~= 10M vertices. */
+#define GRID_RES 3163
+
+#define NUM_RUNS 5
+
+typedef struct GridMesh {
+  MVert *mverts;
+  MEdge *medges;
+  MLoop *mloops;
+  MPoly *mpolys;
+  int totvert, totedge, totloop, totpoly;
+} GridMesh;
+
+static void grid_mesh_create(GridMesh *grid, const int res)
+{
+  grid->totvert = res * res;
+  grid->totedge = res * (res - 1) * 2;
+  grid->totpoly = (res - 1) * (res - 1);
+  grid->totloop = grid->totpoly * 4;
+
+  grid->mverts = (MVert *)MEM_calloc_arrayN(grid->totvert, sizeof(MVert), __func__);
+  grid->medges = (MEdge *)MEM_calloc_arrayN(grid->totedge, sizeof(MEdge), __func__);
+  grid->mloops = (MLoop *)MEM_calloc_arrayN(grid->totloop, sizeof(MLoop), __func__);
+  grid->mpolys = (MPoly *)MEM_calloc_arrayN(grid->totpoly, sizeof(MPoly), __func__);
+
+  for (int y = 0; y < res; y++) {
+    for (int x = 0; x < res; x++) {
+      float *co = grid->mverts[y * res + x].co;
+      co[0] = (float)x / (float)res;
+      co[1] = (float)y / (float)res;
+      /* Some waves, so normals are not all the same. */
+      co[2] = 0.05f * sinf(co[0] * 40.0f) * cosf(co[1] * 25.0f);
+    }
+  }
+
+  /* Edges along x first, then edges along y. */
+  const int edges_y = res * (res - 1);
+  for (int y = 0; y < res; y++) {
+    for (int x = 0; x < res - 1; x++) {
+      MEdge *me = &grid->medges[y * (res - 1) + x];
+      me->v1 = (unsigned int)(y * res + x);
+      me->v2 = (unsigned int)(y * res + x + 1);
+      /* A few sharp edges, so split normals have fans to walk. */
+      if ((x % 16) == 0) {
+        me->flag |= ME_SHARP;
+      }
+    }
+  }
+  for (int y = 0; y < res - 1; y++) {
+    for (int x = 0; x < res; x++) {
+      MEdge *me = &grid->medges[edges_y + y * res + x];
+      me->v1 = (unsigned int)(y * res + x);
+      me->v2 = (unsigned int)((y + 1) * res + x);
+    }
+  }
+
+  int p = 0;
+  for (int y = 0; y < res - 1; y++) {
+    for (int x = 0; x < res - 1; x++, p++) {
+      MPoly *mp = &grid->mpolys[p];
+      MLoop *ml = &grid->mloops[p * 4];
+      mp->loopstart = p * 4;
+      mp->totloop = 4;
+      mp->flag = ME_SMOOTH;
+      ml[0].v = (unsigned int)(y * res + x);
+      ml[0].e = (unsigned int)(y * (res - 1) + x);
+      ml[1].v = (unsigned int)(y * res + x + 1);
+      ml[1].e = (unsigned int)(edges_y + y * res + x + 1);
+      ml[2].v = (unsigned int)((y + 1) * res + x + 1);
+      ml[2].e = (unsigned int)((y + 1) * (res - 1) + x);
+      ml[3].v = (unsigned int)((y + 1) * res + x);
+      ml[3].e = (unsigned int)(edges_y + y * res + x);
+    }
+  }
+}
+
+static void grid_mesh_free(GridMesh *grid)
+{
+  MEM_freeN(grid->mverts);
+  MEM_freeN(grid->medges);
+  MEM_freeN(grid->mloops);
+  MEM_freeN(grid->mpolys);
+}
+
+/* Straightforward single threaded angle weighted vertex normals. */
+static void normals_reference_calc(const GridMesh *grid, float (*r_vnors)[3])
+{
+  memset(r_vnors, 0, sizeof(*r_vnors) * (size_t)grid->totvert);
+
+  for (int p = 0; p < grid->totpoly; p++) {
+    const MPoly *mp = &grid->mpolys[p];
+    const MLoop *ml = &grid->mloops[mp->loopstart];
+    float pnor[3];
+    float *vnors[4];
+    const float *vcos[4];
+    float vdiffs[4][3];
+
+    BKE_mesh_calc_poly_normal(mp, ml, grid->mverts, pnor);
+    for (int i = 0; i < 4; i++) {
+      vnors[i] = r_vnors[ml[i].v];
+      vcos[i] = grid->mverts[ml[i].v].co;
+    }
+    accumulate_vertex_normals_poly_v3(vnors, pnor, vcos, vdiffs, 4);
+  }
+
+  for (int v = 0; v < grid->totvert; v++) {
+    normalize_v3(r_vnors[v]);
+  }
+}
+
+TEST(mesh_normals, CalcNormalsPolyPerformance)
+{
+  BLI_threadapi_init();
+
+  GridMesh grid;
+  grid_mesh_create(&grid, GRID_RES);
+
+  float(*vnors)[3] = (float(*)[3])MEM_malloc_arrayN(grid.totvert, sizeof(*vnors), __func__);
+  float(*pnors)[3] = (float(*)[3])MEM_malloc_arrayN(grid.totpoly, sizeof(*pnors), __func__);
+  float(*vnors_ref)[3] = (float(*)[3])MEM_malloc_arrayN(
+      grid.totvert, sizeof(*vnors_ref), __func__);
+
+  double time_best = DBL_MAX;
+  for (int run = 0; run < NUM_RUNS; run++) {
+    const double time_start = PIL_check_seconds_timer();
+    BKE_mesh_calc_normals_poly(grid.mverts,
+                               vnors,
+                               grid.totvert,
+                               grid.mloops,
+                               grid.mpolys,
+                               grid.totloop,
+                               grid.totpoly,
+                               pnors,
+                               false);
+    time_best = std::min(time_best, PIL_check_seconds_timer() - time_start);
+  }
+
+  const double time_start = PIL_check_seconds_timer();
+  normals_reference_calc(&grid, vnors_ref);
+  const double time_ref = PIL_check_seconds_timer() - time_start;
+
+  printf("%d vertices, %d polygons: %8.3f ms (single threaded reference %8.3f ms)\n",
+         grid.totvert,
+         grid.totpoly,
+         time_best * 1000.0,
+         time_ref * 1000.0);
+
+  int num_mismatch = 0;
+  for (int v = 0; v < grid.totvert; v++) {
+    if (!compare_v3v3(vnors[v], vnors_ref[v], 1e-4f)) {
+      num_mismatch++;
+    }
+  }
+  EXPECT_EQ(num_mismatch, 0);
+
+  MEM_freeN(vnors);
+  MEM_freeN(pnors);
+  MEM_freeN(vnors_ref);
+  grid_mesh_free(&grid);
+}
+
+TEST(mesh_normals, NormalsLoopSplitPerformance)
+{
+  BLI_threadapi_init();
+
+  GridMesh grid;
+  grid_mesh_create(&grid, GRID_RES);
+
+  float(*pnors)[3] = (float(*)[3])MEM_malloc_arrayN(grid.totpoly, sizeof(*pnors), __func__);
+  float(*lnors)[3] = (float(*)[3])MEM_malloc_arrayN(grid.totloop, sizeof(*lnors), __func__);
+  /* Custom normals all set to the default, they still require the loop normal spaces. */
+  short(*clnors)[2] = (short(*)[2])MEM_calloc_arrayN(grid.totloop, sizeof(*clnors), __func__);
+
+  BKE_mesh_calc_normals_poly(grid.mverts,
+                             NULL,
+                             grid.totvert,
+                             grid.mloops,
+                             grid.mpolys,
+                             grid.totloop,
+                             grid.totpoly,
+                             pnors,
+                             false);
+
+  for (int use_clnors = 0; use_clnors < 2; use_clnors++) {
+    double time_best = DBL_MAX;
+    for (int run = 0; run < NUM_RUNS; run++) {
+      const double time_start = PIL_check_seconds_timer();
+      BKE_mesh_normals_loop_split(grid.mverts,
+                                  grid.totvert,
+                                  grid.medges,
+                                  grid.totedge,
+                                  grid.mloops,
+                                  lnors,
+                                  grid.totloop,
+                                  grid.mpolys,
+                                  (const float(*)[3])pnors,
+                                  grid.totpoly,
+                                  true,
+                                  (float)M_PI,
+                                  NULL,
+                                  use_clnors ? clnors : NULL,
+                                  NULL);
+      time_best = std::min(time_best, PIL_check_seconds_timer() - time_start);
+    }
+
+    printf("%d loops%s: %8.3f ms, %8.3f ms per million loops\n",
+           grid.totloop,
+           use_clnors ? " (custom normals)" : "",
+           time_best * 1000.0,
+           time_best * 1000.0 * 1e6 / (double)grid.totloop);
+
+    int num_invalid = 0;
+    for (int l = 0; l < grid.totloop; l++) {
+      if (fabsf(len_v3(lnors[l]) - 1.0f) > 1e-4f) {
+        num_invalid++;
+      }
+    }
+    EXPECT_EQ(num_invalid, 0);
+  }
+
+  MEM_freeN(pnors);
+  MEM_freeN(lnors);
+  MEM_freeN(clnors);
+  grid_mesh_free(&grid);
+}
@@ -0,0 +1,362 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_flatmap.h"
+#include "BLI_ghash.h"
+#include "BLI_rand.h"
+#include "PIL_time.h"
+}
+
+/* Compares #FlatMap against #GHash and the index map which was previously used by
+ * `OldNewMap` in readfile.c, replicated here.
+ *
+ * The workload mimics reading a file: every block in the file gets its old address
+ * inserted once, then pointers to these blocks are looked up several times while
+ * relinking, mostly close to the insertion order. Old addresses are spread
+ * like addresses of a real allocator, mostly increasing with small gaps.
+ * Like in actual files, many looked up pointers are NULL or not in the map
+ * (runtime pointers which were not cleared before writing). */
+
+#define NUM_POINTERS 1000000
+#define NUM_LOOKUPS_PER_POINTER 4
+#define NUM_BLOCKS_PER_ID 50
+
+typedef struct OldNew {
+  const void *oldp;
+  void *newp;
+  int nr;
+} OldNew;
+
+/* Value stored in #FlatMap, the old pointer is the key. */
+typedef struct OldNewValue {
+  void *newp;
+  int nr;
+} OldNewValue;
+
+/* -------------------------------------------------------------------- */
+/** \name Previous OldNewMap Implementation
+ * \{ */
+
+typedef struct IndexMap {
+  OldNew *entries;
+  int nentries;
+  int32_t *map;
+  int capacity_exp;
+} IndexMap;
+
+#define ENTRIES_CAPACITY(onm) (1 << (onm)->capacity_exp)
+#define MAP_CAPACITY(onm) (1 << ((onm)->capacity_exp + 1))
+#define SLOT_MASK(onm) (MAP_CAPACITY(onm) - 1)
+
+#define ITER_SLOTS(onm, KEY, SLOT_NAME, INDEX_NAME) \
+  uint32_t hash = BLI_ghashutil_ptrhash(KEY); \
+  uint32_t mask = SLOT_MASK(onm); \
+  uint perturb = hash; \
+  int SLOT_NAME = mask & hash; \
+  int INDEX_NAME = onm->map[SLOT_NAME]; \
+  for (;; SLOT_NAME = mask & ((5 * SLOT_NAME) + 1 + perturb), \
+          perturb >>= 5, \
+          INDEX_NAME = onm->map[SLOT_NAME])
+
+static void indexmap_insert_index(IndexMap *onm, const void *ptr, int index)
+{
+  ITER_SLOTS (onm, ptr, slot, stored_index) {
+    if (stored_index == -1) {
+      onm->map[slot] = index;
+      break;
+    }
+  }
+}
+
+static IndexMap *indexmap_new(void)
+{
+  IndexMap *onm = (IndexMap *)MEM_callocN(sizeof(*onm), __func__);
+  onm->capacity_exp = 6;
+  onm->entries = (OldNew *)MEM_malloc_arrayN(ENTRIES_CAPACITY(onm), sizeof(OldNew), __func__);
+  onm->map = (int32_t *)MEM_malloc_arrayN(MAP_CAPACITY(onm), sizeof(int32_t), __func__);
+  memset(onm->map, 0xFF, MAP_CAPACITY(onm) * sizeof(*onm->map));
+  return onm;
+}
+
+static void indexmap_insert(IndexMap *onm, const void *oldp, void *newp)
+{
+  if (UNLIKELY(onm->nentries == ENTRIES_CAPACITY(onm))) {
+    onm->capacity_exp++;
+    onm->entries = (OldNew *)MEM_reallocN(onm->entries,
+                                          sizeof(*onm->entries) * ENTRIES_CAPACITY(onm));
+    onm->map = (int32_t *)MEM_reallocN(onm->map, sizeof(*onm->map) * MAP_CAPACITY(onm));
+    memset(onm->map, 0xFF, MAP_CAPACITY(onm) * sizeof(*onm->map));
+    for (int i = 0; i < onm->nentries; i++) {
+      indexmap_insert_index(onm, onm->entries[i].oldp, i);
+    }
+  }
+  ITER_SLOTS (onm, oldp, slot, index) {
+    if (index == -1) {
+      onm->entries[onm->nentries] = {oldp, newp, 0};
+      onm->map[slot] = onm->nentries;
+      onm->nentries++;
+      break;
+    }
+    else if (onm->entries[index].oldp == oldp) {
+      onm->entries[index].newp = newp;
+      break;
+    }
+  }
+}
+
+static void *indexmap_lookup_and_inc(IndexMap *onm, const void *addr)
+{
+  ITER_SLOTS (onm, addr, slot, index) {
+    if (index >= 0) {
+      OldNew *entry = &onm->entries[index];
+      if (entry->oldp == addr) {
+        entry->nr++;
+        return entry->newp;
+      }
+    }
+    else {
+      return NULL;
+    }
+  }
+}
+
+static void indexmap_clear(IndexMap *onm)
+{
+  onm->capacity_exp = 6;
+  memset(onm->map, 0xFF, MAP_CAPACITY(onm) * sizeof(*onm->map));
+  onm->nentries = 0;
+}
+
+static void indexmap_free(IndexMap *onm)
+{
+  MEM_freeN(onm->entries);
+  MEM_freeN(onm->map);
+  MEM_freeN(onm);
+}
+
+#undef ENTRIES_CAPACITY
+#undef MAP_CAPACITY
+#undef SLOT_MASK
+#undef ITER_SLOTS
+
+/** \} */
+
+static void pointer_data_init(uintptr_t **r_keys,
+                              uintptr_t **r_lookup_keys,
+                              uintptr_t *r_checksum_expected)
+{
+  RNG *rng = BLI_rng_new(0);
+  const int num_lookups = NUM_POINTERS * NUM_LOOKUPS_PER_POINTER;
+  uintptr_t *keys = (uintptr_t *)MEM_mallocN(sizeof(*keys) * NUM_POINTERS, __func__);
+  uintptr_t *lookup_keys = (uintptr_t *)MEM_mallocN(sizeof(*lookup_keys) * num_lookups,
+                                                    __func__);
+  uintptr_t checksum_expected = 0;
+
+  uintptr_t address = 0x7f0000000000;
+  for (int i = 0; i < NUM_POINTERS; i++) {
+    address += 16 * (1 + (BLI_rng_get_uint(rng) % 64));
+    keys[i] = address;
+  }
+  for (int i = 0; i < num_lookups; i++) {
+    /* Mostly local accesses (data of the same ID) with some far jumps (other IDs). */
+    const int base = i / NUM_LOOKUPS_PER_POINTER;
+    const uint r = BLI_rng_get_uint(rng) % 16;
+    if (r < 4) {
+      lookup_keys[i] = 0;
+    }
+    else if (r < 5) {
+      /* Not in the map, allocations are 16 bytes aligned. */
+      lookup_keys[i] = keys[base] + 8;
+    }
+    else if (r < 7) {
+      lookup_keys[i] = keys[BLI_rng_get_uint(rng) % NUM_POINTERS];
+      checksum_expected += lookup_keys[i];
+    }
+    else {
+      lookup_keys[i] = keys[base];
+      checksum_expected += lookup_keys[i];
+    }
+  }
+  BLI_rng_free(rng);
+
+  *r_keys = keys;
+  *r_lookup_keys = lookup_keys;
+  *r_checksum_expected = checksum_expected;
+}
+
+static void print_timing(const char *id, const double time)
+{
+  printf("%-24s total: %8.3f ms\n", id, time * 1000.0);
+}
+
+static void print_timing_ex(const char *id, const double time_insert, const double time_lookup)
+{
+  printf("%-24s insert: %8.3f ms, lookup: %8.3f ms, total: %8.3f ms\n",
+         id,
+         time_insert * 1000.0,
+         time_lookup * 1000.0,
+         (time_insert + time_lookup) * 1000.0);
+}
+
+TEST(flatmap, OldNewMapPerformance)
+{
+  uintptr_t *keys, *lookup_keys, checksum_expected;
+  pointer_data_init(&keys, &lookup_keys, &checksum_expected);
+  const int num_lookups = NUM_POINTERS * NUM_LOOKUPS_PER_POINTER;
+
+  printf("\n%d pointers, %d lookups\n", NUM_POINTERS, num_lookups);
+
+  {
+    double time_start = PIL_check_seconds_timer();
+    IndexMap *onm = indexmap_new();
+    for (int i = 0; i < NUM_POINTERS; i++) {
+      indexmap_insert(onm, (void *)keys[i], (void *)keys[i]);
+    }
+    const double time_insert = PIL_check_seconds_timer() - time_start;
+
+    time_start = PIL_check_seconds_timer();
+    uintptr_t checksum = 0;
+    for (int i = 0; i < num_lookups; i++) {
+      checksum += (uintptr_t)indexmap_lookup_and_inc(onm, (void *)lookup_keys[i]);
+    }
+    const double time_lookup = PIL_check_seconds_timer() - time_start;
+
+    EXPECT_EQ(checksum, checksum_expected);
+    print_timing_ex("IndexMap (previous)", time_insert, time_lookup);
+    indexmap_free(onm);
+  }
+
+  {
+    double time_start = PIL_check_seconds_timer();
+    GHash *ghash = BLI_ghash_ptr_new(__func__);
+    for (int i = 0; i < NUM_POINTERS; i++) {
+      BLI_ghash_insert(ghash, (void *)keys[i], (void *)keys[i]);
+    }
+    const double time_insert = PIL_check_seconds_timer() - time_start;
+
+    time_start = PIL_check_seconds_timer();
+    uintptr_t checksum = 0;
+    for (int i = 0; i < num_lookups; i++) {
+      checksum += (uintptr_t)BLI_ghash_lookup(ghash, (void *)lookup_keys[i]);
+    }
+    const double time_lookup = PIL_check_seconds_timer() - time_start;
+
+    EXPECT_EQ(checksum, checksum_expected);
+    print_timing_ex("GHash", time_insert, time_lookup);
+    BLI_ghash_free(ghash, NULL, NULL);
+  }
+
+  {
+    double time_start = PIL_check_seconds_timer();
+    FlatMap *map = BLI_flatmap_new(sizeof(OldNewValue), __func__);
+    for (int i = 0; i < NUM_POINTERS; i++) {
+      OldNewValue *entry;
+      if (!BLI_flatmap_ensure(map, (void *)keys[i], (void **)&entry)) {
+        entry->newp = (void *)keys[i];
+        entry->nr = 0;
+      }
+    }
+    const double time_insert = PIL_check_seconds_timer() - time_start;
+
+    time_start = PIL_check_seconds_timer();
+    uintptr_t checksum = 0;
+    for (int i = 0; i < num_lookups; i++) {
+      OldNewValue *entry = lookup_keys[i] ?
+                               (OldNewValue *)BLI_flatmap_lookup(map, (void *)lookup_keys[i]) :
+                               NULL;
+      if (entry) {
+        entry->nr++;
+        checksum += (uintptr_t)entry->newp;
+      }
+    }
+    const double time_lookup = PIL_check_seconds_timer() - time_start;
+
+    EXPECT_EQ(checksum, checksum_expected);
+    print_timing_ex("FlatMap", time_insert, time_lookup);
+    BLI_flatmap_free(map);
+  }
+
+  MEM_freeN(keys);
+  MEM_freeN(lookup_keys);
+}
+
+/* Per ID data map usage: the map is filled with the blocks of one ID,
+ * looked up while relinking, then iterated to free unused blocks and cleared
+ * before reading the next ID. Lookups into other IDs miss. */
+TEST(flatmap, OldNewMapPerIDPerformance)
+{
+  uintptr_t *keys, *lookup_keys, checksum_unused;
+  pointer_data_init(&keys, &lookup_keys, &checksum_unused);
+  const int num_ids = NUM_POINTERS / NUM_BLOCKS_PER_ID;
+  const int num_lookups_per_id = NUM_BLOCKS_PER_ID * NUM_LOOKUPS_PER_POINTER;
+  uintptr_t checksum_expected = 0;
+  int num_unused_expected = 0;
+
+  printf("\n%d IDs with %d blocks each\n", num_ids, NUM_BLOCKS_PER_ID);
+
+  {
+    const double time_start = PIL_check_seconds_timer();
+    IndexMap *onm = indexmap_new();
+    for (int id = 0; id < num_ids; id++) {
+      for (int i = id * NUM_BLOCKS_PER_ID; i < (id + 1) * NUM_BLOCKS_PER_ID; i++) {
+        indexmap_insert(onm, (void *)keys[i], (void *)keys[i]);
+      }
+      for (int i = id * num_lookups_per_id; i < (id + 1) * num_lookups_per_id; i++) {
+        checksum_expected += (uintptr_t)indexmap_lookup_and_inc(onm, (void *)lookup_keys[i]);
+      }
+      for (int i = 0; i < onm->nentries; i++) {
+        num_unused_expected += (onm->entries[i].nr == 0);
+      }
+      indexmap_clear(onm);
+    }
+    const double time = PIL_check_seconds_timer() - time_start;
+
+    print_timing("IndexMap (previous)", time);
+    indexmap_free(onm);
+  }
+
+  {
+    const double time_start = PIL_check_seconds_timer();
+    FlatMap *map = BLI_flatmap_new(sizeof(OldNewValue), __func__);
+    uintptr_t checksum = 0;
+    int num_unused = 0;
+    for (int id = 0; id < num_ids; id++) {
+      for (int i = id * NUM_BLOCKS_PER_ID; i < (id + 1) * NUM_BLOCKS_PER_ID; i++) {
+        OldNewValue *entry;
+        if (!BLI_flatmap_ensure(map, (void *)keys[i], (void **)&entry)) {
+          entry->newp = (void *)keys[i];
+          entry->nr = 0;
+        }
+      }
+      for (int i = id * num_lookups_per_id; i < (id + 1) * num_lookups_per_id; i++) {
+        /* NULL is never a key, checked before the lookup like readfile.c does. */
+        OldNewValue *entry = lookup_keys[i] ?
+                                 (OldNewValue *)BLI_flatmap_lookup(map, (void *)lookup_keys[i]) :
+                                 NULL;
+        if (entry) {
+          entry->nr++;
+          checksum += (uintptr_t)entry->newp;
+        }
+      }
+      FlatMapIterator iter;
+      FLATMAP_ITER (iter, map) {
+        const OldNewValue *entry = (const OldNewValue *)BLI_flatmapIterator_getValue(&iter);
+        num_unused += (entry->nr == 0);
+      }
+      BLI_flatmap_clear(map);
+    }
+    const double time = PIL_check_seconds_timer() - time_start;
+
+    EXPECT_EQ(checksum, checksum_expected);
+    EXPECT_EQ(num_unused, num_unused_expected);
+    print_timing("FlatMap", time);
+    BLI_flatmap_free(map);
+  }
+
+  MEM_freeN(keys);
+  MEM_freeN(lookup_keys);
+}
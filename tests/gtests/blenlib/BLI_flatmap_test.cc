@@ -0,0 +1,192 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_flatmap.h"
+#include "BLI_rand.h"
+}
+
+#define TESTCASE_SIZE 10000
+
+typedef struct TestValue {
+  int a;
+  int b;
+  char c;
+} TestValue;
+
+/* Keys are never dereferenced, fake pointers with typical allocation alignment. */
+static void *index_to_key(uintptr_t i)
+{
+  return (void *)((i + 1) * 16);
+}
+
+static void flatmap_insert_range(FlatMap *map, int num)
+{
+  for (int i = 0; i < num; i++) {
+    void *value;
+    EXPECT_FALSE(BLI_flatmap_ensure(map, index_to_key(i), &value));
+    ((TestValue *)value)->a = i;
+    ((TestValue *)value)->b = -i;
+    ((TestValue *)value)->c = (char)i;
+  }
+}
+
+TEST(flatmap, InsertLookup)
+{
+  FlatMap *map = BLI_flatmap_new(sizeof(TestValue), __func__);
+
+  flatmap_insert_range(map, TESTCASE_SIZE);
+  EXPECT_EQ(BLI_flatmap_len(map), TESTCASE_SIZE);
+
+  for (int i = 0; i < TESTCASE_SIZE; i++) {
+    TestValue *value = (TestValue *)BLI_flatmap_lookup(map, index_to_key(i));
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(value->a, i);
+    EXPECT_EQ(value->b, -i);
+    EXPECT_EQ(value->c, (char)i);
+  }
+  EXPECT_EQ(BLI_flatmap_lookup(map, index_to_key(TESTCASE_SIZE)), nullptr);
+  EXPECT_EQ(BLI_flatmap_lookup(map, NULL), nullptr);
+
+  BLI_flatmap_free(map);
+}
+
+TEST(flatmap, EnsureExisting)
+{
+  FlatMap *map = BLI_flatmap_new(sizeof(int), __func__);
+  void *value_a, *value_b;
+
+  EXPECT_FALSE(BLI_flatmap_ensure(map, index_to_key(0), &value_a));
+  *(int *)value_a = 42;
+  EXPECT_TRUE(BLI_flatmap_ensure(map, index_to_key(0), &value_b));
+  EXPECT_EQ(value_a, value_b);
+  EXPECT_EQ(*(int *)value_b, 42);
+  EXPECT_EQ(BLI_flatmap_len(map), 1);
+
+  BLI_flatmap_free(map);
+}
+
+TEST(flatmap, ZeroValueSize)
+{
+  FlatMap *map = BLI_flatmap_new(0, __func__);
+  void *value;
+
+  for (int i = 0; i < TESTCASE_SIZE; i++) {
+    EXPECT_FALSE(BLI_flatmap_ensure(map, index_to_key(i * 3), &value));
+  }
+  for (int i = 0; i < TESTCASE_SIZE * 3; i++) {
+    EXPECT_EQ(BLI_flatmap_haskey(map, index_to_key(i)), (i % 3) == 0);
+  }
+
+  BLI_flatmap_free(map);
+}
+
+TEST(flatmap, RemoveReinsert)
+{
+  FlatMap *map = BLI_flatmap_new(sizeof(TestValue), __func__);
+
+  flatmap_insert_range(map, TESTCASE_SIZE);
+
+  /* Remove every other key, lookups must still probe past the deleted slots. */
+  for (int i = 0; i < TESTCASE_SIZE; i += 2) {
+    EXPECT_TRUE(BLI_flatmap_remove(map, index_to_key(i)));
+  }
+  EXPECT_FALSE(BLI_flatmap_remove(map, index_to_key(0)));
+  EXPECT_EQ(BLI_flatmap_len(map), TESTCASE_SIZE / 2);
+  for (int i = 0; i < TESTCASE_SIZE; i++) {
+    TestValue *value = (TestValue *)BLI_flatmap_lookup(map, index_to_key(i));
+    if (i % 2) {
+      ASSERT_NE(value, nullptr);
+      EXPECT_EQ(value->a, i);
+    }
+    else {
+      EXPECT_EQ(value, nullptr);
+    }
+  }
+
+  /* Repeated remove & insert cycles reuse the deleted slots. */
+  for (int pass = 0; pass < 8; pass++) {
+    for (int i = 0; i < TESTCASE_SIZE; i += 2) {
+      void *value;
+      EXPECT_FALSE(BLI_flatmap_ensure(map, index_to_key(i), &value));
+      ((TestValue *)value)->a = i;
+    }
+    for (int i = 0; i < TESTCASE_SIZE; i += 2) {
+      EXPECT_TRUE(BLI_flatmap_remove(map, index_to_key(i)));
+    }
+  }
+  EXPECT_EQ(BLI_flatmap_len(map), TESTCASE_SIZE / 2);
+
+  BLI_flatmap_free(map);
+}
+
+TEST(flatmap, Iterator)
+{
+  FlatMap *map = BLI_flatmap_new(sizeof(TestValue), __func__);
+  FlatMapIterator iter;
+
+  flatmap_insert_range(map, TESTCASE_SIZE);
+
+  int count = 0;
+  int64_t sum = 0;
+  FLATMAP_ITER (iter, map) {
+    const TestValue *value = (const TestValue *)BLI_flatmapIterator_getValue(&iter);
+    EXPECT_EQ(BLI_flatmapIterator_getKey(&iter), index_to_key(value->a));
+    sum += value->a;
+    count++;
+  }
+  EXPECT_EQ(count, TESTCASE_SIZE);
+  EXPECT_EQ(sum, (int64_t)TESTCASE_SIZE * (TESTCASE_SIZE - 1) / 2);
+
+  BLI_flatmap_free(map);
+}
+
+TEST(flatmap, ClearReserve)
+{
+  FlatMap *map = BLI_flatmap_new_ex(sizeof(TestValue), TESTCASE_SIZE, __func__);
+
+  flatmap_insert_range(map, TESTCASE_SIZE);
+  BLI_flatmap_clear(map);
+  EXPECT_EQ(BLI_flatmap_len(map), 0);
+  EXPECT_EQ(BLI_flatmap_lookup(map, index_to_key(0)), nullptr);
+
+  BLI_flatmap_reserve(map, TESTCASE_SIZE);
+  flatmap_insert_range(map, TESTCASE_SIZE / 2);
+  BLI_flatmap_reserve(map, TESTCASE_SIZE * 2);
+  EXPECT_EQ(BLI_flatmap_len(map), TESTCASE_SIZE / 2);
+  for (int i = 0; i < TESTCASE_SIZE / 2; i++) {
+    TestValue *value = (TestValue *)BLI_flatmap_lookup(map, index_to_key(i));
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(value->a, i);
+  }
+
+  BLI_flatmap_free(map);
+}
+
+/* Random keys, including neighbors differing only in the low bits. */
+TEST(flatmap, RandomKeys)
+{
+  FlatMap *map = BLI_flatmap_new(sizeof(uintptr_t), __func__);
+  RNG *rng = BLI_rng_new(0);
+  uintptr_t *keys = (uintptr_t *)MEM_mallocN(sizeof(*keys) * TESTCASE_SIZE, __func__);
+
+  for (int i = 0; i < TESTCASE_SIZE; i++) {
+    keys[i] = ((uintptr_t)BLI_rng_get_uint(rng) << 4) | (uintptr_t)(i & 0xf);
+    void *value;
+    if (!BLI_flatmap_ensure(map, (void *)keys[i], &value)) {
+      *(uintptr_t *)value = keys[i];
+    }
+  }
+  for (int i = 0; i < TESTCASE_SIZE; i++) {
+    uintptr_t *value = (uintptr_t *)BLI_flatmap_lookup(map, (void *)keys[i]);
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(*value, keys[i]);
+  }
+
+  MEM_freeN(keys);
+  BLI_rng_free(rng);
+  BLI_flatmap_free(map);
+}
@@ -0,0 +1,132 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "atomic_ops.h"
+
+extern "C" {
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+#include "PIL_time.h"
+}
+
+/* Throughput of the task scheduler for different amount of threads.
+ *
+ * To compare different scheduler implementations build this test from both
+ * revisions and compare the printed numbers, the workloads here only use the
+ * public task pool API.
+ */
+
+/* Number of tasks pushed in the flat case. */
+#define NUM_TASKS_FLAT 1000000
+
+/* Depth of the binary tree of tasks in the recursive case. */
+#define TREE_DEPTH 18
+
+/* Amount of busy work done by every task, keeps it tiny on purpose so the
+ * scheduler overhead dominates. */
+#define TASK_WORK_ITERATIONS 64
+
+static int task_thread_counts[] = {1, 2, 4, 8, 16, 32, 64};
+
+static void task_do_work(uint32_t *counter)
+{
+  volatile uint32_t value = 0;
+  for (int i = 0; i < TASK_WORK_ITERATIONS; i++) {
+    value = value * 1664525u + 1013904223u;
+  }
+  atomic_add_and_fetch_uint32(counter, 1);
+}
+
+static void task_flat_run(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+  uint32_t *counter = (uint32_t *)BLI_task_pool_userdata(pool);
+  task_do_work(counter);
+}
+
+/* Every task spawns two children from the worker thread, similar to how
+ * dependency graph evaluation schedules nodes which became ready. */
+static void task_tree_run(TaskPool *__restrict pool, void *taskdata, int threadid)
+{
+  uint32_t *counter = (uint32_t *)BLI_task_pool_userdata(pool);
+  const intptr_t depth = (intptr_t)taskdata;
+  task_do_work(counter);
+  if (depth < TREE_DEPTH) {
+    for (int i = 0; i < 2; i++) {
+      BLI_task_pool_push_from_thread(
+          pool, task_tree_run, (void *)(depth + 1), false, TASK_PRIORITY_HIGH, threadid);
+    }
+  }
+}
+
+/* Thread API is initialized once for all the tests, it owns the global
+ * scheduler which is created as a side effect of creating any task pool. */
+static void task_performance_init(void)
+{
+  static bool is_initialized = false;
+  if (!is_initialized) {
+    BLI_threadapi_init();
+    is_initialized = true;
+  }
+}
+
+static void task_performance_print(const char *id,
+                                   const int num_threads,
+                                   const uint32_t num_tasks,
+                                   const double time)
+{
+  printf("%s: %2d threads, %8u tasks in %8.3f ms, %12.0f tasks/sec\n",
+         id,
+         num_threads,
+         num_tasks,
+         time * 1000.0,
+         (double)num_tasks / time);
+}
+
+TEST(task, FlatPushPerformance)
+{
+  task_performance_init();
+  for (int i = 0; i < ARRAY_SIZE(task_thread_counts); i++) {
+    const int num_threads = task_thread_counts[i];
+    TaskScheduler *scheduler = BLI_task_scheduler_create(num_threads);
+    uint32_t counter = 0;
+
+    const double time_start = PIL_check_seconds_timer();
+    TaskPool *pool = BLI_task_pool_create(scheduler, &counter);
+    for (int j = 0; j < NUM_TASKS_FLAT; j++) {
+      BLI_task_pool_push(pool, task_flat_run, NULL, false, TASK_PRIORITY_LOW);
+    }
+    BLI_task_pool_work_and_wait(pool);
+    BLI_task_pool_free(pool);
+    const double time = PIL_check_seconds_timer() - time_start;
+
+    EXPECT_EQ(counter, NUM_TASKS_FLAT);
+    task_performance_print("Flat push", num_threads, counter, time);
+
+    BLI_task_scheduler_free(scheduler);
+  }
+}
+
+TEST(task, RecursivePushPerformance)
+{
+  task_performance_init();
+  const uint32_t num_tasks_expected = (1u << (TREE_DEPTH + 1)) - 1;
+  for (int i = 0; i < ARRAY_SIZE(task_thread_counts); i++) {
+    const int num_threads = task_thread_counts[i];
+    TaskScheduler *scheduler = BLI_task_scheduler_create(num_threads);
+    uint32_t counter = 0;
+
+    const double time_start = PIL_check_seconds_timer();
+    TaskPool *pool = BLI_task_pool_create(scheduler, &counter);
+    BLI_task_pool_push(pool, task_tree_run, (void *)(intptr_t)0, false, TASK_PRIORITY_HIGH);
+    BLI_task_pool_work_and_wait(pool);
+    BLI_task_pool_free(pool);
+    const double time = PIL_check_seconds_timer() - time_start;
+
+    EXPECT_EQ(counter, num_tasks_expected);
+    task_performance_print("Recursive push", num_threads, counter, time);
+
+    BLI_task_scheduler_free(scheduler);
+  }
+}
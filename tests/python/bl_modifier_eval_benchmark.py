@@ -0,0 +1,86 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+# Measures modifier stack evaluation of many small objects, re-evaluated on every frame
+# by a time dependent wave modifier followed by a subdivision surface.
+#
+#   ./blender.bin --background --factory-startup --debug-depsgraph-time \
+#       --python tests/python/bl_modifier_eval_benchmark.py -- --objects 500 --frames 50
+#
+# With --debug-depsgraph-time the depsgraph also prints how often deformed vertex
+# coordinates reused a pooled buffer instead of a new allocation.
+
+import bpy
+import bmesh
+
+import sys
+import time
+
+
+def argv_parse():
+    import argparse
+
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+    parser = argparse.ArgumentParser(description="Modifier stack evaluation benchmark")
+    parser.add_argument("--objects", type=int, default=500, help="Number of mesh objects")
+    parser.add_argument("--subdivisions", type=int, default=4, help="Grid subdivisions per mesh")
+    parser.add_argument("--frames", type=int, default=50, help="Frames to evaluate")
+    return parser.parse_args(argv)
+
+
+def scene_setup(objects, subdivisions):
+    for ob in bpy.data.objects[:]:
+        bpy.data.objects.remove(ob)
+
+    scene = bpy.context.scene
+    for i in range(objects):
+        me = bpy.data.meshes.new("Grid")
+        ob = bpy.data.objects.new("Grid", me)
+        scene.collection.objects.link(ob)
+        bm = bmesh.new()
+        bmesh.ops.create_grid(bm, x_segments=2 ** subdivisions, y_segments=2 ** subdivisions, size=1.0)
+        bm.to_mesh(me)
+        bm.free()
+
+        ob.location = ((i % 32) * 2.5, (i // 32) * 2.5, 0.0)
+        ob.modifiers.new("Wave", 'WAVE')
+        ob.modifiers.new("Subdivision", 'SUBSURF').levels = 1
+
+
+def main():
+    args = argv_parse()
+
+    scene_setup(args.objects, args.subdivisions)
+
+    scene = bpy.context.scene
+    # First evaluation builds the depsgraph, don't time it.
+    scene.frame_set(1)
+
+    t = time.perf_counter()
+    for frame in range(2, args.frames + 2):
+        scene.frame_set(frame)
+    t = time.perf_counter() - t
+
+    print("%d objects, %d frames: %.2f ms per frame" % (
+        args.objects, args.frames, 1000.0 * t / args.frames))
+
+
+if __name__ == "__main__":
+    main()
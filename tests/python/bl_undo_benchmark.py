@@ -0,0 +1,128 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+# Measures the latency of global (memfile) undo & redo on a heavy scene.
+#
+# Undo needs a window, so this runs in the user interface (not in background mode):
+#
+#   ./blender.bin --factory-startup --python tests/python/bl_undo_benchmark.py -- \
+#       --objects 20 --subdivisions 7 --iterations 10
+#
+# Two kinds of undo steps are timed:
+# - object transforms, where all meshes are unchanged.
+# - editing the vertices of a single mesh, where only that mesh changed.
+
+import bpy
+
+import sys
+import time
+
+
+def argv_parse():
+    import argparse
+
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+    parser = argparse.ArgumentParser(description="Memfile undo benchmark")
+    parser.add_argument("--objects", type=int, default=20, help="Number of mesh objects")
+    parser.add_argument("--subdivisions", type=int, default=7, help="Grid subdivisions per mesh")
+    parser.add_argument("--iterations", type=int, default=10, help="Undo steps to time")
+    parser.add_argument("--no-quit", action="store_true", help="Keep Blender open when done")
+    return parser.parse_args(argv)
+
+
+def context_override():
+    window = bpy.context.window_manager.windows[0]
+    return {"window": window, "screen": window.screen}
+
+
+def scene_setup(objects, subdivisions):
+    # Start from an empty scene, the default cube & co. don't matter here.
+    for ob in bpy.data.objects[:]:
+        bpy.data.objects.remove(ob)
+
+    for i in range(objects):
+        bpy.ops.mesh.primitive_grid_add(
+            context_override(),
+            x_subdivisions=2 ** subdivisions,
+            y_subdivisions=2 ** subdivisions,
+            location=(i * 2.5, 0.0, 0.0),
+        )
+
+    totvert = sum(len(me.vertices) for me in bpy.data.meshes)
+    print("Scene: %d meshes, %d vertices" % (len(bpy.data.meshes), totvert))
+
+
+def undo_push(message):
+    bpy.ops.ed.undo_push(context_override(), message=message)
+
+
+def time_undo_redo(name, iterations, step_fn):
+    undo_push("Initial")
+    for i in range(iterations):
+        step_fn(i)
+        undo_push("%s %d" % (name, i))
+
+    time_undo = []
+    for i in range(iterations):
+        t = time.perf_counter()
+        bpy.ops.ed.undo(context_override())
+        time_undo.append(time.perf_counter() - t)
+
+    time_redo = []
+    for i in range(iterations):
+        t = time.perf_counter()
+        bpy.ops.ed.redo(context_override())
+        time_redo.append(time.perf_counter() - t)
+
+    for label, times in (("undo", time_undo), ("redo", time_redo)):
+        print("%-10s %s: average %8.2f ms, min %8.2f ms, max %8.2f ms" % (
+            name, label,
+            1000.0 * sum(times) / len(times),
+            1000.0 * min(times),
+            1000.0 * max(times),
+        ))
+
+
+def step_object_transform(i):
+    ob = bpy.data.objects[i % len(bpy.data.objects)]
+    ob.location.z += 0.5
+
+
+def step_mesh_edit(i):
+    me = bpy.data.objects[0].data
+    me.vertices[i % len(me.vertices)].co.z += 0.5
+    me.update()
+
+
+def main():
+    args = argv_parse()
+
+    scene_setup(args.objects, args.subdivisions)
+
+    time_undo_redo("Transform", args.iterations, step_object_transform)
+    time_undo_redo("Mesh edit", args.iterations, step_mesh_edit)
+
+    if not args.no_quit:
+        bpy.ops.wm.quit_blender(context_override())
+
+
+if __name__ == "__main__":
+    # Run once the window is set up.
+    bpy.app.timers.register(main, first_interval=0.1)
@@ -0,0 +1,128 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+# Compares compositing with per pixel and row based execution of operations.
+#
+#   ./blender.bin --background --factory-startup \
+#       --python tests/python/compositor_row_execution_benchmark.py -- --width 3840 --height 2160
+#
+# A chain of mix, math, alpha over and color balance nodes is built on top of
+# a generated image, and the scene is rendered with and without
+# use_row_execution on the node tree.
+
+import bpy
+
+import sys
+import time
+
+
+def argv_parse():
+    import argparse
+
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+    parser = argparse.ArgumentParser(description="Compositor row execution benchmark")
+    parser.add_argument("--width", type=int, default=1920, help="Render width")
+    parser.add_argument("--height", type=int, default=1080, help="Render height")
+    parser.add_argument("--chains", type=int, default=8, help="Number of node chains to stack")
+    parser.add_argument("--repeat", type=int, default=3, help="Renders per mode, best time is used")
+    return parser.parse_args(argv)
+
+
+def scene_setup(width, height, chains):
+    scene = bpy.context.scene
+    scene.render.engine = 'BLENDER_WORKBENCH'
+    scene.render.resolution_x = width
+    scene.render.resolution_y = height
+    scene.render.resolution_percentage = 100
+    scene.use_nodes = True
+
+    tree = scene.node_tree
+    tree.nodes.clear()
+    links = tree.links
+
+    image = bpy.data.images.new("Benchmark", width, height, alpha=True, float_buffer=True)
+    image.generated_type = 'COLOR_GRID'
+
+    node_image = tree.nodes.new('CompositorNodeImage')
+    node_image.image = image
+    socket = node_image.outputs["Image"]
+
+    for i in range(chains):
+        node_mix = tree.nodes.new('CompositorNodeMixRGB')
+        node_mix.blend_type = ('ADD', 'MULTIPLY', 'SUBTRACT', 'MIX')[i % 4]
+        node_mix.use_clamp = True
+        links.new(socket, node_mix.inputs[1])
+        node_mix.inputs[2].default_value = (0.2, 0.4, 0.6, 1.0)
+
+        node_math = tree.nodes.new('CompositorNodeMath')
+        node_math.operation = ('ADD', 'MULTIPLY', 'SUBTRACT', 'DIVIDE')[i % 4]
+        node_math.inputs[1].default_value = 1.5
+        links.new(node_image.outputs["Alpha"], node_math.inputs[0])
+
+        node_alpha = tree.nodes.new('CompositorNodeAlphaOver')
+        node_alpha.premul = 0.5 if i % 2 else 0.0
+        links.new(node_math.outputs[0], node_alpha.inputs[0])
+        links.new(socket, node_alpha.inputs[1])
+        links.new(node_mix.outputs[0], node_alpha.inputs[2])
+
+        node_balance = tree.nodes.new('CompositorNodeColorBalance')
+        node_balance.correction_method = ('LIFT_GAMMA_GAIN', 'OFFSET_POWER_SLOPE')[i % 2]
+        links.new(node_alpha.outputs[0], node_balance.inputs[1])
+
+        socket = node_balance.outputs[0]
+
+    node_composite = tree.nodes.new('CompositorNodeComposite')
+    links.new(socket, node_composite.inputs[0])
+
+    return tree
+
+
+def render_time(repeat):
+    best = None
+    for _ in range(repeat):
+        t = time.perf_counter()
+        bpy.ops.render.render()
+        t = time.perf_counter() - t
+        best = t if best is None else min(best, t)
+    return best
+
+
+def main():
+    args = argv_parse()
+
+    tree = scene_setup(args.width, args.height, args.chains)
+
+    # Renders the scene and compositing once without timing, so the generated
+    # image and the render result are allocated.
+    bpy.ops.render.render()
+
+    times = {}
+    for use_row_execution in (False, True):
+        tree.use_row_execution = use_row_execution
+        times[use_row_execution] = render_time(args.repeat)
+        print("%dx%d, %d chains, %-5s execution: %.3f s" % (
+            args.width, args.height, args.chains,
+            "row" if use_row_execution else "pixel", times[use_row_execution]))
+
+    print("Speedup: %.2fx" % (times[False] / times[True]))
+
+
+if __name__ == "__main__":
+    main()
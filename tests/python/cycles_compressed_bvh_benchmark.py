@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+# Apache License, Version 2.0
+
+# Compares Cycles CPU renders with and without compressed BVH nodes.
+#
+#   ./tests/python/cycles_compressed_bvh_benchmark.py \
+#       -blender ./blender.bin -testdir ../lib/tests/cycles
+#
+# Every test scene is rendered with the regular and the compressed BVH8 node layout.
+# Render time, BVH node memory, peak memory and primary paths per second are printed.
+# Compressed nodes are only used with the BVH8 layout, so this needs an AVX2 capable CPU.
+
+import argparse
+import glob
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+
+SETUP_EXPR = (
+    "import bpy\n"
+    "scene = bpy.context.scene\n"
+    "scene.cycles.device = 'CPU'\n"
+    "scene.cycles.debug_use_compressed_bvh = {}\n"
+    "render = scene.render\n"
+    "scale = render.resolution_percentage / 100.0\n"
+    "print('BENCHMARK', int(render.resolution_x * scale), int(render.resolution_y * scale),\n"
+    "      scene.cycles.samples)\n"
+)
+
+
+def parse_time(text):
+    # Render statistics print time as [HH:]MM:SS.FF.
+    seconds = 0.0
+    for value in text.split(":"):
+        seconds = seconds * 60.0 + float(value)
+    return seconds
+
+
+def render_file(blender, filepath, use_compressed_bvh):
+    with tempfile.TemporaryDirectory() as output_dir:
+        command = [
+            blender,
+            "--background",
+            "-noaudio",
+            "--factory-startup",
+            "--enable-autoexec",
+            "--debug-cycles",
+            "--verbose", "1",
+            filepath,
+            "-E", "CYCLES",
+            "--python-expr", SETUP_EXPR.format(use_compressed_bvh),
+            "-o", os.path.join(output_dir, "render"),
+            "-F", "PNG",
+            "-f", "1",
+        ]
+
+        try:
+            output = subprocess.check_output(command, stderr=subprocess.STDOUT)
+        except subprocess.CalledProcessError:
+            return None
+
+    output = output.decode("utf-8", "replace")
+
+    result = {"time": None, "peak": None, "bvh": None, "paths": None}
+    pixels = samples = 0
+
+    for line in output.splitlines():
+        match = re.search(r"BENCHMARK (\d+) (\d+) (\d+)", line)
+        if match:
+            width, height, samples = (int(value) for value in match.groups())
+            pixels = width * height
+        match = re.search(r"Peak ([0-9.]+)M", line)
+        if match:
+            result["peak"] = float(match.group(1))
+        match = re.search(r"Time:([0-9:.]+)", line)
+        if match:
+            result["time"] = parse_time(match.group(1))
+        match = re.search(r"Scene BVH nodes memory (.*)$", line)
+        if match:
+            result["bvh"] = match.group(1).strip()
+
+    if result["time"]:
+        result["paths"] = pixels * samples / result["time"] / 1e6
+
+    return result
+
+
+def create_argparse():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("-blender", nargs=1, required=True)
+    parser.add_argument("-testdir", nargs=1, required=True)
+    return parser
+
+
+def main():
+    parser = create_argparse()
+    args = parser.parse_args()
+
+    blender = args.blender[0]
+    test_dir = args.testdir[0]
+
+    filepaths = sorted(glob.glob(os.path.join(test_dir, "*", "*.blend")))
+    if not filepaths:
+        print("No .blend files found in " + test_dir)
+        sys.exit(1)
+
+    print("%-40s %-10s %9s %10s %9s %10s" % (
+        "Scene", "Nodes", "Time (s)", "BVH", "Peak (M)", "Mpaths/s"))
+
+    for filepath in filepaths:
+        name = os.path.relpath(filepath, test_dir)
+
+        for use_compressed_bvh in (False, True):
+            result = render_file(blender, filepath, use_compressed_bvh)
+            nodes = "compressed" if use_compressed_bvh else "regular"
+
+            if result is None:
+                print("%-40s %-10s %9s" % (name, nodes, "CRASH"))
+                continue
+
+            print("%-40s %-10s %9s %10s %9s %10s" % (
+                name,
+                nodes,
+                "%.2f" % result["time"] if result["time"] else "-",
+                result["bvh"] or "-",
+                "%.2f" % result["peak"] if result["peak"] else "-",
+                "%.3f" % result["paths"] if result["paths"] else "-"))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,154 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+# Compares the noise of Cycles renders with and without the light tree, at equal time.
+#
+#   ./blender.bin --background --factory-startup \
+#       --python tests/python/cycles_light_tree_benchmark.py -- --lights 1000 --time 10
+#
+# The scene is a floor lit by many small point lights and emissive quads of varying
+# strength. A reference is rendered first, then both modes are given the same render
+# time and the RMSE against the reference is printed.
+
+import bpy
+
+import math
+import os
+import random
+import sys
+import tempfile
+import time
+
+
+def argv_parse():
+    import argparse
+
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+    parser = argparse.ArgumentParser(description="Cycles light tree benchmark")
+    parser.add_argument("--lights", type=int, default=1000, help="Number of point lights")
+    parser.add_argument("--emitters", type=int, default=200, help="Number of emissive quads")
+    parser.add_argument("--resolution", type=int, default=256, help="Image width and height")
+    parser.add_argument("--time", type=float, default=10.0, help="Render time per mode in seconds")
+    parser.add_argument("--reference-samples", type=int, default=4096, help="Samples of the reference")
+    return parser.parse_args(argv)
+
+
+def scene_setup(lights, emitters, resolution):
+    for ob in bpy.data.objects[:]:
+        bpy.data.objects.remove(ob)
+
+    scene = bpy.context.scene
+    scene.render.engine = 'CYCLES'
+    scene.render.resolution_x = resolution
+    scene.render.resolution_y = resolution
+    scene.render.resolution_percentage = 100
+    scene.render.image_settings.file_format = 'OPEN_EXR'
+    scene.render.image_settings.color_depth = '32'
+    scene.cycles.progressive = 'PATH'
+    scene.cycles.max_bounces = 1
+    scene.cycles.use_square_samples = False
+    scene.cycles.light_sampling_threshold = 0.0
+    scene.world = None
+
+    rng = random.Random(0)
+    size = 20.0
+
+    bpy.ops.mesh.primitive_plane_add(size=2.0 * size)
+
+    for i in range(lights):
+        light = bpy.data.lights.new("Point", 'POINT')
+        light.energy = rng.uniform(1.0, 50.0)
+        light.shadow_soft_size = 0.05
+        ob = bpy.data.objects.new("Point", light)
+        ob.location = (rng.uniform(-size, size), rng.uniform(-size, size), rng.uniform(0.2, 2.0))
+        scene.collection.objects.link(ob)
+
+    material = bpy.data.materials.new("Emission")
+    material.use_nodes = True
+    nodes = material.node_tree.nodes
+    nodes.clear()
+    emission = nodes.new('ShaderNodeEmission')
+    emission.inputs["Strength"].default_value = 20.0
+    output = nodes.new('ShaderNodeOutputMaterial')
+    material.node_tree.links.new(emission.outputs["Emission"], output.inputs["Surface"])
+
+    for i in range(emitters):
+        bpy.ops.mesh.primitive_plane_add(
+            size=0.2,
+            location=(rng.uniform(-size, size), rng.uniform(-size, size), rng.uniform(0.5, 3.0)),
+            rotation=(rng.uniform(0.0, math.pi), 0.0, rng.uniform(0.0, math.pi)),
+        )
+        bpy.context.active_object.data.materials.append(material)
+
+    camera = bpy.data.objects.new("Camera", bpy.data.cameras.new("Camera"))
+    camera.location = (0.0, -size, 12.0)
+    camera.rotation_euler = (math.radians(55.0), 0.0, 0.0)
+    scene.collection.objects.link(camera)
+    scene.camera = camera
+
+
+def render(filepath, samples, use_light_tree):
+    scene = bpy.context.scene
+    scene.cycles.samples = samples
+    scene.cycles.use_light_tree = use_light_tree
+    scene.render.filepath = filepath
+
+    t = time.perf_counter()
+    bpy.ops.render.render(write_still=True)
+    t = time.perf_counter() - t
+
+    image = bpy.data.images.load(filepath)
+    pixels = image.pixels[:]
+    bpy.data.images.remove(image)
+    return pixels, t
+
+
+def rmse(pixels, reference):
+    # Skip alpha.
+    error = sum((a - b) ** 2 for i, (a, b) in enumerate(zip(pixels, reference)) if i % 4 != 3)
+    return math.sqrt(error / (len(reference) * 3 // 4))
+
+
+def main():
+    args = argv_parse()
+
+    scene_setup(args.lights, args.emitters, args.resolution)
+
+    with tempfile.TemporaryDirectory() as dirpath:
+        filepath = os.path.join(dirpath, "render.exr")
+
+        reference, t = render(filepath, args.reference_samples, True)
+        print("Reference: %d samples in %.2f s" % (args.reference_samples, t))
+
+        for use_light_tree in (False, True):
+            name = "Light tree" if use_light_tree else "Distribution"
+
+            # Calibrate samples per second, then render for the requested time.
+            calibration_samples = 16
+            _, t = render(filepath, calibration_samples, use_light_tree)
+            samples = max(1, int(args.time * calibration_samples / t))
+
+            pixels, t = render(filepath, samples, use_light_tree)
+            print("%-12s %6d samples in %6.2f s: RMSE %.5f" % (
+                name, samples, t, rmse(pixels, reference)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+# Apache License, Version 2.0
+
+# Compares CPU rendering throughput of the Cycles megakernel and wavefront split kernel.
+#
+#   ./tests/python/cycles_wavefront_benchmark.py \
+#       -cycles ./bin/cycles -samples 64 -width 640 -height 360 scene1.xml scene2.xml
+#
+# Every scene is rendered with the cycles_standalone application, once with each kernel.
+# Render time and primary paths per second are printed.
+
+import argparse
+import re
+import subprocess
+
+
+def render_file(cycles, filepath, args, wavefront):
+    command = [
+        cycles,
+        "--background",
+        "--device", "CPU",
+        "--samples", str(args.samples),
+        "--width", str(args.width),
+        "--height", str(args.height),
+    ]
+    if args.threads:
+        command += ["--threads", str(args.threads)]
+    if wavefront:
+        command += ["--wavefront"]
+    command += [filepath]
+
+    try:
+        output = subprocess.check_output(command, stderr=subprocess.STDOUT)
+    except subprocess.CalledProcessError:
+        return None
+
+    match = re.search(r"Finished Rendering in ([0-9.]+) seconds, ([0-9.]+) rendering",
+                      output.decode("utf-8", "replace"))
+    if not match:
+        return None
+
+    return float(match.group(2))
+
+
+def create_argparse():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("-cycles", nargs=1, required=True)
+    parser.add_argument("-samples", type=int, default=64)
+    parser.add_argument("-width", type=int, default=640)
+    parser.add_argument("-height", type=int, default=360)
+    parser.add_argument("-threads", type=int, default=0)
+    parser.add_argument("files", nargs="+")
+    return parser
+
+
+def main():
+    parser = create_argparse()
+    args = parser.parse_args()
+
+    cycles = args.cycles[0]
+    num_paths = args.width * args.height * args.samples
+
+    print("%-40s %-11s %9s %10s" % ("Scene", "Kernel", "Time (s)", "Mpaths/s"))
+
+    for filepath in args.files:
+        times = {}
+
+        for wavefront in (False, True):
+            kernel = "wavefront" if wavefront else "megakernel"
+            render_time = render_file(cycles, filepath, args, wavefront)
+            times[wavefront] = render_time
+
+            if render_time is None:
+                print("%-40s %-11s %9s" % (filepath, kernel, "FAILED"))
+                continue
+
+            print("%-40s %-11s %9.2f %10.3f" % (
+                filepath, kernel, render_time, num_paths / render_time / 1e6))
+
+        if times[False] and times[True]:
+            print("%-40s %-11s %8.2fx" % (filepath, "speedup", times[False] / times[True]))
+
+
+if __name__ == "__main__":
+    main()